@@ -1,3 +1,6 @@
 C:/VulkanSDK/1.3.275.0/Bin/glslc.exe "C:/Calico/Shaders/test_shader.vert" -o vert.spv
 C:/VulkanSDK/1.3.275.0/Bin/glslc.exe "C:/Calico/Shaders/test_shader.frag" -o frag.spv
+C:/VulkanSDK/1.3.275.0/Bin/glslc.exe "C:/Calico/Shaders/cull.comp" -o cull.spv
+C:/VulkanSDK/1.3.275.0/Bin/glslc.exe "C:/Calico/Shaders/hiz_reduce.comp" -o hiz_reduce.spv
+C:/VulkanSDK/1.3.275.0/Bin/glslc.exe "C:/Calico/Shaders/cluster_cull.comp" -o cluster_cull.spv
 pause
\ No newline at end of file
@@ -5,11 +5,24 @@ layout(location = 1) in vec3 vertex_color;
 layout(location = 0) in vec2 vertex_positions;
 layout(location = 2) in vec2 tex_coords;
 
+//Location 3 is the vertex normal, nothing reads it yet
+
+//Per instance, see CtInstanceData. The transform takes locations 4 through 7
+layout(location = 4) in mat4 instance_transform;
+layout(location = 8) in vec4 instance_color;
+layout(location = 9) in uint instance_material_id;
+
 layout(location = 0) out vec3 frag_color;
 
+//Bound with a dynamic offset, every draw gets its own slice of the uniform ring. Everything in one instanced draw shares it
+layout(set = 0, binding = 0) uniform DrawUniforms{
+    mat4 transform;
+    vec4 color;
+} draw;
+
 void main(){
 
-    gl_Position = vec4(vertex_positions, 0.0, 1.0);
-    frag_color = vertex_color;
+    gl_Position = draw.transform * instance_transform * vec4(vertex_positions, 0.0, 1.0);
+    frag_color = vertex_color * draw.color.rgb * instance_color.rgb;
 
 }
\ No newline at end of file
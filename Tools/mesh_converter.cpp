@@ -0,0 +1,229 @@
+//Turns source meshes into .ctmesh files the engine can map and upload without parsing anything.
+//Build it along with src/Engine/CtMeshImport.cpp, CtMeshFile.cpp, CtMappedFile.cpp, CtGltfImport.cpp and CtJson.cpp, with glm and the
+//Vulkan headers on the include path.
+//
+//  mesh_converter <input.obj|.gltf|.glb> <output.ctmesh> [--no-lods]
+//
+//The mesh gets welded, optimized for the vertex cache and fetch order, and (unless --no-lods) a LOD chain built for it.
+//It then times loading the file back the way the engine does, next to how long parsing the source took
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+#include "../src/Engine/CtVertex.h"
+#include "../src/Engine/CtMeshImport.h"
+#include "../src/Engine/CtMeshFile.h"
+#include "../src/Engine/CtGltfImport.h"
+
+//OBJ indices start at 1 and negative ones count back from the end of what's been read so far
+static uint32_t ResolveObjIndex(long index, size_t count){
+    long resolved = index < 0 ? static_cast<long>(count) + index : index - 1;
+    if(resolved < 0 || static_cast<size_t>(resolved) >= count){
+        throw std::runtime_error("An OBJ face points at something that doesn't exist.");
+    }
+    return static_cast<uint32_t>(resolved);
+}
+
+//Positions (with the common r g b extension for colors), texture coordinates, normals and polygon faces, which get fanned into
+//triangles. Everything else is skipped. CtVertex positions are 2D for now, so z only goes into working out missing normals
+static std::vector<CtVertex> ReadObj(const std::string& path){
+    std::ifstream file(path);
+    if(!file.is_open()){
+        throw std::runtime_error("Failed to open " + path + ".");
+    }
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> colors;
+    std::vector<glm::vec2> texture_coordinates;
+    std::vector<glm::vec3> normals;
+    std::vector<CtVertex> vertices;
+
+    std::string line;
+    while(std::getline(file, line)){
+        std::istringstream stream(line);
+        std::string type;
+        stream >> type;
+
+        if(type == "v"){
+            glm::vec3 position(0.0f);
+            glm::vec3 color(1.0f, 1.0f, 1.0f);
+            stream >> position.x >> position.y >> position.z;
+            if(stream >> color.x){
+                stream >> color.y >> color.z;
+            }
+            else{
+                color = glm::vec3(1.0f, 1.0f, 1.0f);
+            }
+            positions.push_back(position);
+            colors.push_back(color);
+        }
+        else if(type == "vt"){
+            glm::vec2 texture_coordinate(0.0f, 0.0f);
+            stream >> texture_coordinate.x >> texture_coordinate.y;
+
+            //OBJ puts v = 0 at the bottom, Vulkan samples it at the top
+            texture_coordinate.y = 1.0f - texture_coordinate.y;
+            texture_coordinates.push_back(texture_coordinate);
+        }
+        else if(type == "vn"){
+            glm::vec3 normal(0.0f);
+            stream >> normal.x >> normal.y >> normal.z;
+            normals.push_back(normal);
+        }
+        else if(type == "f"){
+            std::vector<CtVertex> polygon;
+            std::vector<bool> has_normal;
+            std::vector<glm::vec3> polygon_positions;
+
+            std::string corner;
+            while(stream >> corner){
+                long indices[3] = {0, 0, 0};
+                size_t start = 0;
+                for(uint32_t k = 0; k < 3 && start <= corner.size(); k++){
+                    size_t end = corner.find('/', start);
+                    std::string part = corner.substr(start, end == std::string::npos ? std::string::npos : end - start);
+                    if(!part.empty()){
+                        indices[k] = std::stol(part);
+                    }
+                    if(end == std::string::npos){
+                        break;
+                    }
+                    start = end + 1;
+                }
+
+                uint32_t position_index = ResolveObjIndex(indices[0], positions.size());
+
+                CtVertex vertex {};
+                vertex.position = glm::vec2(positions[position_index].x, positions[position_index].y);
+                vertex.color = colors[position_index];
+                vertex.texCoord = indices[1] != 0 ? texture_coordinates[ResolveObjIndex(indices[1], texture_coordinates.size())] : glm::vec2(0.0f, 0.0f);
+                vertex.normal = indices[2] != 0 ? normals[ResolveObjIndex(indices[2], normals.size())] : glm::vec3(0.0f);
+
+                polygon.push_back(vertex);
+                has_normal.push_back(indices[2] != 0);
+                polygon_positions.push_back(positions[position_index]);
+            }
+
+            if(polygon.size() < 3){
+                continue;
+            }
+
+            //Flat normals for corners the file didn't give one
+            glm::vec3 face_normal = glm::cross(polygon_positions[1] - polygon_positions[0], polygon_positions[2] - polygon_positions[0]);
+            float face_length = glm::length(face_normal);
+            face_normal = face_length > 0.0f ? face_normal / face_length : glm::vec3(0.0f, 0.0f, 1.0f);
+            for(size_t c = 0; c < polygon.size(); c++){
+                if(!has_normal[c]){
+                    polygon[c].normal = face_normal;
+                }
+            }
+
+            for(size_t c = 1; c + 1 < polygon.size(); c++){
+                vertices.push_back(polygon[0]);
+                vertices.push_back(polygon[c]);
+                vertices.push_back(polygon[c + 1]);
+            }
+        }
+    }
+
+    return vertices;
+}
+
+//A .ctmesh is one mesh, so every primitive the default scene places gets baked into world space and they all go in together
+static std::vector<CtVertex> ReadGltf(const std::string& path){
+    std::vector<CtMeshData> primitives;
+    CtGltfScene scene = CtGltfImport::Import(path, [&primitives](CtMeshData& mesh){
+        primitives.push_back(std::move(mesh));
+        return static_cast<uint32_t>(primitives.size() - 1);
+    }, false);
+
+    std::vector<CtVertex> vertices;
+    for(const auto& object : scene.objects){
+        const CtMeshData& primitive = primitives[object.mesh_id];
+        for(uint32_t index : primitive.indices){
+            CtVertex vertex = primitive.vertices[index];
+
+            glm::vec4 position = object.transform * glm::vec4(vertex.position.x, vertex.position.y, 0.0f, 1.0f);
+            glm::vec3 normal = glm::vec3(object.transform * glm::vec4(vertex.normal, 0.0f));
+            float normal_length = glm::length(normal);
+
+            vertex.position = glm::vec2(position.x, position.y);
+            vertex.normal = normal_length > 0.0f ? normal / normal_length : glm::vec3(0.0f, 0.0f, 1.0f);
+            vertex.color = glm::vec3(vertex.color.x * object.color.x, vertex.color.y * object.color.y, vertex.color.z * object.color.z);
+            vertices.push_back(vertex);
+        }
+    }
+
+    return vertices;
+}
+
+static bool EndsWith(const std::string& text, const std::string& ending){
+    return text.size() >= ending.size() && text.compare(text.size() - ending.size(), ending.size(), ending) == 0;
+}
+
+int main(int argc, char** argv){
+    if(argc < 3){
+        std::cerr << "Usage: mesh_converter <input.obj|.gltf|.glb> <output.ctmesh> [--no-lods]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string input = argv[1];
+    std::string output = argv[2];
+    bool build_lods = !(argc > 3 && std::strcmp(argv[3], "--no-lods") == 0);
+
+    try{
+        auto parse_start = std::chrono::steady_clock::now();
+
+        std::vector<CtVertex> triangles;
+        if(EndsWith(input, ".obj")){
+            triangles = ReadObj(input);
+        }
+        else if(EndsWith(input, ".gltf") || EndsWith(input, ".glb")){
+            triangles = ReadGltf(input);
+        }
+        else{
+            throw std::runtime_error("Don't know how to read " + input + ".");
+        }
+
+        CtMeshData mesh = CtMeshImport::Weld(triangles, {});
+        double parse_milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - parse_start).count();
+
+        CtMeshImport::Optimize(mesh, true);
+
+        std::vector<CtMeshLod> lods = build_lods ? CtMeshImport::BuildLods(mesh) : std::vector<CtMeshLod>{{mesh.indices, 0.0f}};
+        CtMeshFile::Write<CtMeshVertexLayout>(output, mesh.vertices, lods);
+
+        printf("Wrote %s: %zu vertices, %zu triangles, %zu LODs.\n", output.c_str(), mesh.vertices.size(), mesh.indices.size() / 3, lods.size());
+        for(size_t l = 0; l < lods.size(); l++){
+            printf("  LOD %zu: %zu triangles, error %f\n", l, lods[l].indices.size() / 3, lods[l].error);
+        }
+
+        //Opening is all the engine does before the blobs get copied to staging, so this is the whole CPU side of a load
+        auto load_start = std::chrono::steady_clock::now();
+        CtMeshFile* file = CtMeshFile::Open(output);
+        bool layout_matches = file->HasLayout<CtMeshVertexLayout>();
+        file->Close();
+        delete file;
+        double load_milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load_start).count();
+
+        if(!layout_matches){
+            throw std::runtime_error("The written file doesn't read back with the layout it was written for.");
+        }
+
+        printf("Parsing %s took %.2f ms, opening %s takes %.3f ms.\n", input.c_str(), parse_milliseconds, output.c_str(), load_milliseconds);
+    } catch(const std::exception& exception){
+        std::cerr << exception.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
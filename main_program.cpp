@@ -27,9 +27,37 @@ int main(){
     graphic_settings.shader_files = {fragment, vertex};
     graphic_settings.shader_stages = {static_cast<uint32_t>(CT_SHADER_PIPELINE_STAGE_FRAGMENT), static_cast<uint32_t>(CT_SHADER_PIPELINE_STAGE_VERTEX)};
     graphic_settings.max_frames_in_flight = 2;
+    graphic_settings.uniform_ring_size = 1024 * 1024;
+    graphic_settings.max_instances = 100000;
+    graphic_settings.use_dynamic_rendering = true;
+    graphic_settings.use_synchronization2 = true;
+    graphic_settings.use_bindless = true;
+    graphic_settings.max_bindless_textures = 4096;
+    graphic_settings.max_bindless_storage_buffers = 1024;
+    graphic_settings.use_multi_draw_indirect = true;
+    graphic_settings.max_mesh_vertices = 1024 * 1024;
+    graphic_settings.max_mesh_indices = 4 * 1024 * 1024;
+    graphic_settings.max_indirect_draws = 4096;
+    graphic_settings.max_mesh_clusters = 64 * 1024;
+    graphic_settings.lod_pixel_error = 1.0f;
+    graphic_settings.max_sampler_anisotropy = 16.0f;
+    graphic_settings.use_texture_compression = true;
+    graphic_settings.use_texture_streaming = true;
+    graphic_settings.texture_streaming_budget = 512;
+    //The compute shaders aren't checked in as SPIR-V. Run Shaders/compile.bat before turning these on
+    graphic_settings.use_gpu_culling = false;
+    graphic_settings.cull_shader_file = "C:/Calico/Shaders/cull.spv";
+    graphic_settings.hiz_shader_file = "C:/Calico/Shaders/hiz_reduce.spv";
+    graphic_settings.use_cluster_culling = false;
+    graphic_settings.cluster_cull_shader_file = "C:/Calico/Shaders/cluster_cull.spv";
+    graphic_settings.use_async_compute = true;
+
+    SimulationSettings simulation_settings {};
+    simulation_settings.tick_rate = 60;
 
     settings.windows_settings = window_settings;
     settings.graphics_settings = graphic_settings;
+    settings.simulation_settings = simulation_settings;
 
     try{
         engine.StartEngine(settings);
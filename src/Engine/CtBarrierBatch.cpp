@@ -0,0 +1,189 @@
+#include "CtBarrierBatch.h"
+#include "CtDevice.h"
+
+//Sync2 stages and accesses that don't exist in the legacy flags, and the legacy flag that covers each of them
+const VkPipelineStageFlags2 CT_SYNC2_TRANSFER_STAGES = VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_RESOLVE_BIT |
+    VK_PIPELINE_STAGE_2_BLIT_BIT | VK_PIPELINE_STAGE_2_CLEAR_BIT;
+const VkPipelineStageFlags2 CT_SYNC2_VERTEX_INPUT_STAGES = VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT | VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT;
+const VkAccessFlags2 CT_SYNC2_SHADER_READ_ACCESS = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+const VkAccessFlags2 CT_SYNC2_SHADER_WRITE_ACCESS = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+
+CtBarrierBatch::CtBarrierBatch(CtDevice* device){
+    this->device = device;
+}
+
+void CtBarrierBatch::AddImageBarrier(VkImage image, const VkImageSubresourceRange& range,
+    VkPipelineStageFlags2 source_stage, VkAccessFlags2 source_access, VkImageLayout old_layout,
+    VkPipelineStageFlags2 destination_stage, VkAccessFlags2 destination_access, VkImageLayout new_layout){
+
+    VkImageMemoryBarrier2 barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+    barrier.srcStageMask = source_stage;
+    barrier.srcAccessMask = source_access;
+    barrier.dstStageMask = destination_stage;
+    barrier.dstAccessMask = destination_access;
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = new_layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = range;
+
+    image_barriers.push_back(barrier);
+}
+
+void CtBarrierBatch::AddBufferBarrier(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size,
+    VkPipelineStageFlags2 source_stage, VkAccessFlags2 source_access,
+    VkPipelineStageFlags2 destination_stage, VkAccessFlags2 destination_access){
+
+    VkBufferMemoryBarrier2 barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+    barrier.srcStageMask = source_stage;
+    barrier.srcAccessMask = source_access;
+    barrier.dstStageMask = destination_stage;
+    barrier.dstAccessMask = destination_access;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = buffer;
+    barrier.offset = offset;
+    barrier.size = size;
+
+    buffer_barriers.push_back(barrier);
+}
+
+void CtBarrierBatch::AddMemoryBarrier(VkPipelineStageFlags2 source_stage, VkAccessFlags2 source_access,
+    VkPipelineStageFlags2 destination_stage, VkAccessFlags2 destination_access){
+
+    VkMemoryBarrier2 barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+    barrier.srcStageMask = source_stage;
+    barrier.srcAccessMask = source_access;
+    barrier.dstStageMask = destination_stage;
+    barrier.dstAccessMask = destination_access;
+
+    memory_barriers.push_back(barrier);
+}
+
+void CtBarrierBatch::Flush(VkCommandBuffer command_buffer){
+    if(IsEmpty()){
+        return;
+    }
+
+    if(!device->GetOptionalFeatures().synchronization2){
+        FlushLegacy(command_buffer);
+        Clear();
+        return;
+    }
+
+    VkDependencyInfo dependency_info {};
+    dependency_info.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependency_info.memoryBarrierCount = static_cast<uint32_t>(memory_barriers.size());
+    dependency_info.pMemoryBarriers = memory_barriers.data();
+    dependency_info.bufferMemoryBarrierCount = static_cast<uint32_t>(buffer_barriers.size());
+    dependency_info.pBufferMemoryBarriers = buffer_barriers.data();
+    dependency_info.imageMemoryBarrierCount = static_cast<uint32_t>(image_barriers.size());
+    dependency_info.pImageMemoryBarriers = image_barriers.data();
+
+    device->CmdPipelineBarrier2(command_buffer, &dependency_info);
+
+    Clear();
+}
+
+//Legacy barriers only get one pair of stage masks for the whole call, so every barrier's stages get merged into it.
+//That's looser than what sync2 records, but it's still a single sync point
+void CtBarrierBatch::FlushLegacy(VkCommandBuffer command_buffer){
+    VkPipelineStageFlags2 source_stage = VK_PIPELINE_STAGE_2_NONE;
+    VkPipelineStageFlags2 destination_stage = VK_PIPELINE_STAGE_2_NONE;
+
+    std::vector<VkMemoryBarrier> legacy_memory_barriers;
+    for(const auto& barrier : memory_barriers){
+        source_stage |= barrier.srcStageMask;
+        destination_stage |= barrier.dstStageMask;
+
+        VkMemoryBarrier legacy_barrier {};
+        legacy_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        legacy_barrier.srcAccessMask = ToLegacyAccess(barrier.srcAccessMask);
+        legacy_barrier.dstAccessMask = ToLegacyAccess(barrier.dstAccessMask);
+
+        legacy_memory_barriers.push_back(legacy_barrier);
+    }
+
+    std::vector<VkBufferMemoryBarrier> legacy_buffer_barriers;
+    for(const auto& barrier : buffer_barriers){
+        source_stage |= barrier.srcStageMask;
+        destination_stage |= barrier.dstStageMask;
+
+        VkBufferMemoryBarrier legacy_barrier {};
+        legacy_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        legacy_barrier.srcAccessMask = ToLegacyAccess(barrier.srcAccessMask);
+        legacy_barrier.dstAccessMask = ToLegacyAccess(barrier.dstAccessMask);
+        legacy_barrier.srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+        legacy_barrier.dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+        legacy_barrier.buffer = barrier.buffer;
+        legacy_barrier.offset = barrier.offset;
+        legacy_barrier.size = barrier.size;
+
+        legacy_buffer_barriers.push_back(legacy_barrier);
+    }
+
+    std::vector<VkImageMemoryBarrier> legacy_image_barriers;
+    for(const auto& barrier : image_barriers){
+        source_stage |= barrier.srcStageMask;
+        destination_stage |= barrier.dstStageMask;
+
+        VkImageMemoryBarrier legacy_barrier {};
+        legacy_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        legacy_barrier.srcAccessMask = ToLegacyAccess(barrier.srcAccessMask);
+        legacy_barrier.dstAccessMask = ToLegacyAccess(barrier.dstAccessMask);
+        legacy_barrier.oldLayout = barrier.oldLayout;
+        legacy_barrier.newLayout = barrier.newLayout;
+        legacy_barrier.srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+        legacy_barrier.dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+        legacy_barrier.image = barrier.image;
+        legacy_barrier.subresourceRange = barrier.subresourceRange;
+
+        legacy_image_barriers.push_back(legacy_barrier);
+    }
+
+    vkCmdPipelineBarrier(command_buffer, ToLegacyStage(source_stage, true), ToLegacyStage(destination_stage, false), 0,
+        static_cast<uint32_t>(legacy_memory_barriers.size()), legacy_memory_barriers.data(),
+        static_cast<uint32_t>(legacy_buffer_barriers.size()), legacy_buffer_barriers.data(),
+        static_cast<uint32_t>(legacy_image_barriers.size()), legacy_image_barriers.data());
+}
+
+VkPipelineStageFlags CtBarrierBatch::ToLegacyStage(VkPipelineStageFlags2 stage, bool is_source){
+    VkPipelineStageFlags legacy_stage = static_cast<VkPipelineStageFlags>(stage & 0xFFFFFFFFull);
+
+    if(stage & CT_SYNC2_TRANSFER_STAGES){
+        legacy_stage |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+    }
+    if(stage & CT_SYNC2_VERTEX_INPUT_STAGES){
+        legacy_stage |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+    }
+
+    //Legacy barriers can't wait on or block nothing, so NONE turns into the ends of the pipe, which do the same thing
+    if(legacy_stage == 0){
+        legacy_stage = is_source ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    }
+
+    return legacy_stage;
+}
+
+VkAccessFlags CtBarrierBatch::ToLegacyAccess(VkAccessFlags2 access){
+    VkAccessFlags legacy_access = static_cast<VkAccessFlags>(access & 0xFFFFFFFFull);
+
+    if(access & CT_SYNC2_SHADER_READ_ACCESS){
+        legacy_access |= VK_ACCESS_SHADER_READ_BIT;
+    }
+    if(access & CT_SYNC2_SHADER_WRITE_ACCESS){
+        legacy_access |= VK_ACCESS_SHADER_WRITE_BIT;
+    }
+
+    return legacy_access;
+}
+
+void CtBarrierBatch::Clear(){
+    image_barriers.clear();
+    buffer_barriers.clear();
+    memory_barriers.clear();
+}
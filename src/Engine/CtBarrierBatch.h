@@ -0,0 +1,48 @@
+#include <vulkan/vulkan.h>
+#include <vector>
+
+class CtDevice;
+
+//Collects image, buffer and memory barriers and records all of them with a single call when flushed.
+//Everything is described with synchronization2 stage and access masks, so we can say exactly what we mean (a copy instead
+//of "transfer", a sampled read instead of "shader read"). When the device doesn't have synchronization2 the masks
+//get folded down into the closest legacy ones and go out through one vkCmdPipelineBarrier instead.
+//Meant to live on the stack for however long it takes to build up the barriers
+class CtBarrierBatch{
+
+    public:
+        CtBarrierBatch(CtDevice* device);
+
+        void AddImageBarrier(VkImage image, const VkImageSubresourceRange& range,
+            VkPipelineStageFlags2 source_stage, VkAccessFlags2 source_access, VkImageLayout old_layout,
+            VkPipelineStageFlags2 destination_stage, VkAccessFlags2 destination_access, VkImageLayout new_layout);
+
+        void AddBufferBarrier(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size,
+            VkPipelineStageFlags2 source_stage, VkAccessFlags2 source_access,
+            VkPipelineStageFlags2 destination_stage, VkAccessFlags2 destination_access);
+
+        void AddMemoryBarrier(VkPipelineStageFlags2 source_stage, VkAccessFlags2 source_access,
+            VkPipelineStageFlags2 destination_stage, VkAccessFlags2 destination_access);
+
+        //Records everything we have and empties the batch. Does nothing if the batch is empty
+        void Flush(VkCommandBuffer command_buffer);
+
+        bool IsEmpty(){
+            return image_barriers.empty() && buffer_barriers.empty() && memory_barriers.empty();
+        }
+
+        //The legacy masks are the low 32 bits of the sync2 ones, everything sync2 added above that gets widened to what contains it
+        static VkPipelineStageFlags ToLegacyStage(VkPipelineStageFlags2 stage, bool is_source);
+        static VkAccessFlags ToLegacyAccess(VkAccessFlags2 access);
+
+    private:
+
+        CtDevice* device;
+
+        std::vector<VkImageMemoryBarrier2> image_barriers;
+        std::vector<VkBufferMemoryBarrier2> buffer_barriers;
+        std::vector<VkMemoryBarrier2> memory_barriers;
+
+        void FlushLegacy(VkCommandBuffer command_buffer);
+        void Clear();
+};
@@ -0,0 +1,271 @@
+#include "CtBindlessTable.h"
+#include "CtDevice.h"
+#include <stdexcept>
+#include <array>
+#include <string>
+
+CtBindlessTable* CtBindlessTable::CreateBindlessTable(CtDevice* device, uint32_t max_textures, uint32_t max_storage_buffers, uint32_t max_frames_in_flight){
+    CtBindlessTable* ct_bindless_table = new CtBindlessTable();
+
+    ct_bindless_table->device = device;
+    ct_bindless_table->frame = 0;
+    ct_bindless_table->max_frames_in_flight = max_frames_in_flight;
+
+    ct_bindless_table->textures = {};
+    ct_bindless_table->textures.capacity = max_textures;
+    ct_bindless_table->samplers = {};
+    ct_bindless_table->samplers.capacity = CT_BINDLESS_MAX_SAMPLERS;
+    ct_bindless_table->storage_buffers = {};
+    ct_bindless_table->storage_buffers.capacity = max_storage_buffers;
+
+    ct_bindless_table->ClampCapacities();
+    ct_bindless_table->CreateDescriptorSetLayout();
+    ct_bindless_table->CreateDescriptorPool();
+    ct_bindless_table->AllocateDescriptorSet();
+
+    printf("Created Bindless Table with %u textures, %u samplers and %u storage buffers.\n",
+        ct_bindless_table->textures.capacity, ct_bindless_table->samplers.capacity, ct_bindless_table->storage_buffers.capacity);
+
+    return ct_bindless_table;
+}
+
+//Update after bind descriptors have their own (usually much bigger) limits, so we ask for as much as we wanted and take what we can get
+void CtBindlessTable::ClampCapacities(){
+    VkPhysicalDeviceDescriptorIndexingProperties indexing_properties {};
+    indexing_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+
+    VkPhysicalDeviceProperties2 properties {};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &indexing_properties;
+    vkGetPhysicalDeviceProperties2(*(device->GetPhysicalDevice()), &properties);
+
+    auto clamp = [](uint32_t wanted, uint32_t set_limit, uint32_t stage_limit){
+        uint32_t limit = set_limit < stage_limit ? set_limit : stage_limit;
+        return wanted < limit ? wanted : limit;
+    };
+
+    textures.capacity = clamp(textures.capacity, indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages,
+        indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages);
+    samplers.capacity = clamp(samplers.capacity, indexing_properties.maxDescriptorSetUpdateAfterBindSamplers,
+        indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers);
+    storage_buffers.capacity = clamp(storage_buffers.capacity, indexing_properties.maxDescriptorSetUpdateAfterBindStorageBuffers,
+        indexing_properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers);
+}
+
+void CtBindlessTable::CreateDescriptorSetLayout(){
+    std::array<VkDescriptorSetLayoutBinding, 3> bindings {};
+
+    bindings[0].binding = CT_BINDLESS_BINDING_TEXTURES;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    bindings[0].descriptorCount = textures.capacity;
+    bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+
+    bindings[1].binding = CT_BINDLESS_BINDING_SAMPLERS;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+    bindings[1].descriptorCount = samplers.capacity;
+    bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+    bindings[2].binding = CT_BINDLESS_BINDING_STORAGE_BUFFERS;
+    bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[2].descriptorCount = storage_buffers.capacity;
+    bindings[2].stageFlags = VK_SHADER_STAGE_ALL;
+
+    //Partially bound lets most of the slots stay empty, and update unused while pending lets us fill new ones while a frame is still using the set
+    VkDescriptorBindingFlags flags = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+    std::array<VkDescriptorBindingFlags, 3> binding_flags = {flags, flags, flags};
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info {};
+    binding_flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    binding_flags_info.bindingCount = static_cast<uint32_t>(binding_flags.size());
+    binding_flags_info.pBindingFlags = binding_flags.data();
+
+    VkDescriptorSetLayoutCreateInfo layout_info {};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.pNext = &binding_flags_info;
+    layout_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    layout_info.pBindings = bindings.data();
+
+    if(vkCreateDescriptorSetLayout(*(device->GetInterfaceDevice()), &layout_info, nullptr, &descriptor_set_layout) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create the bindless descriptor set layout.");
+    }
+}
+
+void CtBindlessTable::CreateDescriptorPool(){
+    std::array<VkDescriptorPoolSize, 3> pool_sizes {};
+    pool_sizes[0].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    pool_sizes[0].descriptorCount = textures.capacity;
+    pool_sizes[1].type = VK_DESCRIPTOR_TYPE_SAMPLER;
+    pool_sizes[1].descriptorCount = samplers.capacity;
+    pool_sizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    pool_sizes[2].descriptorCount = storage_buffers.capacity;
+
+    VkDescriptorPoolCreateInfo pool_info {};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    pool_info.maxSets = 1;
+    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    pool_info.pPoolSizes = pool_sizes.data();
+
+    VkResult result = vkCreateDescriptorPool(*(device->GetInterfaceDevice()), &pool_info, nullptr, &descriptor_pool);
+
+    switch(result){
+        case VK_SUCCESS:
+            break;
+        case VK_ERROR_OUT_OF_HOST_MEMORY:
+            throw std::runtime_error("Failed to create the bindless descriptor pool. Out of host memory.\n");
+        case VK_ERROR_OUT_OF_DEVICE_MEMORY:
+            throw std::runtime_error("Failed to create the bindless descriptor pool. Out of device memory.\n");
+        case VK_ERROR_FRAGMENTATION:
+            throw std::runtime_error("Failed to create the bindless descriptor pool. Fragmentation.\n");
+        default:
+            throw std::runtime_error("Failed to create the bindless descriptor pool.\n");
+    }
+}
+
+void CtBindlessTable::AllocateDescriptorSet(){
+    VkDescriptorSetAllocateInfo allocate_info {};
+    allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocate_info.descriptorPool = descriptor_pool;
+    allocate_info.descriptorSetCount = 1;
+    allocate_info.pSetLayouts = &descriptor_set_layout;
+
+    if(vkAllocateDescriptorSets(*(device->GetInterfaceDevice()), &allocate_info, &descriptor_set) != VK_SUCCESS){
+        throw std::runtime_error("Failed to allocate the bindless descriptor set.");
+    }
+}
+
+/******************************************************SLOTS**********************************************************************/
+
+uint32_t CtBindlessTable::RegisterTexture(VkImageView image_view, VkImageLayout layout){
+    uint32_t index = AllocateSlot(textures, "texture");
+
+    VkDescriptorImageInfo image_info {};
+    image_info.imageView = image_view;
+    image_info.imageLayout = layout;
+
+    VkWriteDescriptorSet write {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = descriptor_set;
+    write.dstBinding = CT_BINDLESS_BINDING_TEXTURES;
+    write.dstArrayElement = index;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    write.pImageInfo = &image_info;
+
+    vkUpdateDescriptorSets(*(device->GetInterfaceDevice()), 1, &write, 0, nullptr);
+
+    return index;
+}
+
+uint32_t CtBindlessTable::RegisterSampler(VkSampler sampler){
+    uint32_t index = AllocateSlot(samplers, "sampler");
+
+    VkDescriptorImageInfo image_info {};
+    image_info.sampler = sampler;
+
+    VkWriteDescriptorSet write {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = descriptor_set;
+    write.dstBinding = CT_BINDLESS_BINDING_SAMPLERS;
+    write.dstArrayElement = index;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+    write.pImageInfo = &image_info;
+
+    vkUpdateDescriptorSets(*(device->GetInterfaceDevice()), 1, &write, 0, nullptr);
+
+    return index;
+}
+
+uint32_t CtBindlessTable::RegisterStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range){
+    uint32_t index = AllocateSlot(storage_buffers, "storage buffer");
+
+    VkDescriptorBufferInfo buffer_info {};
+    buffer_info.buffer = buffer;
+    buffer_info.offset = offset;
+    buffer_info.range = range;
+
+    VkWriteDescriptorSet write {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = descriptor_set;
+    write.dstBinding = CT_BINDLESS_BINDING_STORAGE_BUFFERS;
+    write.dstArrayElement = index;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = &buffer_info;
+
+    vkUpdateDescriptorSets(*(device->GetInterfaceDevice()), 1, &write, 0, nullptr);
+
+    return index;
+}
+
+void CtBindlessTable::ReleaseTexture(uint32_t index){
+    ReleaseSlot(textures, index);
+}
+
+void CtBindlessTable::ReleaseSampler(uint32_t index){
+    ReleaseSlot(samplers, index);
+}
+
+void CtBindlessTable::ReleaseStorageBuffer(uint32_t index){
+    ReleaseSlot(storage_buffers, index);
+}
+
+void CtBindlessTable::AdvanceFrame(){
+    frame++;
+
+    RecycleSlots(textures);
+    RecycleSlots(samplers);
+    RecycleSlots(storage_buffers);
+}
+
+//Reuse freed slots first so the arrays stay packed towards the front
+uint32_t CtBindlessTable::AllocateSlot(CtBindlessSlots& slots, const char* name){
+    if(!slots.free_indices.empty()){
+        uint32_t index = slots.free_indices.back();
+        slots.free_indices.pop_back();
+        return index;
+    }
+
+    if(slots.next_unused >= slots.capacity){
+        throw std::runtime_error(std::string("Bindless table is out of ") + name + " slots.");
+    }
+
+    return slots.next_unused++;
+}
+
+//Nothing gets written over the old descriptor. Partially bound means it's fine to leave it there until the slot is reused
+void CtBindlessTable::ReleaseSlot(CtBindlessSlots& slots, uint32_t index){
+    if(index == CT_BINDLESS_INVALID_INDEX){
+        return;
+    }
+
+    slots.retiring_indices.push_back({index, frame + max_frames_in_flight});
+}
+
+void CtBindlessTable::RecycleSlots(CtBindlessSlots& slots){
+    size_t kept = 0;
+
+    for(size_t i = 0; i < slots.retiring_indices.size(); i++){
+        if(slots.retiring_indices[i].second <= frame){
+            slots.free_indices.push_back(slots.retiring_indices[i].first);
+        } else {
+            slots.retiring_indices[kept++] = slots.retiring_indices[i];
+        }
+    }
+
+    slots.retiring_indices.resize(kept);
+}
+
+void CtBindlessTable::Bind(VkCommandBuffer command_buffer, VkPipelineBindPoint bind_point, VkPipelineLayout pipeline_layout, uint32_t set){
+    vkCmdBindDescriptorSets(command_buffer, bind_point, pipeline_layout, set, 1, &descriptor_set, 0, nullptr);
+}
+
+void CtBindlessTable::Cleanup(){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    vkDestroyDescriptorPool(interface_device, descriptor_pool, nullptr);
+    vkDestroyDescriptorSetLayout(interface_device, descriptor_set_layout, nullptr);
+}
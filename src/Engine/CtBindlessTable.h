@@ -0,0 +1,89 @@
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+class CtDevice;
+
+//Handed out when there's nothing to point at. Shaders can check for it, but with partially bound arrays they just can't read it
+const uint32_t CT_BINDLESS_INVALID_INDEX = UINT32_MAX;
+
+//How many samplers the table holds. We only ever need a handful of them, unlike textures
+const uint32_t CT_BINDLESS_MAX_SAMPLERS = 64;
+
+//Where each array lives in the bindless set
+enum CtBindlessBinding{
+    CT_BINDLESS_BINDING_TEXTURES = 0,
+    CT_BINDLESS_BINDING_SAMPLERS = 1,
+    CT_BINDLESS_BINDING_STORAGE_BUFFERS = 2
+};
+
+//What a draw pushes instead of binding descriptor sets. Every field is an index into the bindless table
+struct CtBindlessDrawIndices{
+    uint32_t texture;
+    uint32_t sampler;
+    uint32_t storage_buffer;
+    uint32_t padding;
+};
+
+//One slot array in the table. Freed slots wait a few frames before they get handed out again, since frames that are still in flight
+//might be reading whatever was there before
+struct CtBindlessSlots{
+    uint32_t capacity;
+    uint32_t next_unused;
+    std::vector<uint32_t> free_indices;
+    std::vector<std::pair<uint32_t, uint64_t>> retiring_indices; //Index and the frame it can be reused on
+};
+
+//A single descriptor set with big, partially bound arrays of textures, samplers and storage buffers that stays bound for the whole frame.
+//Anything we want to use gets registered once and is referred to by its index from then on, so switching materials is just a different push constant.
+//Needs descriptor indexing (core in 1.2), which CtDevice turns on when it can
+class CtBindlessTable{
+
+    public:
+        static CtBindlessTable* CreateBindlessTable(CtDevice* device, uint32_t max_textures, uint32_t max_storage_buffers, uint32_t max_frames_in_flight);
+
+        //Registering writes the descriptor right away. Update after bind means we don't have to wait for the set to be unbound
+        uint32_t RegisterTexture(VkImageView image_view, VkImageLayout layout);
+        uint32_t RegisterSampler(VkSampler sampler);
+        uint32_t RegisterStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+
+        void ReleaseTexture(uint32_t index);
+        void ReleaseSampler(uint32_t index);
+        void ReleaseStorageBuffer(uint32_t index);
+
+        //Call once per frame after waiting on that frame's fence, this is what lets released slots come back
+        void AdvanceFrame();
+
+        void Bind(VkCommandBuffer command_buffer, VkPipelineBindPoint bind_point, VkPipelineLayout pipeline_layout, uint32_t set);
+
+        VkDescriptorSetLayout GetDescriptorSetLayout(){
+            return descriptor_set_layout;
+        }
+
+        void Cleanup();
+
+    private:
+
+        CtDevice* device;
+
+        VkDescriptorSetLayout descriptor_set_layout;
+        VkDescriptorPool descriptor_pool;
+        VkDescriptorSet descriptor_set;
+
+        CtBindlessSlots textures;
+        CtBindlessSlots samplers;
+        CtBindlessSlots storage_buffers;
+
+        uint64_t frame;
+        uint32_t max_frames_in_flight;
+
+        void ClampCapacities();
+        void CreateDescriptorSetLayout();
+        void CreateDescriptorPool();
+        void AllocateDescriptorSet();
+
+        uint32_t AllocateSlot(CtBindlessSlots& slots, const char* name);
+        void ReleaseSlot(CtBindlessSlots& slots, uint32_t index);
+        void RecycleSlots(CtBindlessSlots& slots);
+};
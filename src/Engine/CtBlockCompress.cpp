@@ -0,0 +1,274 @@
+#include "CtBlockCompress.h"
+#include "CtImageDecode.h"
+#include <algorithm>
+#include <cmath>
+
+//How many times the principal axis gets refined. It converges quickly, the colors in one block are nearly always close to a line
+const uint32_t CT_BLOCK_COMPRESS_AXIS_ITERATIONS = 4;
+
+std::vector<uint8_t> CtBlockCompress::EncodeBc1(const CtImageData& image){
+    uint32_t blocks_x = (image.width + 3) / 4;
+    uint32_t blocks_y = (image.height + 3) / 4;
+    std::vector<uint8_t> blocks(static_cast<size_t>(blocks_x) * blocks_y * 8);
+
+    uint8_t pixels[64];
+    for(uint32_t y = 0; y < blocks_y; y++){
+        for(uint32_t x = 0; x < blocks_x; x++){
+            ReadBlock(image, x, y, pixels);
+            EncodeColorBlock(pixels, &blocks[(static_cast<size_t>(y) * blocks_x + x) * 8]);
+        }
+    }
+
+    return blocks;
+}
+
+std::vector<uint8_t> CtBlockCompress::EncodeBc3(const CtImageData& image){
+    uint32_t blocks_x = (image.width + 3) / 4;
+    uint32_t blocks_y = (image.height + 3) / 4;
+    std::vector<uint8_t> blocks(static_cast<size_t>(blocks_x) * blocks_y * 16);
+
+    uint8_t pixels[64];
+    for(uint32_t y = 0; y < blocks_y; y++){
+        for(uint32_t x = 0; x < blocks_x; x++){
+            uint8_t* block = &blocks[(static_cast<size_t>(y) * blocks_x + x) * 16];
+            ReadBlock(image, x, y, pixels);
+            EncodeAlphaBlock(pixels, block);
+            EncodeColorBlock(pixels, block + 8);
+        }
+    }
+
+    return blocks;
+}
+
+bool CtBlockCompress::IsOpaque(const CtImageData& image){
+    for(size_t p = 3; p < image.pixels.size(); p += 4){
+        if(image.pixels[p] != 255){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void CtBlockCompress::ReadBlock(const CtImageData& image, uint32_t block_x, uint32_t block_y, uint8_t* pixels){
+    for(uint32_t y = 0; y < 4; y++){
+        uint32_t image_y = std::min(block_y * 4 + y, image.height - 1);
+        for(uint32_t x = 0; x < 4; x++){
+            uint32_t image_x = std::min(block_x * 4 + x, image.width - 1);
+            const uint8_t* pixel = &image.pixels[(static_cast<size_t>(image_y) * image.width + image_x) * 4];
+            std::copy(pixel, pixel + 4, pixels + (y * 4 + x) * 4);
+        }
+    }
+}
+
+/***************************************************************COLOR******************************************************************/
+
+//End points from the line through the colors that spreads them out the most, then moved to wherever fits the indices they picked best
+void CtBlockCompress::EncodeColorBlock(const uint8_t* pixels, uint8_t* out){
+    float mean[3] = {0.0f, 0.0f, 0.0f};
+    for(uint32_t p = 0; p < 16; p++){
+        for(uint32_t c = 0; c < 3; c++){
+            mean[c] += pixels[p * 4 + c];
+        }
+    }
+    for(uint32_t c = 0; c < 3; c++){
+        mean[c] /= 16.0f;
+    }
+
+    float covariance[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    for(uint32_t p = 0; p < 16; p++){
+        float r = pixels[p * 4 + 0] - mean[0];
+        float g = pixels[p * 4 + 1] - mean[1];
+        float b = pixels[p * 4 + 2] - mean[2];
+        covariance[0] += r * r;
+        covariance[1] += r * g;
+        covariance[2] += r * b;
+        covariance[3] += g * g;
+        covariance[4] += g * b;
+        covariance[5] += b * b;
+    }
+
+    //Power iteration. Luminance is a good start, most blocks vary along something close to it
+    float axis[3] = {0.299f, 0.587f, 0.114f};
+    for(uint32_t i = 0; i < CT_BLOCK_COMPRESS_AXIS_ITERATIONS; i++){
+        float next[3] = {
+            covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+            covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+            covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]
+        };
+        float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+        if(length < 1e-6f){
+            break;
+        }
+        for(uint32_t c = 0; c < 3; c++){
+            axis[c] = next[c] / length;
+        }
+    }
+
+    float low = 0.0f;
+    float high = 0.0f;
+    for(uint32_t p = 0; p < 16; p++){
+        float t = (pixels[p * 4 + 0] - mean[0]) * axis[0] + (pixels[p * 4 + 1] - mean[1]) * axis[1] + (pixels[p * 4 + 2] - mean[2]) * axis[2];
+        low = p == 0 ? t : std::min(low, t);
+        high = p == 0 ? t : std::max(high, t);
+    }
+
+    //Pulled in a little, the outermost colors are usually better served by an index between the ends than by the ends themselves
+    float inset = (high - low) / 16.0f;
+    low += inset;
+    high -= inset;
+
+    uint16_t color0 = Pack565(mean[0] + axis[0] * high, mean[1] + axis[1] * high, mean[2] + axis[2] * high);
+    uint16_t color1 = Pack565(mean[0] + axis[0] * low, mean[1] + axis[1] * low, mean[2] + axis[2] * low);
+    uint32_t indices = 0;
+    uint32_t error = FitColorIndices(pixels, color0, color1, indices);
+
+    //Least squares end points for the indices we got. Index 0 is all color0, 1 all color1, 2 and 3 two thirds of one and a third of the other
+    const float weights[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+    float aa = 0.0f;
+    float bb = 0.0f;
+    float ab = 0.0f;
+    float ax[3] = {0.0f, 0.0f, 0.0f};
+    float bx[3] = {0.0f, 0.0f, 0.0f};
+    for(uint32_t p = 0; p < 16; p++){
+        float w = weights[(indices >> (p * 2)) & 3];
+        aa += w * w;
+        bb += (1.0f - w) * (1.0f - w);
+        ab += w * (1.0f - w);
+        for(uint32_t c = 0; c < 3; c++){
+            ax[c] += w * pixels[p * 4 + c];
+            bx[c] += (1.0f - w) * pixels[p * 4 + c];
+        }
+    }
+
+    float determinant = aa * bb - ab * ab;
+    if(std::fabs(determinant) > 1e-6f){
+        float a[3];
+        float b[3];
+        for(uint32_t c = 0; c < 3; c++){
+            a[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+            b[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+        }
+
+        uint16_t refined0 = Pack565(a[0], a[1], a[2]);
+        uint16_t refined1 = Pack565(b[0], b[1], b[2]);
+        uint32_t refined_indices = 0;
+        uint32_t refined_error = FitColorIndices(pixels, refined0, refined1, refined_indices);
+        if(refined_error < error){
+            color0 = refined0;
+            color1 = refined1;
+            indices = refined_indices;
+        }
+    }
+
+    //color0 has to be the bigger one or BC1 reads the block as three colors and transparent black. Swapping the ends swaps 0 with 1 and 2 with 3.
+    //Equal ends can't be ordered at all, so every pixel just takes color0
+    if(color0 < color1){
+        std::swap(color0, color1);
+        indices ^= 0x55555555;
+    }
+    else if(color0 == color1){
+        indices = 0;
+    }
+
+    out[0] = static_cast<uint8_t>(color0 & 0xFF);
+    out[1] = static_cast<uint8_t>(color0 >> 8);
+    out[2] = static_cast<uint8_t>(color1 & 0xFF);
+    out[3] = static_cast<uint8_t>(color1 >> 8);
+    out[4] = static_cast<uint8_t>(indices & 0xFF);
+    out[5] = static_cast<uint8_t>((indices >> 8) & 0xFF);
+    out[6] = static_cast<uint8_t>((indices >> 16) & 0xFF);
+    out[7] = static_cast<uint8_t>(indices >> 24);
+}
+
+uint32_t CtBlockCompress::FitColorIndices(const uint8_t* pixels, uint16_t color0, uint16_t color1, uint32_t& indices){
+    int32_t palette[4][3];
+    Unpack565(color0, palette[0]);
+    Unpack565(color1, palette[1]);
+    for(uint32_t c = 0; c < 3; c++){
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    uint32_t total = 0;
+    indices = 0;
+    for(uint32_t p = 0; p < 16; p++){
+        uint32_t best = 0;
+        uint32_t best_error = UINT32_MAX;
+        for(uint32_t i = 0; i < 4; i++){
+            int32_t r = pixels[p * 4 + 0] - palette[i][0];
+            int32_t g = pixels[p * 4 + 1] - palette[i][1];
+            int32_t b = pixels[p * 4 + 2] - palette[i][2];
+            uint32_t error = static_cast<uint32_t>(r * r + g * g + b * b);
+            if(error < best_error){
+                best = i;
+                best_error = error;
+            }
+        }
+
+        indices |= best << (p * 2);
+        total += best_error;
+    }
+
+    return total;
+}
+
+uint16_t CtBlockCompress::Pack565(float red, float green, float blue){
+    auto quantize = [](float value, float levels){
+        return static_cast<uint16_t>(std::min(std::max(value * levels / 255.0f + 0.5f, 0.0f), levels));
+    };
+
+    return static_cast<uint16_t>((quantize(red, 31.0f) << 11) | (quantize(green, 63.0f) << 5) | quantize(blue, 31.0f));
+}
+
+//Widened by copying the top bits into the bottom, which is how the hardware reads them
+void CtBlockCompress::Unpack565(uint16_t color, int32_t* rgb){
+    int32_t red = (color >> 11) & 0x1F;
+    int32_t green = (color >> 5) & 0x3F;
+    int32_t blue = color & 0x1F;
+    rgb[0] = (red << 3) | (red >> 2);
+    rgb[1] = (green << 2) | (green >> 4);
+    rgb[2] = (blue << 3) | (blue >> 2);
+}
+
+/***************************************************************ALPHA******************************************************************/
+
+//The block's lowest and highest alpha as the ends, with alpha0 above alpha1 so the six values between them are interpolated too
+void CtBlockCompress::EncodeAlphaBlock(const uint8_t* pixels, uint8_t* out){
+    uint8_t low = 255;
+    uint8_t high = 0;
+    for(uint32_t p = 0; p < 16; p++){
+        low = std::min(low, pixels[p * 4 + 3]);
+        high = std::max(high, pixels[p * 4 + 3]);
+    }
+
+    out[0] = high;
+    out[1] = low;
+
+    uint64_t indices = 0;
+    if(high != low){
+        int32_t values[8];
+        values[0] = high;
+        values[1] = low;
+        for(int32_t i = 2; i < 8; i++){
+            values[i] = ((8 - i) * high + (i - 1) * low) / 7;
+        }
+
+        for(uint32_t p = 0; p < 16; p++){
+            uint64_t best = 0;
+            int32_t best_error = 256;
+            for(uint32_t i = 0; i < 8; i++){
+                int32_t error = std::abs(pixels[p * 4 + 3] - values[i]);
+                if(error < best_error){
+                    best = i;
+                    best_error = error;
+                }
+            }
+            indices |= best << (p * 3);
+        }
+    }
+
+    for(uint32_t b = 0; b < 6; b++){
+        out[2 + b] = static_cast<uint8_t>((indices >> (b * 8)) & 0xFF);
+    }
+}
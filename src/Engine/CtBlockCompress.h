@@ -0,0 +1,32 @@
+#include <vector>
+#include <cstdint>
+
+struct CtImageData;
+
+//Encodes RGBA8 images into BC block compressed data the GPU samples directly. Each 4x4 block of pixels becomes two end colors and
+//a 2 bit index per pixel picking one of four points between them, plus the same with eight points for alpha in BC3.
+//Everything in here is plain CPU work, so it can run on any thread. Blocks past the edge of the image repeat the edge pixels
+class CtBlockCompress{
+
+    public:
+        //8 bytes a block, an eighth of RGBA8. Alpha is dropped
+        static std::vector<uint8_t> EncodeBc1(const CtImageData& image);
+
+        //16 bytes a block, a quarter of RGBA8. BC1's color block after a BC4 block for alpha
+        static std::vector<uint8_t> EncodeBc3(const CtImageData& image);
+
+        //True if every pixel has alpha 255, so BC1 loses nothing BC3 would have kept
+        static bool IsOpaque(const CtImageData& image);
+
+    private:
+        //pixels is the block's 16 pixels as RGBA8, row by row
+        static void ReadBlock(const CtImageData& image, uint32_t block_x, uint32_t block_y, uint8_t* pixels);
+        static void EncodeColorBlock(const uint8_t* pixels, uint8_t* out);
+        static void EncodeAlphaBlock(const uint8_t* pixels, uint8_t* out);
+
+        //Picks each pixel's closest of the four colors the two 565 end points make and returns the total squared error
+        static uint32_t FitColorIndices(const uint8_t* pixels, uint16_t color0, uint16_t color1, uint32_t& indices);
+
+        static uint16_t Pack565(float red, float green, float blue);
+        static void Unpack565(uint16_t color, int32_t* rgb);
+};
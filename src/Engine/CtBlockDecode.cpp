@@ -0,0 +1,1067 @@
+#include "CtBlockDecode.h"
+#include "CtImageDecode.h"
+#include "CtTextureStore.h"
+#include <algorithm>
+#include <cstring>
+
+//ASTC's biggest block, 12x12
+const uint32_t CT_BLOCK_DECODE_MAX_TEXELS = 144;
+
+//ETC1's intensity modifiers, the small and large one of each table. The other two are their negatives
+const int32_t CT_BLOCK_DECODE_ETC_MODIFIERS[8][2] = {{2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}};
+
+//How far apart the paint colors of ETC2's T and H modes are
+const int32_t CT_BLOCK_DECODE_ETC_DISTANCES[8] = {3, 6, 11, 16, 23, 32, 41, 64};
+
+const int32_t CT_BLOCK_DECODE_EAC_MODIFIERS[16][8] = {
+    {-3, -6, -9, -15, 2, 5, 8, 14}, {-3, -7, -10, -13, 2, 6, 9, 12}, {-2, -5, -8, -13, 1, 4, 7, 12}, {-2, -4, -6, -13, 1, 3, 5, 12},
+    {-3, -6, -8, -12, 2, 5, 7, 11}, {-3, -7, -9, -11, 2, 6, 8, 10}, {-4, -7, -8, -11, 3, 6, 7, 10}, {-3, -5, -8, -11, 2, 4, 7, 10},
+    {-2, -6, -8, -10, 1, 5, 7, 9}, {-2, -5, -8, -10, 1, 4, 7, 9}, {-2, -4, -8, -10, 1, 3, 7, 9}, {-2, -5, -7, -10, 1, 4, 6, 9},
+    {-3, -4, -7, -10, 2, 3, 6, 9}, {-1, -2, -3, -10, 0, 1, 2, 9}, {-4, -6, -8, -9, 3, 5, 7, 8}, {-3, -5, -7, -9, 2, 4, 6, 8}
+};
+
+//Every range ASTC quantizes values to, smallest first. Weights only use the first 12, colors need at least 6
+const uint32_t CT_BLOCK_DECODE_ASTC_RANGES[21] = {2, 3, 4, 5, 6, 8, 10, 12, 16, 20, 24, 32, 40, 48, 64, 80, 96, 128, 160, 192, 256};
+const uint32_t CT_BLOCK_DECODE_ASTC_MIN_COLOR_RANGE = 4;
+
+//What an ASTC block decodes to when it's an error or HDR
+const uint8_t CT_BLOCK_DECODE_ASTC_ERROR_COLOR[4] = {255, 0, 255, 255};
+
+bool CtBlockDecode::Decode(VkFormat format, const uint8_t* data, uint32_t width, uint32_t height, CtImageData& image){
+    CtFormatBlock block {};
+    if(!CtTextureStore::GetFormatBlock(format, block) || block.compression == CT_TEXTURE_COMPRESSION_NONE){
+        return false;
+    }
+
+    uint32_t blocks_x = (width + block.width - 1) / block.width;
+    uint32_t blocks_y = (height + block.height - 1) / block.height;
+    image.width = width;
+    image.height = height;
+    image.pixels.assign(static_cast<size_t>(width) * height * 4, 0);
+
+    uint8_t pixels[CT_BLOCK_DECODE_MAX_TEXELS * 4];
+    for(uint32_t y = 0; y < blocks_y; y++){
+        for(uint32_t x = 0; x < blocks_x; x++){
+            const uint8_t* source = data + (static_cast<size_t>(y) * blocks_x + x) * block.size;
+
+            //Single and two channel formats leave the rest black and opaque
+            for(uint32_t t = 0; t < block.width * block.height; t++){
+                pixels[t * 4 + 0] = 0;
+                pixels[t * 4 + 1] = 0;
+                pixels[t * 4 + 2] = 0;
+                pixels[t * 4 + 3] = 255;
+            }
+
+            switch(format){
+                case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+                case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+                    //Without alpha the transparent black is just black
+                    DecodeBc1(source, true, pixels);
+                    for(uint32_t t = 0; t < 16; t++){
+                        pixels[t * 4 + 3] = 255;
+                    }
+                    break;
+                case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+                case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+                    DecodeBc1(source, true, pixels);
+                    break;
+                case VK_FORMAT_BC2_UNORM_BLOCK:
+                case VK_FORMAT_BC2_SRGB_BLOCK:
+                    DecodeBc1(source + 8, false, pixels);
+                    DecodeBc2Alpha(source, pixels);
+                    break;
+                case VK_FORMAT_BC3_UNORM_BLOCK:
+                case VK_FORMAT_BC3_SRGB_BLOCK:
+                    DecodeBc1(source + 8, false, pixels);
+                    DecodeBc4(source, 3, pixels);
+                    break;
+                case VK_FORMAT_BC4_UNORM_BLOCK:
+                    DecodeBc4(source, 0, pixels);
+                    break;
+                case VK_FORMAT_BC5_UNORM_BLOCK:
+                    DecodeBc4(source, 0, pixels);
+                    DecodeBc4(source + 8, 1, pixels);
+                    break;
+                case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+                case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+                    DecodeEtc2(source, false, pixels);
+                    break;
+                case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+                case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+                    DecodeEtc2(source, true, pixels);
+                    break;
+                case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+                case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+                    DecodeEtc2(source + 8, false, pixels);
+                    DecodeEac(source, false, 3, pixels);
+                    break;
+                case VK_FORMAT_EAC_R11_UNORM_BLOCK:
+                    DecodeEac(source, true, 0, pixels);
+                    break;
+                case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:
+                    DecodeEac(source, true, 0, pixels);
+                    DecodeEac(source + 8, true, 1, pixels);
+                    break;
+                default:
+                    if(block.compression != CT_TEXTURE_COMPRESSION_ASTC_LDR){
+                        return false;
+                    }
+                    DecodeAstc(source, block.width, block.height, IsSrgb(format), pixels);
+                    break;
+            }
+
+            //Blocks hanging off the right and bottom edges only keep the part inside the image
+            uint32_t columns = std::min(block.width, width - x * block.width);
+            uint32_t rows = std::min(block.height, height - y * block.height);
+            for(uint32_t row = 0; row < rows; row++){
+                size_t image_offset = ((static_cast<size_t>(y) * block.height + row) * width + static_cast<size_t>(x) * block.width) * 4;
+                memcpy(&image.pixels[image_offset], pixels + row * block.width * 4, columns * 4);
+            }
+        }
+    }
+
+    return true;
+}
+
+bool CtBlockDecode::IsSrgb(VkFormat format){
+    switch(format){
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC2_SRGB_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_5x4_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_5x5_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_6x5_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_6x6_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_8x5_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_8x6_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_8x8_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_10x5_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_10x6_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_10x8_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_10x10_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_12x10_SRGB_BLOCK:
+        case VK_FORMAT_ASTC_12x12_SRGB_BLOCK:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*****************************************************************BC*******************************************************************/
+
+void CtBlockDecode::DecodeBc1(const uint8_t* block, bool three_color_mode, uint8_t* pixels){
+    uint16_t color0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+    uint16_t color1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+
+    //Widened by copying the top bits into the bottom
+    int32_t palette[4][4];
+    uint16_t colors[2] = {color0, color1};
+    for(uint32_t i = 0; i < 2; i++){
+        int32_t red = (colors[i] >> 11) & 0x1F;
+        int32_t green = (colors[i] >> 5) & 0x3F;
+        int32_t blue = colors[i] & 0x1F;
+        palette[i][0] = (red << 3) | (red >> 2);
+        palette[i][1] = (green << 2) | (green >> 4);
+        palette[i][2] = (blue << 3) | (blue >> 2);
+        palette[i][3] = 255;
+    }
+
+    if(color0 > color1 || !three_color_mode){
+        for(uint32_t c = 0; c < 3; c++){
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        palette[2][3] = 255;
+        palette[3][3] = 255;
+    }
+    else{
+        for(uint32_t c = 0; c < 3; c++){
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+        palette[2][3] = 255;
+        palette[3][3] = 0;
+    }
+
+    uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+    for(uint32_t p = 0; p < 16; p++){
+        const int32_t* color = palette[(indices >> (p * 2)) & 3];
+        for(uint32_t c = 0; c < 4; c++){
+            pixels[p * 4 + c] = static_cast<uint8_t>(color[c]);
+        }
+    }
+}
+
+void CtBlockDecode::DecodeBc2Alpha(const uint8_t* block, uint8_t* pixels){
+    for(uint32_t p = 0; p < 16; p++){
+        uint32_t alpha = (block[p / 2] >> ((p & 1) * 4)) & 0xF;
+        pixels[p * 4 + 3] = static_cast<uint8_t>(alpha * 17);
+    }
+}
+
+//alpha0 above alpha1 is six values between them, otherwise it's four between and then 0 and 255
+void CtBlockDecode::DecodeBc4(const uint8_t* block, uint32_t channel, uint8_t* pixels){
+    int32_t values[8];
+    values[0] = block[0];
+    values[1] = block[1];
+    if(values[0] > values[1]){
+        for(int32_t i = 2; i < 8; i++){
+            values[i] = ((8 - i) * values[0] + (i - 1) * values[1]) / 7;
+        }
+    }
+    else{
+        for(int32_t i = 2; i < 6; i++){
+            values[i] = ((6 - i) * values[0] + (i - 1) * values[1]) / 5;
+        }
+        values[6] = 0;
+        values[7] = 255;
+    }
+
+    uint64_t indices = 0;
+    for(uint32_t b = 0; b < 6; b++){
+        indices |= static_cast<uint64_t>(block[2 + b]) << (b * 8);
+    }
+    for(uint32_t p = 0; p < 16; p++){
+        pixels[p * 4 + channel] = static_cast<uint8_t>(values[(indices >> (p * 3)) & 7]);
+    }
+}
+
+/****************************************************************ETC2******************************************************************/
+
+//ETC blocks are big endian, and the pixel indices go down each column before moving right. ETC2 hides its T, H and planar modes
+//in differential blocks whose second color would overflow, red for T, green for H and blue for planar
+void CtBlockDecode::DecodeEtc2(const uint8_t* block, bool punch_through, uint8_t* pixels){
+    uint64_t bits = 0;
+    for(uint32_t b = 0; b < 8; b++){
+        bits = (bits << 8) | block[b];
+    }
+
+    auto field = [&](uint32_t low, uint32_t count){
+        return static_cast<int32_t>((bits >> low) & ((1ull << count) - 1));
+    };
+    auto clamp = [](int32_t value){
+        return static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+    };
+    auto extend = [](int32_t value, uint32_t count){
+        return (value << (8 - count)) | (value >> (2 * count - 8));
+    };
+    auto index = [&](uint32_t x, uint32_t y){
+        uint32_t i = x * 4 + y;
+        return static_cast<uint32_t>((field(16 + i, 1) << 1) | field(i, 1));
+    };
+
+    //Punch through blocks use the differential bit to say whether they're opaque. They're never individual
+    bool differential = field(33, 1) != 0;
+    bool opaque = !punch_through || differential;
+
+    int32_t red = field(59, 5);
+    int32_t green = field(51, 5);
+    int32_t blue = field(43, 5);
+    int32_t red_delta = field(56, 3) >= 4 ? field(56, 3) - 8 : field(56, 3);
+    int32_t green_delta = field(48, 3) >= 4 ? field(48, 3) - 8 : field(48, 3);
+    int32_t blue_delta = field(40, 3) >= 4 ? field(40, 3) - 8 : field(40, 3);
+    bool differential_mode = punch_through || differential;
+
+    if(differential_mode && (red + red_delta < 0 || red + red_delta > 31 || green + green_delta < 0 || green + green_delta > 31)){
+        //T and H both pick between four paint colors made from two 4 bit colors and a distance
+        int32_t colors[2][3];
+        int32_t paint[4][3];
+        if(red + red_delta < 0 || red + red_delta > 31){
+            colors[0][0] = extend((field(59, 2) << 2) | field(56, 2), 4);
+            colors[0][1] = extend(field(52, 4), 4);
+            colors[0][2] = extend(field(48, 4), 4);
+            colors[1][0] = extend(field(44, 4), 4);
+            colors[1][1] = extend(field(40, 4), 4);
+            colors[1][2] = extend(field(36, 4), 4);
+            int32_t distance = CT_BLOCK_DECODE_ETC_DISTANCES[(field(34, 2) << 1) | field(32, 1)];
+            for(uint32_t c = 0; c < 3; c++){
+                paint[0][c] = colors[0][c];
+                paint[1][c] = colors[1][c] + distance;
+                paint[2][c] = colors[1][c];
+                paint[3][c] = colors[1][c] - distance;
+            }
+        }
+        else{
+            colors[0][0] = extend(field(59, 4), 4);
+            colors[0][1] = extend((field(56, 3) << 1) | field(52, 1), 4);
+            colors[0][2] = extend((field(51, 1) << 3) | field(47, 3), 4);
+            colors[1][0] = extend(field(43, 4), 4);
+            colors[1][1] = extend(field(39, 4), 4);
+            colors[1][2] = extend(field(35, 4), 4);
+
+            //The last bit of the distance is which color is bigger
+            int32_t first = (colors[0][0] << 16) | (colors[0][1] << 8) | colors[0][2];
+            int32_t second = (colors[1][0] << 16) | (colors[1][1] << 8) | colors[1][2];
+            int32_t distance = CT_BLOCK_DECODE_ETC_DISTANCES[(field(34, 1) << 2) | (field(32, 1) << 1) | (first >= second ? 1 : 0)];
+            for(uint32_t c = 0; c < 3; c++){
+                paint[0][c] = colors[0][c] + distance;
+                paint[1][c] = colors[0][c] - distance;
+                paint[2][c] = colors[1][c] + distance;
+                paint[3][c] = colors[1][c] - distance;
+            }
+        }
+
+        for(uint32_t y = 0; y < 4; y++){
+            for(uint32_t x = 0; x < 4; x++){
+                uint32_t i = index(x, y);
+                uint8_t* pixel = pixels + (y * 4 + x) * 4;
+                if(!opaque && i == 2){
+                    pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0;
+                    continue;
+                }
+                for(uint32_t c = 0; c < 3; c++){
+                    pixel[c] = clamp(paint[i][c]);
+                }
+                pixel[3] = 255;
+            }
+        }
+        return;
+    }
+
+    if(differential_mode && (blue + blue_delta < 0 || blue + blue_delta > 31)){
+        //Planar is a gradient through three colors at the origin, the right and the bottom. It's always opaque
+        int32_t origin[3] = {extend(field(57, 6), 6), extend((field(56, 1) << 6) | field(49, 6), 7),
+            extend((field(48, 1) << 5) | (field(43, 2) << 3) | field(39, 3), 6)};
+        int32_t horizontal[3] = {extend((field(34, 5) << 1) | field(32, 1), 6), extend(field(25, 7), 7), extend(field(19, 6), 6)};
+        int32_t vertical[3] = {extend(field(13, 6), 6), extend(field(6, 7), 7), extend(field(0, 6), 6)};
+
+        for(int32_t y = 0; y < 4; y++){
+            for(int32_t x = 0; x < 4; x++){
+                uint8_t* pixel = pixels + (y * 4 + x) * 4;
+                for(uint32_t c = 0; c < 3; c++){
+                    pixel[c] = clamp((x * (horizontal[c] - origin[c]) + y * (vertical[c] - origin[c]) + 4 * origin[c] + 2) >> 2);
+                }
+                pixel[3] = 255;
+            }
+        }
+        return;
+    }
+
+    //Two halves, side by side or one over the other, each a base color moved by one of its table's four intensities
+    int32_t bases[2][3];
+    if(differential_mode){
+        bases[0][0] = extend(red, 5);
+        bases[0][1] = extend(green, 5);
+        bases[0][2] = extend(blue, 5);
+        bases[1][0] = extend(red + red_delta, 5);
+        bases[1][1] = extend(green + green_delta, 5);
+        bases[1][2] = extend(blue + blue_delta, 5);
+    }
+    else{
+        bases[0][0] = extend(field(60, 4), 4);
+        bases[0][1] = extend(field(52, 4), 4);
+        bases[0][2] = extend(field(44, 4), 4);
+        bases[1][0] = extend(field(56, 4), 4);
+        bases[1][1] = extend(field(48, 4), 4);
+        bases[1][2] = extend(field(40, 4), 4);
+    }
+    int32_t tables[2] = {field(37, 3), field(34, 3)};
+    bool flip = field(32, 1) != 0;
+
+    for(uint32_t y = 0; y < 4; y++){
+        for(uint32_t x = 0; x < 4; x++){
+            uint32_t half = flip ? (y >= 2) : (x >= 2);
+            uint32_t i = index(x, y);
+            uint8_t* pixel = pixels + (y * 4 + x) * 4;
+
+            //Punch through blocks that aren't opaque lose the small positive intensity to transparency and the other small one to 0
+            int32_t modifier = CT_BLOCK_DECODE_ETC_MODIFIERS[tables[half]][i & 1];
+            if(i & 2){
+                modifier = -modifier;
+            }
+            if(!opaque){
+                if(i == 2){
+                    pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0;
+                    continue;
+                }
+                if(i == 0){
+                    modifier = 0;
+                }
+            }
+
+            for(uint32_t c = 0; c < 3; c++){
+                pixel[c] = clamp(bases[half][c] + modifier);
+            }
+            pixel[3] = 255;
+        }
+    }
+}
+
+//A base, a multiplier and a table of eight modifiers. The 11 bit version is for R11 and RG11, where a multiplier of 0 means an eighth
+void CtBlockDecode::DecodeEac(const uint8_t* block, bool eleven_bit, uint32_t channel, uint8_t* pixels){
+    int32_t base = block[0];
+    int32_t multiplier = block[1] >> 4;
+    const int32_t* modifiers = CT_BLOCK_DECODE_EAC_MODIFIERS[block[1] & 0xF];
+
+    uint64_t indices = 0;
+    for(uint32_t b = 2; b < 8; b++){
+        indices = (indices << 8) | block[b];
+    }
+
+    for(uint32_t i = 0; i < 16; i++){
+        int32_t modifier = modifiers[(indices >> (45 - i * 3)) & 7];
+        int32_t value;
+        if(eleven_bit){
+            value = base * 8 + 4 + modifier * (multiplier == 0 ? 1 : multiplier * 8);
+            value = (std::min(std::max(value, 0), 2047) * 255 + 1023) / 2047;
+        }
+        else{
+            value = std::min(std::max(base + modifier * multiplier, 0), 255);
+        }
+
+        uint32_t x = i / 4;
+        uint32_t y = i % 4;
+        pixels[(y * 4 + x) * 4 + channel] = static_cast<uint8_t>(value);
+    }
+}
+
+/****************************************************************ASTC******************************************************************/
+
+//Every block is 128 bits: an 11 bit block mode that says the weight grid's size and range, the partitions and their color endpoint
+//modes, the endpoints from the bottom up and the weights from the top down. Each texel blends its partition's two endpoints by
+//a weight filtered out of the grid
+void CtBlockDecode::DecodeAstc(const uint8_t* block, uint32_t block_width, uint32_t block_height, bool srgb, uint8_t* pixels){
+    uint32_t texel_count = block_width * block_height;
+    auto fill = [&](const uint8_t* color){
+        for(uint32_t t = 0; t < texel_count; t++){
+            memcpy(pixels + t * 4, color, 4);
+        }
+    };
+
+    uint32_t mode = ReadAstcBits(block, 0, 11, 128);
+
+    //Void extent blocks are one 16 bit per channel color for the whole block
+    if((mode & 0x1FF) == 0x1FC){
+        if(mode & 0x200){
+            fill(CT_BLOCK_DECODE_ASTC_ERROR_COLOR);
+            return;
+        }
+        uint8_t color[4];
+        for(uint32_t c = 0; c < 4; c++){
+            color[c] = static_cast<uint8_t>(ReadAstcBits(block, 72 + c * 16, 8, 128));
+        }
+        fill(color);
+        return;
+    }
+
+    uint32_t grid_width = 0;
+    uint32_t grid_height = 0;
+    uint32_t range_bits = (mode >> 4) & 1;
+    bool high_precision = ((mode >> 9) & 1) != 0;
+    bool dual_plane = ((mode >> 10) & 1) != 0;
+    uint32_t a = (mode >> 5) & 3;
+    if((mode & 3) != 0){
+        range_bits |= (mode & 3) << 1;
+        uint32_t b = (mode >> 7) & 3;
+        switch((mode >> 2) & 3){
+            case 0:
+                grid_width = b + 4;
+                grid_height = a + 2;
+                break;
+            case 1:
+                grid_width = b + 8;
+                grid_height = a + 2;
+                break;
+            case 2:
+                grid_width = a + 2;
+                grid_height = b + 8;
+                break;
+            default:
+                if(mode & 0x100){
+                    grid_width = (b & 1) + 2;
+                    grid_height = a + 2;
+                }
+                else{
+                    grid_width = a + 2;
+                    grid_height = (b & 1) + 6;
+                }
+                break;
+        }
+    }
+    else{
+        range_bits |= ((mode >> 2) & 3) << 1;
+        switch((mode >> 7) & 3){
+            case 0:
+                grid_width = 12;
+                grid_height = a + 2;
+                break;
+            case 1:
+                grid_width = a + 2;
+                grid_height = 12;
+                break;
+            case 2:
+                //Bits 9 and 10 are the height here, so neither high precision nor dual plane
+                grid_width = a + 6;
+                grid_height = ((mode >> 9) & 3) + 6;
+                high_precision = false;
+                dual_plane = false;
+                break;
+            default:
+                if(a > 1){
+                    fill(CT_BLOCK_DECODE_ASTC_ERROR_COLOR);
+                    return;
+                }
+                grid_width = a == 0 ? 6 : 10;
+                grid_height = a == 0 ? 10 : 6;
+                break;
+        }
+    }
+
+    //A range of 0 or 1 is reserved, which also catches the all zero block modes
+    if(range_bits < 2){
+        fill(CT_BLOCK_DECODE_ASTC_ERROR_COLOR);
+        return;
+    }
+    uint32_t weight_range = CT_BLOCK_DECODE_ASTC_RANGES[range_bits - 2 + (high_precision ? 6 : 0)];
+    uint32_t plane_count = dual_plane ? 2 : 1;
+    uint32_t weight_count = grid_width * grid_height * plane_count;
+    uint32_t weight_bits = GetAstcIntegerBits(weight_range, weight_count);
+    uint32_t partition_count = ReadAstcBits(block, 11, 2, 128) + 1;
+    if(grid_width > block_width || grid_height > block_height || weight_count > 64 || weight_bits < 24 || weight_bits > 96 ||
+        (partition_count == 4 && dual_plane)){
+        fill(CT_BLOCK_DECODE_ASTC_ERROR_COLOR);
+        return;
+    }
+
+    //With more than one partition they either share a mode or each pick one of two neighbouring classes, with the bits that
+    //don't fit tucked in just under the weights
+    uint32_t modes[4];
+    uint32_t partition_seed = 0;
+    uint32_t color_start = 17;
+    uint32_t extra_bits = 0;
+    if(partition_count == 1){
+        modes[0] = ReadAstcBits(block, 13, 4, 128);
+    }
+    else{
+        partition_seed = ReadAstcBits(block, 13, 10, 128);
+        color_start = 29;
+        uint32_t encoded = ReadAstcBits(block, 23, 6, 128);
+        if((encoded & 3) == 0){
+            for(uint32_t p = 0; p < partition_count; p++){
+                modes[p] = encoded >> 2;
+            }
+        }
+        else{
+            extra_bits = partition_count * 3 - 4;
+            encoded |= ReadAstcBits(block, 128 - weight_bits - extra_bits, extra_bits, 128) << 6;
+            uint32_t base_class = (encoded & 3) - 1;
+            for(uint32_t p = 0; p < partition_count; p++){
+                uint32_t mode_class = base_class + ((encoded >> (2 + p)) & 1);
+                modes[p] = (mode_class << 2) | ((encoded >> (2 + partition_count + p * 2)) & 3);
+            }
+        }
+    }
+
+    //The dual plane channel sits under those, and the colors get whatever's left between the header and there
+    uint32_t color_end = 128 - weight_bits - extra_bits - (dual_plane ? 2 : 0);
+    uint32_t plane_channel = dual_plane ? ReadAstcBits(block, color_end, 2, 128) : 4;
+
+    uint32_t color_count = 0;
+    for(uint32_t p = 0; p < partition_count; p++){
+        color_count += ((modes[p] >> 2) + 1) * 2;
+    }
+    if(color_count > 18 || color_end < color_start){
+        fill(CT_BLOCK_DECODE_ASTC_ERROR_COLOR);
+        return;
+    }
+
+    //The colors use the finest range that fits
+    uint32_t color_range = 20;
+    while(color_range > CT_BLOCK_DECODE_ASTC_MIN_COLOR_RANGE &&
+        GetAstcIntegerBits(CT_BLOCK_DECODE_ASTC_RANGES[color_range], color_count) > color_end - color_start){
+        color_range--;
+    }
+    if(GetAstcIntegerBits(CT_BLOCK_DECODE_ASTC_RANGES[color_range], color_count) > color_end - color_start){
+        fill(CT_BLOCK_DECODE_ASTC_ERROR_COLOR);
+        return;
+    }
+
+    uint32_t color_values[18];
+    DecodeAstcIntegers(block, color_start, color_end, CT_BLOCK_DECODE_ASTC_RANGES[color_range], color_count, color_values);
+    for(uint32_t i = 0; i < color_count; i++){
+        color_values[i] = UnquantizeAstcColor(color_values[i], CT_BLOCK_DECODE_ASTC_RANGES[color_range]);
+    }
+
+    int32_t endpoints[4][2][4];
+    uint32_t next_value = 0;
+    for(uint32_t p = 0; p < partition_count; p++){
+        if(!DecodeAstcEndpoints(modes[p], color_values + next_value, endpoints[p][0], endpoints[p][1])){
+            fill(CT_BLOCK_DECODE_ASTC_ERROR_COLOR);
+            return;
+        }
+        next_value += ((modes[p] >> 2) + 1) * 2;
+    }
+
+    //Weights are read with the whole block bit reversed
+    uint8_t reversed[16];
+    for(uint32_t b = 0; b < 16; b++){
+        uint8_t byte = block[15 - b];
+        byte = static_cast<uint8_t>(((byte & 0xF0) >> 4) | ((byte & 0x0F) << 4));
+        byte = static_cast<uint8_t>(((byte & 0xCC) >> 2) | ((byte & 0x33) << 2));
+        byte = static_cast<uint8_t>(((byte & 0xAA) >> 1) | ((byte & 0x55) << 1));
+        reversed[b] = byte;
+    }
+
+    uint32_t weights[64];
+    DecodeAstcIntegers(reversed, 0, weight_bits, weight_range, weight_count, weights);
+    for(uint32_t i = 0; i < weight_count; i++){
+        weights[i] = UnquantizeAstcWeight(weights[i], weight_range);
+    }
+
+    uint32_t scale_x = (1024 + block_width / 2) / (block_width - 1);
+    uint32_t scale_y = (1024 + block_height / 2) / (block_height - 1);
+    bool small_block = texel_count < 31;
+
+    for(uint32_t y = 0; y < block_height; y++){
+        for(uint32_t x = 0; x < block_width; x++){
+            //Bilinear between the four grid weights around the texel, in sixteenths
+            uint32_t grid_x = (scale_x * x * (grid_width - 1) + 32) >> 6;
+            uint32_t grid_y = (scale_y * y * (grid_height - 1) + 32) >> 6;
+            uint32_t x0 = grid_x >> 4;
+            uint32_t y0 = grid_y >> 4;
+            uint32_t x1 = std::min(x0 + 1, grid_width - 1);
+            uint32_t y1 = std::min(y0 + 1, grid_height - 1);
+            uint32_t fraction_x = grid_x & 0xF;
+            uint32_t fraction_y = grid_y & 0xF;
+            uint32_t weight11 = (fraction_x * fraction_y + 8) >> 4;
+            uint32_t weight10 = fraction_y - weight11;
+            uint32_t weight01 = fraction_x - weight11;
+            uint32_t weight00 = 16 - fraction_x - fraction_y + weight11;
+
+            uint32_t texel_weights[2];
+            for(uint32_t plane = 0; plane < plane_count; plane++){
+                auto grid = [&](uint32_t s, uint32_t t){
+                    return weights[(t * grid_width + s) * plane_count + plane];
+                };
+                texel_weights[plane] = (grid(x0, y0) * weight00 + grid(x1, y0) * weight01 + grid(x0, y1) * weight10 +
+                    grid(x1, y1) * weight11 + 8) >> 4;
+            }
+
+            uint32_t partition = partition_count > 1 ? SelectAstcPartition(partition_seed, x, y, partition_count, small_block) : 0;
+            uint8_t* pixel = pixels + (y * block_width + x) * 4;
+            for(uint32_t c = 0; c < 4; c++){
+                uint32_t weight = c == plane_channel ? texel_weights[1] : texel_weights[0];
+
+                //Endpoints widen to 16 bits before blending. sRGB color fills the bottom with 0x80 instead of copying the top
+                uint32_t endpoint0 = static_cast<uint32_t>(endpoints[partition][0][c]);
+                uint32_t endpoint1 = static_cast<uint32_t>(endpoints[partition][1][c]);
+                if(srgb && c < 3){
+                    endpoint0 = (endpoint0 << 8) | 0x80;
+                    endpoint1 = (endpoint1 << 8) | 0x80;
+                }
+                else{
+                    endpoint0 = (endpoint0 << 8) | endpoint0;
+                    endpoint1 = (endpoint1 << 8) | endpoint1;
+                }
+
+                uint32_t value = (endpoint0 * (64 - weight) + endpoint1 * weight + 32) >> 6;
+                pixel[c] = static_cast<uint8_t>(value >> 8);
+            }
+        }
+    }
+}
+
+uint32_t CtBlockDecode::ReadAstcBits(const uint8_t* data, uint32_t offset, uint32_t count, uint32_t end){
+    uint32_t value = 0;
+    for(uint32_t i = 0; i < count && offset + i < end; i++){
+        value |= ((data[(offset + i) >> 3] >> ((offset + i) & 7)) & 1u) << i;
+    }
+
+    return value;
+}
+
+uint32_t CtBlockDecode::GetAstcIntegerBits(uint32_t range, uint32_t count){
+    uint32_t divisor = range % 3 == 0 ? 3 : (range % 5 == 0 ? 5 : 1);
+    uint32_t bits = 0;
+    while((divisor << bits) < range){
+        bits++;
+    }
+
+    switch(divisor){
+        case 3:
+            return (count * 8 + 4) / 5 + count * bits;
+        case 5:
+            return (count * 7 + 2) / 3 + count * bits;
+        default:
+            return count * bits;
+    }
+}
+
+//Each group of 5 trits or 3 quints is one packed number spread between the groups' low bits
+void CtBlockDecode::DecodeAstcIntegers(const uint8_t* data, uint32_t offset, uint32_t end, uint32_t range, uint32_t count, uint32_t* values){
+    uint32_t divisor = range % 3 == 0 ? 3 : (range % 5 == 0 ? 5 : 1);
+    uint32_t bits = 0;
+    while((divisor << bits) < range){
+        bits++;
+    }
+
+    auto read = [&](uint32_t bit_count){
+        uint32_t value = ReadAstcBits(data, offset, bit_count, end);
+        offset += bit_count;
+        return value;
+    };
+    auto bit = [](uint32_t value, uint32_t position){
+        return (value >> position) & 1;
+    };
+
+    uint32_t i = 0;
+    while(i < count){
+        uint32_t low[5];
+        uint32_t digits[5];
+        uint32_t group = 1;
+        if(divisor == 3){
+            group = 5;
+            low[0] = read(bits);
+            uint32_t packed = read(2);
+            low[1] = read(bits);
+            packed |= read(2) << 2;
+            low[2] = read(bits);
+            packed |= read(1) << 4;
+            low[3] = read(bits);
+            packed |= read(2) << 5;
+            low[4] = read(bits);
+            packed |= read(1) << 7;
+
+            uint32_t rest;
+            if(((packed >> 2) & 7) == 7){
+                rest = ((packed >> 5) << 2) | (packed & 3);
+                digits[4] = 2;
+                digits[3] = 2;
+            }
+            else{
+                rest = packed & 0x1F;
+                if(((packed >> 5) & 3) == 3){
+                    digits[4] = 2;
+                    digits[3] = bit(packed, 7);
+                }
+                else{
+                    digits[4] = bit(packed, 7);
+                    digits[3] = (packed >> 5) & 3;
+                }
+            }
+            if((rest & 3) == 3){
+                digits[2] = 2;
+                digits[1] = bit(rest, 4);
+                digits[0] = (bit(rest, 3) << 1) | (bit(rest, 2) & (bit(rest, 3) ^ 1));
+            }
+            else if(((rest >> 2) & 3) == 3){
+                digits[2] = 2;
+                digits[1] = 2;
+                digits[0] = rest & 3;
+            }
+            else{
+                digits[2] = bit(rest, 4);
+                digits[1] = (rest >> 2) & 3;
+                digits[0] = (bit(rest, 1) << 1) | (bit(rest, 0) & (bit(rest, 1) ^ 1));
+            }
+        }
+        else if(divisor == 5){
+            group = 3;
+            low[0] = read(bits);
+            uint32_t packed = read(3);
+            low[1] = read(bits);
+            packed |= read(2) << 3;
+            low[2] = read(bits);
+            packed |= read(2) << 5;
+
+            if(((packed >> 1) & 3) == 3 && ((packed >> 5) & 3) == 0){
+                uint32_t not_q0 = bit(packed, 0) ^ 1;
+                digits[2] = (bit(packed, 0) << 2) | ((bit(packed, 4) & not_q0) << 1) | (bit(packed, 3) & not_q0);
+                digits[1] = 4;
+                digits[0] = 4;
+            }
+            else{
+                uint32_t rest;
+                if(((packed >> 1) & 3) == 3){
+                    digits[2] = 4;
+                    rest = (((packed >> 3) & 3) << 3) | ((~(packed >> 5) & 3) << 1) | (packed & 1);
+                }
+                else{
+                    digits[2] = (packed >> 5) & 3;
+                    rest = packed & 0x1F;
+                }
+                if((rest & 7) == 5){
+                    digits[1] = 4;
+                    digits[0] = (rest >> 3) & 3;
+                }
+                else{
+                    digits[1] = (rest >> 3) & 3;
+                    digits[0] = rest & 7;
+                }
+            }
+        }
+        else{
+            low[0] = read(bits);
+            digits[0] = 0;
+        }
+
+        for(uint32_t j = 0; j < group && i < count; j++){
+            values[i++] = (digits[j] << bits) | low[j];
+        }
+    }
+}
+
+//Plain bits get their top bits copied down. Trits and quints scale the digit and mix in the low bits in a fixed pattern per range
+uint32_t CtBlockDecode::UnquantizeAstcColor(uint32_t value, uint32_t range){
+    uint32_t divisor = range % 3 == 0 ? 3 : (range % 5 == 0 ? 5 : 1);
+    uint32_t bits = 0;
+    while((divisor << bits) < range){
+        bits++;
+    }
+
+    if(divisor == 1){
+        uint32_t result = 0;
+        for(uint32_t filled = 0; filled < 8; filled += bits){
+            result = (result << bits) | value;
+        }
+        return (result >> (((8 + bits - 1) / bits) * bits - 8)) & 0xFF;
+    }
+
+    uint32_t digit = value >> bits;
+    uint32_t low = value & ((1u << bits) - 1);
+    uint32_t a = (low & 1) ? 0x1FF : 0;
+    uint32_t v = low >> 1;
+    uint32_t b = 0;
+    uint32_t c = 0;
+    if(divisor == 3){
+        switch(bits){
+            case 1: c = 204; break;
+            case 2: b = v * 0x116; c = 93; break;
+            case 3: b = v * 0x85; c = 44; break;
+            case 4: b = v * 0x41; c = 22; break;
+            case 5: b = (v << 5) | (v >> 2); c = 11; break;
+            default: b = (v << 4) | (v >> 4); c = 5; break;
+        }
+    }
+    else{
+        switch(bits){
+            case 1: c = 113; break;
+            case 2: b = v * 0x10C; c = 54; break;
+            case 3: b = (v << 7) | (v << 1) | (v >> 1); c = 26; break;
+            case 4: b = (v << 6) | (v >> 1); c = 13; break;
+            default: b = (v << 5) | (v >> 3); c = 6; break;
+        }
+    }
+
+    uint32_t result = (digit * c + b) ^ a;
+    return (a & 0x80) | (result >> 2);
+}
+
+//The same as colors but to 0-64, with anything above the middle moved up one so 64 is reachable
+uint32_t CtBlockDecode::UnquantizeAstcWeight(uint32_t value, uint32_t range){
+    uint32_t divisor = range % 3 == 0 ? 3 : (range % 5 == 0 ? 5 : 1);
+    uint32_t bits = 0;
+    while((divisor << bits) < range){
+        bits++;
+    }
+
+    uint32_t result;
+    if(divisor == 1){
+        result = 0;
+        for(uint32_t filled = 0; filled < 6; filled += bits){
+            result = (result << bits) | value;
+        }
+        result = (result >> (((6 + bits - 1) / bits) * bits - 6)) & 0x3F;
+    }
+    else if(bits == 0){
+        return value * 64 / (range - 1);
+    }
+    else{
+        uint32_t digit = value >> bits;
+        uint32_t low = value & ((1u << bits) - 1);
+        uint32_t a = (low & 1) ? 0x7F : 0;
+        uint32_t v = low >> 1;
+        uint32_t b = 0;
+        uint32_t c = 0;
+        if(divisor == 3){
+            switch(bits){
+                case 1: c = 50; break;
+                case 2: b = v * 0x45; c = 23; break;
+                default: b = v * 0x21; c = 11; break;
+            }
+        }
+        else{
+            switch(bits){
+                case 1: c = 28; break;
+                default: b = v * 0x42; c = 13; break;
+            }
+        }
+        result = (a & 0x20) | (((digit * c + b) ^ a) >> 2);
+    }
+
+    return result > 32 ? result + 1 : result;
+}
+
+//Base and offset modes store the offset's top bit in the base. Endpoints whose offsets add up negative get their blue pulled in
+//towards red and green, which buys precision for colors near gray
+bool CtBlockDecode::DecodeAstcEndpoints(uint32_t mode, const uint32_t* values, int32_t* endpoint0, int32_t* endpoint1){
+    int32_t v[8];
+    for(uint32_t i = 0; i < 8; i++){
+        v[i] = i < ((mode >> 2) + 1) * 2 ? static_cast<int32_t>(values[i]) : 0;
+    }
+
+    auto set = [](int32_t* endpoint, int32_t red, int32_t green, int32_t blue, int32_t alpha){
+        endpoint[0] = red;
+        endpoint[1] = green;
+        endpoint[2] = blue;
+        endpoint[3] = alpha;
+    };
+    auto blue_contract = [](int32_t* endpoint, int32_t red, int32_t green, int32_t blue, int32_t alpha){
+        endpoint[0] = (red + blue) >> 1;
+        endpoint[1] = (green + blue) >> 1;
+        endpoint[2] = blue;
+        endpoint[3] = alpha;
+    };
+    auto bit_transfer = [](int32_t& offset, int32_t& base){
+        base >>= 1;
+        base |= offset & 0x80;
+        offset >>= 1;
+        offset &= 0x3F;
+        if(offset & 0x20){
+            offset -= 0x40;
+        }
+    };
+
+    switch(mode){
+        case 0:
+            set(endpoint0, v[0], v[0], v[0], 255);
+            set(endpoint1, v[1], v[1], v[1], 255);
+            break;
+        case 1:{
+            int32_t low = (v[0] >> 2) | (v[1] & 0xC0);
+            int32_t high = std::min(low + (v[1] & 0x3F), 255);
+            set(endpoint0, low, low, low, 255);
+            set(endpoint1, high, high, high, 255);
+            break;
+        }
+        case 4:
+            set(endpoint0, v[0], v[0], v[0], v[2]);
+            set(endpoint1, v[1], v[1], v[1], v[3]);
+            break;
+        case 5:
+            bit_transfer(v[1], v[0]);
+            bit_transfer(v[3], v[2]);
+            set(endpoint0, v[0], v[0], v[0], v[2]);
+            set(endpoint1, v[0] + v[1], v[0] + v[1], v[0] + v[1], v[2] + v[3]);
+            break;
+        case 6:
+            set(endpoint0, (v[0] * v[3]) >> 8, (v[1] * v[3]) >> 8, (v[2] * v[3]) >> 8, 255);
+            set(endpoint1, v[0], v[1], v[2], 255);
+            break;
+        case 8:
+        case 12:{
+            int32_t alpha0 = mode == 12 ? v[6] : 255;
+            int32_t alpha1 = mode == 12 ? v[7] : 255;
+            if(v[1] + v[3] + v[5] >= v[0] + v[2] + v[4]){
+                set(endpoint0, v[0], v[2], v[4], alpha0);
+                set(endpoint1, v[1], v[3], v[5], alpha1);
+            }
+            else{
+                blue_contract(endpoint0, v[1], v[3], v[5], alpha1);
+                blue_contract(endpoint1, v[0], v[2], v[4], alpha0);
+            }
+            break;
+        }
+        case 9:
+        case 13:{
+            bit_transfer(v[1], v[0]);
+            bit_transfer(v[3], v[2]);
+            bit_transfer(v[5], v[4]);
+            if(mode == 13){
+                bit_transfer(v[7], v[6]);
+            }
+            int32_t alpha0 = mode == 13 ? v[6] : 255;
+            int32_t alpha1 = mode == 13 ? v[6] + v[7] : 255;
+            if(v[1] + v[3] + v[5] >= 0){
+                set(endpoint0, v[0], v[2], v[4], alpha0);
+                set(endpoint1, v[0] + v[1], v[2] + v[3], v[4] + v[5], alpha1);
+            }
+            else{
+                blue_contract(endpoint0, v[0] + v[1], v[2] + v[3], v[4] + v[5], alpha1);
+                blue_contract(endpoint1, v[0], v[2], v[4], alpha0);
+            }
+            break;
+        }
+        case 10:
+            set(endpoint0, (v[0] * v[3]) >> 8, (v[1] * v[3]) >> 8, (v[2] * v[3]) >> 8, v[4]);
+            set(endpoint1, v[0], v[1], v[2], v[5]);
+            break;
+        default:
+            return false;
+    }
+
+    for(uint32_t c = 0; c < 4; c++){
+        endpoint0[c] = std::min(std::max(endpoint0[c], 0), 255);
+        endpoint1[c] = std::min(std::max(endpoint1[c], 0), 255);
+    }
+
+    return true;
+}
+
+//The spec's hash of the partition pattern index into four lines through the block. Each texel goes to whichever line is highest.
+//Blocks under 31 texels count in half steps so small blocks get patterns as varied as big ones
+uint32_t CtBlockDecode::SelectAstcPartition(uint32_t seed, uint32_t x, uint32_t y, uint32_t partition_count, bool small_block){
+    if(small_block){
+        x <<= 1;
+        y <<= 1;
+    }
+
+    seed += (partition_count - 1) * 1024;
+    uint32_t hash = seed;
+    hash ^= hash >> 15;
+    hash -= hash << 17;
+    hash += hash << 7;
+    hash += hash << 4;
+    hash ^= hash >> 5;
+    hash += hash << 16;
+    hash ^= hash >> 7;
+    hash ^= hash >> 3;
+    hash ^= hash << 6;
+    hash ^= hash >> 17;
+
+    uint32_t shift1;
+    uint32_t shift2;
+    if(seed & 1){
+        shift1 = (seed & 2) ? 4 : 5;
+        shift2 = partition_count == 3 ? 6 : 5;
+    }
+    else{
+        shift1 = partition_count == 3 ? 6 : 5;
+        shift2 = (seed & 2) ? 4 : 5;
+    }
+
+    uint32_t slopes[8];
+    for(uint32_t i = 0; i < 8; i++){
+        uint32_t nibble = (hash >> (i * 4)) & 0xF;
+        slopes[i] = (nibble * nibble) >> ((i & 1) ? shift2 : shift1);
+    }
+
+    uint32_t lines[4] = {
+        (slopes[0] * x + slopes[1] * y + (hash >> 14)) & 0x3F,
+        (slopes[2] * x + slopes[3] * y + (hash >> 10)) & 0x3F,
+        (slopes[4] * x + slopes[5] * y + (hash >> 6)) & 0x3F,
+        (slopes[6] * x + slopes[7] * y + (hash >> 2)) & 0x3F
+    };
+    for(uint32_t p = partition_count; p < 4; p++){
+        lines[p] = 0;
+    }
+
+    if(lines[0] >= lines[1] && lines[0] >= lines[2] && lines[0] >= lines[3]){
+        return 0;
+    }
+    if(lines[1] >= lines[2] && lines[1] >= lines[3]){
+        return 1;
+    }
+    if(lines[2] >= lines[3]){
+        return 2;
+    }
+    return 3;
+}
@@ -0,0 +1,53 @@
+#include <vulkan/vulkan.h>
+#include <cstdint>
+
+struct CtImageData;
+
+//Decodes block compressed data back into RGBA8, for KTX2 files in a format the device can't sample. ASTC on a desktop GPU or BC
+//on a phone gets decoded here and then prepared like any PNG would be. Reads BC1 to BC5, ETC2 and EAC, and every 2D ASTC LDR
+//block size. BC6H, BC7 and the signed formats aren't in here. Everything in here is plain CPU work, so it can run on any thread
+class CtBlockDecode{
+
+    public:
+        //data is one level, rows of blocks from the top with the partial blocks at the edges counted whole. False for a format
+        //there's no decoder for. sRGB formats come out as sRGB bytes, the same as a PNG meant for color
+        static bool Decode(VkFormat format, const uint8_t* data, uint32_t width, uint32_t height, CtImageData& image);
+
+        //The formats whose texels are sRGB encoded color
+        static bool IsSrgb(VkFormat format);
+
+    private:
+        //pixels is the block's texels as RGBA8, row by row
+
+        //A BC1 color block. BC2 and BC3 always use the four color mode, only BC1 has the three colors and transparent black one
+        static void DecodeBc1(const uint8_t* block, bool three_color_mode, uint8_t* pixels);
+        static void DecodeBc2Alpha(const uint8_t* block, uint8_t* pixels);
+
+        //BC4 into one channel. BC3's alpha is the same block
+        static void DecodeBc4(const uint8_t* block, uint32_t channel, uint8_t* pixels);
+
+        //ETC2 RGB, with one bit alpha if punch_through
+        static void DecodeEtc2(const uint8_t* block, bool punch_through, uint8_t* pixels);
+
+        //EAC into one channel, 8 bit for ETC2's alpha or 11 bit for R11 and RG11
+        static void DecodeEac(const uint8_t* block, bool eleven_bit, uint32_t channel, uint8_t* pixels);
+
+        //Anything the block says that LDR can't do (HDR endpoints, reserved modes, too many weights) comes out magenta
+        static void DecodeAstc(const uint8_t* block, uint32_t block_width, uint32_t block_height, bool srgb, uint8_t* pixels);
+
+        //count bits from offset, least significant first. Bits from end on read as 0, which is how a short last group is padded
+        static uint32_t ReadAstcBits(const uint8_t* data, uint32_t offset, uint32_t count, uint32_t end);
+
+        //ASTC packs values of range 3 or 5 times a power of two as trits or quints shared across groups of 5 or 3 values
+        static uint32_t GetAstcIntegerBits(uint32_t range, uint32_t count);
+        static void DecodeAstcIntegers(const uint8_t* data, uint32_t offset, uint32_t end, uint32_t range, uint32_t count, uint32_t* values);
+
+        //Back up to 0-255 for colors and 0-64 for weights
+        static uint32_t UnquantizeAstcColor(uint32_t value, uint32_t range);
+        static uint32_t UnquantizeAstcWeight(uint32_t value, uint32_t range);
+
+        //False for the HDR modes
+        static bool DecodeAstcEndpoints(uint32_t mode, const uint32_t* values, int32_t* endpoint0, int32_t* endpoint1);
+
+        static uint32_t SelectAstcPartition(uint32_t seed, uint32_t x, uint32_t y, uint32_t partition_count, bool small_block);
+};
@@ -0,0 +1,167 @@
+#include "CtClusterCulling.h"
+#include "CtDevice.h"
+#include "CtComputePipeline.h"
+#include "CtInstanceData.h"
+#include "CtMeshStore.h"
+#include "CtDrawBatcher.h"
+#include "CtDescriptorAllocator.h"
+#include <stdexcept>
+#include <cstring>
+#include <vector>
+
+//One clustered object as cluster_cull.comp reads it
+struct CtClusterObject{
+    CtInstanceData instance;
+    glm::vec4 bounds;
+    uint32_t first_cluster;
+    uint32_t cluster_count;
+    uint32_t command;
+    uint32_t count;
+    uint32_t first_instance;
+    uint32_t padding[3];
+};
+
+//Has to match the push constant block in cluster_cull.comp
+struct CtClusterConstants{
+    glm::mat4 view_projection;
+    glm::vec4 camera;
+    uint32_t object_base;
+    uint32_t object_count;
+    uint32_t command_base;
+    uint32_t count_base;
+};
+
+CtClusterCulling* CtClusterCulling::CreateClusterCulling(CtDevice* device, CtMeshStore* mesh_store, CtDrawBatcher* draw_batcher,
+    CtDescriptorAllocator* descriptor_allocator, const std::string& cluster_shader_file, uint32_t max_objects, uint32_t max_frames_in_flight){
+
+    CtClusterCulling* ct_cluster_culling = new CtClusterCulling();
+
+    ct_cluster_culling->device = device;
+    ct_cluster_culling->mesh_store = mesh_store;
+    ct_cluster_culling->draw_batcher = draw_batcher;
+    ct_cluster_culling->descriptor_allocator = descriptor_allocator;
+    ct_cluster_culling->max_objects = max_objects;
+    ct_cluster_culling->current_frame = 0;
+
+    VkPhysicalDeviceProperties properties {};
+    vkGetPhysicalDeviceProperties(*(device->GetPhysicalDevice()), &properties);
+    ct_cluster_culling->max_group_count = properties.limits.maxComputeWorkGroupCount[0];
+
+    ct_cluster_culling->CreateObjectBuffer(max_frames_in_flight);
+
+    //Objects, the mesh store's clusters, the indirect commands and the draw counts
+    ct_cluster_culling->cluster_pipeline = CtComputePipeline::CreateComputePipeline(device, cluster_shader_file, {
+        {0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER},
+        {1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER},
+        {2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER},
+        {3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}
+    });
+
+    draw_batcher->SetClusterCulled(true);
+
+    printf("Created Cluster Culling.\n");
+
+    return ct_cluster_culling;
+}
+
+void CtClusterCulling::BeginFrame(uint32_t frame){
+    current_frame = frame;
+}
+
+/**************************************************************RECORDING*****************************************************************/
+
+void CtClusterCulling::RecordCull(VkCommandBuffer command_buffer, const glm::mat4& view_projection, const glm::vec4& camera){
+    const std::vector<CtInstanceData>& instances = draw_batcher->GetClusterInstances();
+    const std::vector<CtClusterCandidate>& candidates = draw_batcher->GetClusterCandidates();
+    uint32_t object_count = static_cast<uint32_t>(candidates.size());
+
+    if(object_count == 0){
+        return;
+    }
+    if(object_count > max_objects){
+        throw std::runtime_error("Too many clustered objects to cull in one frame. Give cluster culling more objects.");
+    }
+
+    CtClusterObject* objects = reinterpret_cast<CtClusterObject*>(mapped_objects) + static_cast<size_t>(max_objects) * current_frame;
+    for(uint32_t i = 0; i < object_count; i++){
+        const CtMeshRange& mesh = mesh_store->GetMesh(candidates[i].mesh_id);
+
+        objects[i].instance = instances[i];
+        objects[i].bounds = mesh.bounds;
+        objects[i].first_cluster = mesh.first_cluster;
+        objects[i].cluster_count = mesh.cluster_count;
+        objects[i].command = candidates[i].command;
+        objects[i].count = candidates[i].count;
+        objects[i].first_instance = candidates[i].first_instance;
+    }
+
+    //Bound whole with the frame's regions picked by the bases, same as CtGpuCulling
+    VkDescriptorSet cluster_set = cluster_pipeline->AllocateSet(descriptor_allocator);
+    cluster_pipeline->WriteStorageBuffer(cluster_set, 0, object_buffer);
+    cluster_pipeline->WriteStorageBuffer(cluster_set, 1, mesh_store->GetClusterBuffer());
+    cluster_pipeline->WriteStorageBuffer(cluster_set, 2, draw_batcher->GetIndirectBuffer());
+    cluster_pipeline->WriteStorageBuffer(cluster_set, 3, draw_batcher->GetCountBuffer());
+
+    CtClusterConstants constants {};
+    constants.view_projection = view_projection;
+    constants.camera = camera;
+    constants.object_base = max_objects * current_frame;
+    constants.object_count = object_count;
+    constants.command_base = draw_batcher->GetCommandBase();
+    constants.count_base = draw_batcher->GetCountBase();
+
+    cluster_pipeline->Bind(command_buffer, cluster_set);
+    cluster_pipeline->PushConstants(command_buffer, constants);
+
+    uint32_t group_count_x = object_count < max_group_count ? object_count : max_group_count;
+    cluster_pipeline->Dispatch(command_buffer, group_count_x, (object_count + group_count_x - 1) / group_count_x, 1);
+}
+
+/**************************************************************BUFFERS*****************************************************************/
+
+void CtClusterCulling::CreateObjectBuffer(uint32_t max_frames_in_flight){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+    VkDeviceSize size = static_cast<VkDeviceSize>(max_objects) * max_frames_in_flight * sizeof(CtClusterObject);
+
+    VkBufferCreateInfo buffer_info {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = size;
+    buffer_info.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if(vkCreateBuffer(interface_device, &buffer_info, nullptr, &object_buffer) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create the cluster object buffer.");
+    }
+
+    VkMemoryRequirements memory_requirements;
+    vkGetBufferMemoryRequirements(interface_device, object_buffer, &memory_requirements);
+
+    VkMemoryAllocateInfo allocate_info {};
+    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocate_info.allocationSize = memory_requirements.size;
+    allocate_info.memoryTypeIndex = device->FindMemoryType(memory_requirements.memoryTypeBits,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    if(vkAllocateMemory(interface_device, &allocate_info, nullptr, &object_buffer_memory) != VK_SUCCESS){
+        throw std::runtime_error("Failed to allocate the cluster object buffer.");
+    }
+
+    vkBindBufferMemory(interface_device, object_buffer, object_buffer_memory, 0);
+
+    void* data;
+    if(vkMapMemory(interface_device, object_buffer_memory, 0, size, 0, &data) != VK_SUCCESS){
+        throw std::runtime_error("Failed to map the cluster object buffer.");
+    }
+    mapped_objects = static_cast<uint8_t*>(data);
+}
+
+void CtClusterCulling::Cleanup(){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    cluster_pipeline->Cleanup();
+    delete cluster_pipeline;
+
+    vkUnmapMemory(interface_device, object_buffer_memory);
+    vkDestroyBuffer(interface_device, object_buffer, nullptr);
+    vkFreeMemory(interface_device, object_buffer_memory, nullptr);
+}
@@ -0,0 +1,51 @@
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <string>
+#include <cstdint>
+
+class CtDevice;
+class CtMeshStore;
+class CtDrawBatcher;
+class CtDescriptorAllocator;
+class CtComputePipeline;
+
+//Culls dense meshes a meshlet at a time instead of as a whole. Every clustered object the batcher was given gets a workgroup that tests
+//the object's sphere first and then each of its clusters against the frustum and against its normal cone, so clusters that face away from
+//the camera go too. Every cluster that's left becomes its own draw in its run, which means vertex work follows what's on screen and not how
+//many triangles the mesh has
+class CtClusterCulling{
+
+    public:
+        static CtClusterCulling* CreateClusterCulling(CtDevice* device, CtMeshStore* mesh_store, CtDrawBatcher* draw_batcher,
+            CtDescriptorAllocator* descriptor_allocator, const std::string& cluster_shader_file, uint32_t max_objects, uint32_t max_frames_in_flight);
+
+        void BeginFrame(uint32_t frame);
+
+        //Uploads the batcher's cluster candidates and culls them into its cluster runs. Record before the pass that draws them.
+        //camera is the camera's world position with w = 1, or the way an orthographic camera looks with w = 0
+        void RecordCull(VkCommandBuffer command_buffer, const glm::mat4& view_projection, const glm::vec4& camera);
+
+        void Cleanup();
+
+    private:
+
+        CtDevice* device;
+        CtMeshStore* mesh_store;
+        CtDrawBatcher* draw_batcher;
+        CtDescriptorAllocator* descriptor_allocator;
+
+        //What goes into the culling pass, one region per frame in flight
+        VkBuffer object_buffer;
+        VkDeviceMemory object_buffer_memory;
+        uint8_t* mapped_objects;
+        uint32_t max_objects;
+        uint32_t current_frame;
+
+        //One workgroup per object, so past this many they wrap onto a second dimension
+        uint32_t max_group_count;
+
+        CtComputePipeline* cluster_pipeline;
+
+        void CreateObjectBuffer(uint32_t max_frames_in_flight);
+};
@@ -7,6 +7,25 @@
 #include "CtGraphicsPipeline.h"
 #include "CtVertex.h"
 #include "CtQueueFamily.h"
+#include "CtRenderGraph.h"
+#include "CtBindlessTable.h"
+#include "CtDescriptorAllocator.h"
+#include "CtUniformRing.h"
+#include "CtInstanceBuffer.h"
+#include "CtInstanceData.h"
+#include "CtMeshStore.h"
+#include "CtDrawBatcher.h"
+#include "CtRenderSnapshot.h"
+#include "CtGltfImport.h"
+#include "CtTextureStore.h"
+#include "CtTextureStreamer.h"
+
+//What every draw gets through the dynamic uniform buffer. Has to match the UBO in the vertex shader. Instances carry their own
+//transform and color on top of this, so for an instanced draw this is whatever the whole batch shares
+struct CtDrawUniforms{
+    glm::mat4 transform;
+    glm::vec4 color;
+};
 
 void CtRenderer::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, VkDeviceMemory &buffer_memory){
     VkDevice interface_device = *(device->GetInterfaceDevice());
@@ -117,126 +136,157 @@ void CtRenderer::EndSingleTimeCommands(VkCommandBuffer command_buffer){
     vkFreeCommandBuffers(interface_device, command_pool, 1, &command_buffer);
 }
 
-void CtRenderer::CreateVertexBuffer(){
-    VkDevice interface_device = *(device->GetInterfaceDevice());
-
-    VkDeviceSize buffer_size = sizeof(test_vertices[0]) * test_vertices.size();
-
-    VkBuffer staging_buffer;
-    VkDeviceMemory staging_buffer_memory;
-    CreateBuffer(buffer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging_buffer, staging_buffer_memory);
-
-    void *data;
-    vkMapMemory(interface_device, staging_buffer_memory, 0, buffer_size, 0, &data);
-    memcpy(data, test_vertices.data(), (size_t)buffer_size);
-    vkUnmapMemory(interface_device, staging_buffer_memory);
-
-    CreateBuffer(buffer_size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertex_buffer, vertex_buffer_memory);
+//The test mesh is the only mesh there is for now. It goes into the mesh store like any other would
+void CtRenderer::CreateTestMesh(){
+    test_mesh = mesh_store->AddMesh(test_vertices, test_indices);
+    main_bucket = draw_batcher->AddBucket();
+    scene_meshes.push_back(test_mesh);
 
-    CopyBuffer(staging_buffer, vertex_buffer, buffer_size);
-
-    vkDestroyBuffer(interface_device, staging_buffer, nullptr);
-    vkFreeMemory(interface_device, staging_buffer_memory, nullptr);
-
-    printf("Created Vertex Buffer.\n");
+    printf("Created Test Mesh.\n");
 }
 
-void CtRenderer::CreateIndexBuffer(){
-    VkDevice interface_device = *(device->GetInterfaceDevice());
-
-    VkDeviceSize buffer_size = sizeof(test_indices[0]) * test_indices.size();
-
-    VkBuffer staging_buffer;
-    VkDeviceMemory staging_buffer_memory;
-    CreateBuffer(buffer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging_buffer, staging_buffer_memory);
-
-    void *data;
-    vkMapMemory(interface_device, staging_buffer_memory, 0, buffer_size, 0, &data);
-    memcpy(data, test_indices.data(), (size_t)buffer_size);
-    vkUnmapMemory(interface_device, staging_buffer_memory);
+void CtRenderer::LoadMeshFiles(const std::vector<std::string>& mesh_files){
+    for(const auto& mesh_file : mesh_files){
+        scene_meshes.push_back(mesh_store->LoadMesh(mesh_file));
+    }
+}
 
-    CreateBuffer(buffer_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, index_buffer, index_buffer_memory);
+//glTF scenes go straight into the mesh store a primitive at a time, so only a few are ever in memory however big the file is
+void CtRenderer::LoadSceneFiles(const std::vector<std::string>& scene_files){
+    for(const auto& scene_file : scene_files){
+        CtGltfScene scene = CtGltfImport::Load(scene_file, mesh_store, true);
+        for(const auto& object : scene.objects){
+            scene_objects.push_back({object.transform, object.color, object.mesh_id});
+        }
+    }
+}
 
-    CopyBuffer(staging_buffer, index_buffer, buffer_size);
+//Decoded in parallel, uploaded and mipped one at a time. Everything in texture_files is color, so it's all sRGB.
+//Streamed ones start at their baseline, and nothing draws with them yet, so that's where they stay until materials ask for more
+void CtRenderer::LoadTextureFiles(const std::vector<std::string>& texture_files){
+    if(texture_files.empty()){
+        return;
+    }
 
-    vkDestroyBuffer(interface_device, staging_buffer, nullptr);
-    vkFreeMemory(interface_device, staging_buffer_memory, nullptr);
+    if(texture_streamer != nullptr){
+        scene_textures = texture_streamer->LoadTextures(texture_files, true);
+        return;
+    }
 
-    printf("Created Index Buffer.\n");
+    scene_textures = texture_store->LoadTextures(texture_files, true);
 }
 
 //This probably pulls from the most external classes
-void CtRenderer::RecordCommandBuffer(VkCommandBuffer command_buffer, uint32_t image_index){
+void CtRenderer::RecordCommandBuffers(uint32_t image_index){
+
+    BatchDraws();
+
+    //Everything between begin and end is the render graph now, we just have to tell it which swapchain image we got
+    render_graph->SetImportedImage(swapchain_resource, swapchain->swapchain_images[image_index], swapchain->swapchain_image_views[image_index]);
+
+    //Each submission the graph was split into gets its own command buffer
+    for(uint32_t i = 0; i < render_graph->GetSubmissionCount(); i++){
+        VkCommandBuffer command_buffer = command_buffers[current_frame][i];
+
+        vkResetCommandBuffer(command_buffer, 0);
+
+        //Let's start creating the command buffer
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = 0;
+        begin_info.pInheritanceInfo = nullptr;
+
+        if(vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS){
+            throw std::runtime_error("Failed to begin recording to command buffer.");
+        }
+
+        render_graph->ExecuteSubmission(i, command_buffer);
+
+        VkResult result = vkEndCommandBuffer(command_buffer);
+
+        switch(result){
+            case VK_SUCCESS:
+                //do nothing
+                break;
+            case VK_ERROR_OUT_OF_HOST_MEMORY:
+                throw std::runtime_error("Failure to end command buffer. Host is out of memory.\n");
+                break;
+            case VK_ERROR_OUT_OF_DEVICE_MEMORY:
+                throw std::runtime_error("Failure to end command buffer. Device is out of memory.\n");
+                break;
+            default:
+                throw std::runtime_error("Failed to end command buffer.\n");
+                break;
+        }
+    }
+}
 
-    //Let's start creating the command buffer
-    VkCommandBufferBeginInfo begin_info{};
-    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    begin_info.flags = 0;
-    begin_info.pInheritanceInfo = nullptr;
+//The graph has already begun the render pass and set the viewport and scissor by the time this runs
+void CtRenderer::RecordMainPass(VkCommandBuffer command_buffer){
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline->graphics_pipeline);
 
-    if(vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS){
-        throw std::runtime_error("Failed to begin recording to command buffer.");
-    }
+    //Every mesh lives in the batcher's shared buffers, so this is the only vertex and index binding the pass needs
+    draw_batcher->Bind(command_buffer);
 
-    VkRenderPassBeginInfo render_pass_info{};
-    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    render_pass_info.renderPass = graphics_pipeline->render_pass;
-    render_pass_info.framebuffer = swapchain->swapchain_framebuffers[image_index];
-    render_pass_info.renderArea.offset = {0, 0};
-    render_pass_info.renderArea.extent = swapchain->swapchain_extent;
-
-    //The clear values
-    std::array<VkClearValue, 2> clear_values{};
-    clear_values[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
-    clear_values[1].depthStencil = {1.0f, 0};
-
-    render_pass_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
-    render_pass_info.pClearValues = clear_values.data();
-
-    vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
-
-    VkViewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = static_cast<float>(swapchain->swapchain_extent.width);
-    viewport.height = static_cast<float>(swapchain->swapchain_extent.height);
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
-
-    VkRect2D scissor{};
-    scissor.offset = {0, 0};
-    scissor.extent = swapchain->swapchain_extent;
-    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+    //Set 0 only has to live for this frame, so it comes straight out of the frame's pools. It points at one draw's worth of the
+    //uniform ring, and each draw slides that window along with its dynamic offset
+    VkDescriptorSet frame_set = descriptor_allocator->Allocate(graphics_pipeline->descriptor_set_layout);
 
-    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline->graphics_pipeline);
+    VkDescriptorBufferInfo uniform_info {};
+    uniform_info.buffer = uniform_ring->GetBuffer();
+    uniform_info.offset = 0;
+    uniform_info.range = sizeof(CtDrawUniforms);
 
-    VkBuffer vertex_buffers[] = {vertex_buffer};
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(command_buffer, 0, 1, vertex_buffers, offsets);
+    VkWriteDescriptorSet uniform_write {};
+    uniform_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    uniform_write.dstSet = frame_set;
+    uniform_write.dstBinding = 0;
+    uniform_write.dstArrayElement = 0;
+    uniform_write.descriptorCount = 1;
+    uniform_write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    uniform_write.pBufferInfo = &uniform_info;
 
-    vkCmdBindIndexBuffer(command_buffer, index_buffer, 0, VK_INDEX_TYPE_UINT16);
+    vkUpdateDescriptorSets(*(device->GetInterfaceDevice()), 1, &uniform_write, 0, nullptr);
 
-    // vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline->pipeline_layout, 0, 1, &descriptor_sets[current_frame], 0, nullptr);
+    //The bindless set gets bound once for the pass, after that a draw only has to say which slots it wants
+    if(graphics_pipeline->uses_bindless){
+        bindless_table->Bind(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline->pipeline_layout, 1);
 
-    vkCmdDrawIndexed(command_buffer, static_cast<uint16_t>(test_indices.size()), 1, 0, 0, 0);
+        //Nothing has a material yet, so there's no texture to point at. Whatever gets one will read it through the default sampler
+        CtBindlessDrawIndices draw_indices {};
+        draw_indices.texture = CT_BINDLESS_INVALID_INDEX;
+        draw_indices.sampler = default_sampler;
+        draw_indices.storage_buffer = CT_BINDLESS_INVALID_INDEX;
 
-    vkCmdEndRenderPass(command_buffer);
+        graphics_pipeline->PushConstants(command_buffer, draw_indices);
+    }
 
-    VkResult result = vkEndCommandBuffer(command_buffer);
+    CtDrawUniforms batch {glm::mat4(1.0f), glm::vec4(1.0f)};
+    uint32_t dynamic_offset = uniform_ring->Push(batch);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline->pipeline_layout, 0, 1, &frame_set, 1, &dynamic_offset);
 
-    switch(result){
-        case VK_SUCCESS:
-            //do nothing
-            break;
-        case VK_ERROR_OUT_OF_HOST_MEMORY:
-            throw std::runtime_error("Failure to end command buffer. Host is out of memory.\n");
-            break;
-        case VK_ERROR_OUT_OF_DEVICE_MEMORY:
-            throw std::runtime_error("Failure to end command buffer. Device is out of memory.\n");
-            break;
-        default:
-            throw std::runtime_error("Failed to end command buffer.\n");
-            break;
+    draw_batcher->RecordBucket(command_buffer, main_bucket);
+}
+
+//Whatever the scene files placed, then the simulation's objects. Until something is in the scene we still want to see the test mesh
+void CtRenderer::BatchDraws(){
+    //No camera yet. The identity is orthographic and fits 2 units into the height of the screen
+    CtLodView lod_view {};
+    lod_view.camera = glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+    lod_view.pixels_per_unit = swapchain->swapchain_extent.height * 0.5f;
+    lod_view.max_pixel_error = lod_pixel_error;
+    draw_batcher->SetLodView(lod_view);
+
+    for(const auto& object : frame_snapshot->objects){
+        uint32_t mesh = object.mesh_id < scene_meshes.size() ? scene_meshes[object.mesh_id] : test_mesh;
+        draw_batcher->AddDraw(main_bucket, mesh, {object.transform, object.color, object.material_id, {0, 0, 0}});
+    }
+    for(const auto& object : scene_objects){
+        draw_batcher->AddDraw(main_bucket, object.mesh_id, {object.transform, object.color, 0, {0, 0, 0}});
     }
+    if(frame_snapshot->objects.empty() && scene_objects.empty()){
+        draw_batcher->AddDraw(main_bucket, test_mesh, {glm::mat4(1.0f), glm::vec4(1.0f), 0, {0, 0, 0}});
+    }
+
+    draw_batcher->Build();
 }
\ No newline at end of file
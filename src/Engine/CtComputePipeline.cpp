@@ -0,0 +1,205 @@
+#include "CtComputePipeline.h"
+#include "CtDevice.h"
+#include "CtShader.h"
+#include "CtDescriptorAllocator.h"
+
+CtComputePipeline* CtComputePipeline::CreateComputePipeline(CtDevice* device, const std::string& shader_file, const std::vector<CtComputeBinding>& bindings){
+    CtComputePipeline* ct_compute_pipeline = new CtComputePipeline();
+
+    ct_compute_pipeline->device = device;
+    ct_compute_pipeline->bindings = bindings;
+
+    CtShader* shader = CtShader::CreateShader(device, shader_file, CT_SHADER_PIPELINE_STAGE_COMPUTE);
+    for(uint32_t axis = 0; axis < 3; axis++){
+        ct_compute_pipeline->local_size[axis] = shader->GetLocalSize(axis);
+    }
+
+    ct_compute_pipeline->CreateSetLayout();
+    ct_compute_pipeline->CreatePipelineLayout(shader);
+    ct_compute_pipeline->CreatePipeline(shader);
+
+    //The module is baked into the pipeline now
+    shader->DestroyShaderModule(device->GetInterfaceDevice());
+    delete shader;
+
+    printf("Created Compute Pipeline for %s.\n", shader_file.c_str());
+
+    return ct_compute_pipeline;
+}
+
+/**************************************************************CREATION*****************************************************************/
+
+void CtComputePipeline::CreateSetLayout(){
+    std::vector<VkDescriptorSetLayoutBinding> layout_bindings;
+    for(const auto& binding : bindings){
+        VkDescriptorSetLayoutBinding layout_binding {};
+        layout_binding.binding = binding.binding;
+        layout_binding.descriptorType = binding.type;
+        layout_binding.descriptorCount = 1;
+        layout_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        layout_binding.pImmutableSamplers = nullptr;
+
+        layout_bindings.push_back(layout_binding);
+    }
+
+    VkDescriptorSetLayoutCreateInfo layout_info {};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = static_cast<uint32_t>(layout_bindings.size());
+    layout_info.pBindings = layout_bindings.data();
+
+    if(vkCreateDescriptorSetLayout(*(device->GetInterfaceDevice()), &layout_info, nullptr, &set_layout) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create a compute descriptor set layout.");
+    }
+}
+
+//Only the one stage, so the range is just whatever the shader's block covers
+void CtComputePipeline::CreatePipelineLayout(CtShader* shader){
+    has_push_constants = shader->HasPushConstants();
+
+    if(has_push_constants){
+        VkPhysicalDeviceProperties properties {};
+        vkGetPhysicalDeviceProperties(*(device->GetPhysicalDevice()), &properties);
+
+        if(shader->GetPushConstantOffset() + shader->GetPushConstantSize() > properties.limits.maxPushConstantsSize){
+            throw std::runtime_error("Compute shader declares more push constants than the device supports.");
+        }
+
+        push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        push_constant_range.offset = shader->GetPushConstantOffset();
+        push_constant_range.size = shader->GetPushConstantSize();
+    }
+
+    VkPipelineLayoutCreateInfo layout_info {};
+    layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layout_info.setLayoutCount = 1;
+    layout_info.pSetLayouts = &set_layout;
+    layout_info.pushConstantRangeCount = has_push_constants ? 1 : 0;
+    layout_info.pPushConstantRanges = has_push_constants ? &push_constant_range : nullptr;
+
+    if(vkCreatePipelineLayout(*(device->GetInterfaceDevice()), &layout_info, nullptr, &pipeline_layout) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create a compute pipeline layout.");
+    }
+}
+
+void CtComputePipeline::CreatePipeline(CtShader* shader){
+    VkComputePipelineCreateInfo pipeline_info {};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    shader->CreateShaderPipelineInfo(pipeline_info.stage);
+    pipeline_info.layout = pipeline_layout;
+    pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
+    pipeline_info.basePipelineIndex = -1;
+
+    VkResult result = vkCreateComputePipelines(*(device->GetInterfaceDevice()), VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline);
+
+    switch(result){
+        case VK_SUCCESS:
+            break;
+        case VK_ERROR_OUT_OF_HOST_MEMORY:
+            throw std::runtime_error("Failed to create a compute pipeline. Out of host memory.\n");
+        case VK_ERROR_OUT_OF_DEVICE_MEMORY:
+            throw std::runtime_error("Failed to create a compute pipeline. Out of device memory.\n");
+        case VK_ERROR_INVALID_SHADER_NV:
+            throw std::runtime_error("Failed to create a compute pipeline. The shader didn't compile.\n");
+        default:
+            throw std::runtime_error("Failed to create a compute pipeline.\n");
+    }
+}
+
+/**************************************************************DESCRIPTORS*****************************************************************/
+
+VkDescriptorSet CtComputePipeline::AllocateSet(CtDescriptorAllocator* descriptor_allocator){
+    return descriptor_allocator->Allocate(set_layout);
+}
+
+void CtComputePipeline::WriteStorageBuffer(VkDescriptorSet set, uint32_t binding, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range){
+    VkDescriptorBufferInfo buffer_info {};
+    buffer_info.buffer = buffer;
+    buffer_info.offset = offset;
+    buffer_info.range = range;
+
+    WriteDescriptor(set, binding, &buffer_info, nullptr);
+}
+
+void CtComputePipeline::WriteUniformBuffer(VkDescriptorSet set, uint32_t binding, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range){
+    VkDescriptorBufferInfo buffer_info {};
+    buffer_info.buffer = buffer;
+    buffer_info.offset = offset;
+    buffer_info.range = range;
+
+    WriteDescriptor(set, binding, &buffer_info, nullptr);
+}
+
+void CtComputePipeline::WriteStorageImage(VkDescriptorSet set, uint32_t binding, VkImageView image_view, VkImageLayout layout){
+    VkDescriptorImageInfo image_info {};
+    image_info.imageView = image_view;
+    image_info.imageLayout = layout;
+
+    WriteDescriptor(set, binding, nullptr, &image_info);
+}
+
+void CtComputePipeline::WriteSampledImage(VkDescriptorSet set, uint32_t binding, VkImageView image_view, VkSampler sampler, VkImageLayout layout){
+    VkDescriptorImageInfo image_info {};
+    image_info.sampler = sampler;
+    image_info.imageView = image_view;
+    image_info.imageLayout = layout;
+
+    WriteDescriptor(set, binding, nullptr, &image_info);
+}
+
+//The type comes from the layout, so a write can't disagree with what the set was made with
+void CtComputePipeline::WriteDescriptor(VkDescriptorSet set, uint32_t binding, const VkDescriptorBufferInfo* buffer_info, const VkDescriptorImageInfo* image_info){
+    const CtComputeBinding* layout_binding = nullptr;
+    for(const auto& candidate : bindings){
+        if(candidate.binding == binding){
+            layout_binding = &candidate;
+            break;
+        }
+    }
+
+    if(layout_binding == nullptr){
+        throw std::runtime_error("Compute pipeline has no descriptor at that binding.");
+    }
+
+    VkWriteDescriptorSet write {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = binding;
+    write.dstArrayElement = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = layout_binding->type;
+    write.pBufferInfo = buffer_info;
+    write.pImageInfo = image_info;
+
+    vkUpdateDescriptorSets(*(device->GetInterfaceDevice()), 1, &write, 0, nullptr);
+}
+
+/**************************************************************RECORDING*****************************************************************/
+
+void CtComputePipeline::Bind(VkCommandBuffer command_buffer, VkDescriptorSet set){
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout, 0, 1, &set, 0, nullptr);
+}
+
+void CtComputePipeline::Dispatch(VkCommandBuffer command_buffer, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z){
+    if(group_count_x == 0 || group_count_y == 0 || group_count_z == 0){
+        return;
+    }
+
+    vkCmdDispatch(command_buffer, group_count_x, group_count_y, group_count_z);
+}
+
+void CtComputePipeline::DispatchItems(VkCommandBuffer command_buffer, uint32_t item_count){
+    Dispatch(command_buffer, (item_count + local_size[0] - 1) / local_size[0], 1, 1);
+}
+
+void CtComputePipeline::DispatchExtent(VkCommandBuffer command_buffer, VkExtent2D extent){
+    Dispatch(command_buffer, (extent.width + local_size[0] - 1) / local_size[0], (extent.height + local_size[1] - 1) / local_size[1], 1);
+}
+
+void CtComputePipeline::Cleanup(){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    vkDestroyPipeline(interface_device, pipeline, nullptr);
+    vkDestroyPipelineLayout(interface_device, pipeline_layout, nullptr);
+    vkDestroyDescriptorSetLayout(interface_device, set_layout, nullptr);
+}
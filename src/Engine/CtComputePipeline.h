@@ -0,0 +1,87 @@
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+class CtDevice;
+class CtShader;
+class CtDescriptorAllocator;
+
+//Compute pipelines get the same 128 guaranteed bytes graphics ones do
+const uint32_t CT_COMPUTE_MIN_PUSH_CONSTANTS_SIZE = 128;
+
+//One resource the shader's set 0 declares. Storage buffers and storage images are what compute is mostly about,
+//but sampled images and uniform buffers work the same way
+struct CtComputeBinding{
+    uint32_t binding;
+    VkDescriptorType type;
+};
+
+//The compute side of CtGraphicsPipeline. One shader, one set layout built from the bindings we're given and a push constant
+//range read out of the SPIR-V. Sets come out of a CtDescriptorAllocator since they normally only last a frame.
+//Nothing here cares what queue the command buffer belongs to, so the same pipeline can be dispatched inside the frame on the
+//graphics queue or on the compute queue
+class CtComputePipeline{
+
+    public:
+        static CtComputePipeline* CreateComputePipeline(CtDevice* device, const std::string& shader_file, const std::vector<CtComputeBinding>& bindings);
+
+        //Descriptors
+        VkDescriptorSet AllocateSet(CtDescriptorAllocator* descriptor_allocator);
+        void WriteStorageBuffer(VkDescriptorSet set, uint32_t binding, VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+        void WriteUniformBuffer(VkDescriptorSet set, uint32_t binding, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+        void WriteStorageImage(VkDescriptorSet set, uint32_t binding, VkImageView image_view, VkImageLayout layout = VK_IMAGE_LAYOUT_GENERAL);
+        void WriteSampledImage(VkDescriptorSet set, uint32_t binding, VkImageView image_view, VkSampler sampler, VkImageLayout layout);
+
+        //Recording
+        void Bind(VkCommandBuffer command_buffer, VkDescriptorSet set);
+
+        template<typename T>
+        void PushConstants(VkCommandBuffer command_buffer, const T& data, uint32_t offset = 0){
+            static_assert(sizeof(T) <= CT_COMPUTE_MIN_PUSH_CONSTANTS_SIZE, "Push constants have to fit in the 128 bytes every GPU guarantees.");
+            static_assert(sizeof(T) % 4 == 0, "Push constant sizes have to be a multiple of 4.");
+            static_assert(std::is_trivially_copyable<T>::value, "Push constants get copied byte for byte.");
+
+            if(!has_push_constants || offset < push_constant_range.offset ||
+                offset + sizeof(T) > push_constant_range.offset + push_constant_range.size){
+                throw std::runtime_error("Push constants are outside of the compute pipeline's push constant range.");
+            }
+
+            vkCmdPushConstants(command_buffer, pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, offset, sizeof(T), &data);
+        }
+
+        void Dispatch(VkCommandBuffer command_buffer, uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z);
+
+        //Enough workgroups to give every item (or every texel) an invocation, using the local size the shader was compiled with.
+        //The shader still has to check its id against the real count, the last group usually runs over
+        void DispatchItems(VkCommandBuffer command_buffer, uint32_t item_count);
+        void DispatchExtent(VkCommandBuffer command_buffer, VkExtent2D extent);
+
+        uint32_t GetLocalSize(uint32_t axis){
+            return local_size[axis];
+        }
+
+        void Cleanup();
+
+    private:
+
+        CtDevice* device;
+
+        VkPipeline pipeline;
+        VkPipelineLayout pipeline_layout;
+        VkDescriptorSetLayout set_layout;
+        std::vector<CtComputeBinding> bindings;
+
+        VkPushConstantRange push_constant_range;
+        bool has_push_constants = false;
+
+        uint32_t local_size[3];
+
+        void CreateSetLayout();
+        void CreatePipelineLayout(CtShader* shader);
+        void CreatePipeline(CtShader* shader);
+
+        void WriteDescriptor(VkDescriptorSet set, uint32_t binding, const VkDescriptorBufferInfo* buffer_info, const VkDescriptorImageInfo* image_info);
+};
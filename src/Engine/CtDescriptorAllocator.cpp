@@ -0,0 +1,150 @@
+#include "CtDescriptorAllocator.h"
+#include "CtDevice.h"
+#include <stdexcept>
+
+const uint32_t CT_DESCRIPTOR_POOL_INITIAL_SETS = 64;
+const uint32_t CT_DESCRIPTOR_POOL_MAX_SETS = 4096;
+
+CtDescriptorAllocator* CtDescriptorAllocator::CreateDescriptorAllocator(CtDevice* device, uint32_t max_frames_in_flight, const std::vector<CtDescriptorPoolRatio>& ratios){
+    CtDescriptorAllocator* ct_descriptor_allocator = new CtDescriptorAllocator();
+
+    ct_descriptor_allocator->device = device;
+    ct_descriptor_allocator->ratios = ratios;
+    ct_descriptor_allocator->sets_per_pool = CT_DESCRIPTOR_POOL_INITIAL_SETS;
+    ct_descriptor_allocator->current_frame = 0;
+
+    ct_descriptor_allocator->frames.resize(max_frames_in_flight);
+    for(auto& frame : ct_descriptor_allocator->frames){
+        frame.current_pool = ct_descriptor_allocator->GrabPool();
+        frame.used_pools.push_back(frame.current_pool);
+    }
+
+    printf("Created Descriptor Allocator.\n");
+
+    return ct_descriptor_allocator;
+}
+
+//Resetting a pool frees every set in it in one go, which is the whole point of never freeing sets one at a time
+void CtDescriptorAllocator::BeginFrame(uint32_t frame){
+    current_frame = frame;
+
+    CtDescriptorFramePools& frame_pools = frames[frame];
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    for(VkDescriptorPool pool : frame_pools.used_pools){
+        vkResetDescriptorPool(interface_device, pool, 0);
+        free_pools.push_back(pool);
+    }
+    frame_pools.used_pools.clear();
+
+    frame_pools.current_pool = GrabPool();
+    frame_pools.used_pools.push_back(frame_pools.current_pool);
+}
+
+VkDescriptorSet CtDescriptorAllocator::Allocate(VkDescriptorSetLayout layout){
+    CtDescriptorFramePools& frame_pools = frames[current_frame];
+
+    VkDescriptorSetAllocateInfo allocate_info {};
+    allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocate_info.descriptorPool = frame_pools.current_pool;
+    allocate_info.descriptorSetCount = 1;
+    allocate_info.pSetLayouts = &layout;
+
+    VkDescriptorSet descriptor_set;
+    VkResult result = vkAllocateDescriptorSets(*(device->GetInterfaceDevice()), &allocate_info, &descriptor_set);
+
+    //The pool is full, move on to another one and try again. A fresh pool failing means the layout can never fit
+    if(result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL){
+        frame_pools.current_pool = GrabPool();
+        frame_pools.used_pools.push_back(frame_pools.current_pool);
+
+        allocate_info.descriptorPool = frame_pools.current_pool;
+        result = vkAllocateDescriptorSets(*(device->GetInterfaceDevice()), &allocate_info, &descriptor_set);
+    }
+
+    switch(result){
+        case VK_SUCCESS:
+            break;
+        case VK_ERROR_OUT_OF_HOST_MEMORY:
+            throw std::runtime_error("Failed to allocate a descriptor set. Out of host memory.\n");
+        case VK_ERROR_OUT_OF_DEVICE_MEMORY:
+            throw std::runtime_error("Failed to allocate a descriptor set. Out of device memory.\n");
+        case VK_ERROR_OUT_OF_POOL_MEMORY:
+            throw std::runtime_error("Failed to allocate a descriptor set. The layout needs more than a whole pool holds.\n");
+        default:
+            throw std::runtime_error("Failed to allocate a descriptor set.\n");
+    }
+
+    return descriptor_set;
+}
+
+VkDescriptorPool CtDescriptorAllocator::GrabPool(){
+    if(!free_pools.empty()){
+        VkDescriptorPool pool = free_pools.back();
+        free_pools.pop_back();
+        return pool;
+    }
+
+    VkDescriptorPool pool = CreatePool(sets_per_pool);
+
+    sets_per_pool = sets_per_pool * 2 < CT_DESCRIPTOR_POOL_MAX_SETS ? sets_per_pool * 2 : CT_DESCRIPTOR_POOL_MAX_SETS;
+
+    return pool;
+}
+
+VkDescriptorPool CtDescriptorAllocator::CreatePool(uint32_t set_count){
+    std::vector<VkDescriptorPoolSize> pool_sizes;
+    for(const auto& ratio : ratios){
+        VkDescriptorPoolSize pool_size {};
+        pool_size.type = ratio.type;
+        pool_size.descriptorCount = static_cast<uint32_t>(ratio.descriptors_per_set * set_count);
+
+        if(pool_size.descriptorCount == 0){
+            pool_size.descriptorCount = 1;
+        }
+
+        pool_sizes.push_back(pool_size);
+    }
+
+    //No FREE_DESCRIPTOR_SET_BIT, we never give back single sets
+    VkDescriptorPoolCreateInfo pool_info {};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.flags = 0;
+    pool_info.maxSets = set_count;
+    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    pool_info.pPoolSizes = pool_sizes.data();
+
+    VkDescriptorPool pool;
+    VkResult result = vkCreateDescriptorPool(*(device->GetInterfaceDevice()), &pool_info, nullptr, &pool);
+
+    switch(result){
+        case VK_SUCCESS:
+            break;
+        case VK_ERROR_OUT_OF_HOST_MEMORY:
+            throw std::runtime_error("Failed to create a descriptor pool. Out of host memory.\n");
+        case VK_ERROR_OUT_OF_DEVICE_MEMORY:
+            throw std::runtime_error("Failed to create a descriptor pool. Out of device memory.\n");
+        case VK_ERROR_FRAGMENTATION:
+            throw std::runtime_error("Failed to create a descriptor pool. Fragmentation.\n");
+        default:
+            throw std::runtime_error("Failed to create a descriptor pool.\n");
+    }
+
+    return pool;
+}
+
+void CtDescriptorAllocator::Cleanup(){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    for(auto& frame : frames){
+        for(VkDescriptorPool pool : frame.used_pools){
+            vkDestroyDescriptorPool(interface_device, pool, nullptr);
+        }
+        frame.used_pools.clear();
+    }
+
+    for(VkDescriptorPool pool : free_pools){
+        vkDestroyDescriptorPool(interface_device, pool, nullptr);
+    }
+    free_pools.clear();
+}
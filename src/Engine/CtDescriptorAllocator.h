@@ -0,0 +1,50 @@
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <cstdint>
+
+class CtDevice;
+
+//How many descriptors of a type each pool gets, per set it can hold
+struct CtDescriptorPoolRatio{
+    VkDescriptorType type;
+    float descriptors_per_set;
+};
+
+//The pools one frame in flight has handed sets out of since it was last reset
+struct CtDescriptorFramePools{
+    std::vector<VkDescriptorPool> used_pools;
+    VkDescriptorPool current_pool;
+};
+
+//Linear descriptor set allocation for things that only live for one frame. Each frame in flight allocates out of its own pools, grabs
+//another pool when one runs out, and gets all of them reset at once when its fence says the GPU is done with them.
+//Nothing is ever freed on its own, so the pools can't fragment and allocating is just bumping through the pool
+class CtDescriptorAllocator{
+
+    public:
+        static CtDescriptorAllocator* CreateDescriptorAllocator(CtDevice* device, uint32_t max_frames_in_flight, const std::vector<CtDescriptorPoolRatio>& ratios);
+
+        //Call once the frame's fence has signaled. Everything allocated the last time this frame came around is gone after this
+        void BeginFrame(uint32_t frame);
+
+        VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
+
+        void Cleanup();
+
+    private:
+
+        CtDevice* device;
+
+        std::vector<CtDescriptorPoolRatio> ratios;
+        std::vector<CtDescriptorFramePools> frames;
+        uint32_t current_frame;
+
+        //Reset pools nobody is using, so a frame that needs more can take one of these before making a new one
+        std::vector<VkDescriptorPool> free_pools;
+
+        //New pools get bigger each time we run out, up to a point
+        uint32_t sets_per_pool;
+
+        VkDescriptorPool GrabPool();
+        VkDescriptorPool CreatePool(uint32_t set_count);
+};
@@ -5,6 +5,7 @@
 #include "Engine.h"
 #include <set>
 #include <string>
+#include <cstring>
 #include "CtQueueFamily.h"
 #include "CtWindow.h"
 #include "CtSwapchain.h"
@@ -20,7 +21,15 @@ CtDevice* CtDevice::CreateDevice(Engine* ct_engine, EngineSettings settings){
     //Physical Device phase
     ct_device->ChooseDevice(*(ct_engine->instance), requirements);
     ct_device->queue_family->ImplementQueueFamily(ct_device->physical_device);
+
+    VkPhysicalDeviceProperties properties {};
+    vkGetPhysicalDeviceProperties(ct_device->physical_device, &properties);
+    uint32_t instance_version = ct_engine->instance->GetApiVersion();
+    ct_device->api_version = properties.apiVersion < instance_version ? properties.apiVersion : instance_version;
+
+    ct_device->QueryOptionalFeatures(settings.graphics_settings);
     ct_device->CreateInterfaceDevice();
+    ct_device->LoadDeviceFunctions();
 
     return ct_device;
 
@@ -165,7 +174,8 @@ void CtDevice::TransferCreateInfo(CtInterfaceDeviceCreateInfo& ct_create_info, V
 void CtDevice::CreateInterfaceDevice(){
 
     std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
-    std::set<uint32_t> unique_queue_families = {queue_family->graphics_family.value(), queue_family->present_family.value()};
+    std::set<uint32_t> unique_queue_families = {queue_family->graphics_family.value(), queue_family->present_family.value(),
+        queue_family->compute_family.value()};
 
     float queue_priority = 1.0f;
     for(uint32_t queue_family_index : unique_queue_families){
@@ -181,13 +191,33 @@ void CtDevice::CreateInterfaceDevice(){
     CtPhysicalDeviceFeatures ct_device_features {};
     EnableFeature(ct_device_features, SAMPLER_ANISOTROPY_ENABLE);
 
+    if(optional_features.multi_draw_indirect){
+        EnableFeature(ct_device_features, MULTI_DRAW_INDIRECT_ENABLE);
+        EnableFeature(ct_device_features, DRAW_INDIRECT_FIRST_INSTANCE_ENABLE);
+    }
+
+    if(optional_features.full_draw_index_uint32){
+        EnableFeature(ct_device_features, FULL_DRAW_INDEX_UINT32_ENABLE);
+    }
+
+    if(optional_features.texture_compression_bc){
+        EnableFeature(ct_device_features, TEXTURE_COMPRESSION_BC_ENABLE);
+    }
+    if(optional_features.texture_compression_etc2){
+        EnableFeature(ct_device_features, TEXTURE_COMPRESSION_ETC2_ENABLE);
+    }
+    if(optional_features.texture_compression_astc_ldr){
+        EnableFeature(ct_device_features, TEXTURE_COMPRESSION_ASTC_LDR_ENABLE);
+    }
+
     VkPhysicalDeviceFeatures vk_device_features {};
     TransferFeatures(ct_device_features, vk_device_features);
 
     std::vector<const char*> extensions = GetRequiredDeviceExtensions();
+    extensions.insert(extensions.end(), optional_extensions.begin(), optional_extensions.end());
 
     CtInterfaceDeviceCreateInfo ct_interface_create_info {};
-    PopulateCreateInfo(ct_interface_create_info, nullptr, 0, 
+    PopulateCreateInfo(ct_interface_create_info, BuildFeatureChain(), 0, 
         static_cast<uint32_t>(queue_create_infos.size()), queue_create_infos.data(),
         0, nullptr,
         static_cast<uint32_t>(extensions.size()), extensions.data(),
@@ -221,6 +251,7 @@ void CtDevice::CreateInterfaceDevice(){
     }
     vkGetDeviceQueue(interface_device, queue_family->graphics_family.value(), 0, &(queue_family->graphics_queue));
     vkGetDeviceQueue(interface_device, queue_family->present_family.value(), 0, &(queue_family->present_queue));
+    vkGetDeviceQueue(interface_device, queue_family->compute_family.value(), 0, &(queue_family->compute_queue));
 
 }
 
@@ -228,63 +259,330 @@ VkDevice* CtDevice::GetInterfaceDevice(){
     return &interface_device;
 }
 
+/******************************************************QUEUE SHARING**********************************************************************/
+
+void CtDevice::ShareAcrossQueues(VkBufferCreateInfo& buffer_info){
+    if(!optional_features.async_compute){
+        return;
+    }
+
+    shared_queue_families[0] = queue_family->graphics_family.value();
+    shared_queue_families[1] = queue_family->compute_family.value();
+
+    buffer_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    buffer_info.queueFamilyIndexCount = 2;
+    buffer_info.pQueueFamilyIndices = shared_queue_families;
+}
+
+void CtDevice::ShareAcrossQueues(VkImageCreateInfo& image_info){
+    if(!optional_features.async_compute){
+        return;
+    }
+
+    shared_queue_families[0] = queue_family->graphics_family.value();
+    shared_queue_families[1] = queue_family->compute_family.value();
+
+    image_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    image_info.queueFamilyIndexCount = 2;
+    image_info.pQueueFamilyIndices = shared_queue_families;
+}
+
+/******************************************************OPTIONAL FEATURES**********************************************************************/
+
+//We only look for optional features on 1.2 and up. By then everything the extensions depend on is core, so we don't have to chase down
+//a pile of dependency extensions for older drivers
+void CtDevice::QueryOptionalFeatures(GraphicsSettings settings){
+    optional_features = {};
+    optional_extensions.clear();
+
+    dynamic_rendering_features = {};
+    dynamic_rendering_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+
+    synchronization2_features = {};
+    synchronization2_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES;
+
+    descriptor_indexing_features = {};
+    descriptor_indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+    timeline_semaphore_features = {};
+    timeline_semaphore_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+
+    //These two have been around since 1.0, so they don't care what version we got
+    VkPhysicalDeviceFeatures core_features {};
+    vkGetPhysicalDeviceFeatures(physical_device, &core_features);
+
+    if(settings.use_multi_draw_indirect && core_features.multiDrawIndirect && core_features.drawIndirectFirstInstance){
+        optional_features.multi_draw_indirect = true;
+    }
+
+    printf("Multi draw indirect: %s.\n", optional_features.multi_draw_indirect ? "on" : "off");
+
+    //Costs nothing to have on, so there's no setting for it. The mesh store just splits up fewer meshes
+    optional_features.full_draw_index_uint32 = core_features.fullDrawIndexUint32;
+
+    //Same for these, having them on only means the texture store can use more formats
+    optional_features.texture_compression_bc = core_features.textureCompressionBC;
+    optional_features.texture_compression_etc2 = core_features.textureCompressionETC2;
+    optional_features.texture_compression_astc_ldr = core_features.textureCompressionASTC_LDR;
+
+    printf("Texture compression: BC %s, ETC2 %s, ASTC %s.\n", optional_features.texture_compression_bc ? "on" : "off",
+        optional_features.texture_compression_etc2 ? "on" : "off", optional_features.texture_compression_astc_ldr ? "on" : "off");
+
+    if(api_version < VK_API_VERSION_1_2){
+        printf("Device only supports Vulkan %u.%u, optional features are off.\n", VK_API_VERSION_MAJOR(api_version), VK_API_VERSION_MINOR(api_version));
+        return;
+    }
+
+    bool has_dynamic_rendering_extension = api_version >= VK_API_VERSION_1_3 || HasDeviceExtension(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+    bool has_synchronization2_extension = api_version >= VK_API_VERSION_1_3 || HasDeviceExtension(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+
+    //Ask the GPU which of the features behind those extensions it actually supports. Only structs for extensions that exist can go in the chain
+    VkPhysicalDeviceFeatures2 supported_features {};
+    supported_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supported_features.pNext = &descriptor_indexing_features;
+    descriptor_indexing_features.pNext = &timeline_semaphore_features;
+
+    if(has_dynamic_rendering_extension){
+        dynamic_rendering_features.pNext = supported_features.pNext;
+        supported_features.pNext = &dynamic_rendering_features;
+    }
+    if(has_synchronization2_extension){
+        synchronization2_features.pNext = supported_features.pNext;
+        supported_features.pNext = &synchronization2_features;
+    }
+
+    vkGetPhysicalDeviceFeatures2(physical_device, &supported_features);
+
+    if(settings.use_dynamic_rendering && has_dynamic_rendering_extension && dynamic_rendering_features.dynamicRendering){
+        optional_features.dynamic_rendering = true;
+
+        if(api_version < VK_API_VERSION_1_3){
+            optional_extensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+        }
+    }
+
+    if(settings.use_synchronization2 && has_synchronization2_extension && synchronization2_features.synchronization2){
+        optional_features.synchronization2 = true;
+
+        if(api_version < VK_API_VERSION_1_3){
+            optional_extensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+        }
+    }
+
+    //The bindless table needs every one of these, having only some of them doesn't get us anywhere
+    bool has_descriptor_indexing = descriptor_indexing_features.runtimeDescriptorArray &&
+        descriptor_indexing_features.descriptorBindingPartiallyBound &&
+        descriptor_indexing_features.descriptorBindingUpdateUnusedWhilePending &&
+        descriptor_indexing_features.descriptorBindingSampledImageUpdateAfterBind &&
+        descriptor_indexing_features.descriptorBindingStorageBufferUpdateAfterBind &&
+        descriptor_indexing_features.shaderSampledImageArrayNonUniformIndexing &&
+        descriptor_indexing_features.shaderStorageBufferArrayNonUniformIndexing;
+
+    if(settings.use_bindless && has_descriptor_indexing){
+        optional_features.descriptor_indexing = true;
+    }
+
+    //The extension doesn't come with a feature bit, having it is enough. Without multi draw there's nothing for a count to batch
+    if(optional_features.multi_draw_indirect && HasDeviceExtension(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)){
+        optional_features.draw_indirect_count = true;
+        optional_extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    }
+
+    //Waiting on the other queue's timeline is the only way the graph knows how to order the two queues
+    if(timeline_semaphore_features.timelineSemaphore){
+        optional_features.timeline_semaphore = true;
+    }
+
+    if(settings.use_async_compute && optional_features.timeline_semaphore && queue_family->HasDedicatedCompute()){
+        optional_features.async_compute = true;
+    }
+
+    //Its properties come back through vkGetPhysicalDeviceMemoryProperties2, which is core by now
+    if(HasDeviceExtension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)){
+        optional_features.memory_budget = true;
+        optional_extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+
+    printf("Dynamic rendering: %s.\n", optional_features.dynamic_rendering ? "on" : "off");
+    printf("Synchronization2: %s.\n", optional_features.synchronization2 ? "on" : "off");
+    printf("Descriptor indexing: %s.\n", optional_features.descriptor_indexing ? "on" : "off");
+    printf("Draw indirect count: %s.\n", optional_features.draw_indirect_count ? "on" : "off");
+    printf("Async compute: %s.\n", optional_features.async_compute ? "on" : "off");
+    printf("Memory budget: %s.\n", optional_features.memory_budget ? "on" : "off");
+}
+
+bool CtDevice::HasDeviceExtension(const char* extension_name){
+    uint32_t extension_count;
+    vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, nullptr);
+
+    std::vector<VkExtensionProperties> extensions(extension_count);
+    vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, extensions.data());
+
+    for(const auto& extension : extensions){
+        if(strcmp(extension.extensionName, extension_name) == 0){
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//Links every feature struct we want turned on into one pNext chain for device creation. The structs are members so they outlive the call
+void* CtDevice::BuildFeatureChain(){
+    void* chain = nullptr;
+
+    dynamic_rendering_features.pNext = nullptr;
+    if(optional_features.dynamic_rendering){
+        dynamic_rendering_features.dynamicRendering = VK_TRUE;
+        dynamic_rendering_features.pNext = chain;
+        chain = &dynamic_rendering_features;
+    }
+
+    synchronization2_features.pNext = nullptr;
+    if(optional_features.synchronization2){
+        synchronization2_features.synchronization2 = VK_TRUE;
+        synchronization2_features.pNext = chain;
+        chain = &synchronization2_features;
+    }
+
+    //Only turn on what the bindless table uses, not everything the GPU reported
+    descriptor_indexing_features.pNext = nullptr;
+    if(optional_features.descriptor_indexing){
+        VkPhysicalDeviceDescriptorIndexingFeatures enabled {};
+        enabled.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+        enabled.runtimeDescriptorArray = VK_TRUE;
+        enabled.descriptorBindingPartiallyBound = VK_TRUE;
+        enabled.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        enabled.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        enabled.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+        enabled.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        enabled.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+
+        descriptor_indexing_features = enabled;
+        descriptor_indexing_features.pNext = chain;
+        chain = &descriptor_indexing_features;
+    }
+
+    timeline_semaphore_features.pNext = nullptr;
+    if(optional_features.timeline_semaphore){
+        timeline_semaphore_features.timelineSemaphore = VK_TRUE;
+        timeline_semaphore_features.pNext = chain;
+        chain = &timeline_semaphore_features;
+    }
+
+    return chain;
+}
+
+//1.3 gives us the core names, before that we have to go through the KHR ones
+void CtDevice::LoadDeviceFunctions(){
+    begin_rendering = nullptr;
+    end_rendering = nullptr;
+    pipeline_barrier2 = nullptr;
+    draw_indexed_indirect_count = nullptr;
+
+    bool is_core = api_version >= VK_API_VERSION_1_3;
+
+    if(optional_features.dynamic_rendering){
+
+        begin_rendering = (PFN_vkCmdBeginRenderingKHR)vkGetDeviceProcAddr(interface_device, is_core ? "vkCmdBeginRendering" : "vkCmdBeginRenderingKHR");
+        end_rendering = (PFN_vkCmdEndRenderingKHR)vkGetDeviceProcAddr(interface_device, is_core ? "vkCmdEndRendering" : "vkCmdEndRenderingKHR");
+
+        if(begin_rendering == nullptr || end_rendering == nullptr){
+            throw std::runtime_error("Dynamic rendering was enabled but its functions could not be loaded.");
+        }
+    }
+
+    if(optional_features.synchronization2){
+        pipeline_barrier2 = (PFN_vkCmdPipelineBarrier2KHR)vkGetDeviceProcAddr(interface_device, is_core ? "vkCmdPipelineBarrier2" : "vkCmdPipelineBarrier2KHR");
+
+        if(pipeline_barrier2 == nullptr){
+            throw std::runtime_error("Synchronization2 was enabled but its functions could not be loaded.");
+        }
+    }
+
+    if(optional_features.draw_indirect_count){
+        draw_indexed_indirect_count = (PFN_vkCmdDrawIndexedIndirectCountKHR)vkGetDeviceProcAddr(interface_device, "vkCmdDrawIndexedIndirectCountKHR");
+
+        if(draw_indexed_indirect_count == nullptr){
+            throw std::runtime_error("Draw indirect count was enabled but its functions could not be loaded.");
+        }
+    }
+}
+
+void CtDevice::CmdBeginRendering(VkCommandBuffer command_buffer, const VkRenderingInfo* rendering_info){
+    begin_rendering(command_buffer, rendering_info);
+}
+
+void CtDevice::CmdEndRendering(VkCommandBuffer command_buffer){
+    end_rendering(command_buffer);
+}
+
+void CtDevice::CmdPipelineBarrier2(VkCommandBuffer command_buffer, const VkDependencyInfo* dependency_info){
+    pipeline_barrier2(command_buffer, dependency_info);
+}
+
+void CtDevice::CmdDrawIndexedIndirectCount(VkCommandBuffer command_buffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer count_buffer,
+    VkDeviceSize count_buffer_offset, uint32_t max_draw_count, uint32_t stride){
+    draw_indexed_indirect_count(command_buffer, buffer, offset, count_buffer, count_buffer_offset, max_draw_count, stride);
+}
+
 /******************************************************FEATURES ENABLE**********************************************************************/
 
 void CtDevice::TransferFeatures(CtPhysicalDeviceFeatures& device_features, VkPhysicalDeviceFeatures& features){
-    device_features.robustBufferAccess = features.robustBufferAccess;
-    device_features.fullDrawIndexUint32 = features.fullDrawIndexUint32;
-    device_features.imageCubeArray = features.imageCubeArray;
-    device_features.independentBlend = features.independentBlend;
-    device_features.geometryShader = features.geometryShader;
-    device_features.tessellationShader = features.tessellationShader;
-    device_features.sampleRateShading = features.sampleRateShading;
-    device_features.dualSrcBlend = features.dualSrcBlend;
-    device_features.logicOp = features.logicOp;
-    device_features.multiDrawIndirect = features.multiDrawIndirect;
-    device_features.drawIndirectFirstInstance = features.drawIndirectFirstInstance;
-    device_features.depthClamp = features.depthClamp;
-    device_features.depthBiasClamp = features.depthBiasClamp;
-    device_features.fillModeNonSolid = features.fillModeNonSolid;
-    device_features.depthBounds = features.depthBounds;
-    device_features.wideLines = features.wideLines;
-    device_features.largePoints = features.largePoints;
-    device_features.alphaToOne = features.alphaToOne;
-    device_features.multiViewport = features.multiViewport;
-    device_features.samplerAnisotropy = features.samplerAnisotropy;
-    device_features.textureCompressionETC2 = features.textureCompressionETC2;
-    device_features.textureCompressionASTC_LDR = features.textureCompressionASTC_LDR;
-    device_features.textureCompressionBC = features.textureCompressionBC;
-    device_features.occlusionQueryPrecise = features.occlusionQueryPrecise;
-    device_features.pipelineStatisticsQuery = features.pipelineStatisticsQuery;
-    device_features.vertexPipelineStoresAndAtomics = features.vertexPipelineStoresAndAtomics;
-    device_features.fragmentStoresAndAtomics = features.fragmentStoresAndAtomics;
-    device_features.shaderTessellationAndGeometryPointSize = features.shaderTessellationAndGeometryPointSize;
-    device_features.shaderImageGatherExtended = features.shaderImageGatherExtended;
-    device_features.shaderStorageImageExtendedFormats = features.shaderStorageImageExtendedFormats;
-    device_features.shaderStorageImageMultisample = features.shaderStorageImageMultisample;
-    device_features.shaderStorageImageReadWithoutFormat = features.shaderStorageImageReadWithoutFormat;
-    device_features.shaderStorageImageWriteWithoutFormat = features.shaderStorageImageWriteWithoutFormat;
-    device_features.shaderUniformBufferArrayDynamicIndexing = features.shaderUniformBufferArrayDynamicIndexing;
-    device_features.shaderSampledImageArrayDynamicIndexing = features.shaderSampledImageArrayDynamicIndexing;
-    device_features.shaderStorageBufferArrayDynamicIndexing = features.shaderStorageBufferArrayDynamicIndexing;
-    device_features.shaderStorageImageArrayDynamicIndexing = features.shaderStorageImageArrayDynamicIndexing;
-    device_features.shaderClipDistance = features.shaderClipDistance;
-    device_features.shaderCullDistance = features.shaderCullDistance;
-    device_features.shaderFloat64 = features.shaderFloat64;
-    device_features.shaderInt64 = features.shaderInt64;
-    device_features.shaderInt16 = features.shaderInt16;
-    device_features.shaderResourceResidency = features.shaderResourceResidency;
-    device_features.shaderResourceMinLod = features.shaderResourceMinLod;
-    device_features.sparseResidencyBuffer = features.sparseResidencyBuffer;
-    device_features.sparseResidencyImage2D = features.sparseResidencyImage2D;
-    device_features.sparseResidencyImage3D = features.sparseResidencyImage3D;
-    device_features.sparseResidency2Samples = features.sparseResidency2Samples;
-    device_features.sparseResidency4Samples = features.sparseResidency4Samples;
-    device_features.sparseResidency8Samples = features.sparseResidency8Samples;
-    device_features.sparseResidency16Samples = features.sparseResidency16Samples;
-    device_features.sparseResidencyAliased = features.sparseResidencyAliased;
-    device_features.variableMultisampleRate = features.variableMultisampleRate;
-    device_features.inheritedQueries = features.inheritedQueries;
+    features.robustBufferAccess = device_features.robustBufferAccess;
+    features.fullDrawIndexUint32 = device_features.fullDrawIndexUint32;
+    features.imageCubeArray = device_features.imageCubeArray;
+    features.independentBlend = device_features.independentBlend;
+    features.geometryShader = device_features.geometryShader;
+    features.tessellationShader = device_features.tessellationShader;
+    features.sampleRateShading = device_features.sampleRateShading;
+    features.dualSrcBlend = device_features.dualSrcBlend;
+    features.logicOp = device_features.logicOp;
+    features.multiDrawIndirect = device_features.multiDrawIndirect;
+    features.drawIndirectFirstInstance = device_features.drawIndirectFirstInstance;
+    features.depthClamp = device_features.depthClamp;
+    features.depthBiasClamp = device_features.depthBiasClamp;
+    features.fillModeNonSolid = device_features.fillModeNonSolid;
+    features.depthBounds = device_features.depthBounds;
+    features.wideLines = device_features.wideLines;
+    features.largePoints = device_features.largePoints;
+    features.alphaToOne = device_features.alphaToOne;
+    features.multiViewport = device_features.multiViewport;
+    features.samplerAnisotropy = device_features.samplerAnisotropy;
+    features.textureCompressionETC2 = device_features.textureCompressionETC2;
+    features.textureCompressionASTC_LDR = device_features.textureCompressionASTC_LDR;
+    features.textureCompressionBC = device_features.textureCompressionBC;
+    features.occlusionQueryPrecise = device_features.occlusionQueryPrecise;
+    features.pipelineStatisticsQuery = device_features.pipelineStatisticsQuery;
+    features.vertexPipelineStoresAndAtomics = device_features.vertexPipelineStoresAndAtomics;
+    features.fragmentStoresAndAtomics = device_features.fragmentStoresAndAtomics;
+    features.shaderTessellationAndGeometryPointSize = device_features.shaderTessellationAndGeometryPointSize;
+    features.shaderImageGatherExtended = device_features.shaderImageGatherExtended;
+    features.shaderStorageImageExtendedFormats = device_features.shaderStorageImageExtendedFormats;
+    features.shaderStorageImageMultisample = device_features.shaderStorageImageMultisample;
+    features.shaderStorageImageReadWithoutFormat = device_features.shaderStorageImageReadWithoutFormat;
+    features.shaderStorageImageWriteWithoutFormat = device_features.shaderStorageImageWriteWithoutFormat;
+    features.shaderUniformBufferArrayDynamicIndexing = device_features.shaderUniformBufferArrayDynamicIndexing;
+    features.shaderSampledImageArrayDynamicIndexing = device_features.shaderSampledImageArrayDynamicIndexing;
+    features.shaderStorageBufferArrayDynamicIndexing = device_features.shaderStorageBufferArrayDynamicIndexing;
+    features.shaderStorageImageArrayDynamicIndexing = device_features.shaderStorageImageArrayDynamicIndexing;
+    features.shaderClipDistance = device_features.shaderClipDistance;
+    features.shaderCullDistance = device_features.shaderCullDistance;
+    features.shaderFloat64 = device_features.shaderFloat64;
+    features.shaderInt64 = device_features.shaderInt64;
+    features.shaderInt16 = device_features.shaderInt16;
+    features.shaderResourceResidency = device_features.shaderResourceResidency;
+    features.shaderResourceMinLod = device_features.shaderResourceMinLod;
+    features.sparseResidencyBuffer = device_features.sparseResidencyBuffer;
+    features.sparseResidencyImage2D = device_features.sparseResidencyImage2D;
+    features.sparseResidencyImage3D = device_features.sparseResidencyImage3D;
+    features.sparseResidency2Samples = device_features.sparseResidency2Samples;
+    features.sparseResidency4Samples = device_features.sparseResidency4Samples;
+    features.sparseResidency8Samples = device_features.sparseResidency8Samples;
+    features.sparseResidency16Samples = device_features.sparseResidency16Samples;
+    features.sparseResidencyAliased = device_features.sparseResidencyAliased;
+    features.variableMultisampleRate = device_features.variableMultisampleRate;
+    features.inheritedQueries = device_features.inheritedQueries;
 }
 
 void CtDevice::EnableFeature(CtPhysicalDeviceFeatures& feature, CtPhysicalDeviceFeatureEnable enable){
@@ -467,4 +765,37 @@ uint32_t CtDevice::FindMemoryType(uint32_t type_filter, VkMemoryPropertyFlags pr
     }
 
     throw std::runtime_error("Failed to find a suitable memory type!");
+}
+
+//The budget moves around as other processes allocate, so ask every time instead of caching it
+void CtDevice::GetDeviceLocalBudget(VkDeviceSize& budget, VkDeviceSize& usage){
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_properties {};
+    budget_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+    VkPhysicalDeviceMemoryProperties2 memory_properties {};
+    memory_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    if(optional_features.memory_budget){
+        memory_properties.pNext = &budget_properties;
+        vkGetPhysicalDeviceMemoryProperties2(physical_device, &memory_properties);
+    }
+    else{
+        vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties.memoryProperties);
+    }
+
+    budget = 0;
+    usage = 0;
+    const VkPhysicalDeviceMemoryProperties& heaps = memory_properties.memoryProperties;
+    for(uint32_t i = 0; i < heaps.memoryHeapCount; i++){
+        if((heaps.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) == 0){
+            continue;
+        }
+
+        if(optional_features.memory_budget){
+            budget += budget_properties.heapBudget[i];
+            usage += budget_properties.heapUsage[i];
+        }
+        else{
+            budget += heaps.memoryHeaps[i].size;
+        }
+    }
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 class CtInstance;
 class Engine;
 struct EngineSettings;
+struct GraphicsSettings;
 class CtQueueFamily;
 class CtRenderer;
 
@@ -140,6 +141,44 @@ enum CtPhysicalDeviceFeatureEnable {
     INHERITED_QUERIES_ENABLE
 };
 
+//Things we'd like to use but can live without. Each one is only true if it was asked for and the GPU actually has it,
+//so anything that uses one has to check here and keep a fallback around
+struct CtDeviceOptionalFeatures{
+    //vkCmdBeginRendering instead of render pass and framebuffer objects. Core in 1.3, VK_KHR_dynamic_rendering before that
+    bool dynamic_rendering;
+
+    //vkCmdPipelineBarrier2 and the 64 bit stage/access masks. Core in 1.3, VK_KHR_synchronization2 before that
+    bool synchronization2;
+
+    //Update after bind, partially bound descriptor arrays indexed from shaders. Core in 1.2, which we already need for any of these
+    bool descriptor_indexing;
+
+    //More than one command per vkCmdDrawIndexedIndirect, with firstInstance allowed to be something other than 0. Both are 1.0 features
+    bool multi_draw_indirect;
+
+    //vkCmdDrawIndexedIndirectCount, where the number of draws comes out of a buffer. We take it through VK_KHR_draw_indirect_count
+    bool draw_indirect_count;
+
+    //Any 32 bit index in an indexed draw. Without it the device only has to take up to maxDrawIndexedIndexValue, which can be 2^24 - 1
+    bool full_draw_index_uint32;
+
+    //Block compressed texture formats, one feature per family. All 1.0 features, turned on whenever the device has them
+    bool texture_compression_bc;
+    bool texture_compression_etc2;
+    bool texture_compression_astc_ldr;
+
+    //Semaphores that count up instead of flipping between signaled and not. Core in 1.2
+    bool timeline_semaphore;
+
+    //Render graph passes tagged async compute go to their own queue. Needs timeline semaphores and a compute only queue family,
+    //sending them to the graphics family's queue wouldn't run them any sooner
+    bool async_compute;
+
+    //What the driver says each heap has left for us and how much of it the whole process is using, rather than just the heap sizes.
+    //VK_EXT_memory_budget, which has no feature bit. Costs nothing, so it's on whenever the device has it
+    bool memory_budget;
+};
+
 struct CtInterfaceDeviceCreateInfo{
 
     //The structure type of this device 
@@ -177,6 +216,34 @@ class CtDevice{
 
         uint32_t FindMemoryType(uint32_t type_filter, VkMemoryPropertyFlags properties);
 
+        //Totals over every device local heap. Without memory_budget all we know is how big the heaps are, so that's the budget and usage is 0
+        void GetDeviceLocalBudget(VkDeviceSize& budget, VkDeviceSize& usage);
+
+        const CtDeviceOptionalFeatures& GetOptionalFeatures(){
+            return optional_features;
+        }
+
+        //The version we can actually use, which is whichever is lower between the instance and the GPU
+        uint32_t GetApiVersion(){
+            return api_version;
+        }
+
+        //Dynamic rendering. These go through whichever entry point (core or KHR) the device gave us
+        void CmdBeginRendering(VkCommandBuffer command_buffer, const VkRenderingInfo* rendering_info);
+        void CmdEndRendering(VkCommandBuffer command_buffer);
+
+        //Synchronization2. Use CtBarrierBatch instead of calling this directly, it knows how to fall back
+        void CmdPipelineBarrier2(VkCommandBuffer command_buffer, const VkDependencyInfo* dependency_info);
+
+        //Anything both queues touch gets made CONCURRENT between the two families, so handing it across never needs an ownership transfer.
+        //Leaves the create info alone when async compute is off
+        void ShareAcrossQueues(VkBufferCreateInfo& buffer_info);
+        void ShareAcrossQueues(VkImageCreateInfo& image_info);
+
+        //Draw indirect count. Only call this when the draw_indirect_count feature is on
+        void CmdDrawIndexedIndirectCount(VkCommandBuffer command_buffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer count_buffer,
+            VkDeviceSize count_buffer_offset, uint32_t max_draw_count, uint32_t stride);
+
     private:
         //The actual GPU
         VkPhysicalDevice physical_device = VK_NULL_HANDLE;
@@ -190,6 +257,24 @@ class CtDevice{
         //Our enabled features
         CtPhysicalDeviceFeatures features;
 
+        uint32_t api_version;
+
+        //Optional features and the extensions they need. The feature structs get chained onto device creation
+        CtDeviceOptionalFeatures optional_features;
+        std::vector<const char*> optional_extensions;
+        VkPhysicalDeviceDynamicRenderingFeatures dynamic_rendering_features;
+        VkPhysicalDeviceSynchronization2Features synchronization2_features;
+        VkPhysicalDeviceDescriptorIndexingFeatures descriptor_indexing_features;
+        VkPhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_features;
+
+        //Graphics then compute, what ShareAcrossQueues points the create infos at
+        uint32_t shared_queue_families[2];
+
+        PFN_vkCmdBeginRenderingKHR begin_rendering;
+        PFN_vkCmdEndRenderingKHR end_rendering;
+        PFN_vkCmdPipelineBarrier2KHR pipeline_barrier2;
+        PFN_vkCmdDrawIndexedIndirectCountKHR draw_indexed_indirect_count;
+
         //Enabling a feature
         void EnableFeature(CtPhysicalDeviceFeatures& feature, CtPhysicalDeviceFeatureEnable enable);
         void TransferFeatures(CtPhysicalDeviceFeatures& device_features, VkPhysicalDeviceFeatures& features);
@@ -212,9 +297,19 @@ class CtDevice{
         void TransferCreateInfo(CtInterfaceDeviceCreateInfo& ct_create_info, VkDeviceCreateInfo& vk_create_info);
         void CreateInterfaceDevice();
 
+        //Optional features
+        void QueryOptionalFeatures(GraphicsSettings settings);
+        bool HasDeviceExtension(const char* extension_name);
+        void* BuildFeatureChain();
+        void LoadDeviceFunctions();
+
 
     friend class Engine;
     friend class CtQueueFamily;
     friend class CtSwapchain;
     friend class CtRenderer;
+    friend class CtMeshStore;
+    friend class CtTextureStore;
+    friend class CtTextureStreamer;
+    friend class CtRenderGraph;
 };
\ No newline at end of file
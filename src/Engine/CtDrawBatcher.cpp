@@ -0,0 +1,429 @@
+#include "CtDrawBatcher.h"
+#include "CtDevice.h"
+#include "CtMeshStore.h"
+#include "CtInstanceData.h"
+#include "CtInstanceBuffer.h"
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+
+CtDrawBatcher* CtDrawBatcher::CreateDrawBatcher(CtDevice* device, CtMeshStore* mesh_store, CtInstanceBuffer* instance_buffer, uint32_t max_draws,
+    uint32_t max_frames_in_flight){
+
+    CtDrawBatcher* ct_draw_batcher = new CtDrawBatcher();
+
+    ct_draw_batcher->device = device;
+    ct_draw_batcher->mesh_store = mesh_store;
+    ct_draw_batcher->instance_buffer = instance_buffer;
+    ct_draw_batcher->max_draws = max_draws;
+    ct_draw_batcher->current_frame = 0;
+    ct_draw_batcher->max_frames_in_flight = max_frames_in_flight;
+    ct_draw_batcher->gpu_culled = false;
+    ct_draw_batcher->cluster_culled = false;
+    ct_draw_batcher->lod_selection = false;
+
+    VkPhysicalDeviceProperties properties {};
+    vkGetPhysicalDeviceProperties(*(device->GetPhysicalDevice()), &properties);
+    ct_draw_batcher->max_draw_indirect_count = device->GetOptionalFeatures().multi_draw_indirect ? properties.limits.maxDrawIndirectCount : 1;
+
+    //Storage usage too, so a compute pass can rewrite the commands and counts later on
+    ct_draw_batcher->mapped_commands = static_cast<VkDrawIndexedIndirectCommand*>(ct_draw_batcher->CreateMappedBuffer(
+        static_cast<VkDeviceSize>(max_draws) * max_frames_in_flight * sizeof(VkDrawIndexedIndirectCommand),
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        ct_draw_batcher->indirect_buffer, ct_draw_batcher->indirect_buffer_memory));
+    ct_draw_batcher->mapped_counts = static_cast<uint32_t*>(ct_draw_batcher->CreateMappedBuffer(
+        static_cast<VkDeviceSize>(CT_DRAW_BATCHER_MAX_BUCKETS) * CT_DRAW_BATCHER_COUNTS_PER_BUCKET * max_frames_in_flight * sizeof(uint32_t),
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        ct_draw_batcher->count_buffer, ct_draw_batcher->count_buffer_memory));
+
+    printf("Created Draw Batcher.\n");
+
+    return ct_draw_batcher;
+}
+
+/**************************************************************MESHES*****************************************************************/
+
+//A stable partition keeps meshes of one type in the order they were added. Only redone when the store has grown since the last frame
+void CtDrawBatcher::SortMeshes(){
+    uint32_t mesh_count = mesh_store->GetMeshCount();
+    if(mesh_order.size() == mesh_count){
+        return;
+    }
+
+    mesh_order.clear();
+    for(uint32_t m = 0; m < mesh_count; m++){
+        if(mesh_store->GetMesh(m).index_type == VK_INDEX_TYPE_UINT16){
+            mesh_order.push_back(m);
+        }
+    }
+    for(uint32_t m = 0; m < mesh_count; m++){
+        if(mesh_store->GetMesh(m).index_type != VK_INDEX_TYPE_UINT16){
+            mesh_order.push_back(m);
+        }
+    }
+}
+
+const glm::vec4& CtDrawBatcher::GetMeshBounds(uint32_t mesh_id){
+    return mesh_store->GetMesh(mesh_id).bounds;
+}
+
+uint32_t CtDrawBatcher::AddBucket(){
+    if(buckets.size() >= CT_DRAW_BATCHER_MAX_BUCKETS){
+        throw std::runtime_error("Too many draw buckets.");
+    }
+
+    buckets.push_back({});
+
+    return static_cast<uint32_t>(buckets.size() - 1);
+}
+
+/**************************************************************FRAME*****************************************************************/
+
+void CtDrawBatcher::BeginFrame(uint32_t frame){
+    current_frame = frame;
+
+    for(auto& bucket : buckets){
+        bucket.draws.clear();
+        bucket.instances.clear();
+        bucket.first_command = 0;
+        bucket.command_count = 0;
+        bucket.uint16_command_count = 0;
+        bucket.cluster_first_command = 0;
+        bucket.cluster_command_count = 0;
+        bucket.uint16_cluster_command_count = 0;
+    }
+}
+
+void CtDrawBatcher::AddDraw(uint32_t bucket, uint32_t mesh_id, const CtInstanceData& instance){
+    CtDrawBucket& draw_bucket = buckets[bucket];
+    mesh_id = SelectLod(mesh_id, instance);
+
+    draw_bucket.draws.push_back({mesh_id, static_cast<uint32_t>(draw_bucket.instances.size())});
+    draw_bucket.instances.push_back(instance);
+}
+
+void CtDrawBatcher::SetLodView(const CtLodView& view){
+    lod_view = view;
+    lod_selection = true;
+}
+
+//A level's error in pixels is its mesh space error, scaled by the instance and by how big a unit looks from where the camera is. The
+//distance is to the near side of the bounding sphere so nothing gets coarser just because its middle is far away
+uint32_t CtDrawBatcher::SelectLod(uint32_t mesh_id, const CtInstanceData& instance){
+    const CtMeshRange& mesh = mesh_store->GetMesh(mesh_id);
+    if(!lod_selection || mesh.lod_count <= 1){
+        return mesh_id;
+    }
+
+    const glm::mat4& transform = instance.transform;
+    float scale = glm::max(glm::max(glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1]))), glm::length(glm::vec3(transform[2])));
+
+    float pixels_per_error = lod_view.pixels_per_unit * scale;
+    if(lod_view.camera.w != 0.0f){
+        glm::vec3 center = glm::vec3(transform * glm::vec4(glm::vec3(mesh.bounds), 1.0f));
+        float distance = glm::length(center - glm::vec3(lod_view.camera)) - mesh.bounds.w * scale;
+
+        //Close enough to be inside the sphere gets full detail
+        if(distance <= 0.0f){
+            return mesh_id;
+        }
+        pixels_per_error /= distance;
+    }
+
+    uint32_t level = 0;
+    while(level + 1 < mesh.lod_count && mesh_store->GetMesh(mesh_id + level + 1).lod_error * pixels_per_error <= lod_view.max_pixel_error){
+        level++;
+    }
+
+    return mesh_id + level;
+}
+
+//A counting sort by mesh puts every mesh's instances next to each other, then each mesh that showed up is one command instancing over them
+void CtDrawBatcher::Build(){
+    VkDrawIndexedIndirectCommand* commands = mapped_commands + static_cast<size_t>(max_draws) * current_frame;
+    uint32_t* counts = mapped_counts + GetCountBase();
+
+    SortMeshes();
+    uint32_t mesh_count = mesh_store->GetMeshCount();
+
+    frame_commands.clear();
+    cull_instances.clear();
+    cull_candidates.clear();
+    cluster_instances.clear();
+    cluster_candidates.clear();
+
+    std::vector<uint32_t> mesh_starts(mesh_count + 1);
+    std::vector<CtInstanceData> sorted_instances;
+
+    for(uint32_t b = 0; b < buckets.size(); b++){
+        CtDrawBucket& bucket = buckets[b];
+        bucket.first_command = static_cast<uint32_t>(frame_commands.size());
+        bucket.command_count = 0;
+        bucket.uint16_command_count = 0;
+        bucket.cluster_command_count = 0;
+        bucket.uint16_cluster_command_count = 0;
+        size_t first_cluster_candidate = cluster_candidates.size();
+
+        std::fill(mesh_starts.begin(), mesh_starts.end(), 0);
+        for(const auto& draw : bucket.draws){
+            mesh_starts[draw.mesh_id + 1]++;
+        }
+        for(size_t m = 1; m < mesh_starts.size(); m++){
+            mesh_starts[m] += mesh_starts[m - 1];
+        }
+
+        sorted_instances.resize(bucket.draws.size());
+        std::vector<uint32_t> cursor(mesh_starts.begin(), mesh_starts.end() - 1);
+        for(const auto& draw : bucket.draws){
+            sorted_instances[cursor[draw.mesh_id]++] = bucket.instances[draw.instance_index];
+        }
+
+        uint32_t first_instance = 0;
+        if(!sorted_instances.empty()){
+            first_instance = gpu_culled ? instance_buffer->Reserve(static_cast<uint32_t>(sorted_instances.size())) : instance_buffer->Push(sorted_instances);
+        }
+
+        for(uint32_t m : mesh_order){
+            uint32_t instance_count = mesh_starts[m + 1] - mesh_starts[m];
+            if(instance_count == 0){
+                continue;
+            }
+
+            const CtMeshRange& mesh = mesh_store->GetMesh(m);
+
+            //Every instance can draw any of the mesh's clusters, so the run needs room for all of them. Commands are counted from
+            //the front of the cluster runs until we know where those start. With GPU culling on the instances were only reserved, so
+            //these get their own copy and the reserved ones go unused
+            if(cluster_culled && mesh.cluster_count > 0){
+                uint32_t mesh_first_instance = first_instance + mesh_starts[m];
+                if(gpu_culled){
+                    std::vector<CtInstanceData> mesh_instances(sorted_instances.begin() + mesh_starts[m], sorted_instances.begin() + mesh_starts[m + 1]);
+                    mesh_first_instance = instance_buffer->Push(mesh_instances);
+                }
+
+                bool uint16_indices = mesh.index_type == VK_INDEX_TYPE_UINT16;
+                uint32_t count = b * CT_DRAW_BATCHER_COUNTS_PER_BUCKET + (uint16_indices ? 2 : 3);
+                for(uint32_t i = 0; i < instance_count; i++){
+                    cluster_instances.push_back(sorted_instances[mesh_starts[m] + i]);
+                    cluster_candidates.push_back({m, mesh_first_instance + i, uint16_indices ? 0 : bucket.uint16_cluster_command_count, count});
+
+                    bucket.cluster_command_count += mesh.cluster_count;
+                    bucket.uint16_cluster_command_count += uint16_indices ? mesh.cluster_count : 0;
+                }
+                continue;
+            }
+
+            VkDrawIndexedIndirectCommand command {};
+            command.indexCount = mesh.index_count;
+            command.instanceCount = gpu_culled ? 0 : instance_count;
+            command.firstIndex = mesh.first_index;
+            command.vertexOffset = mesh.vertex_offset;
+            command.firstInstance = first_instance + mesh_starts[m];
+
+            if(gpu_culled){
+                uint32_t command_index = static_cast<uint32_t>(frame_commands.size());
+                for(uint32_t i = mesh_starts[m]; i < mesh_starts[m + 1]; i++){
+                    cull_instances.push_back(sorted_instances[i]);
+                    cull_candidates.push_back({m, command_index});
+                }
+            }
+
+            frame_commands.push_back(command);
+            bucket.command_count++;
+            if(mesh.index_type == VK_INDEX_TYPE_UINT16){
+                bucket.uint16_command_count++;
+            }
+        }
+
+        //The cluster runs start out empty and zeroed, culling fills in as many commands as it finds visible clusters
+        bucket.cluster_first_command = static_cast<uint32_t>(frame_commands.size());
+        for(size_t c = first_cluster_candidate; c < cluster_candidates.size(); c++){
+            cluster_candidates[c].command += bucket.cluster_first_command;
+        }
+        if(bucket.cluster_command_count > max_draw_indirect_count){
+            throw std::runtime_error("A bucket has more clusters than one indirect draw can take.");
+        }
+        frame_commands.resize(frame_commands.size() + bucket.cluster_command_count, VkDrawIndexedIndirectCommand{});
+
+        uint32_t* bucket_counts = counts + b * CT_DRAW_BATCHER_COUNTS_PER_BUCKET;
+        bucket_counts[0] = bucket.uint16_command_count;
+        bucket_counts[1] = bucket.command_count - bucket.uint16_command_count;
+        bucket_counts[2] = 0;
+        bucket_counts[3] = 0;
+    }
+
+    if(frame_commands.size() > max_draws){
+        throw std::runtime_error("Too many indirect draws for one frame. Give the draw batcher more.");
+    }
+
+    memcpy(commands, frame_commands.data(), frame_commands.size() * sizeof(VkDrawIndexedIndirectCommand));
+}
+
+//The GPU only ever fills in instance counts the CPU left at zero, so this needs multi draw indirect to have anything to read them
+void CtDrawBatcher::SetGpuCulled(bool is_gpu_culled){
+    if(is_gpu_culled && !device->GetOptionalFeatures().multi_draw_indirect){
+        throw std::runtime_error("GPU culling needs multi draw indirect.");
+    }
+
+    gpu_culled = is_gpu_culled;
+}
+
+//Only the count version can draw however many clusters the GPU decided on
+void CtDrawBatcher::SetClusterCulled(bool is_cluster_culled){
+    const CtDeviceOptionalFeatures& features = device->GetOptionalFeatures();
+    if(is_cluster_culled && !(features.multi_draw_indirect && features.draw_indirect_count)){
+        throw std::runtime_error("Cluster culling needs multi draw indirect and draw indirect count.");
+    }
+
+    cluster_culled = is_cluster_culled;
+}
+
+void CtDrawBatcher::Bind(VkCommandBuffer command_buffer){
+    mesh_store->BindVertexBuffer(command_buffer, 0);
+
+    instance_buffer->Bind(command_buffer, CT_INSTANCE_BINDING);
+}
+
+//Build put the 16 bit meshes first, so a bucket is at most two runs with an index buffer bind in front of each, plus the same again for clusters
+void CtDrawBatcher::RecordBucket(VkCommandBuffer command_buffer, uint32_t bucket){
+    const CtDrawBucket& draw_bucket = buckets[bucket];
+
+    RecordRun(command_buffer, bucket, 0, draw_bucket.uint16_command_count, VK_INDEX_TYPE_UINT16);
+    RecordClusterRun(command_buffer, bucket, 0, draw_bucket.uint16_cluster_command_count, VK_INDEX_TYPE_UINT16);
+    RecordRun(command_buffer, bucket, draw_bucket.uint16_command_count, draw_bucket.command_count - draw_bucket.uint16_command_count, VK_INDEX_TYPE_UINT32);
+    RecordClusterRun(command_buffer, bucket, draw_bucket.uint16_cluster_command_count,
+        draw_bucket.cluster_command_count - draw_bucket.uint16_cluster_command_count, VK_INDEX_TYPE_UINT32);
+}
+
+//With the count version the GPU reads how many commands there are, so whatever writes the counts (us now, a culling pass later)
+//decides how much gets drawn. Without multi draw every command is its own direct draw, which is still one per mesh and not one per object
+void CtDrawBatcher::RecordRun(VkCommandBuffer command_buffer, uint32_t bucket, uint32_t first_command, uint32_t command_count, VkIndexType index_type){
+    if(command_count == 0){
+        return;
+    }
+
+    mesh_store->BindIndexBuffer(command_buffer, index_type);
+
+    const CtDrawBucket& draw_bucket = buckets[bucket];
+    const CtDeviceOptionalFeatures& features = device->GetOptionalFeatures();
+    uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    VkDeviceSize indirect_offset = GetIndirectOffset(bucket) + static_cast<VkDeviceSize>(first_command) * stride;
+
+    if(!features.multi_draw_indirect){
+        for(uint32_t c = 0; c < command_count; c++){
+            const VkDrawIndexedIndirectCommand& command = frame_commands[draw_bucket.first_command + first_command + c];
+            vkCmdDrawIndexed(command_buffer, command.indexCount, command.instanceCount, command.firstIndex, command.vertexOffset, command.firstInstance);
+        }
+        return;
+    }
+
+    if(features.draw_indirect_count && command_count <= max_draw_indirect_count){
+        device->CmdDrawIndexedIndirectCount(command_buffer, indirect_buffer, indirect_offset, count_buffer, GetCountOffset(bucket, index_type),
+            command_count, stride);
+        return;
+    }
+
+    //The device caps how many commands one call can take, so really big runs go out in a few pieces
+    for(uint32_t c = 0; c < command_count; c += max_draw_indirect_count){
+        uint32_t remaining = command_count - c;
+        uint32_t draw_count = remaining < max_draw_indirect_count ? remaining : max_draw_indirect_count;
+
+        vkCmdDrawIndexedIndirect(command_buffer, indirect_buffer, indirect_offset + static_cast<VkDeviceSize>(c) * stride, draw_count, stride);
+    }
+}
+
+//command_count is only how much room there is. The count the culling pass wrote decides how many actually draw
+void CtDrawBatcher::RecordClusterRun(VkCommandBuffer command_buffer, uint32_t bucket, uint32_t first_command, uint32_t command_count, VkIndexType index_type){
+    if(command_count == 0){
+        return;
+    }
+
+    mesh_store->BindIndexBuffer(command_buffer, index_type);
+
+    uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    VkDeviceSize indirect_offset = (static_cast<VkDeviceSize>(max_draws) * current_frame + buckets[bucket].cluster_first_command + first_command) * stride;
+
+    device->CmdDrawIndexedIndirectCount(command_buffer, indirect_buffer, indirect_offset, count_buffer, GetClusterCountOffset(bucket, index_type),
+        command_count, stride);
+}
+
+VkDeviceSize CtDrawBatcher::GetIndirectOffset(uint32_t bucket){
+    return (static_cast<VkDeviceSize>(max_draws) * current_frame + buckets[bucket].first_command) * sizeof(VkDrawIndexedIndirectCommand);
+}
+
+VkDeviceSize CtDrawBatcher::GetIndirectSize(){
+    return static_cast<VkDeviceSize>(max_draws) * max_frames_in_flight * sizeof(VkDrawIndexedIndirectCommand);
+}
+
+VkDeviceSize CtDrawBatcher::GetCountSize(){
+    return static_cast<VkDeviceSize>(CT_DRAW_BATCHER_MAX_BUCKETS) * CT_DRAW_BATCHER_COUNTS_PER_BUCKET * max_frames_in_flight * sizeof(uint32_t);
+}
+
+//Each bucket has a count for its 16 bit run followed by one for its 32 bit run, then the same for its cluster runs
+VkDeviceSize CtDrawBatcher::GetCountOffset(uint32_t bucket, VkIndexType index_type){
+    uint32_t slot = bucket * CT_DRAW_BATCHER_COUNTS_PER_BUCKET + (index_type == VK_INDEX_TYPE_UINT16 ? 0 : 1);
+    return (static_cast<VkDeviceSize>(GetCountBase()) + slot) * sizeof(uint32_t);
+}
+
+VkDeviceSize CtDrawBatcher::GetClusterCountOffset(uint32_t bucket, VkIndexType index_type){
+    uint32_t slot = bucket * CT_DRAW_BATCHER_COUNTS_PER_BUCKET + (index_type == VK_INDEX_TYPE_UINT16 ? 2 : 3);
+    return (static_cast<VkDeviceSize>(GetCountBase()) + slot) * sizeof(uint32_t);
+}
+
+/**************************************************************BUFFERS*****************************************************************/
+
+void CtDrawBatcher::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& buffer_memory){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    VkBufferCreateInfo buffer_info {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = size;
+    buffer_info.usage = usage;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    //The indirect and count buffers get filled in by culling, and that can run on the compute queue
+    if(usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT){
+        device->ShareAcrossQueues(buffer_info);
+    }
+
+    if(vkCreateBuffer(interface_device, &buffer_info, nullptr, &buffer) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create a draw batcher buffer.");
+    }
+
+    VkMemoryRequirements memory_requirements;
+    vkGetBufferMemoryRequirements(interface_device, buffer, &memory_requirements);
+
+    VkMemoryAllocateInfo allocate_info {};
+    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocate_info.allocationSize = memory_requirements.size;
+    allocate_info.memoryTypeIndex = device->FindMemoryType(memory_requirements.memoryTypeBits, properties);
+
+    if(vkAllocateMemory(interface_device, &allocate_info, nullptr, &buffer_memory) != VK_SUCCESS){
+        throw std::runtime_error("Failed to allocate draw batcher memory.");
+    }
+
+    vkBindBufferMemory(interface_device, buffer, buffer_memory, 0);
+}
+
+void* CtDrawBatcher::CreateMappedBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& buffer_memory){
+    CreateBuffer(size, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, buffer, buffer_memory);
+
+    void* data;
+    if(vkMapMemory(*(device->GetInterfaceDevice()), buffer_memory, 0, size, 0, &data) != VK_SUCCESS){
+        throw std::runtime_error("Failed to map draw batcher memory.");
+    }
+
+    return data;
+}
+
+void CtDrawBatcher::Cleanup(){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    vkUnmapMemory(interface_device, indirect_buffer_memory);
+    vkUnmapMemory(interface_device, count_buffer_memory);
+
+    vkDestroyBuffer(interface_device, indirect_buffer, nullptr);
+    vkFreeMemory(interface_device, indirect_buffer_memory, nullptr);
+    vkDestroyBuffer(interface_device, count_buffer, nullptr);
+    vkFreeMemory(interface_device, count_buffer_memory, nullptr);
+}
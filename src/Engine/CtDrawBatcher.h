@@ -0,0 +1,194 @@
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <cstdint>
+
+class CtDevice;
+class CtMeshStore;
+class CtInstanceBuffer;
+struct CtInstanceData;
+
+//How many pipeline buckets the batcher keeps draw counts for
+const uint32_t CT_DRAW_BATCHER_MAX_BUCKETS = 16;
+
+//Every bucket has a draw count for its 16 and 32 bit mesh runs, then one for each of its cluster runs
+const uint32_t CT_DRAW_BATCHER_COUNTS_PER_BUCKET = 4;
+
+//One object the frame wants drawn
+struct CtBatchedDraw{
+    uint32_t mesh_id;
+    uint32_t instance_index; //Into the bucket's instances
+};
+
+//An object that the GPU still has to decide on. Its instance sits at the same index in the batcher's cull instances
+struct CtCullCandidate{
+    uint32_t mesh_id;
+    uint32_t command; //From the start of the frame's commands
+};
+
+//One object made of clusters that the GPU culls a cluster at a time. Its instance sits at the same index in the batcher's cluster instances
+struct CtClusterCandidate{
+    uint32_t mesh_id;
+    uint32_t first_instance; //What the cluster draws use as firstInstance
+    uint32_t command; //First command of its cluster run, from the start of the frame's commands
+    uint32_t count; //Its run's draw count, from the start of the frame's counts
+};
+
+//What LOD selection measures screen space error from. The camera works the same way it does for cluster culling
+struct CtLodView{
+    glm::vec4 camera; //World position with w = 1, or the view direction of an orthographic camera with w = 0
+
+    //Pixels one world unit covers at a distance of 1, which is the viewport height over 2 tan(fov / 2). Orthographic cameras
+    //don't shrink anything with distance, so there it's just pixels per unit
+    float pixels_per_unit;
+
+    //Draws the coarsest level whose error comes out to at most this many pixels
+    float max_pixel_error;
+};
+
+//Everything one pipeline draws this frame. After Build, its commands sit one after another in the frame's indirect region
+struct CtDrawBucket{
+    std::vector<CtBatchedDraw> draws;
+    std::vector<CtInstanceData> instances;
+
+    uint32_t first_command;
+    uint32_t command_count;
+
+    //How many of those, from the front, draw out of 16 bit indices. The rest use 32 bit ones
+    uint32_t uint16_command_count;
+
+    //Room for every cluster the bucket's clustered objects could draw, right after its commands. 16 bit ones first again,
+    //and cluster culling appends to whichever run a visible cluster belongs to
+    uint32_t cluster_first_command;
+    uint32_t cluster_command_count;
+    uint32_t uint16_cluster_command_count;
+};
+
+//Draws whatever is in the mesh store. Each frame, objects get sorted into their pipeline's bucket and grouped by mesh, every mesh becomes one
+//VkDrawIndexedIndirectCommand instancing over its objects, and each bucket goes out as a single vkCmdDrawIndexedIndirect (or the count
+//version when we have it) per index type. Past filling in the instances, recording a bucket costs the same no matter how many objects are in it
+class CtDrawBatcher{
+
+    public:
+        static CtDrawBatcher* CreateDrawBatcher(CtDevice* device, CtMeshStore* mesh_store, CtInstanceBuffer* instance_buffer, uint32_t max_draws,
+            uint32_t max_frames_in_flight);
+
+        //Buckets are just indices. Each pipeline should get its own
+        uint32_t AddBucket();
+
+        //Call once the frame's fence has signaled. Empties every bucket
+        void BeginFrame(uint32_t frame);
+
+        //Meshes with a LOD chain get drawn at whichever level SetLodView says is enough, mesh_id should be the full detail one
+        void AddDraw(uint32_t bucket, uint32_t mesh_id, const CtInstanceData& instance);
+
+        //Call before the frame's draws are added. Until it's called everything draws at full detail
+        void SetLodView(const CtLodView& view);
+
+        //Sorts the draws, writes the instances and the indirect commands. Has to happen before any bucket is recorded
+        void Build();
+
+        //When the GPU culls, Build leaves every command at zero instances and only reserves room for them. The objects go into the
+        //cull candidates instead, and the culling pass adds each one that survives to its command
+        void SetGpuCulled(bool is_gpu_culled);
+        bool IsGpuCulled(){
+            return gpu_culled;
+        }
+        const std::vector<CtInstanceData>& GetCullInstances(){
+            return cull_instances;
+        }
+        const std::vector<CtCullCandidate>& GetCullCandidates(){
+            return cull_candidates;
+        }
+        const glm::vec4& GetMeshBounds(uint32_t mesh_id);
+
+        //When clusters are culled, objects whose mesh has clusters skip the commands above. Their instances still go up as normal, and they
+        //become cluster candidates that a culling pass turns into one command per visible cluster. Needs the count version of indirect draws
+        void SetClusterCulled(bool is_cluster_culled);
+        bool IsClusterCulled(){
+            return cluster_culled;
+        }
+        const std::vector<CtInstanceData>& GetClusterInstances(){
+            return cluster_instances;
+        }
+        const std::vector<CtClusterCandidate>& GetClusterCandidates(){
+            return cluster_candidates;
+        }
+
+        //Binds the shared vertex buffer along with this frame's instances. The index buffer goes with each run of one index type
+        void Bind(VkCommandBuffer command_buffer);
+
+        void RecordBucket(VkCommandBuffer command_buffer, uint32_t bucket);
+
+        //For anything that wants to write or cull the commands on the GPU
+        VkBuffer GetIndirectBuffer(){
+            return indirect_buffer;
+        }
+        VkBuffer GetCountBuffer(){
+            return count_buffer;
+        }
+        VkDeviceSize GetIndirectOffset(uint32_t bucket);
+        VkDeviceSize GetCountOffset(uint32_t bucket, VkIndexType index_type);
+        VkDeviceSize GetClusterCountOffset(uint32_t bucket, VkIndexType index_type);
+        VkDeviceSize GetIndirectSize();
+        VkDeviceSize GetCountSize();
+
+        //Where this frame's commands start, in commands from the front of the indirect buffer
+        uint32_t GetCommandBase(){
+            return max_draws * current_frame;
+        }
+
+        //Where this frame's counts start, in counts from the front of the count buffer
+        uint32_t GetCountBase(){
+            return CT_DRAW_BATCHER_MAX_BUCKETS * CT_DRAW_BATCHER_COUNTS_PER_BUCKET * current_frame;
+        }
+
+        void Cleanup();
+
+    private:
+
+        CtDevice* device;
+        CtMeshStore* mesh_store;
+        CtInstanceBuffer* instance_buffer;
+
+        //Every mesh, 16 bit ones first. Commands come out in this order so each index type is one run in its bucket
+        std::vector<uint32_t> mesh_order;
+
+        //Per frame regions of commands and of one draw count per bucket and index type, written straight from the CPU
+        VkBuffer indirect_buffer;
+        VkDeviceMemory indirect_buffer_memory;
+        VkDrawIndexedIndirectCommand* mapped_commands;
+        VkBuffer count_buffer;
+        VkDeviceMemory count_buffer_memory;
+        uint32_t* mapped_counts;
+
+        uint32_t max_draws;
+        uint32_t current_frame;
+
+        std::vector<CtDrawBucket> buckets;
+
+        bool gpu_culled;
+        std::vector<CtInstanceData> cull_instances;
+        std::vector<CtCullCandidate> cull_candidates;
+        uint32_t max_frames_in_flight;
+
+        bool cluster_culled;
+        std::vector<CtInstanceData> cluster_instances;
+        std::vector<CtClusterCandidate> cluster_candidates;
+
+        //For the direct path when there's no multi draw, and for buckets bigger than the device allows in one call
+        std::vector<VkDrawIndexedIndirectCommand> frame_commands;
+        uint32_t max_draw_indirect_count;
+
+        bool lod_selection;
+        CtLodView lod_view;
+
+        void SortMeshes();
+        uint32_t SelectLod(uint32_t mesh_id, const CtInstanceData& instance);
+        void RecordRun(VkCommandBuffer command_buffer, uint32_t bucket, uint32_t first_command, uint32_t command_count, VkIndexType index_type);
+        void RecordClusterRun(VkCommandBuffer command_buffer, uint32_t bucket, uint32_t first_command, uint32_t command_count, VkIndexType index_type);
+
+        void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& buffer_memory);
+        void* CreateMappedBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VkDeviceMemory& buffer_memory);
+};
@@ -0,0 +1,622 @@
+#include "CtGltfImport.h"
+#include "CtJson.h"
+#include "CtMappedFile.h"
+#include "CtMeshImport.h"
+#include "CtMeshStore.h"
+#include "CtVertex.h"
+#include "CtOrderedWork.h"
+#include <stdexcept>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <cstring>
+
+//"glTF" and the two chunk types of a .glb, read as little endian uint32s
+const uint32_t CT_GLTF_GLB_MAGIC = 0x46546C67;
+const uint32_t CT_GLTF_GLB_CHUNK_JSON = 0x4E4F534A;
+const uint32_t CT_GLTF_GLB_CHUNK_BIN = 0x004E4942;
+
+//Accessor component types, they're the GL enums
+const uint32_t CT_GLTF_BYTE = 5120;
+const uint32_t CT_GLTF_UNSIGNED_BYTE = 5121;
+const uint32_t CT_GLTF_SHORT = 5122;
+const uint32_t CT_GLTF_UNSIGNED_SHORT = 5123;
+const uint32_t CT_GLTF_UNSIGNED_INT = 5125;
+const uint32_t CT_GLTF_FLOAT = 5126;
+
+const uint32_t CT_GLTF_MODE_TRIANGLES = 4;
+
+CtGltfScene CtGltfImport::Import(const std::string& path, const std::function<uint32_t(CtMeshData&)>& consume, bool optimize,
+    uint32_t thread_count){
+
+    CtGltfDocument document;
+    document.path = path;
+
+    //The .gltf's JSON or the whole .glb. A .glb's binary chunk gets read straight out of this, so it stays mapped until the end
+    CtMappedFile* file = CtMappedFile::Open(path, false);
+    document.mappings.push_back(file);
+
+    CtJsonValue json;
+    CtGltfScene scene {};
+
+    try{
+        const uint8_t* data = file->GetData();
+        const char* text = reinterpret_cast<const char*>(data);
+        uint64_t text_size = file->GetSize();
+        const uint8_t* glb_binary = nullptr;
+        uint64_t glb_binary_size = 0;
+
+        uint32_t magic = 0;
+        if(file->GetSize() >= 12){
+            memcpy(&magic, data, sizeof(magic));
+        }
+
+        //A 12 byte header then chunks, each a length and a type followed by the data padded out to 4 bytes. The JSON comes first and
+        //the binary chunk, if there is one, right after it
+        if(magic == CT_GLTF_GLB_MAGIC){
+            uint32_t version = 0;
+            uint32_t length = 0;
+            memcpy(&version, data + 4, sizeof(version));
+            memcpy(&length, data + 8, sizeof(length));
+            if(version != 2 || length > file->GetSize()){
+                throw std::runtime_error(path + " isn't a glTF 2.0 binary or was cut short.");
+            }
+
+            text = nullptr;
+            uint64_t offset = 12;
+            while(offset + 8 <= length){
+                uint32_t chunk_length = 0;
+                uint32_t chunk_type = 0;
+                memcpy(&chunk_length, data + offset, sizeof(chunk_length));
+                memcpy(&chunk_type, data + offset + 4, sizeof(chunk_type));
+                offset += 8;
+
+                if(chunk_length > length - offset){
+                    throw std::runtime_error(path + " has a chunk past the end of the file.");
+                }
+
+                if(chunk_type == CT_GLTF_GLB_CHUNK_JSON && text == nullptr){
+                    text = reinterpret_cast<const char*>(data + offset);
+                    text_size = chunk_length;
+                }
+                else if(chunk_type == CT_GLTF_GLB_CHUNK_BIN && glb_binary == nullptr){
+                    glb_binary = data + offset;
+                    glb_binary_size = chunk_length;
+                }
+
+                offset += (static_cast<uint64_t>(chunk_length) + 3) & ~static_cast<uint64_t>(3);
+            }
+
+            if(text == nullptr){
+                throw std::runtime_error(path + " has no JSON chunk.");
+            }
+        }
+
+        json = CtJson::Parse(text, text_size);
+        document.json = &json;
+
+        if(json["asset"]["version"].GetString().compare(0, 2, "2.") != 0){
+            throw std::runtime_error(path + " isn't glTF 2.0.");
+        }
+
+        OpenBuffers(document, glb_binary, glb_binary_size);
+
+        auto get_accessor = [](const CtJsonValue& value){
+            return value.type == CT_JSON_NUMBER ? static_cast<int32_t>(value.number) : -1;
+        };
+
+        //Every triangle primitive in file order. That's the order they're handed out in too, so mesh ids come out the same every load
+        std::vector<CtGltfPrimitive> primitives;
+        const CtJsonValue& meshes = json["meshes"];
+        scene.meshes.resize(meshes.Size());
+        document.mesh_colors.resize(meshes.Size());
+        uint32_t skipped = 0;
+        for(uint32_t m = 0; m < meshes.Size(); m++){
+            for(const auto& primitive : meshes[m]["primitives"].array){
+                const CtJsonValue& attributes = primitive["attributes"];
+                if(primitive["mode"].GetUint(CT_GLTF_MODE_TRIANGLES) != CT_GLTF_MODE_TRIANGLES || attributes["POSITION"].IsNull()){
+                    skipped++;
+                    continue;
+                }
+
+                primitives.push_back({m, get_accessor(attributes["POSITION"]), get_accessor(attributes["NORMAL"]),
+                    get_accessor(attributes["TEXCOORD_0"]), get_accessor(attributes["COLOR_0"]), get_accessor(primitive["indices"])});
+
+                const CtJsonValue& factor = json["materials"][primitive["material"].GetUint(UINT32_MAX)]["pbrMetallicRoughness"]["baseColorFactor"];
+                document.mesh_colors[m].push_back(glm::vec4(static_cast<float>(factor[0].GetNumber(1.0)), static_cast<float>(factor[1].GetNumber(1.0)),
+                    static_cast<float>(factor[2].GetNumber(1.0)), static_cast<float>(factor[3].GetNumber(1.0))));
+            }
+        }
+        if(skipped > 0){
+            printf("Skipped %u glTF primitives in %s that aren't triangle lists.\n", skipped, path.c_str());
+        }
+
+        uint32_t primitive_count = static_cast<uint32_t>(primitives.size());
+        if(thread_count == 0){
+            thread_count = std::min(std::max(std::thread::hardware_concurrency(), 1u), CT_MESH_IMPORT_MAX_THREADS);
+        }
+
+        //Only a few decoded primitives exist at once however many there are, see CtRunOrdered
+        CtRunOrdered<CtMeshData>(primitive_count, thread_count, thread_count * CT_GLTF_IMPORT_PENDING_PER_THREAD,
+            [&](uint32_t p, CtMeshData& mesh){
+                DecodePrimitive(document, primitives[p], mesh, optimize);
+            },
+            [&](uint32_t p, CtMeshData& mesh){
+                scene.primitive_count++;
+                scene.vertex_count += mesh.vertices.size();
+                scene.index_count += mesh.indices.size();
+                scene.meshes[primitives[p].mesh].push_back(consume(mesh));
+            });
+
+        //Only the default scene gets placed. Without any scenes every node that isn't something else's child is a root
+        const CtJsonValue& scenes = json["scenes"];
+        const CtJsonValue& nodes = json["nodes"];
+        if(scenes.Size() > 0){
+            for(const auto& root : scenes[json["scene"].GetUint(0)]["nodes"].array){
+                AddNode(document, root.GetUint(UINT32_MAX), glm::mat4(1.0f), 0, scene);
+            }
+        }
+        else{
+            std::vector<uint8_t> is_child(nodes.Size(), 0);
+            for(const auto& node : nodes.array){
+                for(const auto& child : node["children"].array){
+                    if(child.GetUint(UINT32_MAX) < is_child.size()){
+                        is_child[child.GetUint(UINT32_MAX)] = 1;
+                    }
+                }
+            }
+            for(uint32_t n = 0; n < nodes.Size(); n++){
+                if(is_child[n] == 0){
+                    AddNode(document, n, glm::mat4(1.0f), 0, scene);
+                }
+            }
+        }
+    } catch(...){
+        for(auto mapping : document.mappings){
+            mapping->Close();
+            delete mapping;
+        }
+        throw;
+    }
+
+    for(auto mapping : document.mappings){
+        mapping->Close();
+        delete mapping;
+    }
+
+    return scene;
+}
+
+CtGltfScene CtGltfImport::Load(const std::string& path, CtMeshStore* mesh_store, bool optimize){
+    auto start = std::chrono::steady_clock::now();
+
+    CtGltfScene scene = Import(path, [mesh_store](CtMeshData& mesh){
+        return mesh_store->AddMesh(mesh.vertices, mesh.indices);
+    }, optimize);
+
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("Loaded glTF %s (%u primitives, %llu vertices, %u objects) in %.2f ms.\n", path.c_str(), scene.primitive_count,
+        static_cast<unsigned long long>(scene.vertex_count), static_cast<uint32_t>(scene.objects.size()), milliseconds);
+
+    return scene;
+}
+
+/**************************************************************BUFFERS*****************************************************************/
+
+//Buffers in their own files get mapped and embedded ones get decoded, a .glb's binary chunk is already mapped with the file
+void CtGltfImport::OpenBuffers(CtGltfDocument& document, const uint8_t* glb_binary, uint64_t glb_binary_size){
+    const CtJsonValue& buffers = (*document.json)["buffers"];
+    document.buffers.resize(buffers.Size());
+
+    size_t slash = document.path.find_last_of("/\\");
+    std::string directory = slash == std::string::npos ? "" : document.path.substr(0, slash + 1);
+
+    for(uint32_t b = 0; b < buffers.Size(); b++){
+        const CtJsonValue& buffer = buffers[b];
+        const std::string& uri = buffer["uri"].GetString();
+        CtGltfBuffer& out = document.buffers[b];
+
+        if(buffer["uri"].IsNull()){
+            //Only a .glb's first buffer is allowed to leave the uri out, it means the binary chunk
+            if(b != 0 || glb_binary == nullptr){
+                throw std::runtime_error(document.path + " has a buffer without any data.");
+            }
+            out.data = glb_binary;
+            out.size = glb_binary_size;
+        }
+        else if(uri.compare(0, 5, "data:") == 0){
+            //There's nothing to map here, embedded buffers have to be decoded into memory whole
+            size_t comma = uri.find(',');
+            if(comma == std::string::npos || uri.rfind(";base64", comma) == std::string::npos){
+                throw std::runtime_error(document.path + " has a data URI that isn't base64.");
+            }
+            out.decoded = DecodeBase64(uri, comma + 1);
+            out.data = out.decoded.data();
+            out.size = out.decoded.size();
+        }
+        else{
+            //Relative to the .gltf, with any %XX escapes undone
+            std::string file_path = directory;
+            for(size_t c = 0; c < uri.size(); c++){
+                if(uri[c] == '%' && c + 2 < uri.size()){
+                    file_path.push_back(static_cast<char>(strtoul(uri.substr(c + 1, 2).c_str(), nullptr, 16)));
+                    c += 2;
+                }
+                else{
+                    file_path.push_back(uri[c]);
+                }
+            }
+
+            CtMappedFile* mapping = CtMappedFile::Open(file_path, false);
+            document.mappings.push_back(mapping);
+            out.data = mapping->GetData();
+            out.size = mapping->GetSize();
+        }
+
+        uint64_t byte_length = static_cast<uint64_t>(buffer["byteLength"].GetNumber(0.0));
+        if(out.size < byte_length){
+            throw std::runtime_error(document.path + " has a buffer shorter than its byteLength.");
+        }
+        out.size = byte_length;
+    }
+}
+
+std::vector<uint8_t> CtGltfImport::DecodeBase64(const std::string& text, size_t offset){
+    std::vector<uint8_t> bytes;
+    bytes.reserve((text.size() - offset) / 4 * 3);
+
+    uint32_t bits = 0;
+    uint32_t bit_count = 0;
+    for(size_t c = offset; c < text.size() && text[c] != '='; c++){
+        char character = text[c];
+        uint32_t value;
+        if(character >= 'A' && character <= 'Z'){
+            value = character - 'A';
+        }
+        else if(character >= 'a' && character <= 'z'){
+            value = character - 'a' + 26;
+        }
+        else if(character >= '0' && character <= '9'){
+            value = character - '0' + 52;
+        }
+        else if(character == '+' || character == '-'){
+            value = 62;
+        }
+        else if(character == '/' || character == '_'){
+            value = 63;
+        }
+        else{
+            continue;
+        }
+
+        bits = (bits << 6) | value;
+        bit_count += 6;
+        if(bit_count >= 8){
+            bit_count -= 8;
+            bytes.push_back(static_cast<uint8_t>(bits >> bit_count));
+        }
+    }
+
+    return bytes;
+}
+
+/**************************************************************DECODING****************************************************************/
+
+//Runs on a worker. Attributes that aren't there get the same defaults the test mesh would have
+void CtGltfImport::DecodePrimitive(const CtGltfDocument& document, const CtGltfPrimitive& primitive, CtMeshData& mesh, bool optimize){
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> texcoords;
+    std::vector<float> colors;
+
+    ReadAccessor(document, static_cast<uint32_t>(primitive.position), 3, 0.0f, positions);
+    uint32_t vertex_count = static_cast<uint32_t>(positions.size() / 3);
+
+    auto read_optional = [&](int32_t accessor, uint32_t component_count, float fill, std::vector<float>& values){
+        if(accessor < 0){
+            return;
+        }
+
+        ReadAccessor(document, static_cast<uint32_t>(accessor), component_count, fill, values);
+        if(values.size() != static_cast<size_t>(vertex_count) * component_count){
+            throw std::runtime_error(document.path + " has a primitive with attributes of different lengths.");
+        }
+    };
+    read_optional(primitive.normal, 3, 0.0f, normals);
+    read_optional(primitive.texcoord, 2, 0.0f, texcoords);
+    read_optional(primitive.color, 3, 1.0f, colors);
+
+    //CtVertex only has x and y so far, z goes nowhere
+    mesh.vertices.resize(vertex_count);
+    for(uint32_t v = 0; v < vertex_count; v++){
+        CtVertex& vertex = mesh.vertices[v];
+        vertex.position = glm::vec2(positions[v * 3], positions[v * 3 + 1]);
+        vertex.normal = normals.empty() ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(normals[v * 3], normals[v * 3 + 1], normals[v * 3 + 2]);
+        vertex.texCoord = texcoords.empty() ? glm::vec2(0.0f) : glm::vec2(texcoords[v * 2], texcoords[v * 2 + 1]);
+        vertex.color = colors.empty() ? glm::vec3(1.0f) : glm::vec3(colors[v * 3], colors[v * 3 + 1], colors[v * 3 + 2]);
+    }
+
+    if(primitive.indices >= 0){
+        ReadIndices(document, static_cast<uint32_t>(primitive.indices), vertex_count, mesh.indices);
+    }
+    else{
+        mesh.indices.resize(vertex_count - vertex_count % 3);
+        for(uint32_t i = 0; i < mesh.indices.size(); i++){
+            mesh.indices[i] = i;
+        }
+    }
+
+    if(mesh.indices.size() % 3 != 0){
+        throw std::runtime_error(document.path + " has a triangle list that doesn't end on a whole triangle.");
+    }
+
+    //The same passes as CtMeshImport::Optimize without the stats, which would be one printf per primitive
+    if(optimize && !mesh.indices.empty()){
+        CtMeshImport::OptimizeVertexCache(mesh, CT_MESH_IMPORT_CACHE_SIZE);
+        CtMeshImport::OptimizeVertexFetch(mesh);
+    }
+}
+
+//Sparse accessors start from their buffer view, or zeros without one, and then have the listed elements replaced
+void CtGltfImport::ReadAccessor(const CtGltfDocument& document, uint32_t accessor_index, uint32_t component_count, float fill,
+    std::vector<float>& values){
+
+    const CtJsonValue& accessor = (*document.json)["accessors"][accessor_index];
+    if(accessor.IsNull()){
+        throw std::runtime_error(document.path + " points at an accessor that isn't there.");
+    }
+
+    uint32_t count = accessor["count"].GetUint(0);
+    uint32_t component_type = accessor["componentType"].GetUint(0);
+    uint32_t component_size = GetComponentSize(component_type);
+    uint32_t accessor_components = GetComponentCount(accessor["type"].GetString());
+    uint32_t read_components = std::min(component_count, accessor_components);
+    bool normalized = accessor["normalized"].GetBool(false);
+
+    values.assign(static_cast<size_t>(count) * component_count, fill);
+
+    if(!accessor["bufferView"].IsNull()){
+        uint32_t stride = 0;
+        const uint8_t* elements = FindElements(document, accessor["bufferView"].GetUint(UINT32_MAX),
+            static_cast<uint64_t>(accessor["byteOffset"].GetNumber(0.0)), count, accessor_components * component_size, stride);
+
+        for(uint32_t e = 0; e < count; e++){
+            const uint8_t* element = elements + static_cast<size_t>(e) * stride;
+            for(uint32_t c = 0; c < read_components; c++){
+                values[static_cast<size_t>(e) * component_count + c] = ReadComponent(element + c * component_size, component_type, normalized);
+            }
+        }
+    }
+    else{
+        for(uint32_t e = 0; e < count; e++){
+            for(uint32_t c = 0; c < read_components; c++){
+                values[static_cast<size_t>(e) * component_count + c] = 0.0f;
+            }
+        }
+    }
+
+    const CtJsonValue& sparse = accessor["sparse"];
+    if(sparse.IsNull()){
+        return;
+    }
+
+    uint32_t sparse_count = sparse["count"].GetUint(0);
+    const CtJsonValue& sparse_indices = sparse["indices"];
+    const CtJsonValue& sparse_values = sparse["values"];
+    uint32_t index_type = sparse_indices["componentType"].GetUint(0);
+
+    uint32_t index_stride = 0;
+    uint32_t value_stride = 0;
+    const uint8_t* index_data = FindElements(document, sparse_indices["bufferView"].GetUint(UINT32_MAX),
+        static_cast<uint64_t>(sparse_indices["byteOffset"].GetNumber(0.0)), sparse_count, GetComponentSize(index_type), index_stride);
+    const uint8_t* value_data = FindElements(document, sparse_values["bufferView"].GetUint(UINT32_MAX),
+        static_cast<uint64_t>(sparse_values["byteOffset"].GetNumber(0.0)), sparse_count, accessor_components * component_size, value_stride);
+
+    for(uint32_t s = 0; s < sparse_count; s++){
+        uint32_t e = ReadIndex(index_data + static_cast<size_t>(s) * index_stride, index_type);
+        if(e >= count){
+            throw std::runtime_error(document.path + " has a sparse accessor pointing past its elements.");
+        }
+
+        const uint8_t* element = value_data + static_cast<size_t>(s) * value_stride;
+        for(uint32_t c = 0; c < read_components; c++){
+            values[static_cast<size_t>(e) * component_count + c] = ReadComponent(element + c * component_size, component_type, normalized);
+        }
+    }
+}
+
+void CtGltfImport::ReadIndices(const CtGltfDocument& document, uint32_t accessor_index, uint32_t vertex_count, std::vector<uint32_t>& indices){
+    const CtJsonValue& accessor = (*document.json)["accessors"][accessor_index];
+    uint32_t component_type = accessor["componentType"].GetUint(0);
+    if(accessor.IsNull() || accessor["bufferView"].IsNull() || !accessor["sparse"].IsNull() ||
+        (component_type != CT_GLTF_UNSIGNED_BYTE && component_type != CT_GLTF_UNSIGNED_SHORT && component_type != CT_GLTF_UNSIGNED_INT)){
+        throw std::runtime_error(document.path + " has indices that aren't plain unsigned integers in a buffer view.");
+    }
+
+    uint32_t count = accessor["count"].GetUint(0);
+    uint32_t stride = 0;
+    const uint8_t* elements = FindElements(document, accessor["bufferView"].GetUint(UINT32_MAX),
+        static_cast<uint64_t>(accessor["byteOffset"].GetNumber(0.0)), count, GetComponentSize(component_type), stride);
+
+    indices.resize(count);
+    for(uint32_t i = 0; i < count; i++){
+        indices[i] = ReadIndex(elements + static_cast<size_t>(i) * stride, component_type);
+        if(indices[i] >= vertex_count){
+            throw std::runtime_error(document.path + " has an index past the end of its vertices.");
+        }
+    }
+}
+
+const uint8_t* CtGltfImport::FindElements(const CtGltfDocument& document, uint32_t buffer_view_index, uint64_t byte_offset, uint32_t count,
+    uint32_t element_size, uint32_t& stride){
+
+    const CtJsonValue& buffer_view = (*document.json)["bufferViews"][buffer_view_index];
+    uint32_t buffer = buffer_view["buffer"].GetUint(UINT32_MAX);
+    if(buffer_view.IsNull() || buffer >= document.buffers.size()){
+        throw std::runtime_error(document.path + " points at a buffer view that isn't there.");
+    }
+
+    //Tightly packed unless the view says otherwise
+    stride = buffer_view["byteStride"].GetUint(element_size);
+    if(stride < element_size){
+        throw std::runtime_error(document.path + " has a buffer view with a stride smaller than its elements.");
+    }
+
+    const CtGltfBuffer& data = document.buffers[buffer];
+    uint64_t view_offset = static_cast<uint64_t>(buffer_view["byteOffset"].GetNumber(0.0));
+    uint64_t view_length = static_cast<uint64_t>(buffer_view["byteLength"].GetNumber(0.0));
+    if(view_offset > data.size || view_length > data.size - view_offset){
+        throw std::runtime_error(document.path + " has a buffer view past the end of its buffer.");
+    }
+
+    uint64_t needed = count == 0 ? 0 : byte_offset + static_cast<uint64_t>(count - 1) * stride + element_size;
+    if(needed > view_length){
+        throw std::runtime_error(document.path + " has an accessor past the end of its buffer view.");
+    }
+
+    return data.data + view_offset + byte_offset;
+}
+
+uint32_t CtGltfImport::GetComponentCount(const std::string& type){
+    if(type == "SCALAR"){
+        return 1;
+    }
+    if(type == "VEC2"){
+        return 2;
+    }
+    if(type == "VEC3"){
+        return 3;
+    }
+    if(type == "VEC4" || type == "MAT2"){
+        return 4;
+    }
+    if(type == "MAT3"){
+        return 9;
+    }
+    if(type == "MAT4"){
+        return 16;
+    }
+
+    throw std::runtime_error("Unknown glTF accessor type " + type + ".");
+}
+
+uint32_t CtGltfImport::GetComponentSize(uint32_t component_type){
+    switch(component_type){
+        case CT_GLTF_BYTE:
+        case CT_GLTF_UNSIGNED_BYTE:
+            return 1;
+        case CT_GLTF_SHORT:
+        case CT_GLTF_UNSIGNED_SHORT:
+            return 2;
+        case CT_GLTF_UNSIGNED_INT:
+        case CT_GLTF_FLOAT:
+            return 4;
+    }
+
+    throw std::runtime_error("Unknown glTF component type " + std::to_string(component_type) + ".");
+}
+
+//Normalized integers map onto [0, 1] or [-1, 1] the way the glTF spec says, the most negative signed value clamped to -1
+float CtGltfImport::ReadComponent(const uint8_t* data, uint32_t component_type, bool normalized){
+    switch(component_type){
+        case CT_GLTF_BYTE: {
+            int8_t value;
+            memcpy(&value, data, sizeof(value));
+            return normalized ? std::max(value / 127.0f, -1.0f) : static_cast<float>(value);
+        }
+        case CT_GLTF_UNSIGNED_BYTE: {
+            uint8_t value;
+            memcpy(&value, data, sizeof(value));
+            return normalized ? value / 255.0f : static_cast<float>(value);
+        }
+        case CT_GLTF_SHORT: {
+            int16_t value;
+            memcpy(&value, data, sizeof(value));
+            return normalized ? std::max(value / 32767.0f, -1.0f) : static_cast<float>(value);
+        }
+        case CT_GLTF_UNSIGNED_SHORT: {
+            uint16_t value;
+            memcpy(&value, data, sizeof(value));
+            return normalized ? value / 65535.0f : static_cast<float>(value);
+        }
+        case CT_GLTF_UNSIGNED_INT: {
+            uint32_t value;
+            memcpy(&value, data, sizeof(value));
+            return static_cast<float>(value);
+        }
+    }
+
+    float value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+uint32_t CtGltfImport::ReadIndex(const uint8_t* data, uint32_t component_type){
+    if(component_type == CT_GLTF_UNSIGNED_BYTE){
+        return data[0];
+    }
+    if(component_type == CT_GLTF_UNSIGNED_SHORT){
+        uint16_t value;
+        memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+/***************************************************************NODES******************************************************************/
+
+//Either a whole column major matrix or translation, rotation and scale applied scale first
+glm::mat4 CtGltfImport::GetNodeTransform(const CtJsonValue& node){
+    glm::mat4 transform(1.0f);
+
+    const CtJsonValue& matrix = node["matrix"];
+    if(matrix.Size() == 16){
+        for(uint32_t c = 0; c < 4; c++){
+            for(uint32_t r = 0; r < 4; r++){
+                transform[c][r] = static_cast<float>(matrix[c * 4 + r].GetNumber(c == r ? 1.0 : 0.0));
+            }
+        }
+        return transform;
+    }
+
+    const CtJsonValue& translation = node["translation"];
+    const CtJsonValue& rotation = node["rotation"];
+    const CtJsonValue& scale = node["scale"];
+
+    float x = static_cast<float>(rotation[0].GetNumber(0.0));
+    float y = static_cast<float>(rotation[1].GetNumber(0.0));
+    float z = static_cast<float>(rotation[2].GetNumber(0.0));
+    float w = static_cast<float>(rotation[3].GetNumber(1.0));
+    glm::vec3 s(static_cast<float>(scale[0].GetNumber(1.0)), static_cast<float>(scale[1].GetNumber(1.0)), static_cast<float>(scale[2].GetNumber(1.0)));
+
+    transform[0] = glm::vec4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w), 0.0f) * s.x;
+    transform[1] = glm::vec4(2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w), 0.0f) * s.y;
+    transform[2] = glm::vec4(2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y), 0.0f) * s.z;
+    transform[3] = glm::vec4(static_cast<float>(translation[0].GetNumber(0.0)), static_cast<float>(translation[1].GetNumber(0.0)),
+        static_cast<float>(translation[2].GetNumber(0.0)), 1.0f);
+
+    return transform;
+}
+
+void CtGltfImport::AddNode(const CtGltfDocument& document, uint32_t node_index, const glm::mat4& parent, uint32_t depth, CtGltfScene& scene){
+    const CtJsonValue& node = (*document.json)["nodes"][node_index];
+    if(node.IsNull() || depth > CT_GLTF_IMPORT_MAX_NODE_DEPTH){
+        throw std::runtime_error(document.path + " has a broken node hierarchy.");
+    }
+
+    glm::mat4 transform = parent * GetNodeTransform(node);
+
+    uint32_t mesh = node["mesh"].GetUint(UINT32_MAX);
+    if(mesh < scene.meshes.size()){
+        for(size_t p = 0; p < scene.meshes[mesh].size(); p++){
+            scene.objects.push_back({transform, document.mesh_colors[mesh][p], scene.meshes[mesh][p]});
+        }
+    }
+
+    for(const auto& child : node["children"].array){
+        AddNode(document, child.GetUint(UINT32_MAX), transform, depth + 1, scene);
+    }
+}
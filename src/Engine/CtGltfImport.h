@@ -0,0 +1,107 @@
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <functional>
+
+class CtMappedFile;
+class CtMeshStore;
+struct CtJsonValue;
+struct CtMeshData;
+
+//How many decoded primitives each worker can be ahead of the one being handed out. This is what bounds peak memory, at most
+//threads * this many primitives are ever sitting in RAM at once no matter how big the scene is
+const uint32_t CT_GLTF_IMPORT_PENDING_PER_THREAD = 2;
+
+//Nodes nested deeper than this are treated as a broken file, glTF doesn't allow cycles but a bad exporter can still write one
+const uint32_t CT_GLTF_IMPORT_MAX_NODE_DEPTH = 256;
+
+//One mesh primitive placed in the scene by a node
+struct CtGltfObject{
+    glm::mat4 transform; //Node to world, every parent's transform included
+    glm::vec4 color; //The material's base color factor, white without one
+    uint32_t mesh_id; //Whatever consume returned for the primitive
+};
+
+//What an import leaves behind. The vertex data itself is already gone by the time this comes back
+struct CtGltfScene{
+    //Per glTF mesh, the ids consume returned for each of its triangle primitives in order
+    std::vector<std::vector<uint32_t>> meshes;
+
+    //Every node with a mesh in the default scene, once per primitive
+    std::vector<CtGltfObject> objects;
+
+    uint32_t primitive_count;
+    uint64_t vertex_count;
+    uint64_t index_count;
+};
+
+//A buffer's bytes, either out of a mapping or decoded from a data URI
+struct CtGltfBuffer{
+    const uint8_t* data;
+    uint64_t size;
+    std::vector<uint8_t> decoded;
+};
+
+//Which accessors make up one primitive, -1 for ones it doesn't have
+struct CtGltfPrimitive{
+    uint32_t mesh;
+    int32_t position;
+    int32_t normal;
+    int32_t texcoord;
+    int32_t color;
+    int32_t indices;
+};
+
+//Everything an import reads from. None of it changes once the workers start
+struct CtGltfDocument{
+    std::string path;
+    const CtJsonValue* json;
+    std::vector<CtGltfBuffer> buffers;
+    std::vector<CtMappedFile*> mappings;
+
+    //Per glTF mesh, the base color of each triangle primitive's material
+    std::vector<std::vector<glm::vec4>> mesh_colors;
+};
+
+//Loads glTF 2.0 files, .gltf with its buffers next to it or as data URIs, and .glb with everything in one. Buffers are memory mapped
+//rather than read, so nothing is pulled off disk until a primitive needs it. Worker threads decode primitives out of the mappings into
+//CtVertex in parallel, and each one is handed over on the calling thread, in file order, as soon as it and everything before it is done.
+//Only triangle lists are read, other modes are skipped
+class CtGltfImport{
+
+    public:
+        //consume gets every primitive's mesh and returns an id for it. The mesh is freed as soon as consume returns, so it can keep
+        //the data with std::move if it wants it. optimize reorders each primitive for the cache on the workers (see CtMeshImport).
+        //thread_count 0 picks one per core, up to CT_MESH_IMPORT_MAX_THREADS
+        static CtGltfScene Import(const std::string& path, const std::function<uint32_t(CtMeshData&)>& consume, bool optimize,
+            uint32_t thread_count = 0);
+
+        //Import straight into a mesh store, one upload per primitive, printing how long it took
+        static CtGltfScene Load(const std::string& path, CtMeshStore* mesh_store, bool optimize);
+
+    private:
+
+        static void OpenBuffers(CtGltfDocument& document, const uint8_t* glb_binary, uint64_t glb_binary_size);
+        static std::vector<uint8_t> DecodeBase64(const std::string& text, size_t offset);
+
+        static void DecodePrimitive(const CtGltfDocument& document, const CtGltfPrimitive& primitive, CtMeshData& mesh, bool optimize);
+
+        //Reads every element of an accessor as floats, component_count per element, converting and normalizing as it goes.
+        //Elements with fewer components than asked for are padded with fill
+        static void ReadAccessor(const CtGltfDocument& document, uint32_t accessor, uint32_t component_count, float fill, std::vector<float>& values);
+        static void ReadIndices(const CtGltfDocument& document, uint32_t accessor, uint32_t vertex_count, std::vector<uint32_t>& indices);
+
+        //Where count elements starting byte_offset into a buffer view are, checked against the view and its buffer
+        static const uint8_t* FindElements(const CtGltfDocument& document, uint32_t buffer_view, uint64_t byte_offset, uint32_t count,
+            uint32_t element_size, uint32_t& stride);
+
+        static uint32_t GetComponentCount(const std::string& type);
+        static uint32_t GetComponentSize(uint32_t component_type);
+        static float ReadComponent(const uint8_t* data, uint32_t component_type, bool normalized);
+        static uint32_t ReadIndex(const uint8_t* data, uint32_t component_type);
+
+        static glm::mat4 GetNodeTransform(const CtJsonValue& node);
+        static void AddNode(const CtGltfDocument& document, uint32_t node, const glm::mat4& parent, uint32_t depth, CtGltfScene& scene);
+};
@@ -0,0 +1,386 @@
+#include "CtGpuCulling.h"
+#include "CtDevice.h"
+#include "CtComputePipeline.h"
+#include "CtInstanceData.h"
+#include "CtInstanceBuffer.h"
+#include "CtDrawBatcher.h"
+#include "CtDescriptorAllocator.h"
+#include "CtBarrierBatch.h"
+#include <stdexcept>
+#include <cstring>
+#include <cmath>
+
+//One candidate as cull.comp reads it
+struct CtCullObject{
+    CtInstanceData instance;
+    glm::vec4 bounds;
+    uint32_t command;
+    uint32_t padding[3];
+};
+
+//Has to match the push constant blocks in cull.comp and hiz_reduce.comp
+struct CtCullConstants{
+    glm::mat4 view_projection;
+    uint32_t object_base;
+    uint32_t object_count;
+    uint32_t command_base;
+    uint32_t instance_base;
+    float hiz_size[2];
+    uint32_t hiz_mip_count;
+    uint32_t occlusion_enabled;
+};
+
+struct CtHiZConstants{
+    int32_t source_size[2];
+    int32_t destination_size[2];
+};
+
+CtGpuCulling* CtGpuCulling::CreateGpuCulling(CtDevice* device, CtDrawBatcher* draw_batcher, CtInstanceBuffer* instance_buffer,
+    CtDescriptorAllocator* descriptor_allocator, const std::string& cull_shader_file, const std::string& hiz_shader_file,
+    uint32_t max_objects, uint32_t max_frames_in_flight){
+
+    CtGpuCulling* ct_gpu_culling = new CtGpuCulling();
+
+    ct_gpu_culling->device = device;
+    ct_gpu_culling->draw_batcher = draw_batcher;
+    ct_gpu_culling->instance_buffer = instance_buffer;
+    ct_gpu_culling->descriptor_allocator = descriptor_allocator;
+    ct_gpu_culling->max_objects = max_objects;
+    ct_gpu_culling->current_frame = 0;
+    ct_gpu_culling->hiz_ready = false;
+
+    ct_gpu_culling->CreateObjectBuffer(max_frames_in_flight);
+
+    //Candidates, the indirect commands, the instances and the pyramid
+    ct_gpu_culling->cull_pipeline = CtComputePipeline::CreateComputePipeline(device, cull_shader_file, {
+        {0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER},
+        {1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER},
+        {2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER},
+        {3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}
+    });
+
+    //The level we read from and the level we write to
+    ct_gpu_culling->hiz_pipeline = CtComputePipeline::CreateComputePipeline(device, hiz_shader_file, {
+        {0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER},
+        {1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE}
+    });
+
+    ct_gpu_culling->CreateSampler();
+
+    draw_batcher->SetGpuCulled(true);
+
+    printf("Created GPU Culling.\n");
+
+    return ct_gpu_culling;
+}
+
+void CtGpuCulling::BeginFrame(uint32_t frame){
+    current_frame = frame;
+}
+
+/**************************************************************RECORDING*****************************************************************/
+
+void CtGpuCulling::RecordCull(VkCommandBuffer command_buffer, const glm::mat4& view_projection){
+    if(!hiz_ready){
+        ClearPyramid(command_buffer);
+    }
+
+    const std::vector<CtInstanceData>& instances = draw_batcher->GetCullInstances();
+    const std::vector<CtCullCandidate>& candidates = draw_batcher->GetCullCandidates();
+    uint32_t object_count = static_cast<uint32_t>(candidates.size());
+
+    if(object_count == 0){
+        return;
+    }
+    if(object_count > max_objects){
+        throw std::runtime_error("Too many objects to cull in one frame. Give GPU culling more objects.");
+    }
+
+    CtCullObject* objects = reinterpret_cast<CtCullObject*>(mapped_objects) + static_cast<size_t>(max_objects) * current_frame;
+    for(uint32_t i = 0; i < object_count; i++){
+        objects[i].instance = instances[i];
+        objects[i].bounds = draw_batcher->GetMeshBounds(candidates[i].mesh_id);
+        objects[i].command = candidates[i].command;
+    }
+
+    //Every buffer is bound whole and the frame's region is picked with the bases in the push constants,
+    //so none of the offsets have to line up with the storage buffer alignment
+    VkDescriptorSet cull_set = cull_pipeline->AllocateSet(descriptor_allocator);
+    cull_pipeline->WriteStorageBuffer(cull_set, 0, object_buffer);
+    cull_pipeline->WriteStorageBuffer(cull_set, 1, draw_batcher->GetIndirectBuffer());
+    cull_pipeline->WriteStorageBuffer(cull_set, 2, instance_buffer->GetBuffer());
+    cull_pipeline->WriteSampledImage(cull_set, 3, hiz_view, hiz_sampler, VK_IMAGE_LAYOUT_GENERAL);
+
+    CtCullConstants constants {};
+    constants.view_projection = view_projection;
+    constants.object_base = max_objects * current_frame;
+    constants.object_count = object_count;
+    constants.command_base = draw_batcher->GetCommandBase();
+    constants.instance_base = instance_buffer->GetFrameBase();
+    constants.hiz_size[0] = static_cast<float>(hiz_extent.width);
+    constants.hiz_size[1] = static_cast<float>(hiz_extent.height);
+    constants.hiz_mip_count = hiz_mip_count;
+    constants.occlusion_enabled = 1;
+
+    cull_pipeline->Bind(command_buffer, cull_set);
+    cull_pipeline->PushConstants(command_buffer, constants);
+    cull_pipeline->DispatchItems(command_buffer, object_count);
+}
+
+//Level 0 is a straight copy of depth, every level after takes the max of the one before it. Each level has to be finished before the next reads it
+void CtGpuCulling::RecordHiZBuild(VkCommandBuffer command_buffer){
+    VkImageSubresourceRange all_levels {};
+    all_levels.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    all_levels.baseMipLevel = 0;
+    all_levels.levelCount = hiz_mip_count;
+    all_levels.baseArrayLayer = 0;
+    all_levels.layerCount = 1;
+
+    //This frame's culling sampled it, so that has to be done before we write over it
+    CtBarrierBatch barriers(device);
+    barriers.AddImageBarrier(hiz_image, all_levels,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_GENERAL,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL);
+    barriers.Flush(command_buffer);
+
+    VkExtent2D source_extent = hiz_extent;
+    for(uint32_t mip = 0; mip < hiz_mip_count; mip++){
+        VkExtent2D destination_extent {};
+        destination_extent.width = std::max(hiz_extent.width >> mip, 1u);
+        destination_extent.height = std::max(hiz_extent.height >> mip, 1u);
+
+        VkDescriptorSet hiz_set = hiz_pipeline->AllocateSet(descriptor_allocator);
+        hiz_pipeline->WriteSampledImage(hiz_set, 0, mip == 0 ? depth_view : hiz_mip_views[mip - 1], hiz_sampler,
+            mip == 0 ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL);
+        hiz_pipeline->WriteStorageImage(hiz_set, 1, hiz_mip_views[mip]);
+
+        CtHiZConstants constants {};
+        constants.source_size[0] = static_cast<int32_t>(source_extent.width);
+        constants.source_size[1] = static_cast<int32_t>(source_extent.height);
+        constants.destination_size[0] = static_cast<int32_t>(destination_extent.width);
+        constants.destination_size[1] = static_cast<int32_t>(destination_extent.height);
+
+        hiz_pipeline->Bind(command_buffer, hiz_set);
+        hiz_pipeline->PushConstants(command_buffer, constants);
+        hiz_pipeline->DispatchExtent(command_buffer, destination_extent);
+
+        //The next level reads this one, and after the last one it's next frame's culling that reads it
+        VkImageSubresourceRange level = all_levels;
+        level.baseMipLevel = mip;
+        level.levelCount = 1;
+
+        barriers.AddImageBarrier(hiz_image, level,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_GENERAL);
+        barriers.Flush(command_buffer);
+
+        source_extent = destination_extent;
+    }
+}
+
+//Far depth everywhere, so nothing is behind it until a real frame has been reduced in
+void CtGpuCulling::ClearPyramid(VkCommandBuffer command_buffer){
+    VkImageSubresourceRange all_levels {};
+    all_levels.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    all_levels.baseMipLevel = 0;
+    all_levels.levelCount = hiz_mip_count;
+    all_levels.baseArrayLayer = 0;
+    all_levels.layerCount = 1;
+
+    CtBarrierBatch barriers(device);
+    barriers.AddImageBarrier(hiz_image, all_levels,
+        VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_PIPELINE_STAGE_2_CLEAR_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL);
+    barriers.Flush(command_buffer);
+
+    VkClearColorValue far_depth = {{1.0f, 1.0f, 1.0f, 1.0f}};
+    vkCmdClearColorImage(command_buffer, hiz_image, VK_IMAGE_LAYOUT_GENERAL, &far_depth, 1, &all_levels);
+
+    barriers.AddImageBarrier(hiz_image, all_levels,
+        VK_PIPELINE_STAGE_2_CLEAR_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_GENERAL);
+    barriers.Flush(command_buffer);
+
+    hiz_ready = true;
+}
+
+/**************************************************************PYRAMID*****************************************************************/
+
+//The graph's depth view might cover stencil too, and a sampled view can only have one aspect, so we make our own
+void CtGpuCulling::SetDepthImage(VkImage image, VkFormat depth_format, VkExtent2D extent){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    if(depth_view != VK_NULL_HANDLE){
+        vkDestroyImageView(interface_device, depth_view, nullptr);
+    }
+
+    depth_image = image;
+    depth_view = CreateImageView(depth_image, depth_format, VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1);
+
+    DestroyPyramid();
+    CreatePyramid(extent);
+}
+
+void CtGpuCulling::CreatePyramid(VkExtent2D extent){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    hiz_extent = extent;
+    hiz_mip_count = static_cast<uint32_t>(std::floor(std::log2(std::max(extent.width, extent.height)))) + 1;
+
+    VkImageCreateInfo image_info {};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.format = VK_FORMAT_R32_SFLOAT;
+    image_info.extent.width = extent.width;
+    image_info.extent.height = extent.height;
+    image_info.extent.depth = 1;
+    image_info.mipLevels = hiz_mip_count;
+    image_info.arrayLayers = 1;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if(vkCreateImage(interface_device, &image_info, nullptr, &hiz_image) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create the Hi-Z pyramid.");
+    }
+
+    VkMemoryRequirements memory_requirements;
+    vkGetImageMemoryRequirements(interface_device, hiz_image, &memory_requirements);
+
+    VkMemoryAllocateInfo allocate_info {};
+    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocate_info.allocationSize = memory_requirements.size;
+    allocate_info.memoryTypeIndex = device->FindMemoryType(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    if(vkAllocateMemory(interface_device, &allocate_info, nullptr, &hiz_image_memory) != VK_SUCCESS){
+        throw std::runtime_error("Failed to allocate the Hi-Z pyramid.");
+    }
+
+    vkBindImageMemory(interface_device, hiz_image, hiz_image_memory, 0);
+
+    hiz_view = CreateImageView(hiz_image, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, 0, hiz_mip_count);
+    for(uint32_t mip = 0; mip < hiz_mip_count; mip++){
+        hiz_mip_views.push_back(CreateImageView(hiz_image, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, mip, 1));
+    }
+
+    hiz_ready = false;
+
+    printf("Created Hi-Z Pyramid (%ux%u, %u levels).\n", extent.width, extent.height, hiz_mip_count);
+}
+
+void CtGpuCulling::DestroyPyramid(){
+    if(hiz_image == VK_NULL_HANDLE){
+        return;
+    }
+
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    for(VkImageView view : hiz_mip_views){
+        vkDestroyImageView(interface_device, view, nullptr);
+    }
+    hiz_mip_views.clear();
+
+    vkDestroyImageView(interface_device, hiz_view, nullptr);
+    vkDestroyImage(interface_device, hiz_image, nullptr);
+    vkFreeMemory(interface_device, hiz_image_memory, nullptr);
+
+    hiz_image = VK_NULL_HANDLE;
+}
+
+VkImageView CtGpuCulling::CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspect, uint32_t base_mip, uint32_t mip_count){
+    VkImageViewCreateInfo view_info {};
+    view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    view_info.image = image;
+    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view_info.format = format;
+    view_info.subresourceRange.aspectMask = aspect;
+    view_info.subresourceRange.baseMipLevel = base_mip;
+    view_info.subresourceRange.levelCount = mip_count;
+    view_info.subresourceRange.baseArrayLayer = 0;
+    view_info.subresourceRange.layerCount = 1;
+
+    VkImageView image_view;
+    if(vkCreateImageView(*(device->GetInterfaceDevice()), &view_info, nullptr, &image_view) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create a Hi-Z image view.");
+    }
+
+    return image_view;
+}
+
+//Nearest so we read real depths and never a blend of a near one and a far one
+void CtGpuCulling::CreateSampler(){
+    VkSamplerCreateInfo sampler_info {};
+    sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_info.magFilter = VK_FILTER_NEAREST;
+    sampler_info.minFilter = VK_FILTER_NEAREST;
+    sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.minLod = 0.0f;
+    sampler_info.maxLod = VK_LOD_CLAMP_NONE;
+
+    if(vkCreateSampler(*(device->GetInterfaceDevice()), &sampler_info, nullptr, &hiz_sampler) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create the Hi-Z sampler.");
+    }
+}
+
+/**************************************************************BUFFERS*****************************************************************/
+
+void CtGpuCulling::CreateObjectBuffer(uint32_t max_frames_in_flight){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+    VkDeviceSize size = static_cast<VkDeviceSize>(max_objects) * max_frames_in_flight * sizeof(CtCullObject);
+
+    VkBufferCreateInfo buffer_info {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = size;
+    buffer_info.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if(vkCreateBuffer(interface_device, &buffer_info, nullptr, &object_buffer) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create the cull object buffer.");
+    }
+
+    VkMemoryRequirements memory_requirements;
+    vkGetBufferMemoryRequirements(interface_device, object_buffer, &memory_requirements);
+
+    VkMemoryAllocateInfo allocate_info {};
+    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocate_info.allocationSize = memory_requirements.size;
+    allocate_info.memoryTypeIndex = device->FindMemoryType(memory_requirements.memoryTypeBits,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    if(vkAllocateMemory(interface_device, &allocate_info, nullptr, &object_buffer_memory) != VK_SUCCESS){
+        throw std::runtime_error("Failed to allocate the cull object buffer.");
+    }
+
+    vkBindBufferMemory(interface_device, object_buffer, object_buffer_memory, 0);
+
+    void* data;
+    if(vkMapMemory(interface_device, object_buffer_memory, 0, size, 0, &data) != VK_SUCCESS){
+        throw std::runtime_error("Failed to map the cull object buffer.");
+    }
+    mapped_objects = static_cast<uint8_t*>(data);
+}
+
+void CtGpuCulling::Cleanup(){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    DestroyPyramid();
+    if(depth_view != VK_NULL_HANDLE){
+        vkDestroyImageView(interface_device, depth_view, nullptr);
+    }
+
+    vkDestroySampler(interface_device, hiz_sampler, nullptr);
+
+    cull_pipeline->Cleanup();
+    hiz_pipeline->Cleanup();
+    delete cull_pipeline;
+    delete hiz_pipeline;
+
+    vkUnmapMemory(interface_device, object_buffer_memory);
+    vkDestroyBuffer(interface_device, object_buffer, nullptr);
+    vkFreeMemory(interface_device, object_buffer_memory, nullptr);
+}
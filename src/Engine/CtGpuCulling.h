@@ -0,0 +1,76 @@
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+class CtDevice;
+class CtDrawBatcher;
+class CtInstanceBuffer;
+class CtDescriptorAllocator;
+class CtComputePipeline;
+
+//Takes the culling off the CPU. Every object the batcher was given goes up as a candidate, and a compute pass tests its bounding sphere
+//against the frustum and against a depth pyramid built from last frame's depth. The ones that make it get appended to their mesh's
+//instances and bump that mesh's command, so the indirect draws only ever see what's visible and occluded objects never reach the vertex shader.
+//The pyramid is one frame behind, which means something that just came out from behind a wall can be missing for a frame
+class CtGpuCulling{
+
+    public:
+        static CtGpuCulling* CreateGpuCulling(CtDevice* device, CtDrawBatcher* draw_batcher, CtInstanceBuffer* instance_buffer,
+            CtDescriptorAllocator* descriptor_allocator, const std::string& cull_shader_file, const std::string& hiz_shader_file,
+            uint32_t max_objects, uint32_t max_frames_in_flight);
+
+        void BeginFrame(uint32_t frame);
+
+        //Call whenever the depth image is remade. The pyramid follows its size and starts out empty, so nothing is occluded the first frame
+        void SetDepthImage(VkImage depth_image, VkFormat depth_format, VkExtent2D extent);
+
+        //Uploads the batcher's candidates and culls them into its indirect commands. Record before the pass that draws them
+        void RecordCull(VkCommandBuffer command_buffer, const glm::mat4& view_projection);
+
+        //Reduces this frame's depth into the pyramid for next frame. Record after the last pass that writes depth
+        void RecordHiZBuild(VkCommandBuffer command_buffer);
+
+        void Cleanup();
+
+    private:
+
+        CtDevice* device;
+        CtDrawBatcher* draw_batcher;
+        CtInstanceBuffer* instance_buffer;
+        CtDescriptorAllocator* descriptor_allocator;
+
+        //What goes into the culling pass, one region per frame in flight
+        VkBuffer object_buffer;
+        VkDeviceMemory object_buffer_memory;
+        uint8_t* mapped_objects;
+        uint32_t max_objects;
+        uint32_t current_frame;
+
+        CtComputePipeline* cull_pipeline;
+        CtComputePipeline* hiz_pipeline;
+
+        //Hi-Z pyramid. It stays in GENERAL the whole time since every level gets both written and sampled
+
+        VkImage hiz_image = VK_NULL_HANDLE;
+        VkDeviceMemory hiz_image_memory;
+        VkImageView hiz_view;
+        std::vector<VkImageView> hiz_mip_views;
+        VkExtent2D hiz_extent;
+        uint32_t hiz_mip_count;
+        bool hiz_ready;
+        VkSampler hiz_sampler;
+
+        VkImage depth_image;
+        VkImageView depth_view = VK_NULL_HANDLE;
+
+        void CreateObjectBuffer(uint32_t max_frames_in_flight);
+        void CreateSampler();
+
+        void CreatePyramid(VkExtent2D extent);
+        void DestroyPyramid();
+        void ClearPyramid(VkCommandBuffer command_buffer);
+        VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspect, uint32_t base_mip, uint32_t mip_count);
+};
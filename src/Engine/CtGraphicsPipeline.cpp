@@ -1,13 +1,16 @@
 #include "CtGraphicsPipeline.h"
 #include "CtVertex.h"
+#include "CtInstanceData.h"
 #include "CtSwapchain.h"
 #include "CtShader.h"
 #include "CtDevice.h"
 #include "Engine.h"
+#include "CtRenderGraph.h"
+#include "CtBindlessTable.h"
 #include <array>
 #include <stdexcept>
 
-CtGraphicsPipeline* CtGraphicsPipeline::CreateGraphicsPipeline(EngineSettings settings, CtDevice* device, CtSwapchain* swapchain){
+CtGraphicsPipeline* CtGraphicsPipeline::CreateGraphicsPipeline(EngineSettings settings, CtDevice* device, CtSwapchain* swapchain, CtBindlessTable* bindless_table){
 
     CtGraphicsPipeline* ct_graphics_pipeline = new CtGraphicsPipeline();
 
@@ -15,18 +18,21 @@ CtGraphicsPipeline* CtGraphicsPipeline::CreateGraphicsPipeline(EngineSettings se
 
     printf("Created Descriptor Set Layouts.\n");
 
-    ct_graphics_pipeline->CreateRenderPass(device, swapchain);
+    //With dynamic rendering the pipeline is told the attachment formats directly, so there's no render pass to make
+    if(!device->GetOptionalFeatures().dynamic_rendering){
+        ct_graphics_pipeline->CreateRenderPass(device, swapchain);
 
-    printf("Created Render Pass.\n");
+        printf("Created Render Pass.\n");
+    }
 
-    ct_graphics_pipeline->CreatePipeline(device, settings.graphics_settings.shader_files, settings.graphics_settings.shader_stages, swapchain);
+    ct_graphics_pipeline->CreatePipeline(device, settings.graphics_settings.shader_files, settings.graphics_settings.shader_stages, swapchain, bindless_table);
 
     printf("Created Graphics Pipeline.\n");
 
     return ct_graphics_pipeline;
 }
 
-void CtGraphicsPipeline::CreatePipeline(CtDevice* device, const std::vector<std::string>& shader_files, std::vector<uint32_t> stages, CtSwapchain* swapchain){
+void CtGraphicsPipeline::CreatePipeline(CtDevice* device, const std::vector<std::string>& shader_files, std::vector<uint32_t> stages, CtSwapchain* swapchain, CtBindlessTable* bindless_table){
     VkGraphicsPipelineCreateInfo pipeline_info {};    
 
     pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
@@ -53,12 +59,20 @@ void CtGraphicsPipeline::CreatePipeline(CtDevice* device, const std::vector<std:
     pipeline_info.pStages = shader_stages.data();
 
     //Now we can move onto the easier stuff!
-    //Vertex
-    auto binding_description = CtVertex::GetBindingDescription();
-    auto attribute_description = CtVertex::GetAttributeDescriptions(); 
+    //Vertex. The mesh's vertices step per vertex on binding 0 and the instance data steps per instance on binding 1
+    //The vertex format is whatever layout meshes get stored as by default, see CtMeshVertexLayout
+    std::vector<VkVertexInputBindingDescription> binding_descriptions = {CtMeshVertexLayout::GetBindingDescription(), CtInstanceData::GetBindingDescription()};
+
+    std::vector<VkVertexInputAttributeDescription> attribute_descriptions;
+    for(const auto& attribute : CtMeshVertexLayout::GetAttributeDescriptions()){
+        attribute_descriptions.push_back(attribute);
+    }
+    for(const auto& attribute : CtInstanceData::GetAttributeDescriptions()){
+        attribute_descriptions.push_back(attribute);
+    }
 
     VkPipelineVertexInputStateCreateInfo vertex_info {};
-    CreateVertexInputState(vertex_info, attribute_description, binding_description);
+    CreateVertexInputState(vertex_info, attribute_descriptions, binding_descriptions);
     pipeline_info.pVertexInputState = &vertex_info;
 
     //Input assembly
@@ -94,7 +108,7 @@ void CtGraphicsPipeline::CreatePipeline(CtDevice* device, const std::vector<std:
     pipeline_info.pDynamicState = &dynamic_state_info;
 
     //Pipeline layout!
-    VkPipelineLayoutCreateInfo pipeline_layout_info = CreatePipelineLayout();
+    VkPipelineLayoutCreateInfo pipeline_layout_info = CreatePipelineLayout(device, bindless_table);
 
     VkResult result = vkCreatePipelineLayout(*(device->GetInterfaceDevice()), &pipeline_layout_info, nullptr, &pipeline_layout);
 
@@ -116,6 +130,19 @@ void CtGraphicsPipeline::CreatePipeline(CtDevice* device, const std::vector<std:
     pipeline_info.renderPass = render_pass;
     pipeline_info.subpass = 0;
 
+    //These have to match the attachments the render graph begins rendering with
+    VkFormat color_format = swapchain->swapchain_image_format;
+    VkPipelineRenderingCreateInfo rendering_info {};
+    rendering_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+    rendering_info.colorAttachmentCount = 1;
+    rendering_info.pColorAttachmentFormats = &color_format;
+    rendering_info.depthAttachmentFormat = FindDepthFormat(device->GetPhysicalDevice());
+
+    if(device->GetOptionalFeatures().dynamic_rendering){
+        pipeline_info.pNext = &rendering_info;
+        pipeline_info.renderPass = VK_NULL_HANDLE;
+    }
+
     result = vkCreateGraphicsPipelines(*(device->GetInterfaceDevice()), VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &graphics_pipeline);
     switch(result){
         case VK_SUCCESS:
@@ -138,37 +165,22 @@ void CtGraphicsPipeline::CreatePipeline(CtDevice* device, const std::vector<std:
     }
 }
 
+//The pipeline only needs a render pass that is compatible with the ones the render graph builds, which just means the formats have to line up.
+//The graph picks the real load/store ops and does every layout transition with barriers, so this one never actually gets begun
 void CtGraphicsPipeline::CreateRenderPass(CtDevice* device, CtSwapchain* swapchain){
-    VkRenderPassCreateInfo render_pass_info {};
-
-    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-
-    //Lets grab the dependency
-    VkSubpassDependency dependency = CreateSubpassDependency();
-    render_pass_info.dependencyCount = 1;
-    render_pass_info.pDependencies = &dependency;
-
-    //Now let's create the subpass
-    VkAttachmentReference color_attachment_reference = CreateColorAttachmentReference();
-    VkAttachmentReference depth_attachment_reference = CreateDepthAttachmentReference();
-    VkSubpassDescription subpass = CreateSubpassDescription(color_attachment_reference, depth_attachment_reference);
-
-    //Finally, let's create the descriptions
-    VkAttachmentDescription color_attachment_description = CreateColorAttachmentDescription(swapchain);
-    VkAttachmentDescription depth_attachment_description = CreateDepthAttachmentDescription(device->GetPhysicalDevice());
-
-    //Make sure these indices are inline with what we put for create color attachment reference and depth
-    std::array<VkAttachmentDescription, 2> attachments = {color_attachment_description, depth_attachment_description};
-
-    render_pass_info.attachmentCount = static_cast<uint32_t>(attachments.size());
-    render_pass_info.pAttachments = attachments.data();
-    render_pass_info.subpassCount = 1;
-    render_pass_info.pSubpasses = &subpass;
-
-
-    if(vkCreateRenderPass(*(device->GetInterfaceDevice()), &render_pass_info, nullptr, &render_pass) != VK_SUCCESS){
-        throw std::runtime_error("Failed to create render pass!");
-    }
+    std::vector<CtRenderGraphAttachment> color_attachments(1);
+    color_attachments[0].format = swapchain->swapchain_image_format;
+    color_attachments[0].load_op = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    color_attachments[0].store_op = VK_ATTACHMENT_STORE_OP_STORE;
+    color_attachments[0].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    CtRenderGraphAttachment depth_attachment {};
+    depth_attachment.format = FindDepthFormat(device->GetPhysicalDevice());
+    depth_attachment.load_op = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depth_attachment.store_op = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depth_attachment.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    render_pass = CtRenderGraph::CreateRenderPass(device, color_attachments, &depth_attachment);
 }
 
 
@@ -177,7 +189,7 @@ void CtGraphicsPipeline::CreateDescriptorSetLayout(CtDevice* device){
     VkDescriptorSetLayoutBinding ubo_layout_binding{};
 
     ubo_layout_binding.binding = 0;
-    ubo_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    ubo_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC; //Per draw data out of the renderer's uniform ring
     ubo_layout_binding.descriptorCount = 1;
 
     ubo_layout_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
@@ -203,25 +215,24 @@ void CtGraphicsPipeline::CreateDescriptorSetLayout(CtDevice* device){
 }
 
 void CtGraphicsPipeline::CreateVertexInputState(VkPipelineVertexInputStateCreateInfo& vertex_state_create_info, 
-    std::array<VkVertexInputAttributeDescription, 3> attribute_description,
-    VkVertexInputBindingDescription binding_description){
+    const std::vector<VkVertexInputAttributeDescription>& attribute_descriptions,
+    const std::vector<VkVertexInputBindingDescription>& binding_descriptions){
 
     //Obviously, we have to define the structure type first
     vertex_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
     //Next we have to get our binding descriptions
-    //We use our CtVertex class defined in CtVertex.h to represent vertices. We have a helpful function to
-    //Grab our binding descriptions!
+    //The vertex layouts in CtVertex.h put these together for us, we just have to pass them along
 
-    //We only ever have one for now - multiple would be for multiple different representation classes
-    vertex_state_create_info.vertexBindingDescriptionCount = 1;
-    vertex_state_create_info.pVertexBindingDescriptions = &binding_description;
+    //One per vertex buffer we bind, right now that's the mesh and its instances
+    vertex_state_create_info.vertexBindingDescriptionCount = static_cast<uint32_t>(binding_descriptions.size());
+    vertex_state_create_info.pVertexBindingDescriptions = binding_descriptions.data();
 
     //Now we do the same thing for our attribute descriptions
 
     //And then we fill and return!
-    vertex_state_create_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribute_description.size());
-    vertex_state_create_info.pVertexAttributeDescriptions = attribute_description.data();
+    vertex_state_create_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribute_descriptions.size());
+    vertex_state_create_info.pVertexAttributeDescriptions = attribute_descriptions.data();
 }
 
 VkPipelineInputAssemblyStateCreateInfo CtGraphicsPipeline::CreateInputAssemblyState(){
@@ -326,17 +337,71 @@ VkPipelineColorBlendStateCreateInfo CtGraphicsPipeline::CreateBlendingState(VkPi
 
     return color_blending;
 }
-VkPipelineLayoutCreateInfo CtGraphicsPipeline::CreatePipelineLayout(){
+//With a bindless table, draws don't bind anything per material. They push a few indices into the table and the shaders look everything up from there
+VkPipelineLayoutCreateInfo CtGraphicsPipeline::CreatePipelineLayout(CtDevice* device, CtBindlessTable* bindless_table){
     VkPipelineLayoutCreateInfo pipeline_layout_info{};
 
+    set_layouts = {descriptor_set_layout};
+    uses_bindless = bindless_table != nullptr;
+
+    if(uses_bindless){
+        set_layouts.push_back(bindless_table->GetDescriptorSetLayout());
+    }
+
+    ReflectPushConstantRange(device, bindless_table);
+
     pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipeline_layout_info.setLayoutCount = 1;
-    pipeline_layout_info.pSetLayouts = &descriptor_set_layout;
-    pipeline_layout_info.pushConstantRangeCount = 0;
-    pipeline_layout_info.pPushConstantRanges = nullptr;
+    pipeline_layout_info.setLayoutCount = static_cast<uint32_t>(set_layouts.size());
+    pipeline_layout_info.pSetLayouts = set_layouts.data();
+    pipeline_layout_info.pushConstantRangeCount = has_push_constants ? 1 : 0;
+    pipeline_layout_info.pPushConstantRanges = has_push_constants ? &push_constant_range : nullptr;
 
     return pipeline_layout_info;
 }
+//The range comes from whatever push constant blocks the shaders declare. Bindless draws always push their indices at the front,
+//so we make sure the range at least covers those even if no shader has gotten around to reading them yet
+void CtGraphicsPipeline::ReflectPushConstantRange(CtDevice* device, CtBindlessTable* bindless_table){
+    uint32_t range_start = UINT32_MAX;
+    uint32_t range_end = 0;
+    VkShaderStageFlags stages = 0;
+
+    for(const auto& shader : shaders){
+        if(!shader->HasPushConstants()){
+            continue;
+        }
+
+        uint32_t start = shader->GetPushConstantOffset();
+        uint32_t end = start + shader->GetPushConstantSize();
+        range_start = start < range_start ? start : range_start;
+        range_end = end > range_end ? end : range_end;
+        stages |= shader->GetStageFlag();
+    }
+
+    if(bindless_table != nullptr){
+        range_start = 0;
+        range_end = range_end > sizeof(CtBindlessDrawIndices) ? range_end : sizeof(CtBindlessDrawIndices);
+        stages |= VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+
+    has_push_constants = range_end > 0;
+    if(!has_push_constants){
+        return;
+    }
+
+    VkPhysicalDeviceProperties properties {};
+    vkGetPhysicalDeviceProperties(*(device->GetPhysicalDevice()), &properties);
+
+    if(range_end > properties.limits.maxPushConstantsSize){
+        throw std::runtime_error("Shaders declare more push constants than the device supports.");
+    }
+
+    push_constant_range.stageFlags = stages;
+    push_constant_range.offset = range_start;
+    push_constant_range.size = range_end - range_start;
+
+    printf("Push constant range: %u bytes at offset %u.\n", push_constant_range.size, push_constant_range.offset);
+}
+
 VkPipelineDepthStencilStateCreateInfo CtGraphicsPipeline::CreateDepthStencilState(){
     VkPipelineDepthStencilStateCreateInfo depth_stencil{};
 
@@ -382,88 +447,6 @@ VkRect2D CtGraphicsPipeline::CreateScissor(CtSwapchain* swapchain){
     return scissor;
 }
 
-VkAttachmentDescription CtGraphicsPipeline::CreateColorAttachmentDescription(CtSwapchain* swapchain){
-    VkAttachmentDescription color_attachment{};
-
-    color_attachment.format = swapchain->swapchain_image_format;
-    color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    color_attachment.storeOp =VK_ATTACHMENT_STORE_OP_STORE;
-
-    color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-
-    color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-    return color_attachment;
-}
-
-VkAttachmentReference CtGraphicsPipeline::CreateColorAttachmentReference(){
-    VkAttachmentReference color_attachment_reference{};
-
-    color_attachment_reference.attachment = 0;
-    color_attachment_reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    return color_attachment_reference;
-}
-
-VkSubpassDependency CtGraphicsPipeline::CreateSubpassDependency(){
-    VkSubpassDependency dependency{};
-
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass = 0;
-
-    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    dependency.srcAccessMask = 0;   
-
-    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
-    return dependency;
-}
-
-VkAttachmentDescription CtGraphicsPipeline::CreateDepthAttachmentDescription(VkPhysicalDevice* physical_device){
-    VkAttachmentDescription depth_attachment{};
-
-    depth_attachment.format = FindDepthFormat(physical_device);
-    depth_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depth_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    depth_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depth_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    depth_attachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    return depth_attachment;
-}
-
-VkAttachmentReference CtGraphicsPipeline::CreateDepthAttachmentReference(){
-    VkAttachmentReference depth_attachment_reference{};
-
-    depth_attachment_reference.attachment = 1;
-    depth_attachment_reference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    return depth_attachment_reference;
-}
-
-VkSubpassDescription CtGraphicsPipeline::CreateSubpassDescription(VkAttachmentReference& color_attachment_reference, VkAttachmentReference& depth_attachment_reference){
-    VkSubpassDescription subpass{};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &color_attachment_reference;
-
-    subpass.pDepthStencilAttachment = &depth_attachment_reference;
-
-    subpass.inputAttachmentCount = 0;
-    subpass.pInputAttachments = nullptr;
-    subpass.pResolveAttachments = nullptr;
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-
-    return subpass;
-}
-
 //Let's define our dynamic states
 std::vector<VkDynamicState> dynamic_states = {
     VK_DYNAMIC_STATE_VIEWPORT,
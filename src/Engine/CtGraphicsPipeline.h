@@ -3,12 +3,18 @@
 #include <string>
 #include <cstdint>
 #include <array>
+#include <stdexcept>
+#include <type_traits>
 
 class CtSwapchain;
 class CtShader;
 class CtSwapchain;
 struct EngineSettings;
 class CtDevice;
+class CtBindlessTable;
+
+//Every GPU has to give us at least this many bytes of push constants, so anything that fits here can be checked at compile time
+const uint32_t CT_MIN_PUSH_CONSTANTS_SIZE = 128;
 
 //So, I know I have been creating my own structs to basically take visual notes on how the API works, but I don't
 //want to completely fill up this header file with all of that, so I will be creating them more directly (which does also mean it's more efficient!)
@@ -16,26 +22,49 @@ class CtDevice;
 class CtGraphicsPipeline {
 
     public:
-        static CtGraphicsPipeline* CreateGraphicsPipeline(EngineSettings settings, CtDevice* device, CtSwapchain* swapchain);
+        static CtGraphicsPipeline* CreateGraphicsPipeline(EngineSettings settings, CtDevice* device, CtSwapchain* swapchain, CtBindlessTable* bindless_table);
 
         static VkFormat FindSupportedFormat(VkPhysicalDevice* physical_device, const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
         static VkFormat FindDepthFormat(VkPhysicalDevice* physical_device);
 
+        //Pushes T at the given offset of the pipeline's push constant range. Sizes are checked against the guaranteed minimum at compile time,
+        //the offset against the range the shaders actually declared when we run
+        template<typename T>
+        void PushConstants(VkCommandBuffer command_buffer, const T& data, uint32_t offset = 0){
+            static_assert(sizeof(T) <= CT_MIN_PUSH_CONSTANTS_SIZE, "Push constants have to fit in the 128 bytes every GPU guarantees.");
+            static_assert(sizeof(T) % 4 == 0, "Push constant sizes have to be a multiple of 4.");
+            static_assert(std::is_trivially_copyable<T>::value, "Push constants get copied byte for byte.");
+
+            if(!has_push_constants || offset < push_constant_range.offset ||
+                offset + sizeof(T) > push_constant_range.offset + push_constant_range.size){
+                throw std::runtime_error("Push constants are outside of the pipeline's push constant range.");
+            }
+
+            vkCmdPushConstants(command_buffer, pipeline_layout, push_constant_range.stageFlags, offset, sizeof(T), &data);
+        }
+
     private:
         //Shaders
         std::vector<CtShader*> shaders;
 
         VkPipeline graphics_pipeline;
-        VkRenderPass render_pass;
+        VkRenderPass render_pass = VK_NULL_HANDLE;
         VkDescriptorSetLayout descriptor_set_layout;
         VkPipelineLayout pipeline_layout;
-        std::vector<VkDescriptorSet> descriptor_sets;
+
+        //Set 0 is ours, set 1 is the bindless table when there is one
+        std::vector<VkDescriptorSetLayout> set_layouts;
+        bool uses_bindless = false;
+
+        //One range covering every stage's push constant block. Every stage that uses any of it gets every push
+        VkPushConstantRange push_constant_range;
+        bool has_push_constants = false;
 
         //Pipeline creation
-        void CreatePipeline(CtDevice* device, const std::vector<std::string>& shader_files, std::vector<uint32_t> stages, CtSwapchain* swapchain);
+        void CreatePipeline(CtDevice* device, const std::vector<std::string>& shader_files, std::vector<uint32_t> stages, CtSwapchain* swapchain, CtBindlessTable* bindless_table);
 
-        void CreateVertexInputState(VkPipelineVertexInputStateCreateInfo& vertex_state_create_info, std::array<VkVertexInputAttributeDescription, 3> attribute_description,
-                    VkVertexInputBindingDescription binding_description);
+        void CreateVertexInputState(VkPipelineVertexInputStateCreateInfo& vertex_state_create_info, const std::vector<VkVertexInputAttributeDescription>& attribute_descriptions,
+                    const std::vector<VkVertexInputBindingDescription>& binding_descriptions);
         VkPipelineInputAssemblyStateCreateInfo CreateInputAssemblyState();
         VkPipelineDynamicStateCreateInfo CreateDynamicState();
         VkPipelineViewportStateCreateInfo CreateViewportState(VkViewport& viewport, VkRect2D& scissor);
@@ -43,28 +72,19 @@ class CtGraphicsPipeline {
         VkPipelineMultisampleStateCreateInfo CreateMultisampleState();
         VkPipelineColorBlendAttachmentState CreateBlendingAttachtmentState();
         VkPipelineColorBlendStateCreateInfo CreateBlendingState(VkPipelineColorBlendAttachmentState& color_blend_attachment);
-        VkPipelineLayoutCreateInfo CreatePipelineLayout();
+        VkPipelineLayoutCreateInfo CreatePipelineLayout(CtDevice* device, CtBindlessTable* bindless_table);
+        void ReflectPushConstantRange(CtDevice* device, CtBindlessTable* bindless_table);
         VkPipelineDepthStencilStateCreateInfo CreateDepthStencilState();
 
         VkViewport CreateViewport(CtSwapchain* swapchain);
         VkRect2D CreateScissor(CtSwapchain* swapchain);
 
-        //Descriptor creation
+        //Descriptor creation. The sets themselves come out of the renderer's CtDescriptorAllocator every frame
         void CreateDescriptorSetLayout(CtDevice* device);
-        void CreateDescriptorSets();
 
         //Render pass creation
         void CreateRenderPass(CtDevice* device, CtSwapchain* swapchain);
 
-        VkAttachmentDescription CreateColorAttachmentDescription(CtSwapchain* swapchain);
-        VkAttachmentReference CreateColorAttachmentReference();
-        VkSubpassDependency CreateSubpassDependency();
-        VkAttachmentDescription CreateDepthAttachmentDescription(VkPhysicalDevice* physical_device);
-        VkAttachmentReference CreateDepthAttachmentReference();
-        VkSubpassDescription CreateSubpassDescription(VkAttachmentReference& color_attachment_reference, VkAttachmentReference& depth_attachment_reference);
-
-        void CreateDescriptorSets(uint32_t max_frames_in_flight);
-
     friend class CtShader;
     friend class CtRenderer;
 };
\ No newline at end of file
@@ -0,0 +1,884 @@
+#include "CtImageDecode.h"
+#include "CtMappedFile.h"
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <array>
+
+//Codes this long or shorter come out of one table lookup, longer ones get walked a bit at a time. Nearly everything a real
+//stream uses is short
+const uint32_t CT_INFLATE_FAST_BITS = 9;
+
+//How many times the compressed size Inflate reserves before it has any output. Image data rarely squeezes down more than this,
+//and a header claiming a huge size shouldn't get that much memory before the stream backs it up
+const size_t CT_INFLATE_RESERVE_RATIO = 4;
+
+//A canonical Huffman code the way deflate describes one, as how many codes there are of each length and the symbols sorted by code
+struct CtHuffmanCode{
+    uint16_t counts[16];
+    uint16_t symbols[288];
+
+    //Indexed by the next CT_INFLATE_FAST_BITS bits of the stream. The symbol in the low 9 bits and the code's length above them, 0 if
+    //the code is longer than the table
+    uint16_t fast[1 << CT_INFLATE_FAST_BITS];
+
+    void Build(const uint8_t* lengths, uint32_t count){
+        memset(counts, 0, sizeof(counts));
+        memset(fast, 0, sizeof(fast));
+
+        for(uint32_t s = 0; s < count; s++){
+            counts[lengths[s]]++;
+        }
+        counts[0] = 0;
+
+        uint16_t offsets[16];
+        offsets[1] = 0;
+        for(uint32_t l = 1; l < 15; l++){
+            offsets[l + 1] = offsets[l] + counts[l];
+        }
+        for(uint32_t s = 0; s < count; s++){
+            if(lengths[s] != 0){
+                symbols[offsets[lengths[s]]++] = static_cast<uint16_t>(s);
+            }
+        }
+
+        //Codes are handed out in order of length then symbol. The stream has them first bit first, so the table is indexed reversed
+        uint32_t code = 0;
+        uint32_t index = 0;
+        for(uint32_t l = 1; l <= CT_INFLATE_FAST_BITS; l++){
+            for(uint32_t c = 0; c < counts[l]; c++){
+                uint32_t reversed = 0;
+                for(uint32_t b = 0; b < l; b++){
+                    reversed |= ((code >> b) & 1) << (l - 1 - b);
+                }
+                for(uint32_t r = reversed; r < (1u << CT_INFLATE_FAST_BITS); r += 1u << l){
+                    fast[r] = static_cast<uint16_t>(symbols[index] | (l << 9));
+                }
+                code++;
+                index++;
+            }
+            code <<= 1;
+        }
+    }
+};
+
+//Where a deflate stream is up to. Bits come out lowest first
+struct CtInflateStream{
+    const uint8_t* data;
+    size_t size;
+    size_t position;
+    uint32_t bit_buffer;
+    uint32_t bit_count;
+
+    uint32_t Bits(uint32_t count){
+        while(bit_count < count){
+            if(position >= size){
+                throw std::runtime_error("A compressed image stream ends too early.");
+            }
+            bit_buffer |= static_cast<uint32_t>(data[position++]) << bit_count;
+            bit_count += 8;
+        }
+
+        uint32_t value = bit_buffer & ((1u << count) - 1);
+        bit_buffer >>= count;
+        bit_count -= count;
+        return value;
+    }
+
+    uint32_t Decode(const CtHuffmanCode& code){
+        //Top up without failing, the stream can legitimately end less than a table's worth of bits after the last code
+        while(bit_count <= 24 && position < size){
+            bit_buffer |= static_cast<uint32_t>(data[position++]) << bit_count;
+            bit_count += 8;
+        }
+
+        uint16_t entry = code.fast[bit_buffer & ((1u << CT_INFLATE_FAST_BITS) - 1)];
+        if(entry != 0 && static_cast<uint32_t>(entry >> 9) <= bit_count){
+            bit_buffer >>= entry >> 9;
+            bit_count -= entry >> 9;
+            return entry & 0x1FF;
+        }
+
+        int32_t value = 0;
+        int32_t first = 0;
+        int32_t index = 0;
+        for(uint32_t l = 1; l < 16; l++){
+            value |= static_cast<int32_t>(Bits(1));
+            int32_t count = code.counts[l];
+            if(value - count < first){
+                return code.symbols[index + (value - first)];
+            }
+            index += count;
+            first = (first + count) << 1;
+            value <<= 1;
+        }
+
+        throw std::runtime_error("A compressed image stream has a code that isn't in its table.");
+    }
+};
+
+CtImageData CtImageDecode::Decode(const uint8_t* data, size_t size, const std::string& name){
+    const uint8_t png_signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    if(size >= 8 && memcmp(data, png_signature, 8) == 0){
+        return DecodePng(data, size, name);
+    }
+    if(size >= 2 && data[0] == 'B' && data[1] == 'M'){
+        return DecodeBmp(data, size, name);
+    }
+
+    //TGA is the only one without a signature, so it's whatever is left
+    return DecodeTga(data, size, name);
+}
+
+CtImageData CtImageDecode::Load(const std::string& path){
+    CtMappedFile* file = CtMappedFile::Open(path, true);
+
+    CtImageData image;
+    try{
+        image = Decode(file->GetData(), static_cast<size_t>(file->GetSize()), path);
+    } catch(...){
+        file->Close();
+        delete file;
+        throw;
+    }
+
+    file->Close();
+    delete file;
+
+    return image;
+}
+
+CtImageData CtImageDecode::Downsample(const CtImageData& image, bool srgb){
+    //sRGB to linear for every byte value. Decoding threads all come through here, so the table is built once by the static's
+    //initialization, which is thread safe
+    static const std::array<float, 256> to_linear = [](){
+        std::array<float, 256> table;
+        for(uint32_t v = 0; v < 256; v++){
+            float c = v / 255.0f;
+            table[v] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return table;
+    }();
+    auto to_srgb = [](float c){
+        c = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+        return static_cast<uint8_t>(std::min(std::max(c * 255.0f + 0.5f, 0.0f), 255.0f));
+    };
+
+    CtImageData half;
+    half.width = std::max(image.width / 2, 1u);
+    half.height = std::max(image.height / 2, 1u);
+    half.pixels.resize(static_cast<size_t>(half.width) * half.height * 4);
+
+    for(uint32_t y = 0; y < half.height; y++){
+        uint32_t y0 = std::min(y * 2, image.height - 1);
+        uint32_t y1 = std::min(y * 2 + 1, image.height - 1);
+
+        for(uint32_t x = 0; x < half.width; x++){
+            uint32_t x0 = std::min(x * 2, image.width - 1);
+            uint32_t x1 = std::min(x * 2 + 1, image.width - 1);
+            const uint8_t* corners[4] = {
+                &image.pixels[(static_cast<size_t>(y0) * image.width + x0) * 4], &image.pixels[(static_cast<size_t>(y0) * image.width + x1) * 4],
+                &image.pixels[(static_cast<size_t>(y1) * image.width + x0) * 4], &image.pixels[(static_cast<size_t>(y1) * image.width + x1) * 4]
+            };
+
+            uint8_t* out = &half.pixels[(static_cast<size_t>(y) * half.width + x) * 4];
+            for(uint32_t c = 0; c < 4; c++){
+                if(srgb && c < 3){
+                    float sum = to_linear[corners[0][c]] + to_linear[corners[1][c]] + to_linear[corners[2][c]] + to_linear[corners[3][c]];
+                    out[c] = to_srgb(sum * 0.25f);
+                }
+                else{
+                    out[c] = static_cast<uint8_t>((corners[0][c] + corners[1][c] + corners[2][c] + corners[3][c] + 2) / 4);
+                }
+            }
+        }
+    }
+
+    return half;
+}
+
+/**************************************************************INFLATE*****************************************************************/
+
+std::vector<uint8_t> CtImageDecode::Inflate(const uint8_t* data, size_t size, size_t expected_size){
+    //Deflate, no preset dictionary, and the header checksum has to work out
+    if(size < 2 || (data[0] & 0x0F) != 8 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20) != 0){
+        throw std::runtime_error("A compressed image stream isn't zlib.");
+    }
+
+    static const uint16_t length_base[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115,
+        131, 163, 195, 227, 258};
+    static const uint8_t length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    static const uint16_t distance_base[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537,
+        2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    static const uint8_t distance_extra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+    static const uint8_t length_order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+    CtInflateStream stream {data, size, 2, 0, 0};
+    std::vector<uint8_t> out;
+    out.reserve(std::min(expected_size, size * CT_INFLATE_RESERVE_RATIO));
+
+    CtHuffmanCode lengths;
+    CtHuffmanCode distances;
+
+    uint32_t last = 0;
+    while(last == 0){
+        last = stream.Bits(1);
+        uint32_t type = stream.Bits(2);
+
+        if(type == 0){
+            //Stored. Skip to the next byte, handing back whole bytes the decoder had already pulled in ahead
+            stream.Bits(stream.bit_count % 8);
+            stream.position -= stream.bit_count / 8;
+            stream.bit_buffer = 0;
+            stream.bit_count = 0;
+
+            if(stream.size - stream.position < 4){
+                throw std::runtime_error("A compressed image stream ends too early.");
+            }
+            uint32_t length = data[stream.position] | (data[stream.position + 1] << 8);
+            uint32_t inverse = data[stream.position + 2] | (data[stream.position + 3] << 8);
+            stream.position += 4;
+            if(length != (~inverse & 0xFFFF) || stream.size - stream.position < length){
+                throw std::runtime_error("A compressed image stream has a broken stored block.");
+            }
+            if(length > expected_size - out.size()){
+                throw std::runtime_error("A compressed image stream inflates to more than it should.");
+            }
+
+            out.insert(out.end(), data + stream.position, data + stream.position + length);
+            stream.position += length;
+            continue;
+        }
+
+        uint8_t code_lengths[320];
+        if(type == 1){
+            for(uint32_t s = 0; s < 288; s++){
+                code_lengths[s] = s < 144 ? 8 : (s < 256 ? 9 : (s < 280 ? 7 : 8));
+            }
+            for(uint32_t s = 0; s < 30; s++){
+                code_lengths[288 + s] = 5;
+            }
+            lengths.Build(code_lengths, 288);
+            distances.Build(code_lengths + 288, 30);
+        }
+        else if(type == 2){
+            uint32_t length_count = stream.Bits(5) + 257;
+            uint32_t distance_count = stream.Bits(5) + 1;
+            uint32_t code_length_count = stream.Bits(4) + 4;
+            if(length_count > 286 || distance_count > 30){
+                throw std::runtime_error("A compressed image stream has too many codes.");
+            }
+
+            uint8_t code_length_lengths[19] = {};
+            for(uint32_t c = 0; c < code_length_count; c++){
+                code_length_lengths[length_order[c]] = static_cast<uint8_t>(stream.Bits(3));
+            }
+            CtHuffmanCode code_length_code;
+            code_length_code.Build(code_length_lengths, 19);
+
+            uint32_t total = length_count + distance_count;
+            uint32_t c = 0;
+            while(c < total){
+                uint32_t symbol = stream.Decode(code_length_code);
+                if(symbol < 16){
+                    code_lengths[c++] = static_cast<uint8_t>(symbol);
+                    continue;
+                }
+
+                uint8_t repeat_length = 0;
+                uint32_t repeat = 0;
+                if(symbol == 16){
+                    if(c == 0){
+                        throw std::runtime_error("A compressed image stream repeats a code length before there is one.");
+                    }
+                    repeat_length = code_lengths[c - 1];
+                    repeat = 3 + stream.Bits(2);
+                }
+                else if(symbol == 17){
+                    repeat = 3 + stream.Bits(3);
+                }
+                else{
+                    repeat = 11 + stream.Bits(7);
+                }
+
+                if(c + repeat > total){
+                    throw std::runtime_error("A compressed image stream has too many code lengths.");
+                }
+                memset(code_lengths + c, repeat_length, repeat);
+                c += repeat;
+            }
+
+            lengths.Build(code_lengths, length_count);
+            distances.Build(code_lengths + length_count, distance_count);
+        }
+        else{
+            throw std::runtime_error("A compressed image stream has a block of an unknown type.");
+        }
+
+        while(true){
+            uint32_t symbol = stream.Decode(lengths);
+            if(symbol < 256){
+                if(out.size() == expected_size){
+                    throw std::runtime_error("A compressed image stream inflates to more than it should.");
+                }
+                out.push_back(static_cast<uint8_t>(symbol));
+                continue;
+            }
+            if(symbol == 256){
+                break;
+            }
+
+            symbol -= 257;
+            if(symbol >= 29){
+                throw std::runtime_error("A compressed image stream has an invalid length.");
+            }
+            uint32_t length = length_base[symbol] + stream.Bits(length_extra[symbol]);
+
+            uint32_t distance_symbol = stream.Decode(distances);
+            if(distance_symbol >= 30){
+                throw std::runtime_error("A compressed image stream has an invalid distance.");
+            }
+            uint32_t distance = distance_base[distance_symbol] + stream.Bits(distance_extra[distance_symbol]);
+            if(distance > out.size()){
+                throw std::runtime_error("A compressed image stream points back before its start.");
+            }
+            if(length > expected_size - out.size()){
+                throw std::runtime_error("A compressed image stream inflates to more than it should.");
+            }
+
+            //Byte at a time, the copy is allowed to overlap what it's writing
+            size_t from = out.size() - distance;
+            for(uint32_t b = 0; b < length; b++){
+                out.push_back(out[from + b]);
+            }
+        }
+    }
+
+    return out;
+}
+
+/****************************************************************PNG*******************************************************************/
+
+CtImageData CtImageDecode::DecodePng(const uint8_t* data, size_t size, const std::string& name){
+    auto read_u32 = [](const uint8_t* bytes){
+        return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) | (static_cast<uint32_t>(bytes[2]) << 8) | bytes[3];
+    };
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t bit_depth = 0;
+    uint32_t color_type = 0;
+    uint32_t interlace = 0;
+    uint8_t palette[256 * 4];
+    uint32_t palette_size = 0;
+    bool has_key = false;
+    uint16_t key[3] = {0, 0, 0};
+    std::vector<uint8_t> compressed;
+
+    for(uint32_t p = 0; p < 256; p++){
+        palette[p * 4 + 0] = 0;
+        palette[p * 4 + 1] = 0;
+        palette[p * 4 + 2] = 0;
+        palette[p * 4 + 3] = 255;
+    }
+
+    //Chunks are a big endian length, a four letter type, the data and a CRC. The CRC isn't checked, a broken stream still fails in Inflate
+    size_t position = 8;
+    bool ended = false;
+    while(!ended){
+        if(size - position < 12){
+            throw std::runtime_error(name + " ends in the middle of a chunk.");
+        }
+
+        uint32_t length = read_u32(data + position);
+        const uint8_t* type = data + position + 4;
+        const uint8_t* chunk = data + position + 8;
+        if(length > size - position - 12){
+            throw std::runtime_error(name + " has a chunk past the end of the file.");
+        }
+
+        if(memcmp(type, "IHDR", 4) == 0 && length >= 13){
+            width = read_u32(chunk);
+            height = read_u32(chunk + 4);
+            bit_depth = chunk[8];
+            color_type = chunk[9];
+            interlace = chunk[12];
+            if(chunk[10] != 0 || chunk[11] != 0 || interlace > 1){
+                throw std::runtime_error(name + " uses a PNG compression, filter or interlace method that doesn't exist.");
+            }
+        }
+        else if(memcmp(type, "PLTE", 4) == 0){
+            palette_size = std::min(length / 3, 256u);
+            for(uint32_t p = 0; p < palette_size; p++){
+                palette[p * 4 + 0] = chunk[p * 3 + 0];
+                palette[p * 4 + 1] = chunk[p * 3 + 1];
+                palette[p * 4 + 2] = chunk[p * 3 + 2];
+            }
+        }
+        else if(memcmp(type, "tRNS", 4) == 0){
+            //Alpha per palette entry, or one color that counts as fully transparent
+            if(color_type == 3){
+                for(uint32_t p = 0; p < std::min(length, 256u); p++){
+                    palette[p * 4 + 3] = chunk[p];
+                }
+            }
+            else if(color_type == 0 && length >= 2){
+                has_key = true;
+                key[0] = static_cast<uint16_t>((chunk[0] << 8) | chunk[1]);
+            }
+            else if(color_type == 2 && length >= 6){
+                has_key = true;
+                for(uint32_t c = 0; c < 3; c++){
+                    key[c] = static_cast<uint16_t>((chunk[c * 2] << 8) | chunk[c * 2 + 1]);
+                }
+            }
+        }
+        else if(memcmp(type, "IDAT", 4) == 0){
+            compressed.insert(compressed.end(), chunk, chunk + length);
+        }
+        else if(memcmp(type, "IEND", 4) == 0){
+            ended = true;
+        }
+
+        position += static_cast<size_t>(length) + 12;
+    }
+
+    uint32_t channels = 0;
+    switch(color_type){
+        case 0: channels = 1; break;
+        case 2: channels = 3; break;
+        case 3: channels = 1; break;
+        case 4: channels = 2; break;
+        case 6: channels = 4; break;
+        default:
+            throw std::runtime_error(name + " has a PNG color type that doesn't exist.");
+    }
+
+    bool valid_depth = color_type == 3 ? (bit_depth == 1 || bit_depth == 2 || bit_depth == 4 || bit_depth == 8) :
+        (color_type == 0 ? (bit_depth == 1 || bit_depth == 2 || bit_depth == 4 || bit_depth == 8 || bit_depth == 16) : (bit_depth == 8 || bit_depth == 16));
+    if(width == 0 || height == 0 || !valid_depth || compressed.empty()){
+        throw std::runtime_error(name + " has a broken PNG header or no image data.");
+    }
+    if(width > CT_IMAGE_DECODE_MAX_DIMENSION || height > CT_IMAGE_DECODE_MAX_DIMENSION ||
+        static_cast<uint64_t>(width) * height * 4 > SIZE_MAX){
+        throw std::runtime_error(name + " is bigger than any texture can be. Scale it down.");
+    }
+    if(color_type == 3 && palette_size == 0){
+        throw std::runtime_error(name + " is palettized without a palette.");
+    }
+
+    //Interlaced images come as seven passes over smaller and smaller grids, Adam7. Otherwise it's one pass over every pixel
+    const uint32_t pass_x[7] = {0, 4, 0, 2, 0, 1, 0};
+    const uint32_t pass_y[7] = {0, 0, 4, 0, 2, 0, 1};
+    const uint32_t pass_step_x[7] = {8, 8, 4, 4, 2, 2, 1};
+    const uint32_t pass_step_y[7] = {8, 8, 8, 4, 4, 2, 2};
+    uint32_t pass_count = interlace == 1 ? 7 : 1;
+
+    uint32_t bits_per_pixel = channels * bit_depth;
+    uint32_t filter_bytes = std::max(bits_per_pixel / 8, 1u);
+
+    uint64_t expected_size = 0;
+    for(uint32_t pass = 0; pass < pass_count; pass++){
+        uint64_t pass_width = interlace == 1 ? (width + pass_step_x[pass] - 1 - pass_x[pass]) / pass_step_x[pass] : width;
+        uint64_t pass_height = interlace == 1 ? (height + pass_step_y[pass] - 1 - pass_y[pass]) / pass_step_y[pass] : height;
+        if(pass_width > 0 && pass_height > 0){
+            expected_size += pass_height * (1 + (pass_width * bits_per_pixel + 7) / 8);
+        }
+    }
+    if(expected_size > SIZE_MAX){
+        throw std::runtime_error(name + " is bigger than any texture can be. Scale it down.");
+    }
+
+    std::vector<uint8_t> filtered = Inflate(compressed.data(), compressed.size(), static_cast<size_t>(expected_size));
+    compressed = std::vector<uint8_t>();
+    if(filtered.size() < expected_size){
+        throw std::runtime_error(name + " has less image data than its size needs.");
+    }
+
+    CtImageData image;
+    image.width = width;
+    image.height = height;
+    image.pixels.resize(static_cast<size_t>(width) * height * 4);
+
+    auto sample = [&](const uint8_t* row, uint32_t x, uint32_t channel) -> uint32_t{
+        if(bit_depth == 8){
+            return row[x * channels + channel];
+        }
+        if(bit_depth == 16){
+            size_t offset = (static_cast<size_t>(x) * channels + channel) * 2;
+            return (row[offset] << 8) | row[offset + 1];
+        }
+
+        //Packed, first pixel in the highest bits. Only ever one channel
+        uint32_t bit = x * bit_depth;
+        return (row[bit / 8] >> (8 - bit_depth - bit % 8)) & ((1u << bit_depth) - 1);
+    };
+    auto to_byte = [&](uint32_t value) -> uint8_t{
+        if(bit_depth == 16){
+            return static_cast<uint8_t>(value >> 8);
+        }
+        return static_cast<uint8_t>(value * 255 / ((1u << bit_depth) - 1));
+    };
+
+    size_t offset = 0;
+    for(uint32_t pass = 0; pass < pass_count; pass++){
+        uint32_t start_x = interlace == 1 ? pass_x[pass] : 0;
+        uint32_t start_y = interlace == 1 ? pass_y[pass] : 0;
+        uint32_t step_x = interlace == 1 ? pass_step_x[pass] : 1;
+        uint32_t step_y = interlace == 1 ? pass_step_y[pass] : 1;
+        uint32_t pass_width = (width + step_x - 1 - start_x) / step_x;
+        uint32_t pass_height = (height + step_y - 1 - start_y) / step_y;
+        if(start_x >= width || start_y >= height || pass_width == 0 || pass_height == 0){
+            continue;
+        }
+
+        size_t stride = (static_cast<size_t>(pass_width) * bits_per_pixel + 7) / 8;
+        std::vector<uint8_t> previous(stride, 0);
+        std::vector<uint8_t> current(stride);
+
+        for(uint32_t y = 0; y < pass_height; y++){
+            uint8_t filter = filtered[offset];
+            const uint8_t* source = &filtered[offset + 1];
+            offset += stride + 1;
+
+            for(size_t i = 0; i < stride; i++){
+                uint32_t left = i >= filter_bytes ? current[i - filter_bytes] : 0;
+                uint32_t up = previous[i];
+                uint32_t up_left = i >= filter_bytes ? previous[i - filter_bytes] : 0;
+
+                uint32_t predicted = 0;
+                switch(filter){
+                    case 0: predicted = 0; break;
+                    case 1: predicted = left; break;
+                    case 2: predicted = up; break;
+                    case 3: predicted = (left + up) / 2; break;
+                    case 4: {
+                        int32_t estimate = static_cast<int32_t>(left + up) - static_cast<int32_t>(up_left);
+                        int32_t distance_left = std::abs(estimate - static_cast<int32_t>(left));
+                        int32_t distance_up = std::abs(estimate - static_cast<int32_t>(up));
+                        int32_t distance_up_left = std::abs(estimate - static_cast<int32_t>(up_left));
+                        predicted = distance_left <= distance_up && distance_left <= distance_up_left ? left : (distance_up <= distance_up_left ? up : up_left);
+                        break;
+                    }
+                    default:
+                        throw std::runtime_error(name + " has a row with an unknown filter.");
+                }
+
+                current[i] = static_cast<uint8_t>(source[i] + predicted);
+            }
+
+            uint32_t image_y = start_y + y * step_y;
+            for(uint32_t x = 0; x < pass_width; x++){
+                uint8_t* out = &image.pixels[(static_cast<size_t>(image_y) * width + start_x + x * step_x) * 4];
+
+                if(color_type == 3){
+                    uint32_t index = sample(current.data(), x, 0);
+                    memcpy(out, &palette[std::min(index, 255u) * 4], 4);
+                    continue;
+                }
+
+                uint32_t values[4];
+                for(uint32_t c = 0; c < channels; c++){
+                    values[c] = sample(current.data(), x, c);
+                }
+
+                if(channels <= 2){
+                    out[0] = out[1] = out[2] = to_byte(values[0]);
+                    out[3] = channels == 2 ? to_byte(values[1]) : (has_key && values[0] == key[0] ? 0 : 255);
+                }
+                else{
+                    out[0] = to_byte(values[0]);
+                    out[1] = to_byte(values[1]);
+                    out[2] = to_byte(values[2]);
+                    out[3] = channels == 4 ? to_byte(values[3]) :
+                        (has_key && values[0] == key[0] && values[1] == key[1] && values[2] == key[2] ? 0 : 255);
+                }
+            }
+
+            std::swap(previous, current);
+        }
+    }
+
+    return image;
+}
+
+/****************************************************************TGA*******************************************************************/
+
+CtImageData CtImageDecode::DecodeTga(const uint8_t* data, size_t size, const std::string& name){
+    if(size < 18){
+        throw std::runtime_error("Don't know what format " + name + " is.");
+    }
+
+    uint32_t id_length = data[0];
+    uint32_t color_map_type = data[1];
+    uint32_t image_type = data[2];
+    uint32_t color_map_first = data[3] | (data[4] << 8);
+    uint32_t color_map_length = data[5] | (data[6] << 8);
+    uint32_t color_map_depth = data[7];
+    uint32_t width = data[12] | (data[13] << 8);
+    uint32_t height = data[14] | (data[15] << 8);
+    uint32_t pixel_depth = data[16];
+    uint32_t descriptor = data[17];
+
+    bool rle = image_type >= 9;
+    uint32_t base_type = rle ? image_type - 8 : image_type;
+    bool valid = (base_type == 1 && color_map_type == 1 && pixel_depth == 8) || (base_type == 2 && (pixel_depth == 15 || pixel_depth == 16 ||
+        pixel_depth == 24 || pixel_depth == 32)) || (base_type == 3 && (pixel_depth == 8 || pixel_depth == 16));
+    if(!valid || width == 0 || height == 0){
+        throw std::runtime_error("Don't know what format " + name + " is, or it's a kind of TGA that isn't supported.");
+    }
+    if(width > CT_IMAGE_DECODE_MAX_DIMENSION || height > CT_IMAGE_DECODE_MAX_DIMENSION){
+        throw std::runtime_error(name + " is bigger than any texture can be. Scale it down.");
+    }
+
+    //read_color only knows these. Anything else would read the wrong number of bytes per entry
+    if(color_map_type == 1 && color_map_depth != 15 && color_map_depth != 16 && color_map_depth != 24 && color_map_depth != 32){
+        throw std::runtime_error(name + " has a color map with " + std::to_string(color_map_depth) + " bit entries, which isn't supported.");
+    }
+
+    //15 and 16 bit are 5 bits a channel with alpha on top, 16 bit grayscale is gray then alpha
+    auto read_color = [&](const uint8_t* bytes, uint32_t depth, uint8_t* out){
+        if(depth == 15 || (depth == 16 && base_type != 3)){
+            uint32_t value = bytes[0] | (bytes[1] << 8);
+            out[0] = static_cast<uint8_t>(((value >> 10) & 0x1F) * 255 / 31);
+            out[1] = static_cast<uint8_t>(((value >> 5) & 0x1F) * 255 / 31);
+            out[2] = static_cast<uint8_t>((value & 0x1F) * 255 / 31);
+            out[3] = depth == 16 && (descriptor & 0x0F) != 0 ? ((value & 0x8000) != 0 ? 255 : 0) : 255;
+        }
+        else if(depth == 16){
+            out[0] = out[1] = out[2] = bytes[0];
+            out[3] = bytes[1];
+        }
+        else if(depth == 8){
+            out[0] = out[1] = out[2] = bytes[0];
+            out[3] = 255;
+        }
+        else{
+            out[0] = bytes[2];
+            out[1] = bytes[1];
+            out[2] = bytes[0];
+            out[3] = depth == 32 && (descriptor & 0x0F) != 0 ? bytes[3] : 255;
+        }
+    };
+
+    size_t position = 18 + id_length;
+    std::vector<uint8_t> color_map;
+    if(color_map_type == 1){
+        uint32_t entry_size = (color_map_depth + 7) / 8;
+        if(size < position + static_cast<size_t>(color_map_length) * entry_size){
+            throw std::runtime_error(name + " ends in the middle of its color map.");
+        }
+
+        color_map.resize(static_cast<size_t>(color_map_length) * 4);
+        for(uint32_t e = 0; e < color_map_length; e++){
+            read_color(data + position + static_cast<size_t>(e) * entry_size, color_map_depth, &color_map[e * 4]);
+        }
+        position += static_cast<size_t>(color_map_length) * entry_size;
+    }
+
+    uint32_t pixel_size = (pixel_depth + 7) / 8;
+    auto read_pixel = [&](const uint8_t* bytes, uint8_t* out){
+        if(base_type == 1){
+            uint32_t index = bytes[0] - std::min(color_map_first, static_cast<uint32_t>(bytes[0]));
+            if(index >= color_map_length){
+                throw std::runtime_error(name + " has a pixel past the end of its color map.");
+            }
+            memcpy(out, &color_map[index * 4], 4);
+        }
+        else{
+            read_color(bytes, pixel_depth, out);
+        }
+    };
+
+    //Raw files need every pixel's bytes, and RLE ones at least a packet header and a pixel for every 128. Checked before
+    //allocating anything so a header can't claim more pixels than the file could hold
+    size_t pixel_count = static_cast<size_t>(width) * height;
+    size_t least_size = rle ? (pixel_count + 127) / 128 * (1 + pixel_size) : pixel_count * pixel_size;
+    if(position > size || size - position < least_size){
+        throw std::runtime_error(name + " ends before its last pixel.");
+    }
+
+    //Decoded in file order first, flipped into rows from the top after
+    std::vector<uint8_t> pixels(pixel_count * 4);
+    size_t p = 0;
+    while(p < pixel_count){
+        if(!rle){
+            if(size - position < pixel_size){
+                throw std::runtime_error(name + " ends before its last pixel.");
+            }
+            read_pixel(data + position, &pixels[p * 4]);
+            position += pixel_size;
+            p++;
+            continue;
+        }
+
+        if(position >= size){
+            throw std::runtime_error(name + " ends before its last pixel.");
+        }
+        uint32_t header = data[position++];
+        uint32_t count = (header & 0x7F) + 1;
+        if(count > pixel_count - p){
+            throw std::runtime_error(name + " has a run past its last pixel.");
+        }
+
+        if((header & 0x80) != 0){
+            if(size - position < pixel_size){
+                throw std::runtime_error(name + " ends before its last pixel.");
+            }
+            uint8_t color[4];
+            read_pixel(data + position, color);
+            position += pixel_size;
+            for(uint32_t r = 0; r < count; r++){
+                memcpy(&pixels[(p + r) * 4], color, 4);
+            }
+        }
+        else{
+            if(size - position < static_cast<size_t>(count) * pixel_size){
+                throw std::runtime_error(name + " ends before its last pixel.");
+            }
+            for(uint32_t r = 0; r < count; r++){
+                read_pixel(data + position, &pixels[(p + r) * 4]);
+                position += pixel_size;
+            }
+        }
+        p += count;
+    }
+
+    //Bit 5 of the descriptor means the first row is the top, bit 4 that rows go right to left. Neither is the usual case
+    bool top_down = (descriptor & 0x20) != 0;
+    bool right_to_left = (descriptor & 0x10) != 0;
+
+    CtImageData image;
+    image.width = width;
+    image.height = height;
+    if(top_down && !right_to_left){
+        image.pixels = std::move(pixels);
+        return image;
+    }
+
+    image.pixels.resize(pixel_count * 4);
+    for(uint32_t y = 0; y < height; y++){
+        uint32_t source_y = top_down ? y : height - 1 - y;
+        for(uint32_t x = 0; x < width; x++){
+            uint32_t source_x = right_to_left ? width - 1 - x : x;
+            memcpy(&image.pixels[(static_cast<size_t>(y) * width + x) * 4], &pixels[(static_cast<size_t>(source_y) * width + source_x) * 4], 4);
+        }
+    }
+
+    return image;
+}
+
+/****************************************************************BMP*******************************************************************/
+
+CtImageData CtImageDecode::DecodeBmp(const uint8_t* data, size_t size, const std::string& name){
+    auto read_u32 = [&](size_t offset){
+        uint32_t value;
+        memcpy(&value, data + offset, sizeof(value));
+        return value;
+    };
+
+    if(size < 54){
+        throw std::runtime_error(name + " is too short to be a BMP.");
+    }
+
+    uint32_t pixel_offset = read_u32(10);
+    uint32_t header_size = read_u32(14);
+    int32_t width = static_cast<int32_t>(read_u32(18));
+    int32_t signed_height = static_cast<int32_t>(read_u32(22));
+    uint32_t bit_count = data[28] | (data[29] << 8);
+    uint32_t compression = read_u32(30);
+    uint32_t palette_count = read_u32(46);
+
+    //Negative heights are stored top row first, positive ones bottom row first
+    bool top_down = signed_height < 0;
+    uint32_t height = static_cast<uint32_t>(top_down ? -static_cast<int64_t>(signed_height) : signed_height);
+
+    //Uncompressed, or 32 bit with its own channel masks. Those follow the header, or are part of it in the newer ones
+    uint32_t masks[4] = {0x00FF0000, 0x0000FF00, 0x000000FF, 0};
+    if(compression == 3 && bit_count == 32){
+        size_t mask_offset = 14 + 40;
+        if(size < mask_offset + 16){
+            throw std::runtime_error(name + " ends in the middle of its header.");
+        }
+        masks[0] = read_u32(mask_offset);
+        masks[1] = read_u32(mask_offset + 4);
+        masks[2] = read_u32(mask_offset + 8);
+        masks[3] = header_size >= 56 ? read_u32(mask_offset + 12) : 0;
+    }
+    else if(compression != 0 || (bit_count != 8 && bit_count != 24 && bit_count != 32)){
+        throw std::runtime_error(name + " is a kind of BMP that isn't supported, only 8, 24 and 32 bit uncompressed ones are.");
+    }
+
+    if(width <= 0 || height == 0){
+        throw std::runtime_error(name + " has a broken BMP header.");
+    }
+    if(static_cast<uint32_t>(width) > CT_IMAGE_DECODE_MAX_DIMENSION || height > CT_IMAGE_DECODE_MAX_DIMENSION){
+        throw std::runtime_error(name + " is bigger than any texture can be. Scale it down.");
+    }
+
+    uint8_t palette[256 * 4] = {};
+    if(bit_count == 8){
+        uint32_t entries = palette_count == 0 ? 256 : std::min(palette_count, 256u);
+        size_t palette_offset = 14 + static_cast<size_t>(header_size);
+        if(size < palette_offset + static_cast<size_t>(entries) * 4){
+            throw std::runtime_error(name + " ends in the middle of its palette.");
+        }
+        for(uint32_t e = 0; e < entries; e++){
+            palette[e * 4 + 0] = data[palette_offset + e * 4 + 2];
+            palette[e * 4 + 1] = data[palette_offset + e * 4 + 1];
+            palette[e * 4 + 2] = data[palette_offset + e * 4 + 0];
+            palette[e * 4 + 3] = 255;
+        }
+    }
+
+    //Pulls one channel out of a 32 bit pixel with its mask and stretches it to 8 bits
+    auto extract = [](uint32_t pixel, uint32_t mask) -> uint8_t{
+        if(mask == 0){
+            return 255;
+        }
+        uint32_t shift = 0;
+        while(((mask >> shift) & 1) == 0){
+            shift++;
+        }
+        uint32_t maximum = mask >> shift;
+        return static_cast<uint8_t>(((pixel & mask) >> shift) * 255 / maximum);
+    };
+
+    //Every row is padded out to 4 bytes
+    size_t stride = (static_cast<size_t>(width) * bit_count / 8 + 3) & ~static_cast<size_t>(3);
+    if(pixel_offset > size || stride * height > size - pixel_offset){
+        throw std::runtime_error(name + " ends before its last pixel.");
+    }
+
+    CtImageData image;
+    image.width = static_cast<uint32_t>(width);
+    image.height = height;
+    image.pixels.resize(static_cast<size_t>(width) * height * 4);
+
+    for(uint32_t y = 0; y < height; y++){
+        const uint8_t* row = data + pixel_offset + stride * (top_down ? y : height - 1 - y);
+        for(uint32_t x = 0; x < image.width; x++){
+            uint8_t* out = &image.pixels[(static_cast<size_t>(y) * image.width + x) * 4];
+            if(bit_count == 8){
+                memcpy(out, &palette[row[x] * 4], 4);
+            }
+            else if(bit_count == 24){
+                out[0] = row[x * 3 + 2];
+                out[1] = row[x * 3 + 1];
+                out[2] = row[x * 3 + 0];
+                out[3] = 255;
+            }
+            else{
+                uint32_t pixel;
+                memcpy(&pixel, row + x * 4, sizeof(pixel));
+                out[0] = extract(pixel, masks[0]);
+                out[1] = extract(pixel, masks[1]);
+                out[2] = extract(pixel, masks[2]);
+                out[3] = extract(pixel, masks[3]);
+            }
+        }
+    }
+
+    return image;
+}
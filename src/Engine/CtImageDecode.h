@@ -0,0 +1,40 @@
+#include <vector>
+#include <string>
+#include <cstdint>
+
+//Biggest width or height the decoders take, checked before anything is allocated for the pixels. Headers are only 16 or 32 bits
+//of whatever the file says, and most devices can't sample anything bigger anyway
+const uint32_t CT_IMAGE_DECODE_MAX_DIMENSION = 16384;
+
+//An image decoded to 8 bit RGBA, rows from the top down
+struct CtImageData{
+    uint32_t width;
+    uint32_t height;
+    std::vector<uint8_t> pixels;
+};
+
+//Turns image files into CtImageData. Everything in here is plain CPU work, so it can run on any thread.
+//Reads PNG (every color type and bit depth, interlaced or not), TGA (color mapped, truecolor and grayscale, raw or RLE) and BMP
+//(8 bit palettized and 24 or 32 bit uncompressed). Anything 16 bit per channel gets cut down to 8
+class CtImageDecode{
+
+    public:
+        //Which format it is comes from the data, not the name. name only goes into errors
+        static CtImageData Decode(const uint8_t* data, size_t size, const std::string& name);
+
+        //Maps the file and decodes it
+        static CtImageData Load(const std::string& path);
+
+        //Half the size with a 2x2 box filter, for when the GPU can't make the mips itself. srgb averages the color in linear space
+        //the way a blit from an sRGB format would
+        static CtImageData Downsample(const CtImageData& image, bool srgb);
+
+        //Decompresses a zlib stream. Throws as soon as it would come out bigger than expected_size, so a broken or hostile stream
+        //can't eat memory. Only a few times the compressed size gets reserved up front, past that it grows as output arrives
+        static std::vector<uint8_t> Inflate(const uint8_t* data, size_t size, size_t expected_size);
+
+    private:
+        static CtImageData DecodePng(const uint8_t* data, size_t size, const std::string& name);
+        static CtImageData DecodeTga(const uint8_t* data, size_t size, const std::string& name);
+        static CtImageData DecodeBmp(const uint8_t* data, size_t size, const std::string& name);
+};
@@ -142,6 +142,20 @@ std::vector<const char*> CtInstance::GrabExtensions(){
     return extensions;
 }
 
+//A 1.0 loader doesn't have vkEnumerateInstanceVersion at all, and it will refuse an instance that asks for anything newer than 1.0
+uint32_t CtInstance::GetSupportedApiVersion(uint32_t highest_version){
+    auto enumerate_instance_version = (PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion");
+
+    if(enumerate_instance_version == nullptr){
+        return VK_API_VERSION_1_0;
+    }
+
+    uint32_t loader_version = VK_API_VERSION_1_0;
+    enumerate_instance_version(&loader_version);
+
+    return loader_version < highest_version ? loader_version : highest_version;
+}
+
 void CtInstance::InitializeInstance(CtInstanceApplicationInfo ct_application_info, CtInstanceCreateInfo ct_create_info){
 
     auto extensions = GrabExtensions();
@@ -159,6 +173,8 @@ void CtInstance::InitializeInstance(CtInstanceApplicationInfo ct_application_inf
     vk_application_info.engineVersion = ct_application_info.engineVersion;
     vk_application_info.apiVersion = ct_application_info.apiVersion;
 
+    api_version = ct_application_info.apiVersion;
+
     printf("Application name: %s.\n", vk_application_info.pApplicationName);
 
     VkInstanceCreateInfo vk_create_info {};
@@ -115,9 +115,18 @@ class CtInstance{
             return &instance;
         }
 
+        uint32_t GetApiVersion(){
+            return api_version;
+        }
+
+        static uint32_t GetSupportedApiVersion(uint32_t highest_version);
+
     private:
         VkInstance instance;
 
+        //The Vulkan version we asked for when creating the instance
+        uint32_t api_version = VK_API_VERSION_1_0;
+
         VkDebugUtilsMessengerEXT debug_messenger;
 
         std::vector<const char*> using_validation_layers;
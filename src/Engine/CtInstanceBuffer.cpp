@@ -0,0 +1,106 @@
+#include "CtInstanceBuffer.h"
+#include "CtDevice.h"
+#include <stdexcept>
+#include <cstring>
+
+CtInstanceBuffer* CtInstanceBuffer::CreateInstanceBuffer(CtDevice* device, uint32_t instance_size, uint32_t max_instances, uint32_t max_frames_in_flight){
+    CtInstanceBuffer* ct_instance_buffer = new CtInstanceBuffer();
+
+    ct_instance_buffer->device = device;
+    ct_instance_buffer->instance_size = instance_size;
+    ct_instance_buffer->max_instances = max_instances;
+    ct_instance_buffer->max_frames_in_flight = max_frames_in_flight;
+    ct_instance_buffer->frame_start = 0;
+    ct_instance_buffer->head = 0;
+
+    ct_instance_buffer->CreateBuffer(static_cast<VkDeviceSize>(instance_size) * max_instances * max_frames_in_flight);
+
+    printf("Created Instance Buffer.\n");
+
+    return ct_instance_buffer;
+}
+
+//Same deal as the uniform ring, the CPU rewrites this every frame and the GPU reads it once, so it stays mapped and we take device
+//local memory when the GPU lets us map it
+void CtInstanceBuffer::CreateBuffer(VkDeviceSize size){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    VkBufferCreateInfo buffer_info {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = size;
+    buffer_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT; //Culling writes the visible instances from compute
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    device->ShareAcrossQueues(buffer_info); //Which might be on the compute queue
+
+    if(vkCreateBuffer(interface_device, &buffer_info, nullptr, &buffer) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create the instance buffer.");
+    }
+
+    VkMemoryRequirements memory_requirements;
+    vkGetBufferMemoryRequirements(interface_device, buffer, &memory_requirements);
+
+    VkMemoryAllocateInfo allocate_info {};
+    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocate_info.allocationSize = memory_requirements.size;
+
+    try{
+        allocate_info.memoryTypeIndex = device->FindMemoryType(memory_requirements.memoryTypeBits,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    } catch(const std::runtime_error&){
+        allocate_info.memoryTypeIndex = device->FindMemoryType(memory_requirements.memoryTypeBits,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    }
+
+    if(vkAllocateMemory(interface_device, &allocate_info, nullptr, &buffer_memory) != VK_SUCCESS){
+        throw std::runtime_error("Failed to allocate the instance buffer memory.");
+    }
+
+    vkBindBufferMemory(interface_device, buffer, buffer_memory, 0);
+
+    void* data;
+    if(vkMapMemory(interface_device, buffer_memory, 0, size, 0, &data) != VK_SUCCESS){
+        throw std::runtime_error("Failed to map the instance buffer memory.");
+    }
+    mapped = static_cast<uint8_t*>(data);
+}
+
+void CtInstanceBuffer::BeginFrame(uint32_t frame){
+    frame_start = static_cast<VkDeviceSize>(instance_size) * max_instances * frame;
+    head = 0;
+}
+
+uint32_t CtInstanceBuffer::Push(const void* instances, uint32_t count){
+    if(head + count > max_instances){
+        throw std::runtime_error("Instance buffer is out of space for this frame. Give it more instances.");
+    }
+
+    memcpy(mapped + frame_start + static_cast<VkDeviceSize>(head) * instance_size, instances, static_cast<size_t>(count) * instance_size);
+
+    uint32_t first_instance = head;
+    head += count;
+
+    return first_instance;
+}
+
+uint32_t CtInstanceBuffer::Reserve(uint32_t count){
+    if(head + count > max_instances){
+        throw std::runtime_error("Instance buffer is out of space for this frame. Give it more instances.");
+    }
+
+    uint32_t first_instance = head;
+    head += count;
+
+    return first_instance;
+}
+
+void CtInstanceBuffer::Bind(VkCommandBuffer command_buffer, uint32_t binding){
+    vkCmdBindVertexBuffers(command_buffer, binding, 1, &buffer, &frame_start);
+}
+
+void CtInstanceBuffer::Cleanup(){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    vkUnmapMemory(interface_device, buffer_memory);
+    vkDestroyBuffer(interface_device, buffer, nullptr);
+    vkFreeMemory(interface_device, buffer_memory, nullptr);
+}
@@ -0,0 +1,67 @@
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+class CtDevice;
+
+//A persistently mapped vertex buffer for per instance data, split into a region per frame in flight the same way the uniform ring is.
+//Every instance for the frame gets copied in with as few pushes as possible and the region is bound once, so drawing 100k copies
+//of a mesh is one upload and one vkCmdDrawIndexed with firstInstance pointing at where that batch landed
+class CtInstanceBuffer{
+
+    public:
+        static CtInstanceBuffer* CreateInstanceBuffer(CtDevice* device, uint32_t instance_size, uint32_t max_instances, uint32_t max_frames_in_flight);
+
+        //Call once the frame's fence has signaled, that region is free to be written over again
+        void BeginFrame(uint32_t frame);
+
+        //Copies count instances in and returns the index of the first one, which is what the draw's firstInstance should be
+        uint32_t Push(const void* instances, uint32_t count);
+
+        template<typename T>
+        uint32_t Push(const std::vector<T>& instances){
+            if(sizeof(T) != instance_size){
+                throw std::runtime_error("Instance type doesn't match the instance buffer's layout.");
+            }
+            return Push(instances.data(), static_cast<uint32_t>(instances.size()));
+        }
+
+        //Takes count instances without writing them, for when the GPU fills them in. Returns the first one like Push
+        uint32_t Reserve(uint32_t count);
+
+        //Binds this frame's region so instance 0 is the start of it
+        void Bind(VkCommandBuffer command_buffer, uint32_t binding);
+
+        VkBuffer GetBuffer(){
+            return buffer;
+        }
+
+        //Where this frame's region starts, in instances from the front of the buffer
+        uint32_t GetFrameBase(){
+            return static_cast<uint32_t>(frame_start / instance_size);
+        }
+
+        VkDeviceSize GetSize(){
+            return static_cast<VkDeviceSize>(instance_size) * max_instances * max_frames_in_flight;
+        }
+
+        void Cleanup();
+
+    private:
+
+        CtDevice* device;
+
+        VkBuffer buffer;
+        VkDeviceMemory buffer_memory;
+        uint8_t* mapped;
+
+        uint32_t instance_size;
+        uint32_t max_instances;
+        uint32_t max_frames_in_flight;
+
+        VkDeviceSize frame_start;
+        uint32_t head; //In instances, not bytes
+
+        void CreateBuffer(VkDeviceSize size);
+};
@@ -0,0 +1,57 @@
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <array>
+#include <cstdint>
+
+//Which vertex binding the per instance data comes in on. Binding 0 is the mesh's own vertices
+const uint32_t CT_INSTANCE_BINDING = 1;
+
+//The first shader location the instance attributes take. The vertex semantics use 0 through 3
+const uint32_t CT_INSTANCE_FIRST_LOCATION = 4;
+
+//Everything one copy of a mesh needs to be told apart from the rest. This steps once per instance instead of once per vertex,
+//so one instanced draw can put the same mesh in thousands of places. To change what an instance carries, change this struct and
+//its attribute descriptions together with the shader inputs
+struct CtInstanceData {
+    glm::mat4 transform;
+    glm::vec4 color;
+    uint32_t material_id;
+
+    //Keeps the stride a multiple of 16 so the next instance's matrix stays aligned
+    uint32_t padding[3];
+
+    static VkVertexInputBindingDescription GetBindingDescription(){
+        VkVertexInputBindingDescription binding_description{};
+
+        binding_description.binding = CT_INSTANCE_BINDING;
+        binding_description.stride = sizeof(CtInstanceData);
+        binding_description.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+        return binding_description;
+    }
+
+    //A mat4 doesn't fit in one attribute, so it goes in as four vec4 columns on back to back locations
+    static std::array<VkVertexInputAttributeDescription, 6> GetAttributeDescriptions(){
+        std::array<VkVertexInputAttributeDescription, 6> attribute_descriptions{};
+
+        for(uint32_t column = 0; column < 4; column++){
+            attribute_descriptions[column].binding = CT_INSTANCE_BINDING;
+            attribute_descriptions[column].location = CT_INSTANCE_FIRST_LOCATION + column;
+            attribute_descriptions[column].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+            attribute_descriptions[column].offset = offsetof(CtInstanceData, transform) + sizeof(glm::vec4) * column;
+        }
+
+        attribute_descriptions[4].binding = CT_INSTANCE_BINDING;
+        attribute_descriptions[4].location = CT_INSTANCE_FIRST_LOCATION + 4;
+        attribute_descriptions[4].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+        attribute_descriptions[4].offset = offsetof(CtInstanceData, color);
+
+        attribute_descriptions[5].binding = CT_INSTANCE_BINDING;
+        attribute_descriptions[5].location = CT_INSTANCE_FIRST_LOCATION + 5;
+        attribute_descriptions[5].format = VK_FORMAT_R32_UINT;
+        attribute_descriptions[5].offset = offsetof(CtInstanceData, material_id);
+
+        return attribute_descriptions;
+    }
+};
@@ -0,0 +1,248 @@
+#include "CtJson.h"
+#include <stdexcept>
+#include <cstdlib>
+#include <cstring>
+
+//Deeper than this is either broken or an attack, real asset descriptions come nowhere near it
+const uint32_t CT_JSON_MAX_DEPTH = 256;
+
+const CtJsonValue& CtJsonValue::operator[](const std::string& key) const{
+    static const CtJsonValue null_value;
+
+    if(type == CT_JSON_OBJECT){
+        for(const auto& member : object){
+            if(member.first == key){
+                return member.second;
+            }
+        }
+    }
+
+    return null_value;
+}
+
+const CtJsonValue& CtJsonValue::operator[](size_t index) const{
+    static const CtJsonValue null_value;
+
+    if(type == CT_JSON_ARRAY && index < array.size()){
+        return array[index];
+    }
+
+    return null_value;
+}
+
+size_t CtJsonValue::Size() const{
+    return type == CT_JSON_ARRAY ? array.size() : (type == CT_JSON_OBJECT ? object.size() : 0);
+}
+
+CtJsonValue CtJson::Parse(const char* text, size_t length){
+    CtJsonValue value;
+    size_t position = 0;
+
+    ParseValue(text, length, position, value, 0);
+    SkipWhitespace(text, length, position);
+
+    if(position != length && text[position] != '\0'){
+        throw std::runtime_error("Unexpected text after the end of a JSON document.");
+    }
+
+    return value;
+}
+
+void CtJson::SkipWhitespace(const char* text, size_t length, size_t& position){
+    while(position < length && (text[position] == ' ' || text[position] == '\t' || text[position] == '\n' || text[position] == '\r')){
+        position++;
+    }
+}
+
+void CtJson::ParseValue(const char* text, size_t length, size_t& position, CtJsonValue& value, uint32_t depth){
+    if(depth > CT_JSON_MAX_DEPTH){
+        throw std::runtime_error("A JSON document is nested too deep.");
+    }
+
+    SkipWhitespace(text, length, position);
+    if(position >= length){
+        throw std::runtime_error("A JSON document ends in the middle of a value.");
+    }
+
+    char c = text[position];
+    if(c == '{'){
+        value.type = CT_JSON_OBJECT;
+        position++;
+
+        SkipWhitespace(text, length, position);
+        if(position < length && text[position] == '}'){
+            position++;
+            return;
+        }
+
+        while(true){
+            SkipWhitespace(text, length, position);
+            std::pair<std::string, CtJsonValue> member;
+            ParseString(text, length, position, member.first);
+
+            SkipWhitespace(text, length, position);
+            if(position >= length || text[position] != ':'){
+                throw std::runtime_error("Expected a ':' in a JSON object.");
+            }
+            position++;
+
+            ParseValue(text, length, position, member.second, depth + 1);
+            value.object.push_back(std::move(member));
+
+            SkipWhitespace(text, length, position);
+            if(position < length && text[position] == ','){
+                position++;
+                continue;
+            }
+            if(position < length && text[position] == '}'){
+                position++;
+                return;
+            }
+            throw std::runtime_error("Expected a ',' or '}' in a JSON object.");
+        }
+    }
+
+    if(c == '['){
+        value.type = CT_JSON_ARRAY;
+        position++;
+
+        SkipWhitespace(text, length, position);
+        if(position < length && text[position] == ']'){
+            position++;
+            return;
+        }
+
+        while(true){
+            value.array.emplace_back();
+            ParseValue(text, length, position, value.array.back(), depth + 1);
+
+            SkipWhitespace(text, length, position);
+            if(position < length && text[position] == ','){
+                position++;
+                continue;
+            }
+            if(position < length && text[position] == ']'){
+                position++;
+                return;
+            }
+            throw std::runtime_error("Expected a ',' or ']' in a JSON array.");
+        }
+    }
+
+    if(c == '"'){
+        value.type = CT_JSON_STRING;
+        ParseString(text, length, position, value.string);
+        return;
+    }
+
+    if(length - position >= 4 && strncmp(text + position, "true", 4) == 0){
+        value.type = CT_JSON_BOOL;
+        value.boolean = true;
+        position += 4;
+        return;
+    }
+    if(length - position >= 5 && strncmp(text + position, "false", 5) == 0){
+        value.type = CT_JSON_BOOL;
+        value.boolean = false;
+        position += 5;
+        return;
+    }
+    if(length - position >= 4 && strncmp(text + position, "null", 4) == 0){
+        value.type = CT_JSON_NULL;
+        position += 4;
+        return;
+    }
+
+    //strtod wants a terminated string and the document might not be, so copy the number out first
+    size_t end = position;
+    while(end < length && (strchr("+-0123456789.eE", text[end]) != nullptr)){
+        end++;
+    }
+    if(end == position){
+        throw std::runtime_error("Unexpected character in a JSON document.");
+    }
+
+    std::string number(text + position, end - position);
+    char* parsed_end = nullptr;
+    value.type = CT_JSON_NUMBER;
+    value.number = strtod(number.c_str(), &parsed_end);
+    if(parsed_end != number.c_str() + number.size()){
+        throw std::runtime_error("A JSON number is malformed.");
+    }
+    position = end;
+}
+
+//Escapes come out as UTF-8, surrogate pairs included
+void CtJson::ParseString(const char* text, size_t length, size_t& position, std::string& string){
+    if(position >= length || text[position] != '"'){
+        throw std::runtime_error("Expected a string in a JSON document.");
+    }
+    position++;
+
+    auto read_hex = [&](){
+        if(length - position < 4){
+            throw std::runtime_error("A JSON string ends in the middle of an escape.");
+        }
+        uint32_t code = static_cast<uint32_t>(strtoul(std::string(text + position, 4).c_str(), nullptr, 16));
+        position += 4;
+        return code;
+    };
+
+    while(position < length && text[position] != '"'){
+        char c = text[position++];
+        if(c != '\\'){
+            string.push_back(c);
+            continue;
+        }
+
+        if(position >= length){
+            break;
+        }
+
+        char escape = text[position++];
+        switch(escape){
+            case '"': string.push_back('"'); break;
+            case '\\': string.push_back('\\'); break;
+            case '/': string.push_back('/'); break;
+            case 'b': string.push_back('\b'); break;
+            case 'f': string.push_back('\f'); break;
+            case 'n': string.push_back('\n'); break;
+            case 'r': string.push_back('\r'); break;
+            case 't': string.push_back('\t'); break;
+            case 'u': {
+                uint32_t code = read_hex();
+                if(code >= 0xD800 && code < 0xDC00 && length - position >= 6 && text[position] == '\\' && text[position + 1] == 'u'){
+                    position += 2;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (read_hex() - 0xDC00);
+                }
+
+                if(code < 0x80){
+                    string.push_back(static_cast<char>(code));
+                }
+                else if(code < 0x800){
+                    string.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                    string.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                }
+                else if(code < 0x10000){
+                    string.push_back(static_cast<char>(0xE0 | (code >> 12)));
+                    string.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                    string.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                }
+                else{
+                    string.push_back(static_cast<char>(0xF0 | (code >> 18)));
+                    string.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+                    string.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                    string.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                }
+                break;
+            }
+            default:
+                throw std::runtime_error("Unknown escape in a JSON string.");
+        }
+    }
+
+    if(position >= length){
+        throw std::runtime_error("A JSON string never ends.");
+    }
+    position++;
+}
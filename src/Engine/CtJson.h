@@ -0,0 +1,60 @@
+#include <vector>
+#include <string>
+#include <utility>
+#include <cstdint>
+
+enum CtJsonType{
+    CT_JSON_NULL,
+    CT_JSON_BOOL,
+    CT_JSON_NUMBER,
+    CT_JSON_STRING,
+    CT_JSON_ARRAY,
+    CT_JSON_OBJECT
+};
+
+//One parsed JSON value. Looking up something that isn't there gives back a null value instead of throwing, so optional
+//fields can be read with a fallback in one go
+struct CtJsonValue{
+    CtJsonType type = CT_JSON_NULL;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<CtJsonValue> array;
+    std::vector<std::pair<std::string, CtJsonValue>> object; //In file order
+
+    bool IsNull() const{
+        return type == CT_JSON_NULL;
+    }
+
+    const CtJsonValue& operator[](const std::string& key) const;
+    const CtJsonValue& operator[](size_t index) const;
+
+    //Elements of an array or members of an object
+    size_t Size() const;
+
+    double GetNumber(double fallback) const{
+        return type == CT_JSON_NUMBER ? number : fallback;
+    }
+    uint32_t GetUint(uint32_t fallback) const{
+        return type == CT_JSON_NUMBER && number >= 0.0 ? static_cast<uint32_t>(number) : fallback;
+    }
+    bool GetBool(bool fallback) const{
+        return type == CT_JSON_BOOL ? boolean : fallback;
+    }
+    const std::string& GetString() const{
+        return string;
+    }
+};
+
+//Just enough of a JSON reader for asset formats. The whole document is parsed up front, so it's meant for descriptions of
+//data (glTF's JSON part) and not for the data itself
+class CtJson{
+
+    public:
+        static CtJsonValue Parse(const char* text, size_t length);
+
+    private:
+        static void ParseValue(const char* text, size_t length, size_t& position, CtJsonValue& value, uint32_t depth);
+        static void ParseString(const char* text, size_t length, size_t& position, std::string& string);
+        static void SkipWhitespace(const char* text, size_t length, size_t& position);
+};
@@ -0,0 +1,108 @@
+#include "CtKtx2.h"
+#include "CtTextureStore.h"
+#include "CtImageDecode.h"
+#include <stdexcept>
+#include <cstring>
+
+//The fixed part up to the level index: identifier, nine 32 bit fields, the four 32 bit and two 64 bit offsets and lengths of the index
+const size_t CT_KTX2_HEADER_SIZE = 80;
+
+//Each level has a 64 bit byte offset, byte length and uncompressed byte length
+const size_t CT_KTX2_LEVEL_INDEX_SIZE = 24;
+
+bool CtKtx2::IsKtx2(const uint8_t* data, size_t size){
+    const uint8_t identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+    return size >= 12 && memcmp(data, identifier, 12) == 0;
+}
+
+CtTextureData CtKtx2::Decode(const uint8_t* data, size_t size, const std::string& name){
+    if(!IsKtx2(data, size) || size < CT_KTX2_HEADER_SIZE){
+        throw std::runtime_error(name + " isn't a KTX2 file.");
+    }
+
+    auto read_u32 = [&](size_t offset){
+        uint32_t value;
+        memcpy(&value, data + offset, sizeof(value));
+        return value;
+    };
+    auto read_u64 = [&](size_t offset){
+        uint64_t value;
+        memcpy(&value, data + offset, sizeof(value));
+        return value;
+    };
+
+    VkFormat format = static_cast<VkFormat>(read_u32(12));
+    uint32_t width = read_u32(20);
+    uint32_t height = read_u32(24);
+    uint32_t depth = read_u32(28);
+    uint32_t layer_count = read_u32(32);
+    uint32_t face_count = read_u32(36);
+    uint32_t level_count = read_u32(40);
+    uint32_t supercompression = read_u32(44);
+
+    //Basis Universal files are UASTC with no VkFormat, or ETC1S behind BasisLZ. Either one needs transcoding into a real format first
+    if(format == VK_FORMAT_UNDEFINED || supercompression == CT_KTX2_SUPERCOMPRESSION_BASIS_LZ){
+        throw std::runtime_error(name + " is Basis Universal, which has to be transcoded. Re-encode it to a BC, ETC2 or ASTC format instead.");
+    }
+    if(supercompression != CT_KTX2_SUPERCOMPRESSION_NONE && supercompression != CT_KTX2_SUPERCOMPRESSION_ZLIB){
+        throw std::runtime_error(name + " is supercompressed with something other than zlib, which can't be read. Re-save it with zlib or none.");
+    }
+    if(width == 0 || height == 0 || depth > 1 || layer_count > 1 || face_count != 1){
+        throw std::runtime_error(name + " isn't a single 2D image. Arrays, cube maps and 3D textures aren't supported.");
+    }
+
+    //Before any level sizes come from it, so a bad header can't ask Inflate for more than a real texture could be
+    if(width > CT_IMAGE_DECODE_MAX_DIMENSION || height > CT_IMAGE_DECODE_MAX_DIMENSION){
+        throw std::runtime_error(name + " is bigger than any texture can be. Scale it down.");
+    }
+
+    CtFormatBlock block {};
+    if(!CtTextureStore::GetFormatBlock(format, block)){
+        throw std::runtime_error(name + " is in a format the texture store doesn't know.");
+    }
+
+    //0 levels means there's only the base level and the mips are for us to make
+    uint32_t full_count = CtTextureStore::GetMipCount(width, height);
+    uint32_t stored_count = level_count == 0 ? 1 : level_count;
+    if(stored_count > full_count){
+        throw std::runtime_error(name + " has more mip levels than its size allows.");
+    }
+    if(size < CT_KTX2_HEADER_SIZE + stored_count * CT_KTX2_LEVEL_INDEX_SIZE){
+        throw std::runtime_error(name + " ends in the middle of its level index.");
+    }
+
+    CtTextureData texture_data {};
+    texture_data.format = format;
+    texture_data.width = width;
+    texture_data.height = height;
+    texture_data.mip_levels = level_count == 0 ? full_count : level_count;
+    texture_data.levels.resize(stored_count);
+
+    for(uint32_t level = 0; level < stored_count; level++){
+        size_t entry = CT_KTX2_HEADER_SIZE + level * CT_KTX2_LEVEL_INDEX_SIZE;
+        uint64_t byte_offset = read_u64(entry);
+        uint64_t byte_length = read_u64(entry + 8);
+        uint64_t uncompressed_length = read_u64(entry + 16);
+        if(byte_offset > size || byte_length > size - byte_offset){
+            throw std::runtime_error(name + " has a mip level past the end of the file.");
+        }
+
+        VkDeviceSize expected_size = CtTextureStore::GetLevelSize(block, width, height, level);
+        const uint8_t* level_data = data + byte_offset;
+        if(supercompression == CT_KTX2_SUPERCOMPRESSION_ZLIB){
+            if(uncompressed_length != expected_size){
+                throw std::runtime_error(name + " has a mip level that isn't the size its format says.");
+            }
+            texture_data.levels[level] = CtImageDecode::Inflate(level_data, static_cast<size_t>(byte_length), static_cast<size_t>(expected_size));
+        }
+        else{
+            texture_data.levels[level].assign(level_data, level_data + byte_length);
+        }
+
+        if(texture_data.levels[level].size() != expected_size){
+            throw std::runtime_error(name + " has a mip level that isn't the size its format says.");
+        }
+    }
+
+    return texture_data;
+}
@@ -0,0 +1,28 @@
+#include <vector>
+#include <string>
+#include <cstdint>
+
+struct CtTextureData;
+
+//The KTX2 supercompression schemes. Only none and zlib can be read, the others need zstd or the Basis Universal transcoder and
+//neither is built in
+enum CtKtx2Supercompression{
+    CT_KTX2_SUPERCOMPRESSION_NONE = 0,
+    CT_KTX2_SUPERCOMPRESSION_BASIS_LZ = 1,
+    CT_KTX2_SUPERCOMPRESSION_ZSTD = 2,
+    CT_KTX2_SUPERCOMPRESSION_ZLIB = 3
+};
+
+//Reads KTX2 textures into CtTextureData, every mip level the file has as is. The file says its own VkFormat, so block compressed ones
+//(BC, ETC2, ASTC) come out ready to copy straight into an image, or for CtBlockDecode when the device doesn't have the format.
+//Only single 2D images, no arrays, cube maps or 3D textures.
+//Plain CPU work, it can run on any thread
+class CtKtx2{
+
+    public:
+        //Checks the first 12 bytes
+        static bool IsKtx2(const uint8_t* data, size_t size);
+
+        //name only goes into errors
+        static CtTextureData Decode(const uint8_t* data, size_t size, const std::string& name);
+};
@@ -0,0 +1,89 @@
+#include "CtMappedFile.h"
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+CtMappedFile* CtMappedFile::Open(const std::string& path, bool sequential){
+    CtMappedFile* ct_mapped_file = new CtMappedFile();
+
+    ct_mapped_file->path = path;
+    ct_mapped_file->file_handle = nullptr;
+    ct_mapped_file->mapping_handle = nullptr;
+    ct_mapped_file->file_descriptor = -1;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if(file == INVALID_HANDLE_VALUE){
+        delete ct_mapped_file;
+        throw std::runtime_error("Failed to open " + path + ".");
+    }
+
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(file, &file_size);
+    uint64_t size = static_cast<uint64_t>(file_size.QuadPart);
+
+    HANDLE mapping = size > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if(view == nullptr){
+        if(mapping != nullptr){
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        delete ct_mapped_file;
+        throw std::runtime_error("Failed to map " + path + ".");
+    }
+
+    ct_mapped_file->file_handle = file;
+    ct_mapped_file->mapping_handle = mapping;
+#else
+    int file_descriptor = open(path.c_str(), O_RDONLY);
+    if(file_descriptor < 0){
+        delete ct_mapped_file;
+        throw std::runtime_error("Failed to open " + path + ".");
+    }
+
+    struct stat file_stat;
+    fstat(file_descriptor, &file_stat);
+    uint64_t size = static_cast<uint64_t>(file_stat.st_size);
+
+    void* view = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file_descriptor, 0) : MAP_FAILED;
+    if(view == MAP_FAILED){
+        close(file_descriptor);
+        delete ct_mapped_file;
+        throw std::runtime_error("Failed to map " + path + ".");
+    }
+
+    madvise(view, size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+
+    ct_mapped_file->file_descriptor = file_descriptor;
+#endif
+
+    ct_mapped_file->data = static_cast<const uint8_t*>(view);
+    ct_mapped_file->size = size;
+
+    return ct_mapped_file;
+}
+
+void CtMappedFile::Close(){
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(static_cast<HANDLE>(mapping_handle));
+    CloseHandle(static_cast<HANDLE>(file_handle));
+#else
+    munmap(const_cast<uint8_t*>(data), size);
+    close(file_descriptor);
+#endif
+
+    data = nullptr;
+    size = 0;
+}
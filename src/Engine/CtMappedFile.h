@@ -0,0 +1,35 @@
+#include <string>
+#include <cstdint>
+
+//A whole file mapped read only. Nothing is read up front, pages come in from disk the first time they're touched and the OS can drop
+//them again whenever it wants, so even files bigger than RAM can be read straight out of the mapping
+class CtMappedFile{
+
+    public:
+        //sequential says the file gets read front to back once, so the OS can read ahead. Leave it off for files that get jumped around in
+        static CtMappedFile* Open(const std::string& path, bool sequential);
+
+        const uint8_t* GetData(){
+            return data;
+        }
+        uint64_t GetSize(){
+            return size;
+        }
+        const std::string& GetPath(){
+            return path;
+        }
+
+        //Unmaps the file. Nothing read out of GetData can be used after this
+        void Close();
+
+    private:
+
+        std::string path;
+        const uint8_t* data;
+        uint64_t size;
+
+        //Whatever the platform needs to keep the mapping open
+        void* file_handle;
+        void* mapping_handle;
+        int file_descriptor;
+};
@@ -0,0 +1,188 @@
+#include "CtMeshFile.h"
+#include "CtMappedFile.h"
+#include "CtMeshImport.h"
+#include "CtMeshStore.h"
+#include "CtVertex.h"
+#include <stdexcept>
+#include <fstream>
+#include <cstring>
+
+CtMeshFile* CtMeshFile::Open(const std::string& path){
+    CtMeshFile* ct_mesh_file = new CtMeshFile();
+
+    ct_mesh_file->path = path;
+
+    //It gets read front to back exactly once
+    try{
+        ct_mesh_file->mapping = CtMappedFile::Open(path, true);
+    } catch(...){
+        delete ct_mesh_file;
+        throw;
+    }
+    ct_mesh_file->data = ct_mesh_file->mapping->GetData();
+    ct_mesh_file->size = ct_mesh_file->mapping->GetSize();
+    ct_mesh_file->header = reinterpret_cast<const CtMeshFileHeader*>(ct_mesh_file->data);
+
+    try{
+        ct_mesh_file->Validate();
+    } catch(...){
+        ct_mesh_file->Close();
+        delete ct_mesh_file;
+        throw;
+    }
+
+    return ct_mesh_file;
+}
+
+/***************************************************************CHECKING***************************************************************/
+
+//A file that's been cut short or written by something else should fail here and not halfway through an upload
+void CtMeshFile::Validate(){
+    if(size < sizeof(CtMeshFileHeader) || header->magic != CT_MESH_FILE_MAGIC){
+        throw std::runtime_error(path + " isn't a .ctmesh file.");
+    }
+    if(header->version != CT_MESH_FILE_VERSION){
+        throw std::runtime_error(path + " is from another version of the .ctmesh format. Convert it again.");
+    }
+    if(header->file_size != size){
+        throw std::runtime_error(path + " is the wrong size, it was probably cut short.");
+    }
+
+    uint64_t index_size = header->index_type == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    if((header->index_type != VK_INDEX_TYPE_UINT16 && header->index_type != VK_INDEX_TYPE_UINT32) || header->lod_count == 0){
+        throw std::runtime_error(path + " has a broken header.");
+    }
+
+    struct CtMeshFileBlob{
+        uint64_t offset;
+        uint64_t size;
+    };
+    CtMeshFileBlob blobs[] = {
+        {header->attribute_offset, static_cast<uint64_t>(header->attribute_count) * sizeof(CtMeshFileAttribute)},
+        {header->lod_offset, static_cast<uint64_t>(header->lod_count) * sizeof(CtMeshFileLod)},
+        {header->vertex_offset, header->vertex_size},
+        {header->index_offset, header->index_size}
+    };
+    for(const auto& blob : blobs){
+        if(blob.offset % CT_MESH_FILE_ALIGNMENT != 0 || blob.offset > size || blob.size > size - blob.offset){
+            throw std::runtime_error(path + " points outside of itself.");
+        }
+    }
+
+    if(header->vertex_size != static_cast<uint64_t>(header->vertex_count) * header->vertex_stride || header->index_size % index_size != 0){
+        throw std::runtime_error(path + " has blobs that don't match its header.");
+    }
+
+    uint64_t index_count = header->index_size / index_size;
+    const CtMeshFileLod* lods = GetLods();
+    for(uint32_t l = 0; l < header->lod_count; l++){
+        if(static_cast<uint64_t>(lods[l].first_index) + lods[l].index_count > index_count){
+            throw std::runtime_error(path + " has a level of detail past the end of its indices.");
+        }
+    }
+}
+
+void CtMeshFile::Close(){
+    mapping->Close();
+    delete mapping;
+    mapping = nullptr;
+
+    data = nullptr;
+    header = nullptr;
+}
+
+/**************************************************************WRITING*****************************************************************/
+
+//Header, attributes, LODs, vertices, indices, each padded out to the alignment. Indices get narrowed the same way the mesh store
+//would do it, so loading never has to
+void CtMeshFile::WritePacked(const std::string& path, const std::vector<CtVertex>& vertices, const std::vector<CtMeshLod>& lods,
+    const std::vector<uint8_t>& packed_vertices, uint32_t stride, const std::vector<CtMeshFileAttribute>& attributes){
+
+    if(lods.empty()){
+        throw std::runtime_error("A mesh needs at least its full detail level.");
+    }
+
+    bool uint16_indices = vertices.size() <= CT_MESH_STORE_MAX_UINT16_VERTICES;
+    uint32_t index_size = uint16_indices ? sizeof(uint16_t) : sizeof(uint32_t);
+
+    std::vector<CtMeshFileLod> file_lods;
+    std::vector<uint8_t> index_blob;
+    uint32_t index_count = 0;
+    for(const auto& lod : lods){
+        file_lods.push_back({index_count, static_cast<uint32_t>(lod.indices.size()), lod.error, 0});
+
+        index_blob.resize(index_blob.size() + lod.indices.size() * index_size);
+        uint8_t* out = index_blob.data() + static_cast<size_t>(index_count) * index_size;
+        for(uint32_t index : lod.indices){
+            if(index >= vertices.size()){
+                throw std::runtime_error("A mesh index points past the mesh's vertices.");
+            }
+
+            if(uint16_indices){
+                uint16_t narrow_index = static_cast<uint16_t>(index);
+                memcpy(out, &narrow_index, sizeof(uint16_t));
+            }
+            else{
+                memcpy(out, &index, sizeof(uint32_t));
+            }
+            out += index_size;
+        }
+
+        index_count += static_cast<uint32_t>(lod.indices.size());
+    }
+
+    //Same bounds the mesh store would work out, so loading doesn't need the full precision vertices
+    glm::vec3 minimum(0.0f);
+    glm::vec3 maximum(0.0f);
+    for(size_t v = 0; v < vertices.size(); v++){
+        glm::vec3 position(vertices[v].position, 0.0f);
+        minimum = v == 0 ? position : glm::min(minimum, position);
+        maximum = v == 0 ? position : glm::max(maximum, position);
+    }
+    glm::vec3 center = (minimum + maximum) * 0.5f;
+    float radius = 0.0f;
+    for(const auto& vertex : vertices){
+        radius = glm::max(radius, glm::length(glm::vec3(vertex.position, 0.0f) - center));
+    }
+
+    auto align = [](uint64_t offset){
+        return (offset + CT_MESH_FILE_ALIGNMENT - 1) / CT_MESH_FILE_ALIGNMENT * CT_MESH_FILE_ALIGNMENT;
+    };
+
+    CtMeshFileHeader header {};
+    header.magic = CT_MESH_FILE_MAGIC;
+    header.version = CT_MESH_FILE_VERSION;
+    header.vertex_count = static_cast<uint32_t>(vertices.size());
+    header.vertex_stride = stride;
+    header.attribute_count = static_cast<uint32_t>(attributes.size());
+    header.index_type = uint16_indices ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    header.lod_count = static_cast<uint32_t>(file_lods.size());
+    header.bounds[0] = center.x;
+    header.bounds[1] = center.y;
+    header.bounds[2] = center.z;
+    header.bounds[3] = radius;
+    header.attribute_offset = align(sizeof(CtMeshFileHeader));
+    header.lod_offset = align(header.attribute_offset + attributes.size() * sizeof(CtMeshFileAttribute));
+    header.vertex_offset = align(header.lod_offset + file_lods.size() * sizeof(CtMeshFileLod));
+    header.vertex_size = packed_vertices.size();
+    header.index_offset = align(header.vertex_offset + header.vertex_size);
+    header.index_size = index_blob.size();
+    header.file_size = header.index_offset + header.index_size;
+
+    std::vector<uint8_t> file_data(header.file_size, 0);
+    memcpy(file_data.data(), &header, sizeof(header));
+    memcpy(file_data.data() + header.attribute_offset, attributes.data(), attributes.size() * sizeof(CtMeshFileAttribute));
+    memcpy(file_data.data() + header.lod_offset, file_lods.data(), file_lods.size() * sizeof(CtMeshFileLod));
+    memcpy(file_data.data() + header.vertex_offset, packed_vertices.data(), packed_vertices.size());
+    memcpy(file_data.data() + header.index_offset, index_blob.data(), index_blob.size());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if(!file.is_open()){
+        throw std::runtime_error("Failed to open " + path + " for writing.");
+    }
+
+    file.write(reinterpret_cast<const char*>(file_data.data()), static_cast<std::streamsize>(file_data.size()));
+    if(!file.good()){
+        throw std::runtime_error("Failed to write " + path + ".");
+    }
+}
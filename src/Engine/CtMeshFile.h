@@ -0,0 +1,136 @@
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+class CtMappedFile;
+struct CtVertex;
+struct CtMeshLod;
+
+//"CTMS" when read as a little endian uint32
+const uint32_t CT_MESH_FILE_MAGIC = 0x534D5443;
+
+//Goes up whenever anything below changes shape. Old files have to be converted again
+const uint32_t CT_MESH_FILE_VERSION = 1;
+
+//Every table and blob starts on a multiple of this, so whatever is in them can be read straight out of the mapping
+const uint32_t CT_MESH_FILE_ALIGNMENT = 64;
+
+//A .ctmesh file is this header followed by the tables and blobs it points at. Everything is fixed size and little endian, and every
+//offset is from the start of the file
+struct CtMeshFileHeader{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t file_size;
+
+    uint32_t vertex_count;
+    uint32_t vertex_stride;
+    uint32_t attribute_count;
+    uint32_t index_type; //A VkIndexType, decided the same way CtMeshStore decides it
+    uint32_t lod_count;
+    uint32_t padding;
+
+    //Sphere around every vertex, center in xyz and radius in w
+    float bounds[4];
+
+    uint64_t attribute_offset;
+    uint64_t lod_offset;
+    uint64_t vertex_offset;
+    uint64_t vertex_size;
+    uint64_t index_offset;
+    uint64_t index_size;
+};
+
+//The vertex layout descriptor, one per attribute. Loading checks it against the layout the mesh is meant for instead of converting
+struct CtMeshFileAttribute{
+    uint32_t location;
+    uint32_t format; //A VkFormat
+    uint32_t offset;
+    uint32_t padding;
+};
+
+//One level of detail. Every level's indices sit back to back in the one index blob
+struct CtMeshFileLod{
+    uint32_t first_index; //In indices from the start of the blob
+    uint32_t index_count;
+    float error;
+    uint32_t padding;
+};
+
+static_assert(sizeof(CtMeshFileHeader) == 104, "The .ctmesh header can't change size without a new version.");
+static_assert(sizeof(CtMeshFileAttribute) == 16 && sizeof(CtMeshFileLod) == 16, "The .ctmesh tables can't change size without a new version.");
+
+//A .ctmesh file mapped into memory. Opening checks the header and that everything it points at is inside the file, and that's all
+//the work there is. The vertices are already in their GPU layout and the indices already in their GPU type, so the blobs go from the
+//mapping into a staging buffer with one copy each
+class CtMeshFile{
+
+    public:
+        static CtMeshFile* Open(const std::string& path);
+
+        //Converts a mesh and its LOD chain into a file meant for Layout. Level 0 should be the mesh's own indices
+        template<typename Layout>
+        static void Write(const std::string& path, const std::vector<CtVertex>& vertices, const std::vector<CtMeshLod>& lods){
+            std::vector<uint8_t> packed_vertices;
+            Layout::Encode(vertices, packed_vertices);
+
+            auto descriptions = Layout::GetAttributeDescriptions();
+            std::vector<CtMeshFileAttribute> attributes;
+            for(const auto& description : descriptions){
+                attributes.push_back({description.location, static_cast<uint32_t>(description.format), description.offset, 0});
+            }
+
+            WritePacked(path, vertices, lods, packed_vertices, Layout::stride, attributes);
+        }
+
+        //Whether the vertices were written for Layout, which is the only layout anything can read them as
+        template<typename Layout>
+        bool HasLayout(){
+            auto descriptions = Layout::GetAttributeDescriptions();
+            if(header->vertex_stride != Layout::stride || header->attribute_count != descriptions.size()){
+                return false;
+            }
+
+            const CtMeshFileAttribute* attributes = GetAttributes();
+            for(uint32_t a = 0; a < header->attribute_count; a++){
+                if(attributes[a].location != descriptions[a].location || attributes[a].format != static_cast<uint32_t>(descriptions[a].format) ||
+                    attributes[a].offset != descriptions[a].offset){
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        const CtMeshFileHeader& GetHeader(){
+            return *header;
+        }
+        const CtMeshFileAttribute* GetAttributes(){
+            return reinterpret_cast<const CtMeshFileAttribute*>(data + header->attribute_offset);
+        }
+        const CtMeshFileLod* GetLods(){
+            return reinterpret_cast<const CtMeshFileLod*>(data + header->lod_offset);
+        }
+        const uint8_t* GetVertices(){
+            return data + header->vertex_offset;
+        }
+        const uint8_t* GetIndices(){
+            return data + header->index_offset;
+        }
+
+        //Unmaps the file. Nothing gotten from it above can be used after this
+        void Close();
+
+    private:
+
+        std::string path;
+        CtMappedFile* mapping;
+        const uint8_t* data;
+        uint64_t size;
+        const CtMeshFileHeader* header;
+
+        void Validate();
+
+        static void WritePacked(const std::string& path, const std::vector<CtVertex>& vertices, const std::vector<CtMeshLod>& lods,
+            const std::vector<uint8_t>& packed_vertices, uint32_t stride, const std::vector<CtMeshFileAttribute>& attributes);
+};
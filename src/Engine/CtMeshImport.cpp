@@ -0,0 +1,780 @@
+#include "CtMeshImport.h"
+#include "CtVertex.h"
+#include <thread>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+CtMeshData CtMeshImport::Weld(const std::vector<CtVertex>& vertices, const std::vector<uint32_t>& indices){
+    std::vector<uint32_t> first_equal = FindDuplicates(vertices);
+
+    CtMeshData mesh;
+    mesh.indices.reserve(indices.empty() ? vertices.size() : indices.size());
+
+    //Handing out new indices in the order the triangles reach them keeps the vertex fetches close together for the GPU
+    std::vector<uint32_t> new_index(vertices.size(), UINT32_MAX);
+    size_t corner_count = indices.empty() ? vertices.size() : indices.size();
+
+    for(size_t corner = 0; corner < corner_count; corner++){
+        uint32_t old_index = indices.empty() ? static_cast<uint32_t>(corner) : indices[corner];
+        if(old_index >= vertices.size()){
+            throw std::runtime_error("A mesh index points past the mesh's vertices.");
+        }
+
+        uint32_t vertex = first_equal[old_index];
+        if(new_index[vertex] == UINT32_MAX){
+            new_index[vertex] = static_cast<uint32_t>(mesh.vertices.size());
+            mesh.vertices.push_back(vertices[vertex]);
+        }
+
+        mesh.indices.push_back(new_index[vertex]);
+    }
+
+    return mesh;
+}
+
+//Every vertex goes to a shard by the top of its hash, and each thread welds one shard in its own open addressed table. Equal vertices
+//always hash the same, so they always end up in the same shard, and walking the vertices in order makes the first one of them win.
+//That makes the answer the same no matter how many threads there are
+std::vector<uint32_t> CtMeshImport::FindDuplicates(const std::vector<CtVertex>& vertices){
+    uint32_t vertex_count = static_cast<uint32_t>(vertices.size());
+
+    uint32_t thread_count = 1;
+    if(vertex_count >= CT_MESH_IMPORT_MIN_PARALLEL_VERTICES){
+        uint32_t hardware_threads = std::thread::hardware_concurrency();
+        thread_count = hardware_threads == 0 ? 1 : (hardware_threads < CT_MESH_IMPORT_MAX_THREADS ? hardware_threads : CT_MESH_IMPORT_MAX_THREADS);
+    }
+
+    std::vector<uint64_t> hashes(vertex_count);
+    std::vector<uint32_t> first_equal(vertex_count);
+
+    RunParallel(thread_count, [&](uint32_t thread){
+        uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(vertex_count) * thread / thread_count);
+        uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(vertex_count) * (thread + 1) / thread_count);
+
+        for(uint32_t v = begin; v < end; v++){
+            hashes[v] = CtHashVertex(vertices[v]);
+        }
+    });
+
+    RunParallel(thread_count, [&](uint32_t shard){
+        uint32_t shard_size = 0;
+        for(uint32_t v = 0; v < vertex_count; v++){
+            if((hashes[v] >> 32) % thread_count == shard){
+                shard_size++;
+            }
+        }
+
+        //At least twice as many slots as there could be different vertices, so probing always finds an empty one quickly
+        uint32_t capacity = 16;
+        while(capacity < shard_size * 2){
+            capacity *= 2;
+        }
+        std::vector<uint32_t> table(capacity, UINT32_MAX);
+
+        for(uint32_t v = 0; v < vertex_count; v++){
+            if((hashes[v] >> 32) % thread_count != shard){
+                continue;
+            }
+
+            uint32_t slot = static_cast<uint32_t>(hashes[v]) & (capacity - 1);
+            while(true){
+                uint32_t existing = table[slot];
+                if(existing == UINT32_MAX){
+                    table[slot] = v;
+                    first_equal[v] = v;
+                    break;
+                }
+                if(hashes[existing] == hashes[v] && vertices[existing] == vertices[v]){
+                    first_equal[v] = existing;
+                    break;
+                }
+                slot = (slot + 1) & (capacity - 1);
+            }
+        }
+    });
+
+    return first_equal;
+}
+
+void CtMeshImport::RunParallel(uint32_t thread_count, const std::function<void(uint32_t)>& work){
+    std::vector<std::thread> threads;
+    for(uint32_t thread = 1; thread < thread_count; thread++){
+        threads.emplace_back(work, thread);
+    }
+
+    work(0);
+
+    for(auto& thread : threads){
+        thread.join();
+    }
+}
+
+/**************************************************************OPTIMIZING*****************************************************************/
+
+//A vertex is still cached if fewer than cache_size misses happened since it went in
+CtVertexCacheStats CtMeshImport::AnalyzeVertexCache(const CtMeshData& mesh, uint32_t cache_size){
+    std::vector<uint32_t> inserted_at(mesh.vertices.size(), 0);
+
+    uint32_t misses = 0;
+    uint32_t used_vertices = 0;
+    for(uint32_t index : mesh.indices){
+        if(inserted_at[index] == 0){
+            used_vertices++;
+        }
+        if(inserted_at[index] == 0 || misses - inserted_at[index] >= cache_size){
+            misses++;
+            inserted_at[index] = misses;
+        }
+    }
+
+    CtVertexCacheStats stats {};
+    stats.transformed = misses;
+    stats.acmr = mesh.indices.empty() ? 0.0f : static_cast<float>(misses) / (mesh.indices.size() / 3);
+    stats.atvr = used_vertices == 0 ? 0.0f : static_cast<float>(misses) / used_vertices;
+
+    return stats;
+}
+
+//Tipsify, from Sander, Nehab and Barczak's "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw". Fan out around one vertex
+//at a time, then move to whichever vertex the fan touched that will still be in the cache once its own triangles are done.
+//When none will be, back up through the recently used ones, and only then jump ahead to the next vertex with anything left
+void CtMeshImport::OptimizeVertexCache(CtMeshData& mesh, uint32_t cache_size, std::vector<uint32_t>* clusters){
+    uint32_t vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+    uint32_t triangle_count = static_cast<uint32_t>(mesh.indices.size() / 3);
+
+    if(clusters != nullptr){
+        clusters->clear();
+    }
+    if(triangle_count == 0){
+        return;
+    }
+
+    //Which triangles every vertex is in, packed one vertex after another
+    std::vector<uint32_t> live(vertex_count, 0);
+    for(uint32_t index : mesh.indices){
+        live[index]++;
+    }
+
+    std::vector<uint32_t> adjacency_start(vertex_count + 1, 0);
+    for(uint32_t v = 0; v < vertex_count; v++){
+        adjacency_start[v + 1] = adjacency_start[v] + live[v];
+    }
+
+    std::vector<uint32_t> adjacency(mesh.indices.size());
+    std::vector<uint32_t> cursor(adjacency_start.begin(), adjacency_start.end() - 1);
+    for(uint32_t t = 0; t < triangle_count; t++){
+        for(uint32_t c = 0; c < 3; c++){
+            adjacency[cursor[mesh.indices[t * 3 + c]]++] = t;
+        }
+    }
+
+    std::vector<uint32_t> cache_time(vertex_count, 0);
+    std::vector<bool> emitted(triangle_count, false);
+    std::vector<uint32_t> dead_ends;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(mesh.indices.size());
+
+    uint32_t time = cache_size + 1;
+    uint32_t scan = 0;
+
+    //The first vertex anything uses
+    int64_t fan = -1;
+    while(scan < vertex_count && live[scan] == 0){
+        scan++;
+    }
+    if(scan < vertex_count){
+        fan = scan;
+    }
+
+    if(clusters != nullptr){
+        clusters->push_back(0);
+    }
+
+    while(fan >= 0){
+        candidates.clear();
+
+        for(uint32_t a = adjacency_start[fan]; a < adjacency_start[fan + 1]; a++){
+            uint32_t t = adjacency[a];
+            if(emitted[t]){
+                continue;
+            }
+
+            for(uint32_t c = 0; c < 3; c++){
+                uint32_t v = mesh.indices[t * 3 + c];
+
+                output.push_back(v);
+                dead_ends.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+
+                if(time - cache_time[v] > cache_size){
+                    cache_time[v] = time;
+                    time++;
+                }
+            }
+
+            emitted[t] = true;
+        }
+
+        //Best is the candidate that's been in the cache longest and can still finish its fan before falling out
+        int64_t next = -1;
+        int64_t best_priority = -1;
+        for(uint32_t v : candidates){
+            if(live[v] == 0){
+                continue;
+            }
+
+            int64_t priority = 0;
+            if(time - cache_time[v] + 2 * live[v] <= cache_size){
+                priority = time - cache_time[v];
+            }
+
+            if(priority > best_priority){
+                best_priority = priority;
+                next = v;
+            }
+        }
+
+        if(next == -1){
+            while(!dead_ends.empty()){
+                uint32_t v = dead_ends.back();
+                dead_ends.pop_back();
+                if(live[v] > 0){
+                    next = v;
+                    break;
+                }
+            }
+        }
+
+        //Nothing nearby is left, so this is a hard break in the order
+        if(next == -1){
+            while(scan < vertex_count && live[scan] == 0){
+                scan++;
+            }
+            if(scan < vertex_count){
+                next = scan;
+                if(clusters != nullptr && output.size() / 3 < triangle_count){
+                    clusters->push_back(static_cast<uint32_t>(output.size() / 3));
+                }
+            }
+        }
+
+        fan = next;
+    }
+
+    mesh.indices = output;
+}
+
+void CtMeshImport::OptimizeOverdraw(CtMeshData& mesh, const std::vector<uint32_t>& clusters){
+    uint32_t triangle_count = static_cast<uint32_t>(mesh.indices.size() / 3);
+    if(clusters.size() < 2){
+        return;
+    }
+
+    //The middle of the mesh, by triangle centers
+    glm::vec3 mesh_center(0.0f);
+    for(uint32_t t = 0; t < triangle_count; t++){
+        for(uint32_t c = 0; c < 3; c++){
+            mesh_center += glm::vec3(mesh.vertices[mesh.indices[t * 3 + c]].position, 0.0f);
+        }
+    }
+    mesh_center /= static_cast<float>(triangle_count * 3);
+
+    struct CtClusterSort{
+        uint32_t first_triangle;
+        uint32_t triangle_count;
+        float facing;
+    };
+
+    std::vector<CtClusterSort> sorted_clusters;
+    for(size_t k = 0; k < clusters.size(); k++){
+        uint32_t first = clusters[k];
+        uint32_t end = k + 1 < clusters.size() ? clusters[k + 1] : triangle_count;
+
+        glm::vec3 center(0.0f);
+        glm::vec3 normal(0.0f);
+        for(uint32_t t = first; t < end; t++){
+            for(uint32_t c = 0; c < 3; c++){
+                const CtVertex& vertex = mesh.vertices[mesh.indices[t * 3 + c]];
+                center += glm::vec3(vertex.position, 0.0f);
+                normal += vertex.normal;
+            }
+        }
+        center /= static_cast<float>((end - first) * 3);
+
+        //How far the cluster sits out from the middle along the way it faces. Those bits are the most likely to be in front
+        sorted_clusters.push_back({first, end - first, glm::dot(center - mesh_center, normal)});
+    }
+
+    std::stable_sort(sorted_clusters.begin(), sorted_clusters.end(), [](const CtClusterSort& a, const CtClusterSort& b){
+        return a.facing > b.facing;
+    });
+
+    std::vector<uint32_t> output;
+    output.reserve(mesh.indices.size());
+    for(const auto& cluster : sorted_clusters){
+        output.insert(output.end(), mesh.indices.begin() + cluster.first_triangle * 3,
+            mesh.indices.begin() + (cluster.first_triangle + cluster.triangle_count) * 3);
+    }
+
+    mesh.indices = output;
+}
+
+void CtMeshImport::OptimizeVertexFetch(CtMeshData& mesh){
+    std::vector<uint32_t> new_index(mesh.vertices.size(), UINT32_MAX);
+    std::vector<CtVertex> vertices;
+    vertices.reserve(mesh.vertices.size());
+
+    for(uint32_t& index : mesh.indices){
+        if(new_index[index] == UINT32_MAX){
+            new_index[index] = static_cast<uint32_t>(vertices.size());
+            vertices.push_back(mesh.vertices[index]);
+        }
+        index = new_index[index];
+    }
+
+    mesh.vertices = vertices;
+}
+
+void CtMeshImport::Optimize(CtMeshData& mesh, bool optimize_overdraw){
+    CtVertexCacheStats before = AnalyzeVertexCache(mesh, CT_MESH_IMPORT_CACHE_SIZE);
+
+    std::vector<uint32_t> clusters;
+    OptimizeVertexCache(mesh, CT_MESH_IMPORT_CACHE_SIZE, optimize_overdraw ? &clusters : nullptr);
+    if(optimize_overdraw){
+        OptimizeOverdraw(mesh, clusters);
+    }
+    OptimizeVertexFetch(mesh);
+
+    CtVertexCacheStats after = AnalyzeVertexCache(mesh, CT_MESH_IMPORT_CACHE_SIZE);
+
+    printf("Optimized mesh: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f.\n", before.acmr, after.acmr, before.atvr, after.atvr);
+}
+
+/**************************************************************MESHLETS*****************************************************************/
+
+std::vector<CtMeshlet> CtMeshImport::BuildMeshlets(const CtMeshData& mesh, uint32_t max_vertices, uint32_t max_triangles){
+    if(max_vertices < 3 || max_triangles == 0){
+        throw std::runtime_error("A meshlet has to be able to hold at least one triangle.");
+    }
+
+    uint32_t triangle_count = static_cast<uint32_t>(mesh.indices.size() / 3);
+    std::vector<CtMeshlet> meshlets;
+
+    //Which meshlet last used each vertex, so counting a meshlet's unique vertices never needs clearing
+    std::vector<uint32_t> last_meshlet(mesh.vertices.size(), UINT32_MAX);
+
+    //How many of a triangle's vertices the meshlet doesn't have yet
+    auto count_new_vertices = [&](uint32_t triangle, uint32_t meshlet_id){
+        uint32_t a = mesh.indices[triangle * 3];
+        uint32_t b = mesh.indices[triangle * 3 + 1];
+        uint32_t c = mesh.indices[triangle * 3 + 2];
+
+        uint32_t count = last_meshlet[a] != meshlet_id ? 1 : 0;
+        count += last_meshlet[b] != meshlet_id && b != a ? 1 : 0;
+        count += last_meshlet[c] != meshlet_id && c != a && c != b ? 1 : 0;
+        return count;
+    };
+
+    CtMeshlet meshlet {};
+    for(uint32_t t = 0; t < triangle_count; t++){
+        uint32_t meshlet_id = static_cast<uint32_t>(meshlets.size());
+        uint32_t new_vertices = count_new_vertices(t, meshlet_id);
+
+        if(meshlet.index_count > 0 && (meshlet.vertex_count + new_vertices > max_vertices || meshlet.index_count / 3 == max_triangles)){
+            ComputeMeshletBounds(mesh, meshlet);
+            meshlets.push_back(meshlet);
+
+            meshlet = {};
+            meshlet.first_index = t * 3;
+            meshlet_id++;
+            new_vertices = count_new_vertices(t, meshlet_id);
+        }
+
+        for(uint32_t c = 0; c < 3; c++){
+            last_meshlet[mesh.indices[t * 3 + c]] = meshlet_id;
+        }
+        meshlet.vertex_count += new_vertices;
+        meshlet.index_count += 3;
+    }
+
+    if(meshlet.index_count > 0){
+        ComputeMeshletBounds(mesh, meshlet);
+        meshlets.push_back(meshlet);
+    }
+
+    return meshlets;
+}
+
+//The cone is the one the triangle normals fit in, the same way meshoptimizer builds it. Its axis is the average normal, and how far
+//the widest normal strays from it decides whether there's a cone at all
+void CtMeshImport::ComputeMeshletBounds(const CtMeshData& mesh, CtMeshlet& meshlet){
+    uint32_t first = meshlet.first_index;
+    uint32_t end = meshlet.first_index + meshlet.index_count;
+
+    glm::vec3 minimum = glm::vec3(mesh.vertices[mesh.indices[first]].position, 0.0f);
+    glm::vec3 maximum = minimum;
+    for(uint32_t i = first; i < end; i++){
+        glm::vec3 position(mesh.vertices[mesh.indices[i]].position, 0.0f);
+        minimum = glm::min(minimum, position);
+        maximum = glm::max(maximum, position);
+    }
+
+    glm::vec3 center = (minimum + maximum) * 0.5f;
+    float radius = 0.0f;
+    for(uint32_t i = first; i < end; i++){
+        radius = glm::max(radius, glm::length(glm::vec3(mesh.vertices[mesh.indices[i]].position, 0.0f) - center));
+    }
+    meshlet.bounds = glm::vec4(center, radius);
+
+    //Face normals from the winding, which is what the rasterizer culls by. Degenerate triangles don't face anywhere
+    std::vector<glm::vec3> normals;
+    glm::vec3 axis(0.0f);
+    for(uint32_t i = first; i < end; i += 3){
+        glm::vec3 a(mesh.vertices[mesh.indices[i]].position, 0.0f);
+        glm::vec3 b(mesh.vertices[mesh.indices[i + 1]].position, 0.0f);
+        glm::vec3 c(mesh.vertices[mesh.indices[i + 2]].position, 0.0f);
+
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        float area = glm::length(normal);
+        if(area > 0.0f){
+            normals.push_back(normal / area);
+            axis += normal / area;
+        }
+    }
+
+    meshlet.cone = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    float axis_length = glm::length(axis);
+    if(normals.empty() || axis_length == 0.0f){
+        return;
+    }
+    axis /= axis_length;
+
+    float min_dot = 1.0f;
+    for(const auto& normal : normals){
+        min_dot = glm::min(min_dot, glm::dot(normal, axis));
+    }
+
+    //Normals more than 90 degrees apart can't all be facing away at once
+    if(min_dot <= 0.0f){
+        return;
+    }
+
+    meshlet.cone = glm::vec4(axis, glm::sqrt(1.0f - min_dot * min_dot));
+}
+
+/**************************************************************SIMPLIFYING*****************************************************************/
+
+//The sum of squared distances to a set of weighted planes, Garland and Heckbert's quadric. Stored as the symmetric matrix terms
+struct CtQuadric{
+    double a00, a01, a02, a11, a12, a22;
+    double b0, b1, b2;
+    double c;
+    double weight;
+
+    void AddPlane(const glm::vec3& normal, float distance, float plane_weight){
+        double x = normal.x, y = normal.y, z = normal.z, d = distance;
+
+        a00 += plane_weight * x * x; a01 += plane_weight * x * y; a02 += plane_weight * x * z;
+        a11 += plane_weight * y * y; a12 += plane_weight * y * z; a22 += plane_weight * z * z;
+        b0 += plane_weight * x * d; b1 += plane_weight * y * d; b2 += plane_weight * z * d;
+        c += plane_weight * d * d;
+        weight += plane_weight;
+    }
+
+    void Add(const CtQuadric& other){
+        a00 += other.a00; a01 += other.a01; a02 += other.a02;
+        a11 += other.a11; a12 += other.a12; a22 += other.a22;
+        b0 += other.b0; b1 += other.b1; b2 += other.b2;
+        c += other.c;
+        weight += other.weight;
+    }
+
+    //Squared distance, averaged over the planes' weights
+    double Error(const glm::vec3& position) const{
+        if(weight <= 0.0){
+            return 0.0;
+        }
+
+        double x = position.x, y = position.y, z = position.z;
+        double error = a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + a11 * y * y + 2.0 * a12 * y * z + a22 * z * z +
+            2.0 * (b0 * x + b1 * y + b2 * z) + c;
+
+        return error < 0.0 ? 0.0 : error / weight;
+    }
+};
+
+//Works in passes. Each pass prices collapsing every edge into either of its ends, then takes the cheapest ones that don't share any
+//triangles with each other, so the prices stay right for the whole pass. Vertices that share a position with another one sit on a
+//seam (uvs, normals) and stay put so the seam can't tear. Border vertices only slide along the border, and a plane standing up
+//along every border edge keeps them from eating into the outline.
+//The quadrics come from the original triangles and a collapsed vertex hands its quadric on to the one it went into, so every price
+//is the distance from the original surface, not from whatever the last pass left
+std::vector<uint32_t> CtMeshImport::Simplify(const CtMeshData& mesh, uint32_t target_index_count, float target_error, float* error){
+    uint32_t vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+    std::vector<uint32_t> indices = mesh.indices;
+
+    std::vector<glm::vec3> positions(vertex_count);
+    for(uint32_t v = 0; v < vertex_count; v++){
+        positions[v] = glm::vec3(mesh.vertices[v].position, 0.0f);
+    }
+
+    //Seams. Sorting by position puts the vertices that share one next to each other
+    std::vector<bool> locked(vertex_count, false);
+    std::vector<uint32_t> by_position(vertex_count);
+    for(uint32_t v = 0; v < vertex_count; v++){
+        by_position[v] = v;
+    }
+    std::sort(by_position.begin(), by_position.end(), [&](uint32_t a, uint32_t b){
+        return positions[a].x != positions[b].x ? positions[a].x < positions[b].x :
+            positions[a].y != positions[b].y ? positions[a].y < positions[b].y : positions[a].z < positions[b].z;
+    });
+    for(uint32_t i = 1; i < vertex_count; i++){
+        if(positions[by_position[i]] == positions[by_position[i - 1]]){
+            locked[by_position[i]] = true;
+            locked[by_position[i - 1]] = true;
+        }
+    }
+
+    struct CtCollapse{
+        uint32_t from;
+        uint32_t to;
+        double error;
+    };
+
+    double max_error = static_cast<double>(target_error) * target_error;
+    double result_error = 0.0;
+
+    std::vector<CtQuadric> quadrics;
+
+    while(indices.size() > target_index_count){
+        uint32_t triangle_count = static_cast<uint32_t>(indices.size() / 3);
+
+        //Triangles around each vertex
+        std::vector<uint32_t> triangle_starts(vertex_count + 1, 0);
+        for(uint32_t index : indices){
+            triangle_starts[index + 1]++;
+        }
+        for(uint32_t v = 0; v < vertex_count; v++){
+            triangle_starts[v + 1] += triangle_starts[v];
+        }
+        std::vector<uint32_t> vertex_triangles(indices.size());
+        std::vector<uint32_t> cursor(triangle_starts.begin(), triangle_starts.end() - 1);
+        for(uint32_t i = 0; i < indices.size(); i++){
+            vertex_triangles[cursor[indices[i]]++] = i / 3;
+        }
+
+        //An edge is on the border when no triangle runs along it the other way
+        auto has_edge = [&](uint32_t a, uint32_t b){
+            for(uint32_t k = triangle_starts[a]; k < triangle_starts[a + 1]; k++){
+                uint32_t t = vertex_triangles[k];
+                for(uint32_t c = 0; c < 3; c++){
+                    if(indices[t * 3 + c] == a && indices[t * 3 + (c + 1) % 3] == b){
+                        return true;
+                    }
+                }
+            }
+            return false;
+        };
+
+        std::vector<bool> border(vertex_count, false);
+        for(uint32_t t = 0; t < triangle_count; t++){
+            for(uint32_t c = 0; c < 3; c++){
+                uint32_t from = indices[t * 3 + c];
+                uint32_t to = indices[t * 3 + (c + 1) % 3];
+                if(!has_edge(to, from)){
+                    border[from] = true;
+                    border[to] = true;
+                }
+            }
+        }
+
+        //First pass only, the triangles are still the original ones
+        if(quadrics.empty()){
+            quadrics.assign(vertex_count, CtQuadric {});
+
+            for(uint32_t t = 0; t < triangle_count; t++){
+                const glm::vec3& a = positions[indices[t * 3]];
+                glm::vec3 normal = glm::cross(positions[indices[t * 3 + 1]] - a, positions[indices[t * 3 + 2]] - a);
+                float length = glm::length(normal);
+                if(length == 0.0f){
+                    continue;
+                }
+                normal = normal / length;
+
+                for(uint32_t c = 0; c < 3; c++){
+                    quadrics[indices[t * 3 + c]].AddPlane(normal, -glm::dot(normal, a), length * 0.5f);
+                }
+
+                for(uint32_t c = 0; c < 3; c++){
+                    uint32_t from = indices[t * 3 + c];
+                    uint32_t to = indices[t * 3 + (c + 1) % 3];
+                    if(has_edge(to, from)){
+                        continue;
+                    }
+
+                    //Weighted heavily, moving the outline shows a lot more than moving a vertex across a surface does
+                    glm::vec3 edge = positions[to] - positions[from];
+                    glm::vec3 side = glm::cross(edge, normal);
+                    float side_length = glm::length(side);
+                    if(side_length > 0.0f){
+                        side = side / side_length;
+                        float edge_weight = glm::dot(edge, edge) * 10.0f;
+                        quadrics[from].AddPlane(side, -glm::dot(side, positions[from]), edge_weight);
+                        quadrics[to].AddPlane(side, -glm::dot(side, positions[from]), edge_weight);
+                    }
+                }
+            }
+        }
+
+        std::vector<CtCollapse> collapses;
+        for(uint32_t t = 0; t < triangle_count; t++){
+            for(uint32_t c = 0; c < 3; c++){
+                uint32_t a = indices[t * 3 + c];
+                uint32_t b = indices[t * 3 + (c + 1) % 3];
+
+                for(uint32_t direction = 0; direction < 2; direction++){
+                    uint32_t from = direction == 0 ? a : b;
+                    uint32_t to = direction == 0 ? b : a;
+
+                    if(locked[from] || (border[from] && has_edge(from, to) == has_edge(to, from))){
+                        continue;
+                    }
+
+                    CtQuadric merged = quadrics[from];
+                    merged.Add(quadrics[to]);
+
+                    double collapse_error = merged.Error(positions[to]);
+                    if(collapse_error <= max_error){
+                        collapses.push_back({from, to, collapse_error});
+                    }
+                }
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const CtCollapse& a, const CtCollapse& b){
+            return a.error < b.error;
+        });
+
+        //Most collapses take two triangles with them, so this lands close to the target without going far past it
+        uint32_t target_triangles = target_index_count / 3;
+        uint32_t collapse_limit = (triangle_count - target_triangles + 1) / 2;
+
+        std::vector<uint32_t> remap(vertex_count);
+        for(uint32_t v = 0; v < vertex_count; v++){
+            remap[v] = v;
+        }
+        std::vector<bool> touched(vertex_count, false);
+
+        uint32_t collapsed = 0;
+        for(const auto& collapse : collapses){
+            if(collapsed >= collapse_limit){
+                break;
+            }
+            if(touched[collapse.from] || touched[collapse.to]){
+                continue;
+            }
+
+            //Triangles that keep going after the collapse can't be turned over by it
+            bool flips = false;
+            for(uint32_t k = triangle_starts[collapse.from]; k < triangle_starts[collapse.from + 1] && !flips; k++){
+                uint32_t t = vertex_triangles[k];
+                glm::vec3 corners[3];
+                glm::vec3 moved[3];
+                bool has_to = false;
+                for(uint32_t c = 0; c < 3; c++){
+                    uint32_t index = indices[t * 3 + c];
+                    has_to = has_to || index == collapse.to;
+                    corners[c] = positions[index];
+                    moved[c] = index == collapse.from ? positions[collapse.to] : corners[c];
+                }
+                if(has_to){
+                    continue;
+                }
+
+                glm::vec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+                glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+                flips = glm::dot(before, after) <= 0.0f;
+            }
+            if(flips){
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to].Add(quadrics[collapse.from]);
+            result_error = std::max(result_error, collapse.error);
+            collapsed++;
+
+            //Nothing that shares a triangle with this one can go this pass, its prices are out of date now
+            for(uint32_t k = triangle_starts[collapse.from]; k < triangle_starts[collapse.from + 1]; k++){
+                uint32_t t = vertex_triangles[k];
+                for(uint32_t c = 0; c < 3; c++){
+                    touched[indices[t * 3 + c]] = true;
+                }
+            }
+        }
+
+        if(collapsed == 0){
+            break;
+        }
+
+        std::vector<uint32_t> remaining;
+        remaining.reserve(indices.size());
+        for(uint32_t t = 0; t < triangle_count; t++){
+            uint32_t a = remap[indices[t * 3]];
+            uint32_t b = remap[indices[t * 3 + 1]];
+            uint32_t c = remap[indices[t * 3 + 2]];
+            if(a != b && b != c && a != c){
+                remaining.insert(remaining.end(), {a, b, c});
+            }
+        }
+        indices = remaining;
+    }
+
+    if(error != nullptr){
+        *error = static_cast<float>(std::sqrt(result_error));
+    }
+
+    return indices;
+}
+
+//Every level simplifies the full mesh again instead of the level before it. Simplify already prices against the original surface,
+//this just keeps the levels from building on each other's choices
+std::vector<CtMeshLod> CtMeshImport::BuildLods(const CtMeshData& mesh, uint32_t max_levels){
+    std::vector<CtMeshLod> lods;
+    lods.push_back({mesh.indices, 0.0f});
+
+    //The error limit scales with the mesh
+    glm::vec3 minimum(0.0f);
+    glm::vec3 maximum(0.0f);
+    for(size_t v = 0; v < mesh.vertices.size(); v++){
+        glm::vec3 position(mesh.vertices[v].position, 0.0f);
+        minimum = v == 0 ? position : glm::min(minimum, position);
+        maximum = v == 0 ? position : glm::max(maximum, position);
+    }
+    float max_error = glm::length(maximum - minimum) * CT_MESH_LOD_MAX_ERROR;
+
+    CtMeshData level;
+    level.vertices = mesh.vertices;
+
+    while(lods.size() < max_levels){
+        size_t previous_count = lods.back().indices.size();
+        uint32_t target_count = static_cast<uint32_t>(previous_count / 3 * CT_MESH_LOD_REDUCTION) * 3;
+        if(target_count == 0){
+            break;
+        }
+
+        float error = 0.0f;
+        level.indices = Simplify(mesh, target_count, max_error, &error);
+        if(level.indices.empty() || level.indices.size() > previous_count * (1.0f - CT_MESH_LOD_MIN_REDUCTION)){
+            break;
+        }
+
+        OptimizeVertexCache(level, CT_MESH_IMPORT_CACHE_SIZE);
+        lods.push_back({level.indices, std::max(error, lods.back().error)});
+    }
+
+    return lods;
+}
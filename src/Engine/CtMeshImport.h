@@ -0,0 +1,118 @@
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+struct CtVertex;
+
+//Below this many vertices spinning up threads costs more than the welding does
+const uint32_t CT_MESH_IMPORT_MIN_PARALLEL_VERTICES = 32768;
+const uint32_t CT_MESH_IMPORT_MAX_THREADS = 16;
+
+//The post transform cache the optimizer orders triangles for and the stats are measured against. Real GPUs don't all have a FIFO of
+//exactly this, but ordering for one this size does well on all of them
+const uint32_t CT_MESH_IMPORT_CACHE_SIZE = 16;
+
+//Meshlet limits. 64 vertices and 124 triangles is what mesh shading hardware is built around, and small enough that culling one
+//throws away a useful amount of work without the culling itself costing more than drawing would
+const uint32_t CT_MESHLET_MAX_VERTICES = 64;
+const uint32_t CT_MESHLET_MAX_TRIANGLES = 124;
+
+//LOD chains. Each level aims for this fraction of the triangles of the one before it, and a level that can't get at least
+//CT_MESH_LOD_MIN_REDUCTION below the last one isn't worth keeping. Simplification stops past CT_MESH_LOD_MAX_ERROR, as a fraction of the
+//mesh's size, since that far off the mesh would only be drawn at a few pixels anyway
+const uint32_t CT_MESH_LOD_MAX_LEVELS = 8;
+const float CT_MESH_LOD_REDUCTION = 0.5f;
+const float CT_MESH_LOD_MIN_REDUCTION = 0.1f;
+const float CT_MESH_LOD_MAX_ERROR = 0.1f;
+
+//An indexed mesh on the CPU, the way it goes into CtMeshStore::AddMesh
+struct CtMeshData{
+    std::vector<CtVertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+//How well a mesh's triangle order reuses transformed vertices, counted with a FIFO cache
+struct CtVertexCacheStats{
+    uint32_t transformed; //Cache misses, so how many times the vertex shader runs
+
+    //Average cache miss ratio, transformed vertices per triangle. 0.5 is about as good as it gets and 3 is no reuse at all
+    float acmr;
+
+    //Average transform to vertex ratio, transformed vertices per vertex. 1 is perfect
+    float atvr;
+};
+
+//A run of a mesh's triangles that gets culled on its own. Meshlets are contiguous in the mesh's index buffer, so drawing one is
+//just a smaller indexed draw of the same mesh
+struct CtMeshlet{
+    uint32_t first_index; //From the front of the mesh's own indices
+    uint32_t index_count;
+    uint32_t vertex_count; //Unique vertices, at most CT_MESHLET_MAX_VERTICES
+
+    //Sphere around the meshlet in mesh space, center in xyz and radius in w
+    glm::vec4 bounds;
+
+    //Every triangle's normal is within the cone around the axis in xyz. w is the sine of the cone's half angle, so the meshlet faces
+    //away from anything looking down the axis closer than that. A zero axis with w = 1 means the triangles face too many ways to cull
+    glm::vec4 cone;
+};
+
+//One level of a mesh's LOD chain. It indexes into the full mesh's vertices, it just uses fewer of them
+struct CtMeshLod{
+    std::vector<uint32_t> indices;
+
+    //How far, in mesh space, the surface can be from the full detail one
+    float error;
+};
+
+//What loaders run a mesh through before it goes anywhere near the GPU. Everything in here is plain CPU work on CtMeshData,
+//so it can run on any thread
+class CtMeshImport{
+
+    public:
+        //Merges vertices that are exactly the same and builds the index buffer to match. No indices means the vertices are a plain
+        //triangle list, three per triangle. Vertices come out in the order the triangles first use them, and ones nothing uses are dropped.
+        //Big inputs get hashed and welded across threads, the result is the same either way
+        static CtMeshData Weld(const std::vector<CtVertex>& vertices, const std::vector<uint32_t>& indices);
+
+        static CtVertexCacheStats AnalyzeVertexCache(const CtMeshData& mesh, uint32_t cache_size);
+
+        //Reorders the triangles so they reuse what's still in the cache (Tipsify). When clusters is given, it gets the first triangle of
+        //every run the ordering had to jump to a new spot for, which is what OptimizeOverdraw moves around
+        static void OptimizeVertexCache(CtMeshData& mesh, uint32_t cache_size, std::vector<uint32_t>* clusters = nullptr);
+
+        //Sorts those runs so the ones facing out from the middle of the mesh draw first and hide more of the rest. Each run keeps
+        //its own order, so the cache hits inside it stay
+        static void OptimizeOverdraw(CtMeshData& mesh, const std::vector<uint32_t>& clusters);
+
+        //Renumbers the vertices in the order the triangles use them, so fetches walk forward through memory
+        static void OptimizeVertexFetch(CtMeshData& mesh);
+
+        //All of the above in order, printing the cache stats before and after
+        static void Optimize(CtMeshData& mesh, bool optimize_overdraw);
+
+        //Cuts the triangles into meshlets in the order they're already in, starting a new one whenever the next triangle would go over
+        //either limit. Run it after Optimize, the cache order keeps neighbouring triangles together so the meshlets come out tight
+        static std::vector<CtMeshlet> BuildMeshlets(const CtMeshData& mesh, uint32_t max_vertices = CT_MESHLET_MAX_VERTICES,
+            uint32_t max_triangles = CT_MESHLET_MAX_TRIANGLES);
+
+        //Collapses edges until the mesh gets down to target_index_count or the next collapse would move the surface further than
+        //target_error (in mesh space). Vertices are never moved or added, only merged into a neighbour, so the result still indexes the
+        //mesh's own vertices. error gets how far off the result ended up
+        static std::vector<uint32_t> Simplify(const CtMeshData& mesh, uint32_t target_index_count, float target_error, float* error = nullptr);
+
+        //The mesh itself as level 0, then coarser and coarser ones made by Simplify. Every level gets its triangles reordered for the cache
+        static std::vector<CtMeshLod> BuildLods(const CtMeshData& mesh, uint32_t max_levels = CT_MESH_LOD_MAX_LEVELS);
+
+    private:
+        //Fills in bounds and cone from the meshlet's triangles
+        static void ComputeMeshletBounds(const CtMeshData& mesh, CtMeshlet& meshlet);
+
+        //For every vertex, the first vertex that's equal to it
+        static std::vector<uint32_t> FindDuplicates(const std::vector<CtVertex>& vertices);
+
+        //Calls work(thread) once for every thread from 0 to thread_count - 1, with thread 0 on the caller's
+        static void RunParallel(uint32_t thread_count, const std::function<void(uint32_t)>& work);
+};
@@ -0,0 +1,406 @@
+#include "CtMeshStore.h"
+#include "CtDevice.h"
+#include "CtQueueFamily.h"
+#include "CtVertex.h"
+#include "CtMeshImport.h"
+#include "CtMeshFile.h"
+#include <stdexcept>
+#include <cstring>
+#include <chrono>
+
+//max_vertices is counted in CtMeshVertexLayout vertices and max_indices in 32 bit indices. Meshes with smaller ones just take up less
+CtMeshStore* CtMeshStore::CreateMeshStore(CtDevice* device, uint32_t max_vertices, uint32_t max_indices, uint32_t max_clusters){
+    CtMeshStore* ct_mesh_store = new CtMeshStore();
+
+    ct_mesh_store->device = device;
+    ct_mesh_store->max_vertex_bytes = static_cast<VkDeviceSize>(max_vertices) * CtMeshVertexLayout::stride;
+    ct_mesh_store->max_index_bytes = static_cast<VkDeviceSize>(max_indices) * sizeof(uint32_t);
+    ct_mesh_store->vertex_bytes = 0;
+    ct_mesh_store->index_bytes = 0;
+    ct_mesh_store->max_clusters = max_clusters > 0 ? max_clusters : 1;
+    ct_mesh_store->cluster_count = 0;
+
+    //The device only has to take indices up to 2^24 - 1 without fullDrawIndexUint32
+    VkPhysicalDeviceProperties properties {};
+    vkGetPhysicalDeviceProperties(*(device->GetPhysicalDevice()), &properties);
+    ct_mesh_store->max_index_value = device->GetOptionalFeatures().full_draw_index_uint32 ? UINT32_MAX : properties.limits.maxDrawIndexedIndexValue;
+
+    ct_mesh_store->CreateBuffer(ct_mesh_store->max_vertex_bytes,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        ct_mesh_store->vertex_buffer, ct_mesh_store->vertex_buffer_memory);
+    ct_mesh_store->CreateBuffer(ct_mesh_store->max_index_bytes,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        ct_mesh_store->index_buffer, ct_mesh_store->index_buffer_memory);
+    ct_mesh_store->CreateBuffer(static_cast<VkDeviceSize>(ct_mesh_store->max_clusters) * sizeof(CtMeshCluster),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        ct_mesh_store->cluster_buffer, ct_mesh_store->cluster_buffer_memory);
+
+    ct_mesh_store->CreateUploadPool();
+
+    printf("Created Mesh Store.\n");
+
+    return ct_mesh_store;
+}
+
+/**************************************************************MESHES*****************************************************************/
+
+uint32_t CtMeshStore::AddMesh(const std::vector<CtVertex>& vertices, const std::vector<uint32_t>& indices){
+    return AddMesh<CtMeshVertexLayout>(vertices, indices);
+}
+
+uint32_t CtMeshStore::AddMesh(const std::vector<CtVertex>& vertices, const std::vector<uint16_t>& indices){
+    return AddMesh<CtMeshVertexLayout>(vertices, indices);
+}
+
+uint32_t CtMeshStore::AddMesh(const CtMeshData& mesh, const std::vector<CtMeshlet>& meshlets){
+    if(cluster_count + meshlets.size() > max_clusters){
+        throw std::runtime_error("The mesh store's cluster buffer is full. Give it more clusters.");
+    }
+
+    uint32_t mesh_id = AddMesh(mesh.vertices, mesh.indices);
+    CtMeshRange& range = meshes[mesh_id];
+
+    std::vector<CtMeshCluster> clusters;
+    clusters.reserve(meshlets.size());
+    for(const auto& meshlet : meshlets){
+        if(meshlet.first_index + meshlet.index_count > range.index_count){
+            throw std::runtime_error("A meshlet runs past the end of its mesh's indices.");
+        }
+
+        CtMeshCluster cluster {};
+        cluster.bounds = meshlet.bounds;
+        cluster.cone = meshlet.cone;
+        cluster.first_index = range.first_index + meshlet.first_index;
+        cluster.index_count = meshlet.index_count;
+        cluster.vertex_offset = range.vertex_offset;
+        clusters.push_back(cluster);
+    }
+
+    Upload(cluster_buffer, cluster_count * sizeof(CtMeshCluster), clusters.data(), clusters.size() * sizeof(CtMeshCluster));
+
+    range.first_cluster = cluster_count;
+    range.cluster_count = static_cast<uint32_t>(clusters.size());
+    cluster_count += range.cluster_count;
+
+    return mesh_id;
+}
+
+uint32_t CtMeshStore::AddMesh(const CtMeshData& mesh, const std::vector<CtMeshLod>& lods){
+    if(lods.empty()){
+        throw std::runtime_error("A mesh needs at least its full detail level.");
+    }
+
+    uint32_t mesh_id = AddMesh(mesh.vertices, lods[0].indices);
+    uint32_t lod_count = static_cast<uint32_t>(lods.size());
+
+    //Every level has the same vertices, so they all end up with the same index type as the first
+    for(uint32_t l = 1; l < lod_count; l++){
+        CtMeshRange lod = meshes[mesh_id];
+
+        for(uint32_t index : lods[l].indices){
+            if(index >= lod.vertex_count){
+                throw std::runtime_error("A mesh index points past the mesh's vertices.");
+            }
+        }
+
+        if(lod.index_type == VK_INDEX_TYPE_UINT16){
+            std::vector<uint16_t> narrow_indices(lods[l].indices.begin(), lods[l].indices.end());
+            lod.first_index = AddIndices(narrow_indices.data(), static_cast<uint32_t>(narrow_indices.size()), VK_INDEX_TYPE_UINT16);
+        }
+        else{
+            lod.first_index = AddIndices(lods[l].indices.data(), static_cast<uint32_t>(lods[l].indices.size()), VK_INDEX_TYPE_UINT32);
+        }
+
+        lod.index_count = static_cast<uint32_t>(lods[l].indices.size());
+        lod.lod_error = lods[l].error;
+        meshes.push_back(lod);
+    }
+
+    for(uint32_t l = 0; l < lod_count; l++){
+        meshes[mesh_id + l].lod_count = lod_count - l;
+    }
+
+    return mesh_id;
+}
+
+uint32_t CtMeshStore::AddMesh(CtMeshFile* file){
+    const CtMeshFileHeader& header = file->GetHeader();
+    if(!file->HasLayout<CtMeshVertexLayout>()){
+        throw std::runtime_error("A mesh file was written for a different vertex layout than the mesh store uses. Convert it again.");
+    }
+
+    VkIndexType index_type = static_cast<VkIndexType>(header.index_type);
+    if(index_type == VK_INDEX_TYPE_UINT32 && header.vertex_count > max_index_value + 1ull){
+        throw std::runtime_error("A mesh has more vertices than the device can index in one draw. Split it up.");
+    }
+
+    uint32_t index_size = index_type == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    int32_t vertex_offset = AddVertices(file->GetVertices(), header.vertex_size, header.vertex_stride);
+    uint32_t first_index = AddIndices(file->GetIndices(), static_cast<uint32_t>(header.index_size / index_size), index_type);
+
+    uint32_t mesh_id = static_cast<uint32_t>(meshes.size());
+    const CtMeshFileLod* lods = file->GetLods();
+    for(uint32_t l = 0; l < header.lod_count; l++){
+        CtMeshRange mesh {};
+        mesh.first_index = first_index + lods[l].first_index;
+        mesh.index_count = lods[l].index_count;
+        mesh.vertex_offset = vertex_offset;
+        mesh.vertex_count = header.vertex_count;
+        mesh.vertex_stride = header.vertex_stride;
+        mesh.index_type = index_type;
+        mesh.bounds = glm::vec4(header.bounds[0], header.bounds[1], header.bounds[2], header.bounds[3]);
+        mesh.lod_count = header.lod_count - l;
+        mesh.lod_error = lods[l].error;
+        meshes.push_back(mesh);
+    }
+
+    return mesh_id;
+}
+
+uint32_t CtMeshStore::LoadMesh(const std::string& path){
+    auto start = std::chrono::steady_clock::now();
+
+    CtMeshFile* file = CtMeshFile::Open(path);
+    uint32_t mesh_id;
+    try{
+        mesh_id = AddMesh(file);
+    } catch(...){
+        file->Close();
+        delete file;
+        throw;
+    }
+
+    const CtMeshFileHeader& header = file->GetHeader();
+    uint32_t vertex_count = header.vertex_count;
+    uint32_t lod_count = header.lod_count;
+    uint64_t file_size = header.file_size;
+
+    file->Close();
+    delete file;
+
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("Loaded Mesh %s (%u vertices, %u LODs, %llu bytes) in %.2f ms.\n", path.c_str(), vertex_count, lod_count,
+        static_cast<unsigned long long>(file_size), milliseconds);
+
+    return mesh_id;
+}
+
+//Anything small enough gets narrowed to 16 bits on the way in
+uint32_t CtMeshStore::AddPackedMesh(const std::vector<CtVertex>& vertices, const std::vector<uint8_t>& packed_vertices, uint32_t stride,
+    const std::vector<uint32_t>& indices){
+    for(uint32_t index : indices){
+        if(index >= vertices.size()){
+            throw std::runtime_error("A mesh index points past the mesh's vertices.");
+        }
+    }
+
+    if(vertices.size() <= CT_MESH_STORE_MAX_UINT16_VERTICES){
+        std::vector<uint16_t> narrow_indices(indices.begin(), indices.end());
+        return AddMeshData(vertices, packed_vertices, stride, narrow_indices.data(), static_cast<uint32_t>(narrow_indices.size()), VK_INDEX_TYPE_UINT16);
+    }
+
+    if(vertices.size() - 1 > max_index_value){
+        throw std::runtime_error("A mesh has more vertices than the device can index in one draw. Split it up.");
+    }
+
+    return AddMeshData(vertices, packed_vertices, stride, indices.data(), static_cast<uint32_t>(indices.size()), VK_INDEX_TYPE_UINT32);
+}
+
+uint32_t CtMeshStore::AddPackedMesh(const std::vector<CtVertex>& vertices, const std::vector<uint8_t>& packed_vertices, uint32_t stride,
+    const std::vector<uint16_t>& indices){
+    for(uint16_t index : indices){
+        if(index >= vertices.size()){
+            throw std::runtime_error("A mesh index points past the mesh's vertices.");
+        }
+    }
+
+    return AddMeshData(vertices, packed_vertices, stride, indices.data(), static_cast<uint32_t>(indices.size()), VK_INDEX_TYPE_UINT16);
+}
+
+//Every mesh's indices start on a 4 byte boundary, so their offset divides evenly into whichever index size they end up being read as.
+//Its vertices start on a multiple of its own stride for the same reason
+uint32_t CtMeshStore::AddMeshData(const std::vector<CtVertex>& vertices, const std::vector<uint8_t>& packed_vertices, uint32_t stride,
+    const void* indices, uint32_t index_count, VkIndexType index_type){
+
+    uint32_t first_index = AddIndices(indices, index_count, index_type);
+    int32_t vertex_offset = AddVertices(packed_vertices.data(), packed_vertices.size(), stride);
+
+    //Centered on the middle of the bounding box, which is close enough to the smallest sphere for culling
+    glm::vec3 minimum(0.0f);
+    glm::vec3 maximum(0.0f);
+    for(size_t v = 0; v < vertices.size(); v++){
+        glm::vec3 position(vertices[v].position, 0.0f);
+        minimum = v == 0 ? position : glm::min(minimum, position);
+        maximum = v == 0 ? position : glm::max(maximum, position);
+    }
+
+    glm::vec3 center = (minimum + maximum) * 0.5f;
+    float radius = 0.0f;
+    for(const auto& vertex : vertices){
+        radius = glm::max(radius, glm::length(glm::vec3(vertex.position, 0.0f) - center));
+    }
+
+    CtMeshRange mesh {};
+    mesh.first_index = first_index;
+    mesh.index_count = index_count;
+    mesh.vertex_offset = vertex_offset;
+    mesh.vertex_count = static_cast<uint32_t>(vertices.size());
+    mesh.vertex_stride = stride;
+    mesh.index_type = index_type;
+    mesh.bounds = glm::vec4(center, radius);
+    mesh.lod_count = 1;
+    mesh.lod_error = 0.0f;
+    meshes.push_back(mesh);
+
+    return static_cast<uint32_t>(meshes.size() - 1);
+}
+
+int32_t CtMeshStore::AddVertices(const void* packed_vertices, VkDeviceSize size, uint32_t stride){
+    VkDeviceSize vertex_start = (vertex_bytes + stride - 1) / stride * stride;
+
+    if(vertex_start + size > max_vertex_bytes){
+        throw std::runtime_error("The mesh store's shared buffers are full. Give it more vertices or indices.");
+    }
+
+    Upload(vertex_buffer, vertex_start, packed_vertices, size);
+    vertex_bytes = vertex_start + size;
+
+    return static_cast<int32_t>(vertex_start / stride);
+}
+
+uint32_t CtMeshStore::AddIndices(const void* indices, uint32_t index_count, VkIndexType index_type){
+    VkDeviceSize index_size = index_type == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    VkDeviceSize index_start = (index_bytes + sizeof(uint32_t) - 1) & ~static_cast<VkDeviceSize>(sizeof(uint32_t) - 1);
+
+    if(index_start + index_count * index_size > max_index_bytes){
+        throw std::runtime_error("The mesh store's shared buffers are full. Give it more vertices or indices.");
+    }
+
+    Upload(index_buffer, index_start, indices, index_count * index_size);
+    index_bytes = index_start + index_count * index_size;
+
+    return static_cast<uint32_t>(index_start / index_size);
+}
+
+void CtMeshStore::BindVertexBuffer(VkCommandBuffer command_buffer, uint32_t binding){
+    VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(command_buffer, binding, 1, &vertex_buffer, &offset);
+}
+
+void CtMeshStore::BindIndexBuffer(VkCommandBuffer command_buffer, VkIndexType index_type){
+    vkCmdBindIndexBuffer(command_buffer, index_buffer, 0, index_type);
+}
+
+/**************************************************************BUFFERS*****************************************************************/
+
+void CtMeshStore::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& buffer_memory){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    VkBufferCreateInfo buffer_info {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = size;
+    buffer_info.usage = usage;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    //Cluster culling reads the clusters, and that can run on the compute queue
+    if(usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT){
+        device->ShareAcrossQueues(buffer_info);
+    }
+
+    if(vkCreateBuffer(interface_device, &buffer_info, nullptr, &buffer) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create a mesh store buffer.");
+    }
+
+    VkMemoryRequirements memory_requirements;
+    vkGetBufferMemoryRequirements(interface_device, buffer, &memory_requirements);
+
+    VkMemoryAllocateInfo allocate_info {};
+    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocate_info.allocationSize = memory_requirements.size;
+    allocate_info.memoryTypeIndex = device->FindMemoryType(memory_requirements.memoryTypeBits, properties);
+
+    if(vkAllocateMemory(interface_device, &allocate_info, nullptr, &buffer_memory) != VK_SUCCESS){
+        throw std::runtime_error("Failed to allocate mesh store memory.");
+    }
+
+    vkBindBufferMemory(interface_device, buffer, buffer_memory, 0);
+}
+
+void CtMeshStore::CreateUploadPool(){
+    VkCommandPoolCreateInfo pool_info {};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pool_info.queueFamilyIndex = device->queue_family->graphics_family.value();
+
+    if(vkCreateCommandPool(*(device->GetInterfaceDevice()), &pool_info, nullptr, &upload_pool) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create the mesh store's upload pool.");
+    }
+}
+
+//Staging buffer, one copy, wait. Meshes get added at load time so there's nothing to overlap with yet
+void CtMeshStore::Upload(VkBuffer destination, VkDeviceSize offset, const void* data, VkDeviceSize size){
+    if(size == 0){
+        return;
+    }
+
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    VkBuffer staging_buffer;
+    VkDeviceMemory staging_buffer_memory;
+    CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        staging_buffer, staging_buffer_memory);
+
+    void* mapped;
+    if(vkMapMemory(interface_device, staging_buffer_memory, 0, size, 0, &mapped) != VK_SUCCESS){
+        throw std::runtime_error("Failed to map mesh store staging memory.");
+    }
+    memcpy(mapped, data, static_cast<size_t>(size));
+    vkUnmapMemory(interface_device, staging_buffer_memory);
+
+    VkCommandBufferAllocateInfo allocate_info {};
+    allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocate_info.commandPool = upload_pool;
+    allocate_info.commandBufferCount = 1;
+
+    VkCommandBuffer command_buffer;
+    vkAllocateCommandBuffers(interface_device, &allocate_info, &command_buffer);
+
+    VkCommandBufferBeginInfo begin_info {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(command_buffer, &begin_info);
+
+    VkBufferCopy copy_region {};
+    copy_region.srcOffset = 0;
+    copy_region.dstOffset = offset;
+    copy_region.size = size;
+    vkCmdCopyBuffer(command_buffer, staging_buffer, destination, 1, &copy_region);
+
+    vkEndCommandBuffer(command_buffer);
+
+    VkSubmitInfo submit_info {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &command_buffer;
+
+    vkQueueSubmit(device->queue_family->graphics_queue, 1, &submit_info, VK_NULL_HANDLE);
+    vkQueueWaitIdle(device->queue_family->graphics_queue);
+
+    vkFreeCommandBuffers(interface_device, upload_pool, 1, &command_buffer);
+    vkDestroyBuffer(interface_device, staging_buffer, nullptr);
+    vkFreeMemory(interface_device, staging_buffer_memory, nullptr);
+}
+
+void CtMeshStore::Cleanup(){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    vkDestroyCommandPool(interface_device, upload_pool, nullptr);
+
+    vkDestroyBuffer(interface_device, vertex_buffer, nullptr);
+    vkFreeMemory(interface_device, vertex_buffer_memory, nullptr);
+    vkDestroyBuffer(interface_device, index_buffer, nullptr);
+    vkFreeMemory(interface_device, index_buffer_memory, nullptr);
+    vkDestroyBuffer(interface_device, cluster_buffer, nullptr);
+    vkFreeMemory(interface_device, cluster_buffer_memory, nullptr);
+}
@@ -0,0 +1,158 @@
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+class CtDevice;
+class CtMeshFile;
+struct CtVertex;
+struct CtMeshData;
+struct CtMeshlet;
+struct CtMeshLod;
+
+//Meshes with at most this many vertices get 16 bit indices. Index 0xFFFF is left alone so turning primitive restart on can't break a mesh
+const uint32_t CT_MESH_STORE_MAX_UINT16_VERTICES = 0xFFFF;
+
+//Where a mesh landed in the store's shared vertex and index buffers
+struct CtMeshRange{
+    //In the mesh's own index size from the front of the index buffer, so it goes straight into a draw with the buffer bound at 0
+    uint32_t first_index;
+    uint32_t index_count;
+    int32_t vertex_offset; //In vertices of the mesh's own layout
+    uint32_t vertex_count;
+    uint32_t vertex_stride;
+    VkIndexType index_type;
+
+    //Sphere around every vertex in mesh space, center in xyz and radius in w
+    glm::vec4 bounds;
+
+    //The mesh's meshlets in the cluster buffer. 0 clusters means it was added without any and only ever draws whole
+    uint32_t first_cluster;
+    uint32_t cluster_count;
+
+    //Levels of detail are meshes of their own, one after another in mesh ids and all sharing the first one's vertices. lod_count is how
+    //many levels there are from this one on, counting itself, so the next coarser one is mesh_id + 1 while it's above 1
+    uint32_t lod_count;
+    float lod_error; //Mesh space, see CtMeshLod
+};
+
+//One meshlet the way cluster culling reads it out of the cluster buffer, laid out for std430
+struct CtMeshCluster{
+    glm::vec4 bounds; //Mesh space sphere
+    glm::vec4 cone; //Axis and cutoff, see CtMeshlet
+
+    //Ready to go straight into a draw command, first_index already counts from the front of the index buffer
+    uint32_t first_index;
+    uint32_t index_count;
+    int32_t vertex_offset;
+    uint32_t padding;
+};
+
+//Packs every mesh into one shared vertex buffer and one shared index buffer, so drawing anything never needs new buffers bound.
+//Each mesh gets the smallest index type its vertex count allows. Small meshes read half the index bytes, big ones still work, and
+//both kinds live in the same buffer since a draw's firstIndex is counted in whatever index type is bound. Vertices work the same way,
+//each mesh starts on a multiple of its layout's stride so vertexOffset lands on it with the buffer bound at 0
+class CtMeshStore{
+
+    public:
+        static CtMeshStore* CreateMeshStore(CtDevice* device, uint32_t max_vertices, uint32_t max_indices, uint32_t max_clusters);
+
+        //Copies the mesh in as CtMeshVertexLayout and waits for it to land. Meant for load time, not the middle of a frame.
+        //Indices are local to the mesh
+        uint32_t AddMesh(const std::vector<CtVertex>& vertices, const std::vector<uint32_t>& indices);
+        uint32_t AddMesh(const std::vector<CtVertex>& vertices, const std::vector<uint16_t>& indices);
+
+        //The same with any other CtVertexLayout. Only a pipeline built for that layout can draw the mesh
+        template<typename Layout, typename Index>
+        uint32_t AddMesh(const std::vector<CtVertex>& vertices, const std::vector<Index>& indices){
+            std::vector<uint8_t> packed_vertices;
+            Layout::Encode(vertices, packed_vertices);
+
+            return AddPackedMesh(vertices, packed_vertices, Layout::stride, indices);
+        }
+
+        //A mesh split into meshlets by CtMeshImport::BuildMeshlets. It draws like any other mesh, and cluster culling can also draw it
+        //one meshlet at a time
+        uint32_t AddMesh(const CtMeshData& mesh, const std::vector<CtMeshlet>& meshlets);
+
+        //A mesh with the LOD chain CtMeshImport::BuildLods made for it. The vertices go in once and every level gets its own indices.
+        //Returns the full detail level
+        uint32_t AddMesh(const CtMeshData& mesh, const std::vector<CtMeshLod>& lods);
+
+        //Everything in a .ctmesh file, LODs included, copied from the mapping into staging as is. The file has to be written for
+        //CtMeshVertexLayout. Returns the full detail level
+        uint32_t AddMesh(CtMeshFile* file);
+
+        //Opens, adds and closes a .ctmesh file, printing how long it took
+        uint32_t LoadMesh(const std::string& path);
+
+        const CtMeshRange& GetMesh(uint32_t mesh_id){
+            return meshes[mesh_id];
+        }
+        uint32_t GetMeshCount(){
+            return static_cast<uint32_t>(meshes.size());
+        }
+
+        void BindVertexBuffer(VkCommandBuffer command_buffer, uint32_t binding);
+
+        //Every mesh of one index type draws out of the same binding, so this only has to change between runs of different types
+        void BindIndexBuffer(VkCommandBuffer command_buffer, VkIndexType index_type);
+
+        VkBuffer GetVertexBuffer(){
+            return vertex_buffer;
+        }
+        VkBuffer GetIndexBuffer(){
+            return index_buffer;
+        }
+        VkBuffer GetClusterBuffer(){
+            return cluster_buffer;
+        }
+
+        void Cleanup();
+
+    private:
+
+        CtDevice* device;
+
+        //The shared buffers and how much of them is taken. Meshes are only ever added, never removed
+        VkBuffer vertex_buffer;
+        VkDeviceMemory vertex_buffer_memory;
+        VkBuffer index_buffer;
+        VkDeviceMemory index_buffer_memory;
+        VkDeviceSize max_vertex_bytes;
+        VkDeviceSize max_index_bytes;
+        VkDeviceSize vertex_bytes;
+        VkDeviceSize index_bytes;
+
+        //Every clustered mesh's CtMeshClusters back to back
+        VkBuffer cluster_buffer;
+        VkDeviceMemory cluster_buffer_memory;
+        uint32_t max_clusters;
+        uint32_t cluster_count;
+
+        //The biggest index a 32 bit mesh may use. All of them with fullDrawIndexUint32, otherwise whatever the device says
+        uint32_t max_index_value;
+
+        std::vector<CtMeshRange> meshes;
+
+        //Uploads
+        VkCommandPool upload_pool;
+
+        //Picks the index type. The full precision vertices are only still around for the bounds
+        uint32_t AddPackedMesh(const std::vector<CtVertex>& vertices, const std::vector<uint8_t>& packed_vertices, uint32_t stride,
+            const std::vector<uint32_t>& indices);
+        uint32_t AddPackedMesh(const std::vector<CtVertex>& vertices, const std::vector<uint8_t>& packed_vertices, uint32_t stride,
+            const std::vector<uint16_t>& indices);
+        uint32_t AddMeshData(const std::vector<CtVertex>& vertices, const std::vector<uint8_t>& packed_vertices, uint32_t stride,
+            const void* indices, uint32_t index_count, VkIndexType index_type);
+
+        //Copy vertices or indices in after everything else and return where they start, in vertices of the stride or indices of their own size
+        int32_t AddVertices(const void* packed_vertices, VkDeviceSize size, uint32_t stride);
+        uint32_t AddIndices(const void* indices, uint32_t index_count, VkIndexType index_type);
+
+        void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& buffer_memory);
+        void CreateUploadPool();
+        void Upload(VkBuffer destination, VkDeviceSize offset, const void* data, VkDeviceSize size);
+};
@@ -0,0 +1,117 @@
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+//Runs produce(i) for every i below count on worker threads and consume(i, result) on the calling thread, in order, as soon as result i and
+//everything before it is ready. A worker only starts on i once it's less than window ahead of the last one consumed, so at most window
+//results are ever waiting no matter how many there are. That's what lets loaders decode in parallel and still upload with bounded memory.
+//The first exception from either side stops the workers and is rethrown here
+template<typename Result>
+void CtRunOrdered(uint32_t count, uint32_t thread_count, uint32_t window, const std::function<void(uint32_t, Result&)>& produce,
+    const std::function<void(uint32_t, Result&)>& consume){
+
+    thread_count = std::max(std::min(thread_count, count), 1u);
+    window = std::max(window, thread_count);
+
+    //Result i waits in slot i % window. Whatever was in that slot before was i - window, which has to have been consumed already
+    std::vector<Result> slots(window);
+    std::vector<uint8_t> ready(window, 0);
+    uint32_t next_produce = 0;
+    uint32_t next_consume = 0;
+    bool stop = false;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable produced;
+    std::condition_variable consumed;
+
+    auto work = [&](){
+        while(true){
+            uint32_t i;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                consumed.wait(lock, [&](){
+                    return stop || next_produce >= count || next_produce < next_consume + window;
+                });
+                if(stop || next_produce >= count){
+                    return;
+                }
+                i = next_produce++;
+            }
+
+            Result result {};
+            try{
+                produce(i, result);
+            } catch(...){
+                std::lock_guard<std::mutex> lock(mutex);
+                if(!error){
+                    error = std::current_exception();
+                }
+                stop = true;
+                produced.notify_all();
+                consumed.notify_all();
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            slots[i % window] = std::move(result);
+            ready[i % window] = 1;
+            produced.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for(uint32_t t = 0; t < thread_count; t++){
+        workers.emplace_back(work);
+    }
+
+    auto stop_workers = [&](){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        consumed.notify_all();
+        for(auto& worker : workers){
+            worker.join();
+        }
+    };
+
+    try{
+        for(uint32_t i = 0; i < count; i++){
+            Result result {};
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                produced.wait(lock, [&](){
+                    return stop || ready[i % window] != 0;
+                });
+                if(ready[i % window] == 0){
+                    break;
+                }
+
+                result = std::move(slots[i % window]);
+                slots[i % window] = Result {};
+                ready[i % window] = 0;
+            }
+
+            consume(i, result);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                next_consume = i + 1;
+            }
+            consumed.notify_all();
+        }
+    } catch(...){
+        stop_workers();
+        throw;
+    }
+
+    stop_workers();
+    if(error){
+        std::rethrow_exception(error);
+    }
+}
@@ -14,26 +14,33 @@ void CtQueueFamily::ImplementQueueFamily(VkPhysicalDevice device){
     std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count, queue_families.data());
 
-    //Now let's find our queue families
+    //Now let's find our queue families. We look at all of them, a compute only family is usually further down the list
     int i = 0;
     for(const auto& queue_family_index : queue_families){
-        if(queue_family_index.queueFlags & VK_QUEUE_GRAPHICS_BIT){
+        if((queue_family_index.queueFlags & VK_QUEUE_GRAPHICS_BIT) && !graphics_family.has_value()){
             graphics_family = i;
         }
 
+        //A family with compute but no graphics is the async compute hardware, so that's the one we want
+        if((queue_family_index.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queue_family_index.queueFlags & VK_QUEUE_GRAPHICS_BIT) &&
+            !compute_family.has_value()){
+            compute_family = i;
+        }
+
         VkBool32 present_support = false;
         vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &present_support);
 
-        if(present_support){
+        if(present_support && !present_family.has_value()){
             present_family = i;
         }
 
-        if(IsComplete()){
-            break;
-        }
-        
         i++;
     }
+
+    //Graphics families always do compute too
+    if(!compute_family.has_value() && graphics_family.has_value()){
+        compute_family = graphics_family;
+    }
 }
 
 bool CtQueueFamily::TestDevice(VkPhysicalDevice device){
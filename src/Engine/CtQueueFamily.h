@@ -33,14 +33,24 @@ class CtQueueFamily{
         uint32_t PresentFamilyValue(){
             return present_family.value();
         }
+        uint32_t ComputeFamilyValue(){
+            return compute_family.value();
+        }
+
+        //True when compute has its own family, so work submitted there can actually run next to graphics
+        bool HasDedicatedCompute(){
+            return compute_family.value() != graphics_family.value();
+        }
 
 
     private:
         std::optional<uint32_t> graphics_family;
         std::optional<uint32_t> present_family;
+        std::optional<uint32_t> compute_family; //Falls back to the graphics family when there's no compute only one
 
         VkQueue graphics_queue;
         VkQueue present_queue;
+        VkQueue compute_queue;
 
         VkSurfaceKHR surface;
 
@@ -52,5 +62,9 @@ class CtQueueFamily{
 
     friend class CtDevice;
     friend class CtRenderer;
+    friend class CtMeshStore;
+    friend class CtTextureStore;
+    friend class CtTextureStreamer;
+    friend class CtRenderGraph;
 };
 
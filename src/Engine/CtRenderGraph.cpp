@@ -0,0 +1,1570 @@
+#include "CtRenderGraph.h"
+#include "CtDevice.h"
+#include "CtBarrierBatch.h"
+#include "CtQueueFamily.h"
+#include <stdexcept>
+#include <algorithm>
+#include <array>
+
+//Every access bit that actually writes memory. Only these ever need to be made available by a barrier
+const VkAccessFlags2 CT_RENDER_GRAPH_WRITE_ACCESS = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_HOST_WRITE_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+CtRenderGraph* CtRenderGraph::CreateRenderGraph(CtDevice* device){
+    CtRenderGraph* ct_render_graph = new CtRenderGraph();
+
+    ct_render_graph->device = device;
+
+    return ct_render_graph;
+}
+
+/******************************************************RESOURCES**********************************************************************/
+
+CtRenderGraphResourceHandle CtRenderGraph::ImportImage(const std::string& name, VkImage image, VkImageView image_view, VkFormat format, VkExtent2D extent, VkImageLayout initial_layout){
+    CtRenderGraphResource resource {};
+
+    resource.name = name;
+    resource.type = CT_RENDER_GRAPH_RESOURCE_IMAGE;
+    resource.image = image;
+    resource.image_view = image_view;
+    resource.format = format;
+    resource.extent = extent;
+    resource.aspect = GetAspectFromFormat(format);
+    resource.initial_layout = initial_layout;
+    resource.is_output = false;
+    resource.is_transient = false;
+    resource.memory_block = CT_RENDER_GRAPH_NONE;
+    resource.alias_predecessor = CT_RENDER_GRAPH_NONE;
+
+    resources.push_back(resource);
+    compiled = false;
+
+    return static_cast<CtRenderGraphResourceHandle>(resources.size() - 1);
+}
+
+//The image itself is only made when we compile, since that's when we know how it gets used and how long it has to live
+CtRenderGraphResourceHandle CtRenderGraph::CreateImage(const std::string& name, VkFormat format, VkExtent2D extent){
+    CtRenderGraphResource resource {};
+
+    resource.name = name;
+    resource.type = CT_RENDER_GRAPH_RESOURCE_IMAGE;
+    resource.image = VK_NULL_HANDLE;
+    resource.image_view = VK_NULL_HANDLE;
+    resource.format = format;
+    resource.extent = extent;
+    resource.aspect = GetAspectFromFormat(format);
+    resource.initial_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    resource.is_output = false;
+    resource.is_transient = true;
+    resource.memory_block = CT_RENDER_GRAPH_NONE;
+    resource.alias_predecessor = CT_RENDER_GRAPH_NONE;
+
+    resources.push_back(resource);
+    compiled = false;
+
+    return static_cast<CtRenderGraphResourceHandle>(resources.size() - 1);
+}
+
+CtRenderGraphResourceHandle CtRenderGraph::ImportBuffer(const std::string& name, VkBuffer buffer, VkDeviceSize size){
+    CtRenderGraphResource resource {};
+
+    resource.name = name;
+    resource.type = CT_RENDER_GRAPH_RESOURCE_BUFFER;
+    resource.buffer = buffer;
+    resource.size = size;
+    resource.initial_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    resource.is_output = false;
+    resource.is_transient = false;
+    resource.memory_block = CT_RENDER_GRAPH_NONE;
+    resource.alias_predecessor = CT_RENDER_GRAPH_NONE;
+
+    resources.push_back(resource);
+    compiled = false;
+
+    return static_cast<CtRenderGraphResourceHandle>(resources.size() - 1);
+}
+
+//Swapping the handle doesn't change any of the compiled barriers, those only care about how a resource is used
+void CtRenderGraph::SetImportedImage(CtRenderGraphResourceHandle resource, VkImage image, VkImageView image_view){
+    resources[resource].image = image;
+    resources[resource].image_view = image_view;
+}
+
+void CtRenderGraph::SetImportedBuffer(CtRenderGraphResourceHandle resource, VkBuffer buffer){
+    resources[resource].buffer = buffer;
+}
+
+void CtRenderGraph::MarkOutput(CtRenderGraphResourceHandle resource, CtRenderGraphAccess final_access){
+    resources[resource].is_output = true;
+    resources[resource].final_access = final_access;
+    compiled = false;
+}
+
+/******************************************************PASSES**********************************************************************/
+
+CtRenderGraphPassHandle CtRenderGraph::AddPass(const std::string& name, CtRenderGraphPassType type){
+    CtRenderGraphPass pass {};
+
+    pass.name = name;
+    pass.type = type;
+    pass.has_depth_attachment = false;
+    pass.depth_clears = false;
+    pass.has_side_effects = false;
+    pass.async_compute = false;
+    pass.culled = false;
+    pass.on_compute_queue = false;
+    pass.render_pass = VK_NULL_HANDLE;
+
+    passes.push_back(pass);
+    compiled = false;
+
+    return static_cast<CtRenderGraphPassHandle>(passes.size() - 1);
+}
+
+void CtRenderGraph::AddUse(CtRenderGraphPassHandle pass, CtRenderGraphResourceHandle resource, CtRenderGraphAccess access){
+    if(resource >= resources.size()){
+        throw std::runtime_error("Render graph pass uses a resource that doesn't exist.");
+    }
+
+    CtRenderGraphResourceUse use {};
+    use.resource = resource;
+    use.access = access;
+
+    passes[pass].uses.push_back(use);
+    compiled = false;
+}
+
+void CtRenderGraph::Read(CtRenderGraphPassHandle pass, CtRenderGraphResourceHandle resource, CtRenderGraphAccess access){
+    if(GetAccessInfo(access).is_write){
+        throw std::runtime_error("Render graph read declared with a write access.");
+    }
+
+    AddUse(pass, resource, access);
+}
+
+void CtRenderGraph::Write(CtRenderGraphPassHandle pass, CtRenderGraphResourceHandle resource, CtRenderGraphAccess access){
+    if(!GetAccessInfo(access).is_write){
+        throw std::runtime_error("Render graph write declared with a read access.");
+    }
+
+    AddUse(pass, resource, access);
+}
+
+//Passing no clear value means we keep whatever was in the attachment, which also counts as reading it
+void CtRenderGraph::WriteColorAttachment(CtRenderGraphPassHandle pass, CtRenderGraphResourceHandle resource, const VkClearColorValue* clear_value){
+    if(passes[pass].type != CT_RENDER_GRAPH_PASS_RASTER){
+        throw std::runtime_error("Only raster passes can have attachments.");
+    }
+
+    VkClearValue clear {};
+    if(clear_value != nullptr){
+        clear.color = *clear_value;
+    }
+
+    passes[pass].color_attachments.push_back(resource);
+    passes[pass].color_clear_values.push_back(clear);
+    passes[pass].color_clears.push_back(clear_value != nullptr);
+
+    AddUse(pass, resource, CT_RENDER_GRAPH_ACCESS_COLOR_ATTACHMENT);
+}
+
+void CtRenderGraph::WriteDepthAttachment(CtRenderGraphPassHandle pass, CtRenderGraphResourceHandle resource, const VkClearDepthStencilValue* clear_value){
+    if(passes[pass].type != CT_RENDER_GRAPH_PASS_RASTER){
+        throw std::runtime_error("Only raster passes can have attachments.");
+    }
+
+    passes[pass].depth_attachment = resource;
+    passes[pass].has_depth_attachment = true;
+    passes[pass].depth_clears = clear_value != nullptr;
+    if(clear_value != nullptr){
+        passes[pass].depth_clear_value.depthStencil = *clear_value;
+    }
+
+    AddUse(pass, resource, CT_RENDER_GRAPH_ACCESS_DEPTH_ATTACHMENT);
+}
+
+void CtRenderGraph::SetSideEffects(CtRenderGraphPassHandle pass){
+    passes[pass].has_side_effects = true;
+    compiled = false;
+}
+
+void CtRenderGraph::SetAsyncCompute(CtRenderGraphPassHandle pass){
+    if(passes[pass].type != CT_RENDER_GRAPH_PASS_COMPUTE){
+        throw std::runtime_error("Only compute passes can run on the async compute queue.");
+    }
+
+    passes[pass].async_compute = true;
+    compiled = false;
+}
+
+void CtRenderGraph::SetPassExecute(CtRenderGraphPassHandle pass, std::function<void(VkCommandBuffer)> execute){
+    passes[pass].execute = execute;
+}
+
+bool CtRenderGraph::PassReads(const CtRenderGraphPass& pass, CtRenderGraphResourceHandle resource){
+    for(const auto& use : pass.uses){
+        if(use.resource == resource && !GetAccessInfo(use.access).is_write){
+            return true;
+        }
+    }
+
+    //Attachments that load keep the old contents around
+    for(size_t i = 0; i < pass.color_attachments.size(); i++){
+        if(pass.color_attachments[i] == resource && !pass.color_clears[i]){
+            return true;
+        }
+    }
+
+    if(pass.has_depth_attachment && pass.depth_attachment == resource && !pass.depth_clears){
+        return true;
+    }
+
+    return false;
+}
+
+bool CtRenderGraph::PassWrites(const CtRenderGraphPass& pass, CtRenderGraphResourceHandle resource){
+    for(const auto& use : pass.uses){
+        if(use.resource == resource && GetAccessInfo(use.access).is_write){
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/******************************************************COMPILE**********************************************************************/
+
+void CtRenderGraph::Compile(){
+    Destroy();
+
+    CullPasses();
+    OrderPasses();
+    AssignQueues();
+    CreateTransientResources();
+    ComputeBarriers();
+    CreateRenderPasses();
+    BuildSubmissions();
+
+    compiled = true;
+
+    printf("Compiled render graph with %zu of %zu passes in %zu submissions.\n", pass_order.size(), passes.size(), submissions.size());
+}
+
+//Walk backwards from the outputs. A pass survives if it has side effects or writes something a surviving pass (or the outside world) needs
+void CtRenderGraph::CullPasses(){
+    std::vector<bool> needed(resources.size(), false);
+
+    for(size_t i = 0; i < resources.size(); i++){
+        needed[i] = resources[i].is_output;
+    }
+
+    for(size_t i = passes.size(); i-- > 0;){
+        CtRenderGraphPass& pass = passes[i];
+
+        bool alive = pass.has_side_effects;
+        for(const auto& use : pass.uses){
+            if(GetAccessInfo(use.access).is_write && needed[use.resource]){
+                alive = true;
+            }
+        }
+
+        pass.culled = !alive;
+        if(!alive){
+            continue;
+        }
+
+        for(const auto& use : pass.uses){
+            if(PassReads(pass, use.resource)){
+                needed[use.resource] = true;
+            }
+        }
+    }
+}
+
+//Dependencies come from declaration order: a pass depends on every earlier pass it has a read/write or write/write
+//conflict with. Within that we schedule greedily, and whenever we have a choice we avoid picking a pass that depends on the one
+//we just scheduled. That puts distance between producers and consumers so the barriers between them have less to wait on
+void CtRenderGraph::OrderPasses(){
+    pass_order.clear();
+
+    std::vector<CtRenderGraphPassHandle> alive;
+    for(size_t i = 0; i < passes.size(); i++){
+        if(!passes[i].culled){
+            alive.push_back(static_cast<CtRenderGraphPassHandle>(i));
+        }
+    }
+
+    std::vector<std::vector<CtRenderGraphPassHandle>> dependencies(passes.size());
+    for(size_t j = 0; j < alive.size(); j++){
+        const CtRenderGraphPass& later = passes[alive[j]];
+
+        for(size_t i = 0; i < j; i++){
+            const CtRenderGraphPass& earlier = passes[alive[i]];
+
+            bool conflict = false;
+            for(const auto& use : later.uses){
+                bool later_writes = GetAccessInfo(use.access).is_write;
+                bool earlier_writes = PassWrites(earlier, use.resource);
+                bool earlier_reads = PassReads(earlier, use.resource);
+
+                if(earlier_writes || (later_writes && earlier_reads)){
+                    conflict = true;
+                    break;
+                }
+            }
+
+            if(conflict){
+                dependencies[alive[j]].push_back(alive[i]);
+            }
+        }
+    }
+
+    for(CtRenderGraphPassHandle handle : alive){
+        passes[handle].dependencies = dependencies[handle];
+    }
+
+    std::vector<bool> scheduled(passes.size(), false);
+    CtRenderGraphPassHandle last_scheduled = UINT32_MAX;
+
+    while(pass_order.size() < alive.size()){
+        CtRenderGraphPassHandle best = UINT32_MAX;
+        bool best_depends_on_last = true;
+
+        for(CtRenderGraphPassHandle candidate : alive){
+            if(scheduled[candidate]){
+                continue;
+            }
+
+            bool ready = true;
+            bool depends_on_last = false;
+            for(CtRenderGraphPassHandle dependency : dependencies[candidate]){
+                if(!scheduled[dependency]){
+                    ready = false;
+                    break;
+                }
+                if(dependency == last_scheduled){
+                    depends_on_last = true;
+                }
+            }
+
+            if(!ready){
+                continue;
+            }
+
+            //Alive is in declaration order, so the first ready pass wins any tie
+            if(best == UINT32_MAX || (best_depends_on_last && !depends_on_last)){
+                best = candidate;
+                best_depends_on_last = depends_on_last;
+            }
+        }
+
+        if(best == UINT32_MAX){
+            throw std::runtime_error("Render graph has a dependency cycle.");
+        }
+
+        scheduled[best] = true;
+        pass_order.push_back(best);
+        last_scheduled = best;
+    }
+}
+
+//Async compute passes only leave the graphics queue when the device has a compute only family to send them to.
+//Without one they run in order with everything else, same as if they were never tagged
+void CtRenderGraph::AssignQueues(){
+    bool has_async_compute = device->GetOptionalFeatures().async_compute;
+
+    for(auto& pass : passes){
+        pass.on_compute_queue = has_async_compute && pass.async_compute && !pass.culled;
+    }
+
+    for(auto& resource : resources){
+        resource.shared_queues = false;
+    }
+
+    for(CtRenderGraphPassHandle pass_handle : pass_order){
+        if(!passes[pass_handle].on_compute_queue){
+            continue;
+        }
+        for(const auto& use : passes[pass_handle].uses){
+            resources[use.resource].shared_queues = true;
+        }
+    }
+}
+
+//Cuts the pass order wherever the queue changes. Any frame with compute work ends on a graphics submission that waits for the last
+//compute one, which is where the final barriers go and what signals the fence, so the fence still means the whole frame is done
+void CtRenderGraph::BuildSubmissions(){
+    submissions.clear();
+
+    std::vector<uint32_t> pass_submission(passes.size(), CT_RENDER_GRAPH_NONE);
+    uint32_t last_compute_submission = CT_RENDER_GRAPH_NONE;
+
+    for(CtRenderGraphPassHandle pass_handle : pass_order){
+        const CtRenderGraphPass& pass = passes[pass_handle];
+
+        if(submissions.empty() || submissions.back().on_compute_queue != pass.on_compute_queue){
+            CtRenderGraphSubmission submission {};
+            submission.on_compute_queue = pass.on_compute_queue;
+            submission.wait_submission = CT_RENDER_GRAPH_NONE;
+
+            submissions.push_back(submission);
+        }
+
+        uint32_t index = static_cast<uint32_t>(submissions.size() - 1);
+        CtRenderGraphSubmission& submission = submissions[index];
+        submission.passes.push_back(pass_handle);
+        pass_submission[pass_handle] = index;
+
+        if(pass.on_compute_queue){
+            last_compute_submission = index;
+        }
+
+        //Submissions on the other queue only ever come from earlier in the order, so the latest one covers the rest
+        for(CtRenderGraphPassHandle dependency : pass.dependencies){
+            uint32_t other = pass_submission[dependency];
+            if(submissions[other].on_compute_queue == pass.on_compute_queue){
+                continue;
+            }
+
+            if(submission.wait_submission == CT_RENDER_GRAPH_NONE || other > submission.wait_submission){
+                submission.wait_submission = other;
+            }
+        }
+    }
+
+    if(submissions.empty() || last_compute_submission != CT_RENDER_GRAPH_NONE){
+        CtRenderGraphSubmission tail {};
+        tail.on_compute_queue = false;
+        tail.wait_submission = last_compute_submission;
+
+        submissions.push_back(tail);
+    }
+
+    if(last_compute_submission != CT_RENDER_GRAPH_NONE){
+        CreateTimelines();
+    }
+}
+
+void CtRenderGraph::CreateTimelines(){
+    if(graphics_timeline != VK_NULL_HANDLE){
+        return;
+    }
+
+    VkSemaphoreTypeCreateInfo type_info {};
+    type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    type_info.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphore_info {};
+    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphore_info.pNext = &type_info;
+
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+    if(vkCreateSemaphore(interface_device, &semaphore_info, nullptr, &graphics_timeline) != VK_SUCCESS ||
+        vkCreateSemaphore(interface_device, &semaphore_info, nullptr, &compute_timeline) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create the render graph's timeline semaphores.");
+    }
+
+    timeline_value = 0;
+    last_compute_value = 0;
+}
+
+//Transient images get created here once we know every way they're used and which passes they live between.
+//Images that are only ever attachments get TRANSIENT_ATTACHMENT and lazily allocated memory if the device has it.
+//Then we pack them into as few allocations as we can, biggest first, letting images share memory when their lifetimes don't overlap
+void CtRenderGraph::CreateTransientResources(){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    for(auto& resource : resources){
+        if(!resource.is_transient){
+            continue;
+        }
+        resource.usage = 0;
+        resource.first_use = CT_RENDER_GRAPH_NONE;
+        resource.last_use = 0;
+        resource.memory_block = CT_RENDER_GRAPH_NONE;
+        resource.alias_predecessor = CT_RENDER_GRAPH_NONE;
+    }
+
+    for(uint32_t position = 0; position < pass_order.size(); position++){
+        for(const auto& use : passes[pass_order[position]].uses){
+            CtRenderGraphResource& resource = resources[use.resource];
+            if(!resource.is_transient){
+                continue;
+            }
+
+            resource.usage |= GetImageUsage(use.access);
+            resource.first_use = std::min(resource.first_use, position);
+            resource.last_use = std::max(resource.last_use, position);
+        }
+    }
+
+    struct TransientImage{
+        CtRenderGraphResourceHandle handle;
+        VkMemoryRequirements requirements;
+        uint32_t memory_type;
+        bool lazily_allocated;
+    };
+    std::vector<TransientImage> images;
+
+    const VkImageUsageFlags attachment_only = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+        VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+
+    for(size_t i = 0; i < resources.size(); i++){
+        CtRenderGraphResource& resource = resources[i];
+
+        //Nothing that survived culling touches it, so it doesn't need to exist
+        if(!resource.is_transient || resource.first_use == CT_RENDER_GRAPH_NONE){
+            continue;
+        }
+
+        //If nothing ever reads it outside of a render pass its contents never have to leave tile memory
+        bool allow_lazy = (resource.usage & ~attachment_only) == 0;
+        if(allow_lazy){
+            resource.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+        }
+
+        VkImageCreateInfo image_info {};
+        image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_info.imageType = VK_IMAGE_TYPE_2D;
+        image_info.extent.width = resource.extent.width;
+        image_info.extent.height = resource.extent.height;
+        image_info.extent.depth = 1;
+        image_info.mipLevels = 1;
+        image_info.arrayLayers = 1;
+        image_info.format = resource.format;
+        image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_info.usage = resource.usage;
+        image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_info.flags = 0;
+
+        if(resource.shared_queues){
+            device->ShareAcrossQueues(image_info);
+        }
+
+        if(vkCreateImage(interface_device, &image_info, nullptr, &resource.image) != VK_SUCCESS){
+            throw std::runtime_error("Failed to create render graph image " + resource.name + ".");
+        }
+
+        TransientImage image {};
+        image.handle = static_cast<CtRenderGraphResourceHandle>(i);
+        vkGetImageMemoryRequirements(interface_device, resource.image, &image.requirements);
+        image.memory_type = FindTransientMemoryType(image.requirements.memoryTypeBits, allow_lazy, image.lazily_allocated);
+
+        images.push_back(image);
+    }
+
+    std::sort(images.begin(), images.end(), [](const TransientImage& a, const TransientImage& b){
+        return a.requirements.size > b.requirements.size;
+    });
+
+    VkDeviceSize unaliased_size = 0;
+    for(const auto& image : images){
+        CtRenderGraphResource& resource = resources[image.handle];
+        unaliased_size += image.requirements.size;
+
+        //Everything in a block is bound at offset 0, so a block works as long as nobody in it is alive at the same time
+        uint32_t chosen_block = CT_RENDER_GRAPH_NONE;
+        for(uint32_t block_index = 0; block_index < memory_blocks.size() && chosen_block == CT_RENDER_GRAPH_NONE; block_index++){
+            CtRenderGraphMemoryBlock& block = memory_blocks[block_index];
+            if(block.memory_type != image.memory_type || (image.requirements.memoryTypeBits & (1u << block.memory_type)) == 0){
+                continue;
+            }
+            if(resource.shared_queues && !block.resources.empty()){
+                continue;
+            }
+
+            bool overlaps = false;
+            for(CtRenderGraphResourceHandle other : block.resources){
+                if(resources[other].shared_queues){
+                    overlaps = true;
+                    break;
+                }
+                if(resource.first_use <= resources[other].last_use && resources[other].first_use <= resource.last_use){
+                    overlaps = true;
+                    break;
+                }
+            }
+
+            if(!overlaps){
+                chosen_block = block_index;
+            }
+        }
+
+        if(chosen_block == CT_RENDER_GRAPH_NONE){
+            CtRenderGraphMemoryBlock block {};
+            block.memory = VK_NULL_HANDLE;
+            block.size = 0;
+            block.memory_type = image.memory_type;
+            block.lazily_allocated = image.lazily_allocated;
+
+            memory_blocks.push_back(block);
+            chosen_block = static_cast<uint32_t>(memory_blocks.size() - 1);
+        }
+
+        CtRenderGraphMemoryBlock& block = memory_blocks[chosen_block];
+        block.size = std::max(block.size, image.requirements.size);
+        block.resources.push_back(image.handle);
+        resource.memory_block = chosen_block;
+    }
+
+    VkDeviceSize aliased_size = 0;
+    for(auto& block : memory_blocks){
+        VkMemoryAllocateInfo allocate_info {};
+        allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocate_info.allocationSize = block.size;
+        allocate_info.memoryTypeIndex = block.memory_type;
+
+        VkResult result = vkAllocateMemory(interface_device, &allocate_info, nullptr, &block.memory);
+
+        switch(result){
+            case VK_SUCCESS:
+                //do nothing
+                break;
+            case VK_ERROR_OUT_OF_HOST_MEMORY:
+                throw std::runtime_error("Failure to allocate render graph memory. Host is out of memory.\n");
+                break;
+            case VK_ERROR_OUT_OF_DEVICE_MEMORY:
+                throw std::runtime_error("Failure to allocate render graph memory. Device is out of memory.\n");
+                break;
+            default:
+                throw std::runtime_error("Failed to allocate render graph memory.\n");
+                break;
+        }
+
+        aliased_size += block.size;
+
+        //Hand the memory over in pass order so every image knows who used it last
+        std::sort(block.resources.begin(), block.resources.end(), [&](CtRenderGraphResourceHandle a, CtRenderGraphResourceHandle b){
+            return resources[a].first_use < resources[b].first_use;
+        });
+
+        for(size_t i = 0; i < block.resources.size(); i++){
+            CtRenderGraphResource& resource = resources[block.resources[i]];
+
+            vkBindImageMemory(interface_device, resource.image, block.memory, 0);
+            resource.alias_predecessor = i > 0 ? block.resources[i - 1] : CT_RENDER_GRAPH_NONE;
+
+            VkImageViewCreateInfo view_info {};
+            view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            view_info.image = resource.image;
+            view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            view_info.format = resource.format;
+            view_info.subresourceRange.aspectMask = resource.aspect;
+            view_info.subresourceRange.baseMipLevel = 0;
+            view_info.subresourceRange.levelCount = 1;
+            view_info.subresourceRange.baseArrayLayer = 0;
+            view_info.subresourceRange.layerCount = 1;
+
+            if(vkCreateImageView(interface_device, &view_info, nullptr, &resource.image_view) != VK_SUCCESS){
+                throw std::runtime_error("Failed to create render graph image view " + resource.name + ".");
+            }
+        }
+    }
+
+    if(!images.empty()){
+        printf("Render graph placed %zu transient images in %zu allocations (%llu bytes, %llu without aliasing).\n", images.size(), memory_blocks.size(),
+            static_cast<unsigned long long>(aliased_size), static_cast<unsigned long long>(unaliased_size));
+    }
+}
+
+//Lazily allocated memory only makes sense for attachments that never leave the render pass. Not every device has it (most desktop GPUs don't),
+//so we fall back to plain device local memory
+uint32_t CtRenderGraph::FindTransientMemoryType(uint32_t type_filter, bool allow_lazy, bool& lazily_allocated){
+    lazily_allocated = false;
+
+    if(allow_lazy){
+        VkPhysicalDeviceMemoryProperties memory_properties;
+        vkGetPhysicalDeviceMemoryProperties(*(device->GetPhysicalDevice()), &memory_properties);
+
+        VkMemoryPropertyFlags lazy_properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+        for(uint32_t i = 0; i < memory_properties.memoryTypeCount; i++){
+            if((type_filter & (1u << i)) && (memory_properties.memoryTypes[i].propertyFlags & lazy_properties) == lazy_properties){
+                lazily_allocated = true;
+                return i;
+            }
+        }
+    }
+
+    return device->FindMemoryType(type_filter, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
+//Per resource we track the last write and every read since it. Writes and layout changes wait on all of that,
+//reads only wait on the last write and only for stages that haven't already been made to wait on it
+void CtRenderGraph::ComputeBarriers(){
+    struct ResourceState{
+        VkImageLayout layout;
+        VkPipelineStageFlags2 write_stage;
+        VkAccessFlags2 write_access;
+        VkPipelineStageFlags2 read_stage;
+        VkPipelineStageFlags2 visible_stage;
+        VkAccessFlags2 visible_access;
+        bool on_compute_queue;
+    };
+
+    std::vector<ResourceState> states(resources.size());
+    std::vector<bool> touched(resources.size(), false);
+
+    //Transient memory is shared by every frame in flight, so what the frame before did to it is still running when this one starts
+    std::vector<ResourceState> last_frame_states;
+
+    auto reset_states = [&](){
+        for(size_t i = 0; i < resources.size(); i++){
+            states[i] = {};
+            states[i].layout = resources[i].initial_layout;
+
+            //Whatever left an image in a real layout counts as a write we have to wait for
+            if(resources[i].initial_layout != VK_IMAGE_LAYOUT_UNDEFINED){
+                VkAccessFlags2 access;
+                GetLayoutSynchronization(resources[i].initial_layout, states[i].write_stage, access);
+                states[i].write_access = access & CT_RENDER_GRAPH_WRITE_ACCESS;
+            }
+        }
+
+        touched.assign(resources.size(), false);
+    };
+
+    auto transition = [&](CtRenderGraphResourceHandle handle, const CtRenderGraphAccessInfo& info, std::vector<CtRenderGraphBarrier>& barriers,
+        bool on_compute_queue){
+        ResourceState& state = states[handle];
+
+        //An aliased image starts out as whatever was last done to the memory under it, so its first barrier has to wait for that too.
+        //The first image in a block follows the last one from the frame before
+        if(!touched[handle]){
+            touched[handle] = true;
+
+            const CtRenderGraphResource& resource = resources[handle];
+            const ResourceState* previous = nullptr;
+            if(resource.alias_predecessor != CT_RENDER_GRAPH_NONE){
+                previous = &states[resource.alias_predecessor];
+            } else
+            if(resource.is_transient && resource.memory_block != CT_RENDER_GRAPH_NONE && !last_frame_states.empty()){
+                previous = &last_frame_states[memory_blocks[resource.memory_block].resources.back()];
+            }
+
+            if(previous != nullptr){
+                state.write_stage = previous->write_stage | previous->read_stage;
+                state.write_access = previous->write_access;
+                state.on_compute_queue = previous->on_compute_queue;
+            }
+        }
+
+        //Coming over from the other queue the semaphore has already waited on everything done there and made it visible. A barrier here
+        //couldn't name the other queue's stages anyway, so all that can be left is a layout change
+        if(state.on_compute_queue != on_compute_queue){
+            state.on_compute_queue = on_compute_queue;
+            state.write_stage = 0;
+            state.write_access = 0;
+            state.read_stage = 0;
+            state.visible_stage = 0;
+            state.visible_access = 0;
+        }
+        bool is_image = resources[handle].type == CT_RENDER_GRAPH_RESOURCE_IMAGE;
+        bool layout_change = is_image && info.layout != state.layout;
+
+        if(info.is_write || layout_change){
+            if(state.write_stage != 0 || state.read_stage != 0 || layout_change){
+                CtRenderGraphBarrier barrier {};
+                barrier.resource = handle;
+                barrier.source_stage = state.write_stage | state.read_stage;
+                barrier.source_access = state.write_access;
+                barrier.old_layout = state.layout;
+                barrier.destination_stage = info.stage;
+                barrier.destination_access = info.access;
+                barrier.new_layout = is_image ? info.layout : state.layout;
+
+                //Nothing in the frame touched it yet, but something outside might have (like the acquire semaphore waiting on
+                //the swapchain image). Waiting on the stage we're about to use keeps the transition chained behind that
+                if(barrier.source_stage == 0){
+                    barrier.source_stage = info.stage;
+                }
+
+                barriers.push_back(barrier);
+            }
+
+            if(is_image){
+                state.layout = info.layout;
+            }
+
+            //A layout transition behaves like a write that the barrier already made visible to this access
+            state.write_stage = info.stage;
+            state.write_access = info.is_write ? (info.access & CT_RENDER_GRAPH_WRITE_ACCESS) : 0;
+            state.read_stage = info.is_write ? 0 : info.stage;
+            state.visible_stage = info.is_write ? 0 : info.stage;
+            state.visible_access = info.is_write ? 0 : info.access;
+            return;
+        }
+
+        bool needs_visibility = (info.stage & ~state.visible_stage) != 0 || (info.access & ~state.visible_access) != 0;
+        if(state.write_stage != 0 && needs_visibility){
+            CtRenderGraphBarrier barrier {};
+            barrier.resource = handle;
+            barrier.source_stage = state.write_stage;
+            barrier.source_access = state.write_access;
+            barrier.old_layout = state.layout;
+            barrier.destination_stage = info.stage;
+            barrier.destination_access = info.access;
+            barrier.new_layout = state.layout;
+
+            barriers.push_back(barrier);
+
+            state.visible_stage |= info.stage;
+            state.visible_access |= info.access;
+        }
+
+        state.read_stage |= info.stage;
+    };
+
+    //Every frame does the same thing, so walking it once tells us how the frame before leaves each transient image. The second walk
+    //starts from there and its barriers are the ones we keep
+    for(uint32_t walk = 0; walk < 2; walk++){
+        reset_states();
+
+        for(CtRenderGraphPassHandle pass_handle : pass_order){
+            CtRenderGraphPass& pass = passes[pass_handle];
+            pass.barriers.clear();
+
+            //A pass might touch the same resource more than once, so fold those into one access first
+            std::map<CtRenderGraphResourceHandle, CtRenderGraphAccessInfo> merged;
+            for(const auto& use : pass.uses){
+                CtRenderGraphAccessInfo info = GetAccessInfo(use.access);
+
+                auto found = merged.find(use.resource);
+                if(found == merged.end()){
+                    merged[use.resource] = info;
+                    continue;
+                }
+
+                if(resources[use.resource].type == CT_RENDER_GRAPH_RESOURCE_IMAGE && found->second.layout != info.layout){
+                    throw std::runtime_error("Render graph pass uses an image in two different layouts.");
+                }
+
+                found->second.stage |= info.stage;
+                found->second.access |= info.access;
+                found->second.is_write = found->second.is_write || info.is_write;
+            }
+
+            for(const auto& entry : merged){
+                transition(entry.first, entry.second, pass.barriers, pass.on_compute_queue);
+            }
+        }
+
+        //Outputs end up wherever they were asked to, and anything that has to survive into the next frame goes back to where it started
+        final_barriers.clear();
+        for(size_t i = 0; i < resources.size(); i++){
+            CtRenderGraphResourceHandle handle = static_cast<CtRenderGraphResourceHandle>(i);
+
+            if(resources[i].is_output){
+                transition(handle, GetAccessInfo(resources[i].final_access), final_barriers, false);
+            } else
+            if(resources[i].type == CT_RENDER_GRAPH_RESOURCE_IMAGE && resources[i].initial_layout != VK_IMAGE_LAYOUT_UNDEFINED &&
+                states[i].layout != resources[i].initial_layout){
+                CtRenderGraphAccessInfo info {};
+                GetLayoutSynchronization(resources[i].initial_layout, info.stage, info.access);
+                info.layout = resources[i].initial_layout;
+                info.is_write = false;
+
+                transition(handle, info, final_barriers, false);
+            }
+        }
+
+        if(walk == 0){
+            last_frame_states = states;
+        }
+    }
+}
+
+//Render passes only need to match formats to be compatible, so we can give each raster pass exactly the load and store ops
+//it needs. Layouts never change inside the render pass, the barriers in front of it already did that.
+//With dynamic rendering we keep the same attachment info but skip the render pass object entirely
+void CtRenderGraph::CreateRenderPasses(){
+    for(size_t position = 0; position < pass_order.size(); position++){
+        CtRenderGraphPass& pass = passes[pass_order[position]];
+
+        if(pass.type != CT_RENDER_GRAPH_PASS_RASTER){
+            continue;
+        }
+
+        auto has_contents = [&](CtRenderGraphResourceHandle resource){
+            if(resources[resource].initial_layout != VK_IMAGE_LAYOUT_UNDEFINED){
+                return true;
+            }
+            for(size_t i = 0; i < position; i++){
+                if(PassWrites(passes[pass_order[i]], resource)){
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        auto contents_needed_later = [&](CtRenderGraphResourceHandle resource){
+            if(resources[resource].is_output || resources[resource].initial_layout != VK_IMAGE_LAYOUT_UNDEFINED){
+                return true;
+            }
+            for(size_t i = position + 1; i < pass_order.size(); i++){
+                if(PassReads(passes[pass_order[i]], resource)){
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        std::vector<CtRenderGraphAttachment> color_attachments;
+        for(size_t i = 0; i < pass.color_attachments.size(); i++){
+            CtRenderGraphResourceHandle resource = pass.color_attachments[i];
+
+            CtRenderGraphAttachment attachment {};
+            attachment.format = resources[resource].format;
+            attachment.layout = GetAccessInfo(CT_RENDER_GRAPH_ACCESS_COLOR_ATTACHMENT).layout;
+            attachment.load_op = pass.color_clears[i] ? VK_ATTACHMENT_LOAD_OP_CLEAR :
+                (has_contents(resource) ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE);
+            attachment.store_op = contents_needed_later(resource) ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+            color_attachments.push_back(attachment);
+        }
+
+        CtRenderGraphAttachment depth_attachment {};
+        if(pass.has_depth_attachment){
+            CtRenderGraphResourceHandle resource = pass.depth_attachment;
+
+            depth_attachment.format = resources[resource].format;
+            depth_attachment.layout = GetAccessInfo(CT_RENDER_GRAPH_ACCESS_DEPTH_ATTACHMENT).layout;
+            depth_attachment.load_op = pass.depth_clears ? VK_ATTACHMENT_LOAD_OP_CLEAR :
+                (has_contents(resource) ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE);
+            depth_attachment.store_op = contents_needed_later(resource) ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        }
+
+        pass.color_attachment_info = color_attachments;
+        pass.depth_attachment_info = depth_attachment;
+
+        if(!device->GetOptionalFeatures().dynamic_rendering){
+            pass.render_pass = CreateRenderPass(device, color_attachments, pass.has_depth_attachment ? &depth_attachment : nullptr);
+        }
+    }
+}
+
+VkRenderPass CtRenderGraph::CreateRenderPass(CtDevice* device, const std::vector<CtRenderGraphAttachment>& color_attachments, const CtRenderGraphAttachment* depth_attachment){
+    std::vector<VkAttachmentDescription> descriptions;
+    std::vector<VkAttachmentReference> color_references;
+    VkAttachmentReference depth_reference {};
+
+    for(const auto& attachment : color_attachments){
+        VkAttachmentDescription description {};
+        description.format = attachment.format;
+        description.samples = VK_SAMPLE_COUNT_1_BIT;
+        description.loadOp = attachment.load_op;
+        description.storeOp = attachment.store_op;
+        description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        description.initialLayout = attachment.layout;
+        description.finalLayout = attachment.layout;
+
+        VkAttachmentReference reference {};
+        reference.attachment = static_cast<uint32_t>(descriptions.size());
+        reference.layout = attachment.layout;
+
+        descriptions.push_back(description);
+        color_references.push_back(reference);
+    }
+
+    if(depth_attachment != nullptr){
+        VkAttachmentDescription description {};
+        description.format = depth_attachment->format;
+        description.samples = VK_SAMPLE_COUNT_1_BIT;
+        description.loadOp = depth_attachment->load_op;
+        description.storeOp = depth_attachment->store_op;
+        description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        description.initialLayout = depth_attachment->layout;
+        description.finalLayout = depth_attachment->layout;
+
+        depth_reference.attachment = static_cast<uint32_t>(descriptions.size());
+        depth_reference.layout = depth_attachment->layout;
+
+        descriptions.push_back(description);
+    }
+
+    VkSubpassDescription subpass {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = static_cast<uint32_t>(color_references.size());
+    subpass.pColorAttachments = color_references.data();
+    subpass.pDepthStencilAttachment = depth_attachment != nullptr ? &depth_reference : nullptr;
+
+    VkRenderPassCreateInfo render_pass_info {};
+    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    render_pass_info.attachmentCount = static_cast<uint32_t>(descriptions.size());
+    render_pass_info.pAttachments = descriptions.data();
+    render_pass_info.subpassCount = 1;
+    render_pass_info.pSubpasses = &subpass;
+    render_pass_info.dependencyCount = 0;
+    render_pass_info.pDependencies = nullptr;
+
+    VkRenderPass render_pass;
+    if(vkCreateRenderPass(*(device->GetInterfaceDevice()), &render_pass_info, nullptr, &render_pass) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create render pass!");
+    }
+
+    return render_pass;
+}
+
+/******************************************************EXECUTE**********************************************************************/
+
+void CtRenderGraph::Execute(VkCommandBuffer command_buffer){
+    if(compiled && submissions.size() != 1){
+        throw std::runtime_error("Render graph runs on more than one queue. Record it with ExecuteSubmission instead.");
+    }
+
+    ExecuteSubmission(0, command_buffer);
+}
+
+void CtRenderGraph::ExecuteSubmission(uint32_t submission, VkCommandBuffer command_buffer){
+    if(!compiled){
+        throw std::runtime_error("Render graph has to be compiled before it is executed.");
+    }
+
+    for(CtRenderGraphPassHandle pass_handle : submissions[submission].passes){
+        CtRenderGraphPass& pass = passes[pass_handle];
+
+        RecordBarriers(command_buffer, pass.barriers);
+
+        if(pass.type == CT_RENDER_GRAPH_PASS_RASTER){
+            if(device->GetOptionalFeatures().dynamic_rendering){
+                BeginDynamicRendering(command_buffer, pass);
+            } else {
+                BeginRasterPass(command_buffer, pass);
+            }
+        }
+
+        if(pass.execute){
+            pass.execute(command_buffer);
+        }
+
+        if(pass.type == CT_RENDER_GRAPH_PASS_RASTER){
+            EndRasterPass(command_buffer);
+        }
+    }
+
+    if(submission == submissions.size() - 1){
+        RecordBarriers(command_buffer, final_barriers);
+    }
+}
+
+//Each submission signals its own value on its queue's timeline and waits on the value of the one it depends on from the other queue.
+//The two queues share images and buffers from one frame to the next, so compute also waits for the end of last frame, and the
+//first graphics submission waits for last frame's compute work. Nothing in the frame after it is ordered behind that otherwise
+void CtRenderGraph::Submit(const std::vector<VkCommandBuffer>& command_buffers, VkSemaphore wait_semaphore, VkPipelineStageFlags wait_stage,
+    VkSemaphore signal_semaphore, VkFence fence){
+
+    if(command_buffers.size() != submissions.size()){
+        throw std::runtime_error("Render graph needs one command buffer per submission.");
+    }
+
+    VkQueue graphics_queue = device->queue_family->graphics_queue;
+    VkQueue compute_queue = device->queue_family->compute_queue;
+
+    uint64_t frame_base = timeline_value;
+    uint64_t compute_value = 0;
+    bool waited_on_semaphore = false;
+    bool waited_on_last_frame = false;
+
+    for(uint32_t i = 0; i < submissions.size(); i++){
+        const CtRenderGraphSubmission& submission = submissions[i];
+        bool is_last = i == submissions.size() - 1;
+
+        std::vector<VkSemaphore> wait_semaphores;
+        std::vector<uint64_t> wait_values;
+        std::vector<VkPipelineStageFlags> wait_stages;
+        std::vector<VkSemaphore> signal_semaphores;
+        std::vector<uint64_t> signal_values;
+
+        if(!submission.on_compute_queue && !waited_on_semaphore && wait_semaphore != VK_NULL_HANDLE){
+            wait_semaphores.push_back(wait_semaphore);
+            wait_values.push_back(0);
+            wait_stages.push_back(wait_stage);
+            waited_on_semaphore = true;
+        }
+
+        if(graphics_timeline != VK_NULL_HANDLE){
+            uint64_t other_value = 0;
+            if(submission.wait_submission != CT_RENDER_GRAPH_NONE){
+                other_value = frame_base + submission.wait_submission + 1;
+            }
+            if(submission.on_compute_queue && frame_base > other_value){
+                other_value = frame_base;
+            }
+            if(!submission.on_compute_queue && !waited_on_last_frame){
+                other_value = std::max(other_value, last_compute_value);
+                waited_on_last_frame = true;
+            }
+
+            if(other_value > 0){
+                wait_semaphores.push_back(submission.on_compute_queue ? graphics_timeline : compute_timeline);
+                wait_values.push_back(other_value);
+                wait_stages.push_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+            }
+
+            signal_semaphores.push_back(submission.on_compute_queue ? compute_timeline : graphics_timeline);
+            signal_values.push_back(frame_base + i + 1);
+
+            if(submission.on_compute_queue){
+                compute_value = frame_base + i + 1;
+            }
+        }
+
+        if(is_last && signal_semaphore != VK_NULL_HANDLE){
+            signal_semaphores.push_back(signal_semaphore);
+            signal_values.push_back(0);
+        }
+
+        //Binary semaphores ignore their values, they just need a slot so the arrays line up
+        VkTimelineSemaphoreSubmitInfo timeline_info {};
+        timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timeline_info.waitSemaphoreValueCount = static_cast<uint32_t>(wait_values.size());
+        timeline_info.pWaitSemaphoreValues = wait_values.data();
+        timeline_info.signalSemaphoreValueCount = static_cast<uint32_t>(signal_values.size());
+        timeline_info.pSignalSemaphoreValues = signal_values.data();
+
+        VkSubmitInfo submit_info {};
+        submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.pNext = graphics_timeline != VK_NULL_HANDLE ? &timeline_info : nullptr;
+        submit_info.waitSemaphoreCount = static_cast<uint32_t>(wait_semaphores.size());
+        submit_info.pWaitSemaphores = wait_semaphores.data();
+        submit_info.pWaitDstStageMask = wait_stages.data();
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers = &command_buffers[i];
+        submit_info.signalSemaphoreCount = static_cast<uint32_t>(signal_semaphores.size());
+        submit_info.pSignalSemaphores = signal_semaphores.data();
+
+        VkResult result = vkQueueSubmit(submission.on_compute_queue ? compute_queue : graphics_queue, 1, &submit_info, is_last ? fence : VK_NULL_HANDLE);
+
+        switch(result){
+            case VK_SUCCESS:
+                break;
+            case VK_ERROR_OUT_OF_HOST_MEMORY:
+                throw std::runtime_error("Failed to submit the render graph. Host is out of memory.\n");
+            case VK_ERROR_OUT_OF_DEVICE_MEMORY:
+                throw std::runtime_error("Failed to submit the render graph. Device is out of memory.\n");
+            case VK_ERROR_DEVICE_LOST:
+                throw std::runtime_error("Failed to submit the render graph. Device was lost.\n");
+            default:
+                throw std::runtime_error("Failed to submit the render graph.\n");
+        }
+    }
+
+    timeline_value = frame_base + submissions.size();
+    if(compute_value > 0){
+        last_compute_value = compute_value;
+    }
+}
+
+//Everything a pass needs gets merged into a single vkCmdPipelineBarrier
+void CtRenderGraph::RecordBarriers(VkCommandBuffer command_buffer, const std::vector<CtRenderGraphBarrier>& barriers){
+    CtBarrierBatch batch(device);
+
+    for(const auto& barrier : barriers){
+        const CtRenderGraphResource& resource = resources[barrier.resource];
+
+        if(resource.type == CT_RENDER_GRAPH_RESOURCE_IMAGE){
+            VkImageSubresourceRange range {};
+            range.aspectMask = resource.aspect;
+            range.baseMipLevel = 0;
+            range.levelCount = VK_REMAINING_MIP_LEVELS;
+            range.baseArrayLayer = 0;
+            range.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+            batch.AddImageBarrier(resource.image, range,
+                barrier.source_stage, barrier.source_access, barrier.old_layout,
+                barrier.destination_stage, barrier.destination_access, barrier.new_layout);
+        } else {
+            batch.AddBufferBarrier(resource.buffer, 0, VK_WHOLE_SIZE,
+                barrier.source_stage, barrier.source_access,
+                barrier.destination_stage, barrier.destination_access);
+        }
+    }
+
+    batch.Flush(command_buffer);
+}
+
+VkExtent2D CtRenderGraph::GetRenderArea(const CtRenderGraphPass& pass){
+    if(!pass.color_attachments.empty()){
+        return resources[pass.color_attachments[0]].extent;
+    }
+
+    return resources[pass.depth_attachment].extent;
+}
+
+void CtRenderGraph::BeginRasterPass(VkCommandBuffer command_buffer, CtRenderGraphPass& pass){
+    VkExtent2D extent = GetRenderArea(pass);
+
+    std::vector<VkClearValue> clear_values = pass.color_clear_values;
+    if(pass.has_depth_attachment){
+        clear_values.push_back(pass.depth_clear_value);
+    }
+
+    VkRenderPassBeginInfo render_pass_info {};
+    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    render_pass_info.renderPass = pass.render_pass;
+    render_pass_info.framebuffer = GetFramebuffer(static_cast<CtRenderGraphPassHandle>(&pass - passes.data()));
+    render_pass_info.renderArea.offset = {0, 0};
+    render_pass_info.renderArea.extent = extent;
+    render_pass_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
+    render_pass_info.pClearValues = clear_values.data();
+
+    vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+
+    SetViewportAndScissor(command_buffer, extent);
+}
+
+//Same attachments, load and store ops as the render pass path, just handed straight to the command buffer. No framebuffer to build or cache
+void CtRenderGraph::BeginDynamicRendering(VkCommandBuffer command_buffer, CtRenderGraphPass& pass){
+    VkExtent2D extent = GetRenderArea(pass);
+
+    std::vector<VkRenderingAttachmentInfo> color_attachments;
+    for(size_t i = 0; i < pass.color_attachments.size(); i++){
+        VkRenderingAttachmentInfo attachment {};
+        attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        attachment.imageView = resources[pass.color_attachments[i]].image_view;
+        attachment.imageLayout = pass.color_attachment_info[i].layout;
+        attachment.loadOp = pass.color_attachment_info[i].load_op;
+        attachment.storeOp = pass.color_attachment_info[i].store_op;
+        attachment.clearValue = pass.color_clear_values[i];
+
+        color_attachments.push_back(attachment);
+    }
+
+    VkRenderingAttachmentInfo depth_attachment {};
+    if(pass.has_depth_attachment){
+        depth_attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        depth_attachment.imageView = resources[pass.depth_attachment].image_view;
+        depth_attachment.imageLayout = pass.depth_attachment_info.layout;
+        depth_attachment.loadOp = pass.depth_attachment_info.load_op;
+        depth_attachment.storeOp = pass.depth_attachment_info.store_op;
+        depth_attachment.clearValue = pass.depth_clear_value;
+    }
+
+    VkRenderingInfo rendering_info {};
+    rendering_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+    rendering_info.renderArea.offset = {0, 0};
+    rendering_info.renderArea.extent = extent;
+    rendering_info.layerCount = 1;
+    rendering_info.colorAttachmentCount = static_cast<uint32_t>(color_attachments.size());
+    rendering_info.pColorAttachments = color_attachments.data();
+    rendering_info.pDepthAttachment = pass.has_depth_attachment ? &depth_attachment : nullptr;
+
+    device->CmdBeginRendering(command_buffer, &rendering_info);
+
+    SetViewportAndScissor(command_buffer, extent);
+}
+
+void CtRenderGraph::EndRasterPass(VkCommandBuffer command_buffer){
+    if(device->GetOptionalFeatures().dynamic_rendering){
+        device->CmdEndRendering(command_buffer);
+    } else {
+        vkCmdEndRenderPass(command_buffer);
+    }
+}
+
+//Every raster pass wants these to cover its attachments, so we might as well do it here
+void CtRenderGraph::SetViewportAndScissor(VkCommandBuffer command_buffer, VkExtent2D extent){
+    VkViewport viewport {};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = static_cast<float>(extent.width);
+    viewport.height = static_cast<float>(extent.height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+
+    VkRect2D scissor {};
+    scissor.offset = {0, 0};
+    scissor.extent = extent;
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+}
+
+VkFramebuffer CtRenderGraph::GetFramebuffer(CtRenderGraphPassHandle pass_handle){
+    CtRenderGraphPass& pass = passes[pass_handle];
+
+    std::vector<VkImageView> attachments;
+    for(CtRenderGraphResourceHandle resource : pass.color_attachments){
+        attachments.push_back(resources[resource].image_view);
+    }
+    if(pass.has_depth_attachment){
+        attachments.push_back(resources[pass.depth_attachment].image_view);
+    }
+
+    std::vector<uint64_t> key;
+    key.push_back(pass_handle);
+    for(VkImageView view : attachments){
+        key.push_back(reinterpret_cast<uint64_t>(view));
+    }
+
+    auto found = framebuffer_cache.find(key);
+    if(found != framebuffer_cache.end()){
+        return found->second;
+    }
+
+    VkExtent2D extent = GetRenderArea(pass);
+
+    VkFramebufferCreateInfo framebuffer_info {};
+    framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebuffer_info.renderPass = pass.render_pass;
+    framebuffer_info.attachmentCount = static_cast<uint32_t>(attachments.size());
+    framebuffer_info.pAttachments = attachments.data();
+    framebuffer_info.width = extent.width;
+    framebuffer_info.height = extent.height;
+    framebuffer_info.layers = 1;
+
+    VkFramebuffer framebuffer;
+    if(vkCreateFramebuffer(*(device->GetInterfaceDevice()), &framebuffer_info, nullptr, &framebuffer) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create a frame buffer");
+    }
+
+    framebuffer_cache[key] = framebuffer;
+    return framebuffer;
+}
+
+//Only safe once the GPU is done with every frame that used the graph
+void CtRenderGraph::Destroy(){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    for(auto& entry : framebuffer_cache){
+        vkDestroyFramebuffer(interface_device, entry.second, nullptr);
+    }
+    framebuffer_cache.clear();
+
+    DestroyTransientResources();
+
+    if(graphics_timeline != VK_NULL_HANDLE){
+        vkDestroySemaphore(interface_device, graphics_timeline, nullptr);
+        vkDestroySemaphore(interface_device, compute_timeline, nullptr);
+        graphics_timeline = VK_NULL_HANDLE;
+        compute_timeline = VK_NULL_HANDLE;
+    }
+    submissions.clear();
+
+    for(auto& pass : passes){
+        if(pass.render_pass != VK_NULL_HANDLE){
+            vkDestroyRenderPass(interface_device, pass.render_pass, nullptr);
+            pass.render_pass = VK_NULL_HANDLE;
+        }
+    }
+
+    compiled = false;
+}
+
+void CtRenderGraph::DestroyTransientResources(){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    for(auto& resource : resources){
+        if(!resource.is_transient){
+            continue;
+        }
+
+        if(resource.image_view != VK_NULL_HANDLE){
+            vkDestroyImageView(interface_device, resource.image_view, nullptr);
+            resource.image_view = VK_NULL_HANDLE;
+        }
+        if(resource.image != VK_NULL_HANDLE){
+            vkDestroyImage(interface_device, resource.image, nullptr);
+            resource.image = VK_NULL_HANDLE;
+        }
+    }
+
+    for(auto& block : memory_blocks){
+        vkFreeMemory(interface_device, block.memory, nullptr);
+    }
+    memory_blocks.clear();
+}
+
+/******************************************************ACCESS TABLES**********************************************************************/
+
+CtRenderGraphAccessInfo CtRenderGraph::GetAccessInfo(CtRenderGraphAccess access){
+    CtRenderGraphAccessInfo info {};
+
+    switch(access){
+        case CT_RENDER_GRAPH_ACCESS_COLOR_ATTACHMENT:
+            info.stage = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+            info.access = VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+            info.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            info.is_write = true;
+            break;
+        case CT_RENDER_GRAPH_ACCESS_DEPTH_ATTACHMENT:
+            info.stage = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+            info.access = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            info.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            info.is_write = true;
+            break;
+        case CT_RENDER_GRAPH_ACCESS_DEPTH_ATTACHMENT_READ_ONLY:
+            info.stage = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+            info.access = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+            info.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+            info.is_write = false;
+            break;
+        case CT_RENDER_GRAPH_ACCESS_FRAGMENT_SAMPLED:
+            info.stage = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+            info.access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+            info.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            info.is_write = false;
+            break;
+        case CT_RENDER_GRAPH_ACCESS_COMPUTE_SAMPLED:
+            info.stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+            info.access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+            info.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            info.is_write = false;
+            break;
+        case CT_RENDER_GRAPH_ACCESS_COMPUTE_STORAGE_READ:
+            info.stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+            info.access = VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+            info.layout = VK_IMAGE_LAYOUT_GENERAL;
+            info.is_write = false;
+            break;
+        case CT_RENDER_GRAPH_ACCESS_COMPUTE_STORAGE_WRITE:
+            info.stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+            info.access = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+            info.layout = VK_IMAGE_LAYOUT_GENERAL;
+            info.is_write = true;
+            break;
+        case CT_RENDER_GRAPH_ACCESS_VERTEX_SHADER_STORAGE_READ:
+            info.stage = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT;
+            info.access = VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+            info.layout = VK_IMAGE_LAYOUT_GENERAL;
+            info.is_write = false;
+            break;
+        case CT_RENDER_GRAPH_ACCESS_UNIFORM_READ:
+            info.stage = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+            info.access = VK_ACCESS_2_UNIFORM_READ_BIT;
+            info.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            info.is_write = false;
+            break;
+        case CT_RENDER_GRAPH_ACCESS_INDIRECT_READ:
+            info.stage = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT;
+            info.access = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT;
+            info.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            info.is_write = false;
+            break;
+        case CT_RENDER_GRAPH_ACCESS_VERTEX_BUFFER_READ:
+            info.stage = VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT;
+            info.access = VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT;
+            info.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            info.is_write = false;
+            break;
+        case CT_RENDER_GRAPH_ACCESS_INDEX_BUFFER_READ:
+            info.stage = VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT;
+            info.access = VK_ACCESS_2_INDEX_READ_BIT;
+            info.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            info.is_write = false;
+            break;
+        case CT_RENDER_GRAPH_ACCESS_TRANSFER_READ:
+            info.stage = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+            info.access = VK_ACCESS_2_TRANSFER_READ_BIT;
+            info.layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            info.is_write = false;
+            break;
+        case CT_RENDER_GRAPH_ACCESS_TRANSFER_WRITE:
+            info.stage = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+            info.access = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+            info.layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            info.is_write = true;
+            break;
+        case CT_RENDER_GRAPH_ACCESS_PRESENT:
+            info.stage = VK_PIPELINE_STAGE_2_NONE;
+            info.access = VK_ACCESS_2_NONE;
+            info.layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+            info.is_write = false;
+            break;
+        default:
+            throw std::runtime_error("Unknown render graph access.");
+    }
+
+    return info;
+}
+
+//The stages and accesses that can touch an image while it sits in a layout. Used whenever we only know the layouts
+//on either side of a transition, so it leans conservative instead of throwing on layouts it doesn't expect
+void CtRenderGraph::GetLayoutSynchronization(VkImageLayout layout, VkPipelineStageFlags2& stage, VkAccessFlags2& access){
+    switch(layout){
+        case VK_IMAGE_LAYOUT_UNDEFINED:
+            stage = VK_PIPELINE_STAGE_2_NONE;
+            access = VK_ACCESS_2_NONE;
+            break;
+        case VK_IMAGE_LAYOUT_PREINITIALIZED:
+            stage = VK_PIPELINE_STAGE_2_HOST_BIT;
+            access = VK_ACCESS_2_HOST_WRITE_BIT;
+            break;
+        case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+            stage = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+            access = VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+            break;
+        case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+            stage = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+            access = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            break;
+        case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+            stage = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT |
+                VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+            access = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+            break;
+        case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+            stage = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+            access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+            break;
+        case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+            stage = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+            access = VK_ACCESS_2_TRANSFER_READ_BIT;
+            break;
+        case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+            stage = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+            access = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+            break;
+        case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
+            stage = VK_PIPELINE_STAGE_2_NONE;
+            access = VK_ACCESS_2_NONE;
+            break;
+        default:
+            stage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+            access = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+            break;
+    }
+}
+
+VkImageUsageFlags CtRenderGraph::GetImageUsage(CtRenderGraphAccess access){
+    switch(access){
+        case CT_RENDER_GRAPH_ACCESS_COLOR_ATTACHMENT:
+            return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        case CT_RENDER_GRAPH_ACCESS_DEPTH_ATTACHMENT:
+        case CT_RENDER_GRAPH_ACCESS_DEPTH_ATTACHMENT_READ_ONLY:
+            return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        case CT_RENDER_GRAPH_ACCESS_FRAGMENT_SAMPLED:
+        case CT_RENDER_GRAPH_ACCESS_COMPUTE_SAMPLED:
+            return VK_IMAGE_USAGE_SAMPLED_BIT;
+        case CT_RENDER_GRAPH_ACCESS_COMPUTE_STORAGE_READ:
+        case CT_RENDER_GRAPH_ACCESS_COMPUTE_STORAGE_WRITE:
+        case CT_RENDER_GRAPH_ACCESS_VERTEX_SHADER_STORAGE_READ:
+            return VK_IMAGE_USAGE_STORAGE_BIT;
+        case CT_RENDER_GRAPH_ACCESS_TRANSFER_READ:
+            return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        case CT_RENDER_GRAPH_ACCESS_TRANSFER_WRITE:
+            return VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        default:
+            return 0;
+    }
+}
+
+VkImageAspectFlags CtRenderGraph::GetAspectFromFormat(VkFormat format){
+    switch(format){
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_X8_D24_UNORM_PACK32:
+        case VK_FORMAT_D32_SFLOAT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT;
+        case VK_FORMAT_S8_UINT:
+            return VK_IMAGE_ASPECT_STENCIL_BIT;
+        case VK_FORMAT_D16_UNORM_S8_UINT:
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+        default:
+            return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+}
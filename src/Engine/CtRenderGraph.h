@@ -0,0 +1,275 @@
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+#include <map>
+#include <functional>
+#include <cstdint>
+
+class CtDevice;
+
+typedef uint32_t CtRenderGraphResourceHandle;
+typedef uint32_t CtRenderGraphPassHandle;
+
+const uint32_t CT_RENDER_GRAPH_NONE = UINT32_MAX;
+
+//What kind of work a pass does. Raster passes get their attachments bound for them
+enum CtRenderGraphPassType{
+    CT_RENDER_GRAPH_PASS_RASTER,
+    CT_RENDER_GRAPH_PASS_COMPUTE,
+    CT_RENDER_GRAPH_PASS_TRANSFER
+};
+
+enum CtRenderGraphResourceType{
+    CT_RENDER_GRAPH_RESOURCE_IMAGE,
+    CT_RENDER_GRAPH_RESOURCE_BUFFER
+};
+
+//Every way a pass can touch a resource. Each one maps onto a fixed stage, access mask and (for images) layout,
+//which is what lets the graph work out barriers on its own instead of us writing them by hand
+enum CtRenderGraphAccess{
+    CT_RENDER_GRAPH_ACCESS_COLOR_ATTACHMENT,
+    CT_RENDER_GRAPH_ACCESS_DEPTH_ATTACHMENT,
+    CT_RENDER_GRAPH_ACCESS_DEPTH_ATTACHMENT_READ_ONLY,
+    CT_RENDER_GRAPH_ACCESS_FRAGMENT_SAMPLED,
+    CT_RENDER_GRAPH_ACCESS_COMPUTE_SAMPLED,
+    CT_RENDER_GRAPH_ACCESS_COMPUTE_STORAGE_READ,
+    CT_RENDER_GRAPH_ACCESS_COMPUTE_STORAGE_WRITE,
+    CT_RENDER_GRAPH_ACCESS_VERTEX_SHADER_STORAGE_READ,
+    CT_RENDER_GRAPH_ACCESS_UNIFORM_READ,
+    CT_RENDER_GRAPH_ACCESS_INDIRECT_READ,
+    CT_RENDER_GRAPH_ACCESS_VERTEX_BUFFER_READ,
+    CT_RENDER_GRAPH_ACCESS_INDEX_BUFFER_READ,
+    CT_RENDER_GRAPH_ACCESS_TRANSFER_READ,
+    CT_RENDER_GRAPH_ACCESS_TRANSFER_WRITE,
+    CT_RENDER_GRAPH_ACCESS_PRESENT
+};
+
+//The synchronization side of an access, in synchronization2 terms so the stages and accesses can be exact
+struct CtRenderGraphAccessInfo{
+    VkPipelineStageFlags2 stage;
+    VkAccessFlags2 access;
+    VkImageLayout layout;
+    bool is_write;
+};
+
+//What we need to know to build a render pass attachment
+struct CtRenderGraphAttachment{
+    VkFormat format;
+    VkAttachmentLoadOp load_op;
+    VkAttachmentStoreOp store_op;
+    VkImageLayout layout;
+};
+
+struct CtRenderGraphResource{
+    std::string name;
+    CtRenderGraphResourceType type;
+
+    //Images
+    VkImage image;
+    VkImageView image_view;
+    VkFormat format;
+    VkExtent2D extent;
+    VkImageAspectFlags aspect;
+
+    //Buffers
+    VkBuffer buffer;
+    VkDeviceSize size;
+
+    //What layout the resource is in when the frame starts. UNDEFINED means we don't care about what was in it
+    VkImageLayout initial_layout;
+
+    //Outputs are kept alive by culling and get moved into final_access once every pass is done
+    bool is_output;
+    CtRenderGraphAccess final_access;
+
+    //Transient images are owned by the graph and only live between the first and last pass that touches them.
+    //Two transients whose lifetimes don't overlap can share the same memory block
+    bool is_transient;
+    VkImageUsageFlags usage;
+    uint32_t first_use;
+    uint32_t last_use;
+    uint32_t memory_block;
+    CtRenderGraphResourceHandle alias_predecessor; //Whoever had the memory right before us, so we wait on it
+
+    //Touched from the compute queue too. These are made CONCURRENT and never alias, pass order says nothing about
+    //when two queues are done with something
+    bool shared_queues;
+};
+
+//One allocation shared by every transient image placed in it
+struct CtRenderGraphMemoryBlock{
+    VkDeviceMemory memory;
+    VkDeviceSize size;
+    uint32_t memory_type;
+    bool lazily_allocated; //Tile based GPUs might never back these with real memory at all
+    std::vector<CtRenderGraphResourceHandle> resources;
+};
+
+struct CtRenderGraphResourceUse{
+    CtRenderGraphResourceHandle resource;
+    CtRenderGraphAccess access;
+};
+
+//One transition or dependency for one resource, resolved into a real barrier when we record
+struct CtRenderGraphBarrier{
+    CtRenderGraphResourceHandle resource;
+    VkPipelineStageFlags2 source_stage;
+    VkAccessFlags2 source_access;
+    VkImageLayout old_layout;
+    VkPipelineStageFlags2 destination_stage;
+    VkAccessFlags2 destination_access;
+    VkImageLayout new_layout;
+};
+
+struct CtRenderGraphPass{
+    std::string name;
+    CtRenderGraphPassType type;
+
+    std::vector<CtRenderGraphResourceUse> uses;
+
+    //Attachments for raster passes, in the order the shaders see them
+    std::vector<CtRenderGraphResourceHandle> color_attachments;
+    std::vector<VkClearValue> color_clear_values;
+    std::vector<bool> color_clears;
+    CtRenderGraphResourceHandle depth_attachment;
+    VkClearValue depth_clear_value;
+    bool has_depth_attachment;
+    bool depth_clears;
+
+    //Passes that write to things outside the graph (readbacks, queries) can't be culled
+    bool has_side_effects;
+
+    //Asked to run on the compute queue. Only compute passes can be, and it only happens when the device has async compute
+    bool async_compute;
+
+    std::function<void(VkCommandBuffer)> execute;
+
+    //Filled in by Compile. With dynamic rendering there is no render pass, we just begin rendering with the attachment info
+    bool culled;
+    bool on_compute_queue;
+    std::vector<CtRenderGraphPassHandle> dependencies;
+    std::vector<CtRenderGraphBarrier> barriers;
+    std::vector<CtRenderGraphAttachment> color_attachment_info;
+    CtRenderGraphAttachment depth_attachment_info;
+    VkRenderPass render_pass;
+};
+
+//A run of passes in a row that go to the same queue, which is one vkQueueSubmit. The only cross queue wait a submission needs
+//is on the latest submission it depends on from the other queue, the timeline semaphore covers everything before that
+struct CtRenderGraphSubmission{
+    bool on_compute_queue;
+    std::vector<CtRenderGraphPassHandle> passes;
+    uint32_t wait_submission;
+};
+
+//A frame described as a set of passes that declare what they read and write. From that the graph culls passes nobody
+//needs, picks an order, and puts one merged barrier in front of each pass that only covers what actually changed.
+//Images and buffers are handed to the graph as handles, so imported resources (like the swapchain image) can be swapped out every frame
+class CtRenderGraph{
+
+    public:
+        static CtRenderGraph* CreateRenderGraph(CtDevice* device);
+
+        //Resources
+        CtRenderGraphResourceHandle ImportImage(const std::string& name, VkImage image, VkImageView image_view, VkFormat format, VkExtent2D extent, VkImageLayout initial_layout);
+        CtRenderGraphResourceHandle CreateImage(const std::string& name, VkFormat format, VkExtent2D extent);
+        CtRenderGraphResourceHandle ImportBuffer(const std::string& name, VkBuffer buffer, VkDeviceSize size);
+        void SetImportedImage(CtRenderGraphResourceHandle resource, VkImage image, VkImageView image_view);
+        void SetImportedBuffer(CtRenderGraphResourceHandle resource, VkBuffer buffer);
+        void MarkOutput(CtRenderGraphResourceHandle resource, CtRenderGraphAccess final_access);
+
+        //Passes
+        CtRenderGraphPassHandle AddPass(const std::string& name, CtRenderGraphPassType type);
+        void Read(CtRenderGraphPassHandle pass, CtRenderGraphResourceHandle resource, CtRenderGraphAccess access);
+        void Write(CtRenderGraphPassHandle pass, CtRenderGraphResourceHandle resource, CtRenderGraphAccess access);
+        void WriteColorAttachment(CtRenderGraphPassHandle pass, CtRenderGraphResourceHandle resource, const VkClearColorValue* clear_value);
+        void WriteDepthAttachment(CtRenderGraphPassHandle pass, CtRenderGraphResourceHandle resource, const VkClearDepthStencilValue* clear_value);
+        void SetSideEffects(CtRenderGraphPassHandle pass);
+        void SetAsyncCompute(CtRenderGraphPassHandle pass);
+        void SetPassExecute(CtRenderGraphPassHandle pass, std::function<void(VkCommandBuffer)> execute);
+
+        void Compile();
+        void Destroy();
+
+        //Only for graphs that compiled down to a single submission, which is every graph without async compute
+        void Execute(VkCommandBuffer command_buffer);
+
+        //With async compute the frame is split across the two queues. Record each submission into a command buffer from a pool on
+        //its queue's family, then hand them all to Submit in the same order. The first graphics submission waits on wait_semaphore,
+        //the last one signals signal_semaphore and the fence, and by then both queues are done with the frame
+        uint32_t GetSubmissionCount(){
+            return static_cast<uint32_t>(submissions.size());
+        }
+        bool IsComputeSubmission(uint32_t submission){
+            return submissions[submission].on_compute_queue;
+        }
+        void ExecuteSubmission(uint32_t submission, VkCommandBuffer command_buffer);
+        void Submit(const std::vector<VkCommandBuffer>& command_buffers, VkSemaphore wait_semaphore, VkPipelineStageFlags wait_stage,
+            VkSemaphore signal_semaphore, VkFence fence);
+
+        const std::vector<CtRenderGraphPassHandle>& GetPassOrder(){
+            return pass_order;
+        }
+
+        //Transient images only exist once the graph has been compiled
+        VkImage GetImage(CtRenderGraphResourceHandle resource){
+            return resources[resource].image;
+        }
+
+        static CtRenderGraphAccessInfo GetAccessInfo(CtRenderGraphAccess access);
+        static void GetLayoutSynchronization(VkImageLayout layout, VkPipelineStageFlags2& stage, VkAccessFlags2& access);
+        static VkImageUsageFlags GetImageUsage(CtRenderGraphAccess access);
+        static VkImageAspectFlags GetAspectFromFormat(VkFormat format);
+        static VkRenderPass CreateRenderPass(CtDevice* device, const std::vector<CtRenderGraphAttachment>& color_attachments, const CtRenderGraphAttachment* depth_attachment);
+
+    private:
+
+        CtDevice* device;
+
+        std::vector<CtRenderGraphResource> resources;
+        std::vector<CtRenderGraphPass> passes;
+
+        //Compile results
+        bool compiled = false;
+        std::vector<CtRenderGraphPassHandle> pass_order;
+        std::vector<CtRenderGraphBarrier> final_barriers;
+        std::vector<CtRenderGraphMemoryBlock> memory_blocks;
+        std::vector<CtRenderGraphSubmission> submissions;
+
+        //One timeline per queue. Every submission signals its queue's timeline with the next value of one shared counter,
+        //so a value alone says which submission of which frame we mean
+        VkSemaphore graphics_timeline = VK_NULL_HANDLE;
+        VkSemaphore compute_timeline = VK_NULL_HANDLE;
+        uint64_t timeline_value = 0;
+
+        //What the last compute submission of the previous frame signalled. Graphics waits on it before it can reuse anything
+        //that frame's compute work was still reading, like the depth a hiz pass samples
+        uint64_t last_compute_value = 0;
+
+        //Framebuffers depend on which image views are imported that frame, so we build them lazily and keep them around
+        std::map<std::vector<uint64_t>, VkFramebuffer> framebuffer_cache;
+
+        void CullPasses();
+        void OrderPasses();
+        void CreateTransientResources();
+        void ComputeBarriers();
+        void CreateRenderPasses();
+        void AssignQueues();
+        void BuildSubmissions();
+        void CreateTimelines();
+
+        void AddUse(CtRenderGraphPassHandle pass, CtRenderGraphResourceHandle resource, CtRenderGraphAccess access);
+        bool PassReads(const CtRenderGraphPass& pass, CtRenderGraphResourceHandle resource);
+        bool PassWrites(const CtRenderGraphPass& pass, CtRenderGraphResourceHandle resource);
+
+        void RecordBarriers(VkCommandBuffer command_buffer, const std::vector<CtRenderGraphBarrier>& barriers);
+        void BeginRasterPass(VkCommandBuffer command_buffer, CtRenderGraphPass& pass);
+        void BeginDynamicRendering(VkCommandBuffer command_buffer, CtRenderGraphPass& pass);
+        void EndRasterPass(VkCommandBuffer command_buffer);
+        void SetViewportAndScissor(VkCommandBuffer command_buffer, VkExtent2D extent);
+        VkFramebuffer GetFramebuffer(CtRenderGraphPassHandle pass_handle);
+        VkExtent2D GetRenderArea(const CtRenderGraphPass& pass);
+
+        void DestroyTransientResources();
+        uint32_t FindTransientMemoryType(uint32_t type_filter, bool allow_lazy, bool& lazily_allocated);
+};
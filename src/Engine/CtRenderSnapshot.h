@@ -0,0 +1,35 @@
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+//Everything the renderer needs to know about a single object for one frame
+struct CtRenderObject{
+    //Where the object is in the world
+    glm::mat4 transform;
+
+    //A flat tint for the object
+    glm::vec4 color;
+
+    //Which mesh to draw
+    uint32_t mesh_id;
+
+    //Which material to draw it with
+    uint32_t material_id;
+};
+
+//A frozen picture of the simulation at the end of a tick. The simulation thread fills these in and the
+//render thread only ever reads them, so nothing in here should point back into live simulation state
+struct CtRenderSnapshot{
+    //The tick this snapshot was taken on
+    uint64_t tick;
+
+    //Total simulated time in seconds at the end of the tick
+    double simulation_time;
+
+    //The fixed length of a tick in seconds
+    double tick_delta;
+
+    //All the objects to draw this frame
+    std::vector<CtRenderObject> objects;
+};
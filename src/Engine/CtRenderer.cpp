@@ -6,24 +6,71 @@
 #include "CtSwapchain.h"
 #include "CtGraphicsPipeline.h"
 #include "CtQueueFamily.h"
-
-CtRenderer* CtRenderer::CreateRenderer(EngineSettings settings, CtDevice* device, CtSwapchain* swapchain, CtGraphicsPipeline* graphics_pipeline){
+#include "CtTripleBuffer.h"
+#include "CtRenderSnapshot.h"
+#include "CtRenderGraph.h"
+#include "CtBindlessTable.h"
+#include "CtDescriptorAllocator.h"
+#include "CtUniformRing.h"
+#include "CtInstanceBuffer.h"
+#include "CtInstanceData.h"
+#include "CtMeshStore.h"
+#include "CtDrawBatcher.h"
+#include "CtGpuCulling.h"
+#include "CtClusterCulling.h"
+#include "CtTextureStore.h"
+#include "CtTextureStreamer.h"
+#include "CtSamplerCache.h"
+
+CtRenderer* CtRenderer::CreateRenderer(EngineSettings settings, CtDevice* device, CtSwapchain* swapchain, CtGraphicsPipeline* graphics_pipeline,
+    CtBindlessTable* bindless_table, CtTripleBuffer<CtRenderSnapshot>* snapshots){
 
     CtRenderer* ct_renderer = new CtRenderer();
 
     ct_renderer->swapchain = swapchain;
     ct_renderer->device = device;
     ct_renderer->graphics_pipeline = graphics_pipeline;
+    ct_renderer->bindless_table = bindless_table;
+    ct_renderer->snapshots = snapshots;
+    ct_renderer->frame_snapshot = &snapshots->Read();
     ct_renderer->max_frames_in_flight = settings.graphics_settings.max_frames_in_flight;
+    ct_renderer->lod_pixel_error = settings.graphics_settings.lod_pixel_error;
     ct_renderer->current_frame = 0;
     ct_renderer->CreateSyncObjects();
     ct_renderer->CreateCommandPool();
-    ct_renderer->CreateCommandBuffers();
-    ct_renderer->CreateIndexBuffer();
-    ct_renderer->CreateVertexBuffer();
+    ct_renderer->CreateDescriptorAllocator();
+    ct_renderer->uniform_ring = CtUniformRing::CreateUniformRing(device, settings.graphics_settings.uniform_ring_size, ct_renderer->max_frames_in_flight);
+    ct_renderer->instance_buffer = CtInstanceBuffer::CreateInstanceBuffer(device, sizeof(CtInstanceData), settings.graphics_settings.max_instances, ct_renderer->max_frames_in_flight);
+    ct_renderer->mesh_store = CtMeshStore::CreateMeshStore(device, settings.graphics_settings.max_mesh_vertices, settings.graphics_settings.max_mesh_indices,
+        settings.graphics_settings.max_mesh_clusters);
+    ct_renderer->texture_store = CtTextureStore::CreateTextureStore(device, bindless_table, settings.graphics_settings.use_texture_compression);
+    ct_renderer->texture_streamer = nullptr;
+    if(settings.graphics_settings.use_texture_streaming){
+        ct_renderer->texture_streamer = CtTextureStreamer::CreateTextureStreamer(device, ct_renderer->texture_store, bindless_table,
+            settings.graphics_settings.texture_streaming_budget, ct_renderer->max_frames_in_flight);
+    }
+    ct_renderer->sampler_cache = CtSamplerCache::CreateSamplerCache(device, bindless_table, settings.graphics_settings.max_sampler_anisotropy);
+    ct_renderer->default_sampler = ct_renderer->sampler_cache->GetSamplerIndex(CtSamplerCache::GetTrilinearState(VK_SAMPLER_ADDRESS_MODE_REPEAT));
+    ct_renderer->draw_batcher = CtDrawBatcher::CreateDrawBatcher(device, ct_renderer->mesh_store, ct_renderer->instance_buffer,
+        settings.graphics_settings.max_indirect_draws, ct_renderer->max_frames_in_flight);
+    ct_renderer->gpu_culling = nullptr;
+    if(settings.graphics_settings.use_gpu_culling && device->GetOptionalFeatures().multi_draw_indirect){
+        ct_renderer->gpu_culling = CtGpuCulling::CreateGpuCulling(device, ct_renderer->draw_batcher, ct_renderer->instance_buffer, ct_renderer->descriptor_allocator,
+            settings.graphics_settings.cull_shader_file, settings.graphics_settings.hiz_shader_file, settings.graphics_settings.max_instances, ct_renderer->max_frames_in_flight);
+    }
+    ct_renderer->cluster_culling = nullptr;
+    const CtDeviceOptionalFeatures& features = device->GetOptionalFeatures();
+    if(settings.graphics_settings.use_cluster_culling && features.multi_draw_indirect && features.draw_indirect_count){
+        ct_renderer->cluster_culling = CtClusterCulling::CreateClusterCulling(device, ct_renderer->mesh_store, ct_renderer->draw_batcher,
+            ct_renderer->descriptor_allocator, settings.graphics_settings.cluster_cull_shader_file, settings.graphics_settings.max_instances,
+            ct_renderer->max_frames_in_flight);
+    }
+    ct_renderer->CreateTestMesh();
+    ct_renderer->LoadMeshFiles(settings.graphics_settings.mesh_files);
+    ct_renderer->LoadSceneFiles(settings.graphics_settings.scene_files);
+    ct_renderer->LoadTextureFiles(settings.graphics_settings.texture_files);
     swapchain->renderer = ct_renderer;
-    swapchain->CreateDepthResources();
-    swapchain->InitializeSwapchainFramebuffers(graphics_pipeline->render_pass);
+    ct_renderer->BuildRenderGraph();
 
     printf("Created Renderer.\n");
     return ct_renderer;
@@ -34,17 +81,39 @@ void CtRenderer::DrawFrame(){
     VkDevice interface_device = *(device->GetInterfaceDevice());
     VkSwapchainKHR swapchain_khr = (swapchain->swapchain);
     VkQueue present_queue = (device->queue_family->present_queue);
-    VkQueue graphics_queue = device->queue_family->graphics_queue;
 
     vkWaitForFences(interface_device, 1, &in_flight_fences[current_frame], VK_TRUE, UINT64_MAX);
 
+    //Whatever this frame allocated last time around is done with
+    descriptor_allocator->BeginFrame(current_frame);
+    uniform_ring->BeginFrame(current_frame);
+    instance_buffer->BeginFrame(current_frame);
+    draw_batcher->BeginFrame(current_frame);
+    if(gpu_culling != nullptr){
+        gpu_culling->BeginFrame(current_frame);
+    }
+    if(cluster_culling != nullptr){
+        cluster_culling->BeginFrame(current_frame);
+    }
+
+    //The oldest frame is done now, so anything released that long ago can't still be read
+    if(bindless_table != nullptr){
+        bindless_table->AdvanceFrame();
+    }
+
+    //Same goes for any texture images streaming swapped out. Then whatever was asked for last frame decides what streams next
+    if(texture_streamer != nullptr){
+        texture_streamer->Update();
+    }
+
     uint32_t image_index;
     //First we have to wait
     VkResult result = vkAcquireNextImageKHR(interface_device, swapchain->swapchain, UINT64_MAX, image_available_semaphores[current_frame], VK_NULL_HANDLE, &image_index);
 
     //Let's see if we need to change our swap chain
     if(result == VK_ERROR_OUT_OF_DATE_KHR){
-        swapchain->RecreateSwapchain(graphics_pipeline->render_pass);
+        swapchain->RecreateSwapchain();
+        RebuildRenderGraph();
         return;
     } else 
     if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR){
@@ -53,28 +122,18 @@ void CtRenderer::DrawFrame(){
 
     vkResetFences(interface_device, 1, &in_flight_fences[current_frame]);
 
-    vkResetCommandBuffer(command_buffers[current_frame], 0);
-    RecordCommandBuffer(command_buffers[current_frame], image_index);
-
-    VkSubmitInfo submit_info{};
-    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    //Pick up the newest state the simulation has published. If it hasn't ticked since last frame we just draw the same one again
+    snapshots->Consume();
+    frame_snapshot = &snapshots->Read();
 
-    VkSemaphore wait_semaphores[] = {image_available_semaphores[current_frame]};
-    VkPipelineStageFlags wait_stages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submit_info.waitSemaphoreCount = 1;
-    submit_info.pWaitSemaphores = wait_semaphores;
-    submit_info.pWaitDstStageMask = wait_stages;
+    RecordCommandBuffers(image_index);
 
-    submit_info.commandBufferCount = 1;
-    submit_info.pCommandBuffers = &command_buffers[current_frame];
+    //The graph knows how its passes got split between the queues, so it does the submitting. The last submission signals the
+    //render finished semaphore and the fence, and that one always goes to the graphics queue
+    render_graph->Submit(command_buffers[current_frame], image_available_semaphores[current_frame], VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        render_finished_semaphores[current_frame], in_flight_fences[current_frame]);
 
     VkSemaphore signal_semaphore[] = {render_finished_semaphores[current_frame]};
-    submit_info.signalSemaphoreCount = 1;
-    submit_info.pSignalSemaphores = signal_semaphore;
-
-    if (vkQueueSubmit(graphics_queue, 1, &submit_info, in_flight_fences[current_frame]) != VK_SUCCESS){
-        throw std::runtime_error("failed to submit draw command buffer!");
-    }
 
     VkPresentInfoKHR present_info{};
     present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -93,7 +152,8 @@ void CtRenderer::DrawFrame(){
     // Let's re-query to see if our result is suboptimal mostly (or failed)
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebuffer_resized){
         framebuffer_resized = false;
-        swapchain->RecreateSwapchain(graphics_pipeline->render_pass);
+        swapchain->RecreateSwapchain();
+        RebuildRenderGraph();
     }
     else 
     if (result != VK_SUCCESS){
@@ -103,6 +163,113 @@ void CtRenderer::DrawFrame(){
     current_frame = (current_frame + 1) % max_frames_in_flight;
 }
 
+//Right now the frame is one pass that clears and draws straight into the swapchain image. The graph works out the barriers
+//(and the move to PRESENT_SRC) that the render pass used to do with its subpass dependency and final layouts
+void CtRenderer::BuildRenderGraph(){
+    render_graph = CtRenderGraph::CreateRenderGraph(device);
+
+    VkFormat depth_format = CtGraphicsPipeline::FindDepthFormat(device->GetPhysicalDevice());
+
+    //We don't care what was in the swapchain image before. Depth only lives for the one pass, so the graph owns it
+    //and can keep it in lazily allocated memory (or alias it with other targets that come later)
+    swapchain_resource = render_graph->ImportImage("swapchain", swapchain->swapchain_images[0], swapchain->swapchain_image_views[0],
+        swapchain->swapchain_image_format, swapchain->swapchain_extent, VK_IMAGE_LAYOUT_UNDEFINED);
+    depth_resource = render_graph->CreateImage("depth", depth_format, swapchain->swapchain_extent);
+
+    VkClearColorValue clear_color = {{0.0f, 0.0f, 0.0f, 1.0f}};
+    VkClearDepthStencilValue clear_depth = {1.0f, 0};
+
+    //Either kind of culling writes the indirect commands the main pass draws. Dependencies follow declaration order, so anything
+    //the main pass reads has to be declared before it
+    if(gpu_culling != nullptr || cluster_culling != nullptr){
+        indirect_resource = render_graph->ImportBuffer("indirect", draw_batcher->GetIndirectBuffer(), draw_batcher->GetIndirectSize());
+    }
+
+    //With GPU culling the main pass draws whatever the cull pass left in the indirect and instance buffers
+    uint32_t cull_pass = 0;
+    if(gpu_culling != nullptr){
+        instance_resource = render_graph->ImportBuffer("instances", instance_buffer->GetBuffer(), instance_buffer->GetSize());
+
+        cull_pass = render_graph->AddPass("cull", CT_RENDER_GRAPH_PASS_COMPUTE);
+        render_graph->Write(cull_pass, indirect_resource, CT_RENDER_GRAPH_ACCESS_COMPUTE_STORAGE_WRITE);
+        render_graph->Write(cull_pass, instance_resource, CT_RENDER_GRAPH_ACCESS_COMPUTE_STORAGE_WRITE);
+        render_graph->SetPassExecute(cull_pass, [this](VkCommandBuffer command_buffer){
+            //No camera yet, so this has to stay the same matrix the main pass draws with
+            gpu_culling->RecordCull(command_buffer, glm::mat4(1.0f));
+        });
+    }
+
+    //Cluster culling fills the cluster runs and their draw counts, which the main pass reads how many clusters to draw from
+    if(cluster_culling != nullptr){
+        count_resource = render_graph->ImportBuffer("counts", draw_batcher->GetCountBuffer(), draw_batcher->GetCountSize());
+
+        uint32_t cluster_pass = render_graph->AddPass("clusters", CT_RENDER_GRAPH_PASS_COMPUTE);
+        render_graph->Write(cluster_pass, indirect_resource, CT_RENDER_GRAPH_ACCESS_COMPUTE_STORAGE_WRITE);
+        render_graph->Write(cluster_pass, count_resource, CT_RENDER_GRAPH_ACCESS_COMPUTE_STORAGE_WRITE);
+        render_graph->SetPassExecute(cluster_pass, [this](VkCommandBuffer command_buffer){
+            //No camera yet. The identity looks down +z like an orthographic camera would, so that's the view direction
+            cluster_culling->RecordCull(command_buffer, glm::mat4(1.0f), glm::vec4(0.0f, 0.0f, 1.0f, 0.0f));
+        });
+
+        render_graph->SetAsyncCompute(cluster_pass);
+    }
+
+    uint32_t main_pass = render_graph->AddPass("main", CT_RENDER_GRAPH_PASS_RASTER);
+    render_graph->WriteColorAttachment(main_pass, swapchain_resource, &clear_color);
+    render_graph->WriteDepthAttachment(main_pass, depth_resource, &clear_depth);
+    render_graph->SetPassExecute(main_pass, [this](VkCommandBuffer command_buffer){
+        RecordMainPass(command_buffer);
+    });
+
+    if(gpu_culling != nullptr || cluster_culling != nullptr){
+        render_graph->Read(main_pass, indirect_resource, CT_RENDER_GRAPH_ACCESS_INDIRECT_READ);
+    }
+
+    if(cluster_culling != nullptr){
+        render_graph->Read(main_pass, count_resource, CT_RENDER_GRAPH_ACCESS_INDIRECT_READ);
+    }
+
+    //Once the main pass is done its depth gets reduced into the pyramid the next frame culls against
+    if(gpu_culling != nullptr){
+        render_graph->Read(main_pass, instance_resource, CT_RENDER_GRAPH_ACCESS_VERTEX_BUFFER_READ);
+
+        //Nothing in the graph reads the pyramid, it's for next frame, so the pass has to be kept alive by hand
+        uint32_t hiz_pass = render_graph->AddPass("hiz", CT_RENDER_GRAPH_PASS_COMPUTE);
+        render_graph->Read(hiz_pass, depth_resource, CT_RENDER_GRAPH_ACCESS_COMPUTE_SAMPLED);
+        render_graph->SetSideEffects(hiz_pass);
+        render_graph->SetPassExecute(hiz_pass, [this](VkCommandBuffer command_buffer){
+            gpu_culling->RecordHiZBuild(command_buffer);
+        });
+
+        //Both go to the compute queue if there's one of its own. The pyramid is written by one and read by the other, so they
+        //have to stay together, and the hiz pass overlaps with whatever graphics work comes after the main pass
+        render_graph->SetAsyncCompute(cull_pass);
+        render_graph->SetAsyncCompute(hiz_pass);
+    }
+
+    render_graph->MarkOutput(swapchain_resource, CT_RENDER_GRAPH_ACCESS_PRESENT);
+
+    render_graph->Compile();
+
+    if(gpu_culling != nullptr){
+        gpu_culling->SetDepthImage(render_graph->GetImage(depth_resource), depth_format, swapchain->swapchain_extent);
+    }
+
+    //How many command buffers a frame needs depends on how the graph got split up
+    CreateCommandBuffers();
+
+    printf("Created Render Graph.\n");
+}
+
+//The graph holds framebuffers built from the old image views and a depth image at the old size, so once the swapchain is recreated we start over
+void CtRenderer::RebuildRenderGraph(){
+    FreeCommandBuffers();
+    render_graph->Destroy();
+    delete render_graph;
+
+    BuildRenderGraph();
+}
+
 void CtRenderer::CreateSyncObjects(){
 
     image_available_semaphores.resize(max_frames_in_flight);
@@ -131,21 +298,55 @@ void CtRenderer::CreateSyncObjects(){
 }
 
 void CtRenderer::CreateCommandBuffers(){
+    uint32_t submission_count = render_graph->GetSubmissionCount();
+
     command_buffers.resize(max_frames_in_flight);
 
-    VkCommandBufferAllocateInfo alloc_info{};
-    alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    alloc_info.commandPool = command_pool;
-    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    alloc_info.commandBufferCount = (uint32_t)command_buffers.size();
+    for(auto& frame_command_buffers : command_buffers){
+        frame_command_buffers.resize(submission_count);
 
-    if(vkAllocateCommandBuffers(*(device->GetInterfaceDevice()), &alloc_info, command_buffers.data()) != VK_SUCCESS){
-        throw std::runtime_error("Failed to create command buffers");
+        for(uint32_t i = 0; i < submission_count; i++){
+            VkCommandBufferAllocateInfo alloc_info{};
+            alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            alloc_info.commandPool = render_graph->IsComputeSubmission(i) ? compute_command_pool : command_pool;
+            alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            alloc_info.commandBufferCount = 1;
+
+            if(vkAllocateCommandBuffers(*(device->GetInterfaceDevice()), &alloc_info, &frame_command_buffers[i]) != VK_SUCCESS){
+                throw std::runtime_error("Failed to create command buffers");
+            }
+        }
     }
 
     printf("Created Command Buffers.\n");
 }
 
+//Only safe once the device is idle, which it is whenever the graph gets rebuilt
+void CtRenderer::FreeCommandBuffers(){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    for(auto& frame_command_buffers : command_buffers){
+        for(uint32_t i = 0; i < frame_command_buffers.size(); i++){
+            VkCommandPool pool = render_graph->IsComputeSubmission(i) ? compute_command_pool : command_pool;
+            vkFreeCommandBuffers(interface_device, pool, 1, &frame_command_buffers[i]);
+        }
+    }
+    command_buffers.clear();
+}
+
+//The ratios follow the graphics pipeline's set layout, one dynamic uniform buffer and one combined image sampler per set.
+//The culling sets add three or four storage buffers, and each Hi-Z level a storage image
+void CtRenderer::CreateDescriptorAllocator(){
+    std::vector<CtDescriptorPoolRatio> ratios = {
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3.0f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f}
+    };
+
+    descriptor_allocator = CtDescriptorAllocator::CreateDescriptorAllocator(device, max_frames_in_flight, ratios);
+}
+
 void CtRenderer::CreateCommandPool(){
     //This is honestly super simple, we just mostly need the graphics queue
     VkCommandPoolCreateInfo pool_info{};
@@ -157,5 +358,14 @@ void CtRenderer::CreateCommandPool(){
         throw std::runtime_error("Failed to create a command pool");
     }
 
+    //Async compute submissions record into buffers from the compute family instead
+    if(device->GetOptionalFeatures().async_compute){
+        pool_info.queueFamilyIndex = device->queue_family->ComputeFamilyValue();
+
+        if(vkCreateCommandPool(*(device->GetInterfaceDevice()), &pool_info, nullptr, &compute_command_pool) != VK_SUCCESS){
+            throw std::runtime_error("Failed to create the compute command pool");
+        }
+    }
+
     printf("Created Command Pool.\n");
 }
\ No newline at end of file
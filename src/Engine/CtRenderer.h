@@ -1,16 +1,42 @@
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
 #include <vulkan/vulkan.h>
 #include <vector>
+#include <string>
+#include <cstdint>
 
 class CtDevice;
 struct EngineSettings;
 class CtSwapchain;
 class CtGraphicsPipeline;
+class CtRenderGraph;
+class CtBindlessTable;
+class CtDescriptorAllocator;
+class CtUniformRing;
+class CtInstanceBuffer;
+class CtMeshStore;
+class CtSamplerCache;
+class CtTextureStore;
+class CtTextureStreamer;
+class CtDrawBatcher;
+class CtGpuCulling;
+class CtClusterCulling;
+struct CtRenderSnapshot;
+template<typename T> class CtTripleBuffer;
+
+//Something a scene file put in the world. It never moves, so the renderer keeps it rather than the simulation handing it over every tick
+struct CtSceneObject{
+    glm::mat4 transform;
+    glm::vec4 color;
+    uint32_t mesh_id; //The store's, not a scene_meshes index
+};
 
 //This class is responsible for drawing as well as doing the synch variables in check
 class CtRenderer{
 
     public:
-        static CtRenderer* CreateRenderer(EngineSettings settings, CtDevice* device, CtSwapchain* swapchain, CtGraphicsPipeline* graphics_pipeline);
+        static CtRenderer* CreateRenderer(EngineSettings settings, CtDevice* device, CtSwapchain* swapchain, CtGraphicsPipeline* graphics_pipeline,
+            CtBindlessTable* bindless_table, CtTripleBuffer<CtRenderSnapshot>* snapshots);
 
         void DrawFrame();
 
@@ -22,20 +48,71 @@ class CtRenderer{
         CtDevice* device;
         CtSwapchain* swapchain;
         CtGraphicsPipeline* graphics_pipeline;
+        CtBindlessTable* bindless_table; //Can be null
+
+        //Where the simulation hands us its state, and the state we're drawing this frame
+        CtTripleBuffer<CtRenderSnapshot>* snapshots;
+        const CtRenderSnapshot* frame_snapshot;
+
+        //The frame as a render graph. The swapchain image changes every frame, so we just hold on to its handle and swap it in
+        CtRenderGraph* render_graph;
+        uint32_t swapchain_resource;
+        uint32_t depth_resource;
+        uint32_t indirect_resource;
+        uint32_t instance_resource;
+        uint32_t count_resource;
 
         VkCommandPool command_pool;
 
-        std::vector<VkCommandBuffer> command_buffers;
+        //Only made when async compute is on. Command buffers for the graph's compute submissions have to come from the compute family
+        VkCommandPool compute_command_pool = VK_NULL_HANDLE;
+
+        //Per frame descriptor sets. They're thrown away in bulk when the frame comes back around
+        CtDescriptorAllocator* descriptor_allocator;
+
+        //Where per draw constants go. Each frame in flight writes its own region
+        CtUniformRing* uniform_ring;
+
+        //Where per instance data goes, also one region per frame in flight
+        CtInstanceBuffer* instance_buffer;
+
+        //One command buffer per graph submission, per frame in flight. Without async compute that's just one each
+        std::vector<std::vector<VkCommandBuffer>> command_buffers;
         std::vector<VkSemaphore> image_available_semaphores;
         std::vector<VkSemaphore> render_finished_semaphores;
         std::vector<VkFence> in_flight_fences;
 
-        //Buffers
-        VkBuffer vertex_buffer;
-        VkDeviceMemory vertex_buffer_memory;
+        //Every mesh, packed into shared vertex and index buffers
+        CtMeshStore* mesh_store;
+
+        //Every texture with its mips, and the samplers they're read with
+        CtTextureStore* texture_store;
+        CtSamplerCache* sampler_cache;
+        uint32_t default_sampler; //Bindless index of the trilinear, repeating one
 
-        VkBuffer index_buffer;
-        VkDeviceMemory index_buffer_memory;
+        //Streams the texture files' upper mips in and out under a budget. Null when it's off
+        CtTextureStreamer* texture_streamer;
+
+        //The store's texture for each of the texture files, in order
+        std::vector<uint32_t> scene_textures;
+
+        //Turns the frame's objects into indirect draws, one bucket per pipeline
+        CtDrawBatcher* draw_batcher;
+        uint32_t test_mesh;
+        uint32_t main_bucket;
+
+        //What a render object's mesh_id means, the store's mesh for each one. The test mesh is always first
+        std::vector<uint32_t> scene_meshes;
+
+        //Drawn every frame along with the snapshot's objects
+        std::vector<CtSceneObject> scene_objects;
+        float lod_pixel_error;
+
+        //Fills the batcher's indirect commands on the GPU with only what survives the frustum and last frame's depth. Null when it's off
+        CtGpuCulling* gpu_culling;
+
+        //Culls clustered meshes a meshlet at a time into their own runs of the batcher's commands. Null when it's off
+        CtClusterCulling* cluster_culling;
 
         uint32_t max_frames_in_flight; //Just a quick reference
 
@@ -43,9 +120,13 @@ class CtRenderer{
 
         void CreateSyncObjects();
         void CreateCommandBuffers();
+        void FreeCommandBuffers();
         void CreateCommandPool();
-        void CreateVertexBuffer();
-        void CreateIndexBuffer();
+        void CreateDescriptorAllocator();
+        void CreateTestMesh();
+        void LoadMeshFiles(const std::vector<std::string>& mesh_files);
+        void LoadSceneFiles(const std::vector<std::string>& scene_files);
+        void LoadTextureFiles(const std::vector<std::string>& texture_files);
 
         void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, VkDeviceMemory &buffer_memory);
         void CopyBuffer(VkBuffer source_buffer, VkBuffer destination_buffer, VkDeviceSize size);
@@ -53,7 +134,12 @@ class CtRenderer{
         VkCommandBuffer BeginSingleTimeCommands();
         void EndSingleTimeCommands(VkCommandBuffer command_buffer);
 
-        void RecordCommandBuffer(VkCommandBuffer command_buffer, uint32_t image_index);
+        void RecordCommandBuffers(uint32_t image_index);
+        void RecordMainPass(VkCommandBuffer command_buffer);
+        void BatchDraws();
+
+        void BuildRenderGraph();
+        void RebuildRenderGraph();
 
     friend class CtSwapchain;
     friend class CtDevice;
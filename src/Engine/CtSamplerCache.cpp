@@ -0,0 +1,94 @@
+#include "CtSamplerCache.h"
+#include "CtDevice.h"
+#include "CtBindlessTable.h"
+#include <stdexcept>
+#include <algorithm>
+
+CtSamplerCache* CtSamplerCache::CreateSamplerCache(CtDevice* device, CtBindlessTable* bindless_table, float max_anisotropy){
+    CtSamplerCache* ct_sampler_cache = new CtSamplerCache();
+
+    ct_sampler_cache->device = device;
+    ct_sampler_cache->bindless_table = bindless_table;
+
+    //Sampler anisotropy is one of the features we require, so there's always some to have
+    VkPhysicalDeviceProperties properties {};
+    vkGetPhysicalDeviceProperties(*(device->GetPhysicalDevice()), &properties);
+    ct_sampler_cache->max_anisotropy = std::max(std::min(max_anisotropy, properties.limits.maxSamplerAnisotropy), 1.0f);
+
+    printf("Created Sampler Cache.\n");
+
+    return ct_sampler_cache;
+}
+
+CtSamplerState CtSamplerCache::GetTrilinearState(VkSamplerAddressMode address_mode){
+    CtSamplerState state {};
+    state.mag_filter = VK_FILTER_LINEAR;
+    state.min_filter = VK_FILTER_LINEAR;
+    state.mipmap_mode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    state.address_mode_u = address_mode;
+    state.address_mode_v = address_mode;
+    state.address_mode_w = address_mode;
+    state.max_anisotropy = 16.0f;
+    state.max_lod = VK_LOD_CLAMP_NONE;
+
+    return state;
+}
+
+VkSampler CtSamplerCache::GetSampler(const CtSamplerState& state){
+    return FindSampler(state).sampler;
+}
+
+uint32_t CtSamplerCache::GetSamplerIndex(const CtSamplerState& state){
+    return FindSampler(state).bindless_index;
+}
+
+const CtCachedSampler& CtSamplerCache::FindSampler(const CtSamplerState& state){
+    CtSamplerState clamped = state;
+    clamped.max_anisotropy = clamped.max_anisotropy > 1.0f ? std::min(clamped.max_anisotropy, max_anisotropy) : 1.0f;
+
+    for(const auto& cached : samplers){
+        if(cached.state == clamped){
+            return cached;
+        }
+    }
+
+    VkSamplerCreateInfo sampler_info {};
+    sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_info.magFilter = clamped.mag_filter;
+    sampler_info.minFilter = clamped.min_filter;
+    sampler_info.mipmapMode = clamped.mipmap_mode;
+    sampler_info.addressModeU = clamped.address_mode_u;
+    sampler_info.addressModeV = clamped.address_mode_v;
+    sampler_info.addressModeW = clamped.address_mode_w;
+    sampler_info.mipLodBias = 0.0f;
+    sampler_info.anisotropyEnable = clamped.max_anisotropy > 1.0f ? VK_TRUE : VK_FALSE;
+    sampler_info.maxAnisotropy = clamped.max_anisotropy;
+    sampler_info.compareEnable = VK_FALSE;
+    sampler_info.compareOp = VK_COMPARE_OP_ALWAYS;
+    sampler_info.minLod = 0.0f;
+    sampler_info.maxLod = clamped.max_lod;
+    sampler_info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    sampler_info.unnormalizedCoordinates = VK_FALSE;
+
+    CtCachedSampler cached {};
+    cached.state = clamped;
+    if(vkCreateSampler(*(device->GetInterfaceDevice()), &sampler_info, nullptr, &cached.sampler) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create a sampler.");
+    }
+
+    cached.bindless_index = bindless_table != nullptr ? bindless_table->RegisterSampler(cached.sampler) : CT_BINDLESS_INVALID_INDEX;
+
+    samplers.push_back(cached);
+    return samplers.back();
+}
+
+//Anything still drawing with these has to be done first
+void CtSamplerCache::Cleanup(){
+    for(const auto& cached : samplers){
+        if(bindless_table != nullptr){
+            bindless_table->ReleaseSampler(cached.bindless_index);
+        }
+        vkDestroySampler(*(device->GetInterfaceDevice()), cached.sampler, nullptr);
+    }
+    samplers.clear();
+}
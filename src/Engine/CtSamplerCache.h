@@ -0,0 +1,67 @@
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <cstdint>
+
+class CtDevice;
+class CtBindlessTable;
+
+//Everything about a sampler we ever change. Two equal states always get the same VkSampler
+struct CtSamplerState{
+    VkFilter mag_filter;
+    VkFilter min_filter;
+    VkSamplerMipmapMode mipmap_mode;
+    VkSamplerAddressMode address_mode_u;
+    VkSamplerAddressMode address_mode_v;
+    VkSamplerAddressMode address_mode_w;
+    float max_anisotropy; //1 or less is off
+    float max_lod; //VK_LOD_CLAMP_NONE to use every mip there is
+
+    bool operator==(const CtSamplerState& other) const{
+        return mag_filter == other.mag_filter && min_filter == other.min_filter && mipmap_mode == other.mipmap_mode &&
+            address_mode_u == other.address_mode_u && address_mode_v == other.address_mode_v && address_mode_w == other.address_mode_w &&
+            max_anisotropy == other.max_anisotropy && max_lod == other.max_lod;
+    }
+};
+
+struct CtCachedSampler{
+    CtSamplerState state;
+    VkSampler sampler;
+    uint32_t bindless_index; //CT_BINDLESS_INVALID_INDEX without a bindless table
+};
+
+//Hands out samplers by state and makes each one only once. Devices cap how many samplers can exist at a time, some as low as 4000,
+//and the bindless table only has CT_BINDLESS_MAX_SAMPLERS slots, so textures share these rather than each making their own.
+//There are only ever a handful, a straight search is faster than hashing them
+class CtSamplerCache{
+
+    public:
+        //max_anisotropy caps what any state can ask for, on top of what the device allows
+        static CtSamplerCache* CreateSamplerCache(CtDevice* device, CtBindlessTable* bindless_table, float max_anisotropy);
+
+        //Linear filtering between linear filtered mips, anisotropic up to the cap
+        static CtSamplerState GetTrilinearState(VkSamplerAddressMode address_mode);
+
+        VkSampler GetSampler(const CtSamplerState& state);
+
+        //Where the state's sampler is in the bindless table
+        uint32_t GetSamplerIndex(const CtSamplerState& state);
+
+        uint32_t GetSamplerCount(){
+            return static_cast<uint32_t>(samplers.size());
+        }
+
+        void Cleanup();
+
+    private:
+
+        CtDevice* device;
+        CtBindlessTable* bindless_table; //Can be null
+
+        //The lower of the setting and the device limit
+        float max_anisotropy;
+
+        std::vector<CtCachedSampler> samplers;
+
+        //Finds or makes it. Anisotropy gets clamped first, so asking for more than the cap lands on the same sampler as asking for the cap
+        const CtCachedSampler& FindSampler(const CtSamplerState& state);
+};
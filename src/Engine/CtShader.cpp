@@ -2,6 +2,9 @@
 #include <iostream>
 #include "CtDevice.h"
 #include <fstream>
+#include <map>
+#include <stdexcept>
+#include <cstring>
 
 CtShader* CtShader::CreateShader(CtDevice* device, const std::string& shader_file_name, CtShaderPipelineStage pipeline_stage){
     CtShader* shader = new CtShader();
@@ -42,6 +45,8 @@ void CtShader::CreateShaderModule(VkDevice* interface_device, const std::string&
         throw std::runtime_error("Failed to create shader module.");
     }
 
+    Reflect(byte_code);
+
     // printf("Created shader module for %s.\n", shader_file_name);
 }
 
@@ -52,6 +57,19 @@ void CtShader::CreateShaderPipelineInfo(VkPipelineShaderStageCreateInfo& vk_crea
     TransferShaderPipelineStageInfo(ct_create_info, vk_create_info);
 }
 
+VkShaderStageFlagBits CtShader::GetStageFlag(){
+    switch(pipeline_stage){
+        case CT_SHADER_PIPELINE_STAGE_FRAGMENT:
+            return VK_SHADER_STAGE_FRAGMENT_BIT;
+        case CT_SHADER_PIPELINE_STAGE_VERTEX:
+            return VK_SHADER_STAGE_VERTEX_BIT;
+        case CT_SHADER_PIPELINE_STAGE_COMPUTE:
+            return VK_SHADER_STAGE_COMPUTE_BIT;
+        default:
+            throw std::runtime_error("Shader stage not implemented.");
+    }
+}
+
 void CtShader::PopulateShaderModuleCreateInfo(CtShaderModuleCreateInfo& shader_create_info,
             const void* pointer_to_next, VkShaderModuleCreateFlags flags,
             size_t code_size, const uint32_t* pointer_to_code){
@@ -79,16 +97,7 @@ void CtShader::PopulateShaderPipelineStageInfo(CtPipelineShaderStageCreateInfo&
     shader_pipeline_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     shader_pipeline_create_info.pNext = pointer_to_next;
     shader_pipeline_create_info.flags = flags;
-    switch(pipeline_stage){
-        case CT_SHADER_PIPELINE_STAGE_FRAGMENT:
-            shader_pipeline_create_info.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-            break;
-        case CT_SHADER_PIPELINE_STAGE_VERTEX:
-            shader_pipeline_create_info.stage = VK_SHADER_STAGE_VERTEX_BIT;
-            break;
-        default:
-            throw std::runtime_error("Shader stage not implemented.");
-    }
+    shader_pipeline_create_info.stage = GetStageFlag();
     shader_pipeline_create_info.module_ = module_;
     shader_pipeline_create_info.pName = pointer_to_name;
     shader_pipeline_create_info.pSpecializationInfo = pointer_to_specialization_info;
@@ -102,4 +111,219 @@ void CtShader::TransferShaderPipelineStageInfo(CtPipelineShaderStageCreateInfo&
     vk_pipeline_shader_stage_create_info.module = ct_pipeline_shader_stage_create_info.module_;
     vk_pipeline_shader_stage_create_info.pName = ct_pipeline_shader_stage_create_info.pName;
     vk_pipeline_shader_stage_create_info.pSpecializationInfo = ct_pipeline_shader_stage_create_info.pSpecializationInfo;
-}
\ No newline at end of file
+}
+
+/******************************************************REFLECTION**********************************************************************/
+
+//SPIR-V is just a list of instructions, each one starting with a word that holds its length and opcode. We only need enough of it
+//to find the variable in the PushConstant storage class and work out how many bytes its struct covers, so we only look at the types and decorations
+const uint32_t CT_SPIRV_MAGIC = 0x07230203;
+
+const uint32_t CT_SPIRV_OP_EXECUTION_MODE = 16;
+const uint32_t CT_SPIRV_OP_TYPE_BOOL = 20;
+const uint32_t CT_SPIRV_OP_TYPE_INT = 21;
+const uint32_t CT_SPIRV_OP_TYPE_FLOAT = 22;
+const uint32_t CT_SPIRV_OP_TYPE_VECTOR = 23;
+const uint32_t CT_SPIRV_OP_TYPE_MATRIX = 24;
+const uint32_t CT_SPIRV_OP_TYPE_ARRAY = 28;
+const uint32_t CT_SPIRV_OP_TYPE_STRUCT = 30;
+const uint32_t CT_SPIRV_OP_TYPE_POINTER = 32;
+const uint32_t CT_SPIRV_OP_CONSTANT = 43;
+const uint32_t CT_SPIRV_OP_VARIABLE = 59;
+const uint32_t CT_SPIRV_OP_DECORATE = 71;
+const uint32_t CT_SPIRV_OP_MEMBER_DECORATE = 72;
+
+const uint32_t CT_SPIRV_EXECUTION_MODE_LOCAL_SIZE = 17;
+
+const uint32_t CT_SPIRV_DECORATION_ROW_MAJOR = 4;
+const uint32_t CT_SPIRV_DECORATION_ARRAY_STRIDE = 6;
+const uint32_t CT_SPIRV_DECORATION_MATRIX_STRIDE = 7;
+const uint32_t CT_SPIRV_DECORATION_OFFSET = 35;
+
+const uint32_t CT_SPIRV_STORAGE_CLASS_PUSH_CONSTANT = 9;
+
+struct CtSpirvType{
+    uint32_t opcode;
+    std::vector<uint32_t> operands; //Everything after the result id
+};
+
+struct CtSpirvMember{
+    uint32_t offset = 0;
+    uint32_t matrix_stride = 0;
+    bool row_major = false;
+};
+
+struct CtSpirvModule{
+    std::map<uint32_t, CtSpirvType> types;
+    std::map<uint32_t, uint32_t> constants;
+    std::map<uint32_t, uint32_t> array_strides;
+    std::map<uint32_t, std::map<uint32_t, CtSpirvMember>> members;
+};
+
+static uint32_t GetTypeSize(const CtSpirvModule& spirv, uint32_t type_id, const CtSpirvMember* member);
+
+static uint32_t GetStructSize(const CtSpirvModule& spirv, uint32_t struct_id){
+    const CtSpirvType& type = spirv.types.at(struct_id);
+    auto found = spirv.members.find(struct_id);
+
+    uint32_t size = 0;
+    for(uint32_t i = 0; i < type.operands.size(); i++){
+        const CtSpirvMember* member = nullptr;
+        if(found != spirv.members.end() && found->second.count(i)){
+            member = &found->second.at(i);
+        }
+
+        uint32_t offset = member ? member->offset : 0;
+        uint32_t end = offset + GetTypeSize(spirv, type.operands[i], member);
+        size = end > size ? end : size;
+    }
+
+    return size;
+}
+
+//Members carry the layout decorations for matrices, so they get passed down with the type
+static uint32_t GetTypeSize(const CtSpirvModule& spirv, uint32_t type_id, const CtSpirvMember* member){
+    const CtSpirvType& type = spirv.types.at(type_id);
+
+    switch(type.opcode){
+        case CT_SPIRV_OP_TYPE_BOOL:
+            return 4;
+        case CT_SPIRV_OP_TYPE_INT:
+        case CT_SPIRV_OP_TYPE_FLOAT:
+            return type.operands[0] / 8;
+        case CT_SPIRV_OP_TYPE_VECTOR:
+            return GetTypeSize(spirv, type.operands[0], nullptr) * type.operands[1];
+        case CT_SPIRV_OP_TYPE_MATRIX: {
+            const CtSpirvType& column = spirv.types.at(type.operands[0]);
+            uint32_t columns = type.operands[1];
+            uint32_t rows = column.operands[1];
+            uint32_t stride = (member && member->matrix_stride) ? member->matrix_stride : GetTypeSize(spirv, type.operands[0], nullptr);
+
+            return (member && member->row_major) ? rows * stride : columns * stride;
+        }
+        case CT_SPIRV_OP_TYPE_ARRAY: {
+            uint32_t length = spirv.constants.at(type.operands[1]);
+            auto stride = spirv.array_strides.find(type_id);
+
+            if(stride != spirv.array_strides.end()){
+                return length * stride->second;
+            }
+            return length * GetTypeSize(spirv, type.operands[0], member);
+        }
+        case CT_SPIRV_OP_TYPE_STRUCT:
+            return GetStructSize(spirv, type_id);
+        default:
+            throw std::runtime_error("Push constant block uses a type we can't size.");
+    }
+}
+
+//One walk over the module for the push constant block and, for compute shaders, the workgroup size
+void CtShader::Reflect(const std::vector<char>& byte_code){
+    has_push_constants = false;
+
+    if(byte_code.size() < 20 || byte_code.size() % 4 != 0){
+        return;
+    }
+
+    std::vector<uint32_t> words(byte_code.size() / 4);
+    memcpy(words.data(), byte_code.data(), byte_code.size());
+
+    if(words[0] != CT_SPIRV_MAGIC){
+        throw std::runtime_error("Shader isn't SPIR-V.");
+    }
+
+    CtSpirvModule spirv;
+    std::map<uint32_t, uint32_t> pointer_types; //Pointer id to the type it points at, only for push constant pointers
+    uint32_t block_type = 0;
+
+    //The header is five words, instructions start right after it
+    size_t position = 5;
+    while(position < words.size()){
+        uint32_t word_count = words[position] >> 16;
+        uint32_t opcode = words[position] & 0xFFFF;
+
+        if(word_count == 0 || position + word_count > words.size()){
+            throw std::runtime_error("Shader has a broken SPIR-V instruction.");
+        }
+
+        const uint32_t* operands = &words[position + 1];
+        uint32_t operand_count = word_count - 1;
+
+        switch(opcode){
+            case CT_SPIRV_OP_EXECUTION_MODE:
+                if(operands[1] == CT_SPIRV_EXECUTION_MODE_LOCAL_SIZE && operand_count >= 5){
+                    local_size[0] = operands[2];
+                    local_size[1] = operands[3];
+                    local_size[2] = operands[4];
+                }
+                break;
+            case CT_SPIRV_OP_TYPE_BOOL:
+            case CT_SPIRV_OP_TYPE_INT:
+            case CT_SPIRV_OP_TYPE_FLOAT:
+            case CT_SPIRV_OP_TYPE_VECTOR:
+            case CT_SPIRV_OP_TYPE_MATRIX:
+            case CT_SPIRV_OP_TYPE_ARRAY:
+            case CT_SPIRV_OP_TYPE_STRUCT: {
+                CtSpirvType type {};
+                type.opcode = opcode;
+                type.operands.assign(operands + 1, operands + operand_count);
+                spirv.types[operands[0]] = type;
+                break;
+            }
+            case CT_SPIRV_OP_TYPE_POINTER:
+                if(operands[1] == CT_SPIRV_STORAGE_CLASS_PUSH_CONSTANT){
+                    pointer_types[operands[0]] = operands[2];
+                }
+                break;
+            case CT_SPIRV_OP_CONSTANT:
+                spirv.constants[operands[1]] = operands[2];
+                break;
+            case CT_SPIRV_OP_VARIABLE:
+                if(operands[2] == CT_SPIRV_STORAGE_CLASS_PUSH_CONSTANT){
+                    block_type = pointer_types[operands[0]];
+                }
+                break;
+            case CT_SPIRV_OP_DECORATE:
+                if(operands[1] == CT_SPIRV_DECORATION_ARRAY_STRIDE){
+                    spirv.array_strides[operands[0]] = operands[2];
+                }
+                break;
+            case CT_SPIRV_OP_MEMBER_DECORATE: {
+                CtSpirvMember& member = spirv.members[operands[0]][operands[1]];
+                if(operands[2] == CT_SPIRV_DECORATION_OFFSET){
+                    member.offset = operands[3];
+                } else
+                if(operands[2] == CT_SPIRV_DECORATION_MATRIX_STRIDE){
+                    member.matrix_stride = operands[3];
+                } else
+                if(operands[2] == CT_SPIRV_DECORATION_ROW_MAJOR){
+                    member.row_major = true;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+
+        position += word_count;
+    }
+
+    if(block_type == 0){
+        return;
+    }
+
+    //A stage that only uses the back half of a block gets a range that starts at its first member, which is what lets stages share one block
+    uint32_t first_offset = UINT32_MAX;
+    for(const auto& member : spirv.members[block_type]){
+        first_offset = member.second.offset < first_offset ? member.second.offset : first_offset;
+    }
+    if(first_offset == UINT32_MAX){
+        first_offset = 0;
+    }
+
+    uint32_t end = GetStructSize(spirv, block_type);
+
+    has_push_constants = true;
+    push_constant_offset = first_offset;
+    push_constant_size = ((end - first_offset) + 3) & ~3u;
+}
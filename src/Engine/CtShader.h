@@ -1,6 +1,7 @@
 #include <string>
 #include <vector>
 #include <vulkan/vulkan.h>
+#include <cstdint>
 
 class CtDevice;
 class CtGraphicsPipeline;
@@ -64,7 +65,8 @@ struct CtPipelineShaderStageCreateInfo{
 //Most simply used to differentiate what stage this shader is going to work with
 enum CtShaderPipelineStage{
     CT_SHADER_PIPELINE_STAGE_FRAGMENT,
-    CT_SHADER_PIPELINE_STAGE_VERTEX
+    CT_SHADER_PIPELINE_STAGE_VERTEX,
+    CT_SHADER_PIPELINE_STAGE_COMPUTE
 };
 
 
@@ -76,11 +78,35 @@ class CtShader{
         static CtShader* CreateShader(CtDevice* device, const std::string& shader_file_name, CtShaderPipelineStage pipeline_stage);
         void CreateShaderPipelineInfo(VkPipelineShaderStageCreateInfo& vk_shader_info);
 
+        VkShaderStageFlagBits GetStageFlag();
+
+        //What the shader's push constant block covers, read straight out of the SPIR-V
+        bool HasPushConstants(){
+            return has_push_constants;
+        }
+        uint32_t GetPushConstantOffset(){
+            return push_constant_offset;
+        }
+        uint32_t GetPushConstantSize(){
+            return push_constant_size;
+        }
+
+        //The local_size a compute shader was compiled with. Graphics stages leave it at 1, 1, 1
+        uint32_t GetLocalSize(uint32_t axis){
+            return local_size[axis];
+        }
+
     private:
 
         VkShaderModule shader_module;
         CtShaderPipelineStage pipeline_stage;
 
+        bool has_push_constants = false;
+        uint32_t push_constant_offset = 0;
+        uint32_t push_constant_size = 0;
+
+        uint32_t local_size[3] = {1, 1, 1};
+
         std::vector<char> ReadFile(const std::string& file_name);
 
         void PopulateShaderModuleCreateInfo(CtShaderModuleCreateInfo& shader_create_info,
@@ -95,10 +121,14 @@ class CtShader{
 
         void CreateShaderModule(VkDevice* interface_device, const std::string& file_name);
 
+        //Reflection
+        void Reflect(const std::vector<char>& byte_code);
+
         void DestroyShaderModule(VkDevice* interface_device){
             vkDestroyShaderModule(*interface_device, shader_module, nullptr);
         }
 
     friend class CtGraphicsPipeline;
+    friend class CtComputePipeline;
 
 };
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "CtSimulation.h"
+#include "Engine.h"
+#include <chrono>
+#include <stdexcept>
+
+CtSimulation* CtSimulation::CreateSimulation(EngineSettings settings){
+
+    CtSimulation* ct_simulation = new CtSimulation();
+
+    uint32_t tick_rate = settings.simulation_settings.tick_rate;
+    if(tick_rate == 0){
+        throw std::runtime_error("Simulation tick rate must be above zero.");
+    }
+
+    ct_simulation->tick_delta = 1.0 / static_cast<double>(tick_rate);
+    ct_simulation->update = settings.simulation_settings.update;
+
+    ct_simulation->state.tick = 0;
+    ct_simulation->state.simulation_time = 0.0;
+    ct_simulation->state.tick_delta = ct_simulation->tick_delta;
+
+    //Publish the starting state so the renderer has something to look at before the first tick lands
+    ct_simulation->PublishSnapshot();
+
+    printf("Created Simulation.\n");
+    return ct_simulation;
+}
+
+void CtSimulation::Start(){
+    if(running.exchange(true)){
+        return;
+    }
+
+    simulation_thread = std::thread(&CtSimulation::SimulationLoop, this);
+}
+
+void CtSimulation::Stop(){
+    if(!running.exchange(false)){
+        return;
+    }
+
+    if(simulation_thread.joinable()){
+        simulation_thread.join();
+    }
+}
+
+//Fixed timestep loop. We keep an absolute deadline instead of sleeping for tick_delta each time so
+//that small oversleeps don't add up, and if we fall really far behind we drop the backlog instead of spiraling
+void CtSimulation::SimulationLoop(){
+    using clock = std::chrono::steady_clock;
+
+    const auto tick_duration = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(tick_delta));
+    const uint32_t max_catch_up_ticks = 5;
+
+    auto next_tick = clock::now();
+
+    while(running.load(std::memory_order_relaxed)){
+        uint32_t ticks_run = 0;
+
+        while(clock::now() >= next_tick && ticks_run < max_catch_up_ticks){
+            Tick();
+            next_tick += tick_duration;
+            ticks_run++;
+        }
+
+        if(ticks_run == max_catch_up_ticks){
+            next_tick = clock::now() + tick_duration;
+        }
+
+        //Only the newest state matters to the renderer, so we publish once no matter how many ticks we ran
+        if(ticks_run > 0){
+            PublishSnapshot();
+        }
+
+        std::this_thread::sleep_until(next_tick);
+    }
+}
+
+void CtSimulation::Tick(){
+    if(update){
+        update(state, tick_delta);
+    }
+
+    state.tick++;
+    state.simulation_time += tick_delta;
+}
+
+//Copies our state into the free slot. Assigning the vector reuses whatever capacity the slot already had so
+//after the first few ticks this stops allocating
+void CtSimulation::PublishSnapshot(){
+    CtRenderSnapshot& snapshot = snapshots.BeginWrite();
+
+    snapshot.tick = state.tick;
+    snapshot.simulation_time = state.simulation_time;
+    snapshot.tick_delta = state.tick_delta;
+    snapshot.objects.assign(state.objects.begin(), state.objects.end());
+
+    snapshots.Publish();
+}
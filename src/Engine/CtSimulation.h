@@ -0,0 +1,46 @@
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <cstdint>
+#include "CtTripleBuffer.h"
+#include "CtRenderSnapshot.h"
+
+struct EngineSettings;
+
+//Runs the update logic on its own thread at a fixed tick rate. Every tick the state gets copied into
+//a snapshot and published to the renderer through a triple buffer, so neither side ever blocks the other
+class CtSimulation{
+
+    public:
+        static CtSimulation* CreateSimulation(EngineSettings settings);
+
+        void Start();
+        void Stop();
+
+        CtTripleBuffer<CtRenderSnapshot>* GetSnapshots(){
+            return &snapshots;
+        }
+
+    private:
+
+        std::thread simulation_thread;
+        std::atomic<bool> running {false};
+
+        //How long a tick is, in seconds
+        double tick_delta;
+
+        //The state that the update function owns. Only the simulation thread touches this
+        CtRenderSnapshot state;
+
+        //What gets handed over to the renderer
+        CtTripleBuffer<CtRenderSnapshot> snapshots;
+
+        //The user's update function
+        std::function<void(CtRenderSnapshot&, double)> update;
+
+        void SimulationLoop();
+        void Tick();
+        void PublishSnapshot();
+
+    friend class Engine;
+};
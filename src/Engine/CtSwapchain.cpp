@@ -271,34 +271,8 @@ void CtSwapchain::PopulateSwapchainCreateInfo(CtSwapchainCreateInfoKHR& create_i
     create_info.oldSwapchain = old_swapchain;
 }
 
-void CtSwapchain::InitializeSwapchainFramebuffers(VkRenderPass& render_pass){
-    swapchain_framebuffers.resize(swapchain_image_views.size());
-
-    for(size_t i = 0; i < swapchain_image_views.size(); i++){
-        std::array<VkImageView, 2> attachments = {
-            swapchain_image_views[i],
-            depth_image_view
-        };
-
-        VkFramebufferCreateInfo framebuffer_info {};
-        framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebuffer_info.renderPass = render_pass;
-        framebuffer_info.attachmentCount = static_cast<uint32_t>(attachments.size());
-        framebuffer_info.pAttachments = attachments.data();
-        framebuffer_info.width = swapchain_extent.width;
-        framebuffer_info.height = swapchain_extent.height;
-        framebuffer_info.layers = 1;
-
-        if(vkCreateFramebuffer(*(device->GetInterfaceDevice()), &framebuffer_info, nullptr, &swapchain_framebuffers[i]) != VK_SUCCESS){
-            throw std::runtime_error("Failed to create a frame buffer");
-        }
-
-    }
-
-    printf("Created framebuffers.\n");
-}
-
-void CtSwapchain::RecreateSwapchain(VkRenderPass& render_pass){
+//Framebuffers belong to the render graph now, so the renderer rebuilds it once we are done here
+void CtSwapchain::RecreateSwapchain(){
     int width = 0, height = 0;
     glfwGetFramebufferSize((window->GetWindow()), &width, &height);
 
@@ -313,21 +287,11 @@ void CtSwapchain::RecreateSwapchain(VkRenderPass& render_pass){
 
     InitializeSwapchain(QuerySwapchainSupport(*(device->GetPhysicalDevice()), window->GetSurface()));
     InitializeSwapchainImageViews();
-    CreateDepthResources();
-    InitializeSwapchainFramebuffers(render_pass);
 }
 
 void CtSwapchain::Cleanup(){
     VkDevice interface_device = *(device->GetInterfaceDevice());
 
-    vkDestroyImageView(interface_device, depth_image_view, nullptr);
-    vkDestroyImage(interface_device, depth_image, nullptr);
-    vkFreeMemory(interface_device, depth_image_memory, nullptr);
-
-    for(auto framebuffer : swapchain_framebuffers){
-        vkDestroyFramebuffer(interface_device, framebuffer, nullptr);
-    }
-
     for(auto image_view : swapchain_image_views){
         vkDestroyImageView(interface_device, image_view, nullptr);
     }
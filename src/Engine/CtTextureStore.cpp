@@ -0,0 +1,681 @@
+#include "CtTextureStore.h"
+#include "CtDevice.h"
+#include "CtQueueFamily.h"
+#include "CtBindlessTable.h"
+#include "CtBarrierBatch.h"
+#include "CtImageDecode.h"
+#include "CtBlockCompress.h"
+#include "CtBlockDecode.h"
+#include "CtKtx2.h"
+#include "CtMappedFile.h"
+#include "CtOrderedWork.h"
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <thread>
+
+//Every level starts on a multiple of this in staging. It covers the texel or block size of every format we know and the 4 bytes copies need
+const VkDeviceSize CT_TEXTURE_STORE_LEVEL_ALIGNMENT = 16;
+
+CtTextureStore* CtTextureStore::CreateTextureStore(CtDevice* device, CtBindlessTable* bindless_table, bool use_compression){
+    CtTextureStore* ct_texture_store = new CtTextureStore();
+
+    ct_texture_store->device = device;
+    ct_texture_store->bindless_table = bindless_table;
+
+    VkPhysicalDeviceProperties properties {};
+    vkGetPhysicalDeviceProperties(*(device->GetPhysicalDevice()), &properties);
+    ct_texture_store->max_dimension = properties.limits.maxImageDimension2D;
+
+    //Desktop GPUs all have BC. Anything that doesn't keeps RGBA8, there's no encoder here for the mobile formats
+    CtFormatBlock bc1 {};
+    CtFormatBlock bc3 {};
+    GetFormatBlock(VK_FORMAT_BC1_RGB_SRGB_BLOCK, bc1);
+    GetFormatBlock(VK_FORMAT_BC3_SRGB_BLOCK, bc3);
+    ct_texture_store->compress = use_compression &&
+        ct_texture_store->CanSample(VK_FORMAT_BC1_RGB_UNORM_BLOCK, bc1) && ct_texture_store->CanSample(VK_FORMAT_BC1_RGB_SRGB_BLOCK, bc1) &&
+        ct_texture_store->CanSample(VK_FORMAT_BC3_UNORM_BLOCK, bc3) && ct_texture_store->CanSample(VK_FORMAT_BC3_SRGB_BLOCK, bc3);
+
+    ct_texture_store->CreateUploadPool();
+
+    printf("Created Texture Store (compression %s).\n", ct_texture_store->compress ? "BC" : "off");
+
+    return ct_texture_store;
+}
+
+/*************************************************************TEXTURES*****************************************************************/
+
+uint32_t CtTextureStore::AddTexture(const CtTextureData& texture_data){
+    CheckTexture(texture_data);
+    if(texture_data.levels.size() < texture_data.mip_levels && !CanGenerateMips(texture_data.format)){
+        throw std::runtime_error("A texture needs mips made on the GPU but its format can't be blitted. Give it every level.");
+    }
+
+    CtTexture texture {};
+    texture.format = texture_data.format;
+    texture.width = texture_data.width;
+    texture.height = texture_data.height;
+    texture.mip_levels = texture_data.mip_levels;
+    texture.bindless_index = CT_BINDLESS_INVALID_INDEX;
+
+    CreateImage(texture);
+    CreateImageView(texture);
+
+    Upload(texture, texture_data.levels);
+
+    if(bindless_table != nullptr){
+        texture.bindless_index = bindless_table->RegisterTexture(texture.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+
+    textures.push_back(texture);
+
+    return static_cast<uint32_t>(textures.size() - 1);
+}
+
+uint32_t CtTextureStore::AddTexture(const CtImageData& image, bool srgb){
+    return AddTexture(PrepareTexture(image, srgb));
+}
+
+//The GPU makes the mips when it can. Block compressed formats can't be blitted into, and some devices can't blit sRGB, so those get
+//every level made here
+CtTextureData CtTextureStore::PrepareTexture(CtImageData image, bool srgb){
+    if(image.width == 0 || image.height == 0 || image.pixels.size() != static_cast<size_t>(image.width) * image.height * 4){
+        throw std::runtime_error("A texture's pixels don't match its size.");
+    }
+
+    CtTextureData texture_data {};
+    texture_data.width = image.width;
+    texture_data.height = image.height;
+    texture_data.mip_levels = GetMipCount(image.width, image.height);
+
+    if(compress){
+        bool opaque = CtBlockCompress::IsOpaque(image);
+        if(opaque){
+            texture_data.format = srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+        }
+        else{
+            texture_data.format = srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+        }
+
+        for(uint32_t mip = 0; mip < texture_data.mip_levels; mip++){
+            if(mip > 0){
+                image = CtImageDecode::Downsample(image, srgb);
+            }
+            texture_data.levels.push_back(opaque ? CtBlockCompress::EncodeBc1(image) : CtBlockCompress::EncodeBc3(image));
+        }
+
+        return texture_data;
+    }
+
+    texture_data.format = srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+    bool generate_mips = CanGenerateMips(texture_data.format);
+
+    texture_data.levels.push_back(image.pixels);
+    if(!generate_mips){
+        for(uint32_t mip = 1; mip < texture_data.mip_levels; mip++){
+            image = CtImageDecode::Downsample(image, srgb);
+            texture_data.levels.push_back(image.pixels);
+        }
+    }
+
+    return texture_data;
+}
+
+CtTextureData CtTextureStore::LoadTextureData(const std::string& path, bool srgb){
+    CtMappedFile* file = CtMappedFile::Open(path, true);
+
+    CtTextureData texture_data;
+    try{
+        const uint8_t* data = file->GetData();
+        size_t size = static_cast<size_t>(file->GetSize());
+        if(CtKtx2::IsKtx2(data, size)){
+            texture_data = CtKtx2::Decode(data, size, path);
+
+            //ASTC on desktop or BC on mobile gets decoded back to RGBA8 and prepared like any other image, keeping how many mips
+            //the file asked for
+            CtFormatBlock block {};
+            GetFormatBlock(texture_data.format, block);
+            if(!CanSample(texture_data.format, block)){
+                CtImageData image {};
+                if(!CtBlockDecode::Decode(texture_data.format, texture_data.levels[0].data(), texture_data.width, texture_data.height, image)){
+                    throw std::runtime_error("The device can't sample " + path + "'s format and it can't be decoded. Convert it to one the device has.");
+                }
+
+                uint32_t mip_levels = texture_data.mip_levels;
+                texture_data = PrepareTexture(std::move(image), CtBlockDecode::IsSrgb(texture_data.format));
+                texture_data.mip_levels = std::min(texture_data.mip_levels, mip_levels);
+                if(texture_data.levels.size() > texture_data.mip_levels){
+                    texture_data.levels.resize(texture_data.mip_levels);
+                }
+            }
+        }
+        else{
+            texture_data = PrepareTexture(CtImageDecode::Decode(data, size, path), srgb);
+        }
+    } catch(...){
+        file->Close();
+        delete file;
+        throw;
+    }
+
+    file->Close();
+    delete file;
+
+    return texture_data;
+}
+
+uint32_t CtTextureStore::LoadTexture(const std::string& path, bool srgb){
+    auto start = std::chrono::steady_clock::now();
+
+    uint32_t texture_id = AddTexture(LoadTextureData(path, srgb));
+    const CtTexture& texture = textures[texture_id];
+
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("Loaded Texture %s (%ux%u, %u mips, %.2f MB) in %.2f ms.\n", path.c_str(), texture.width, texture.height, texture.mip_levels,
+        texture.size / (1024.0 * 1024.0), milliseconds);
+
+    return texture_id;
+}
+
+//Decoding and compressing are most of the time and every image is independent. Uploads share the queue and the pool, so they stay on this thread
+std::vector<uint32_t> CtTextureStore::LoadTextures(const std::vector<std::string>& paths, bool srgb, uint32_t thread_count){
+    auto start = std::chrono::steady_clock::now();
+
+    uint32_t count = static_cast<uint32_t>(paths.size());
+    if(thread_count == 0){
+        thread_count = std::min(std::max(std::thread::hardware_concurrency(), 1u), CT_TEXTURE_STORE_MAX_THREADS);
+    }
+    thread_count = std::max(std::min(thread_count, count), 1u);
+
+    std::vector<uint32_t> texture_ids;
+    texture_ids.reserve(count);
+    VkDeviceSize total_size = 0;
+
+    CtRunOrdered<CtTextureData>(count, thread_count, thread_count * CT_TEXTURE_STORE_PENDING_PER_THREAD,
+        [&](uint32_t i, CtTextureData& texture_data){
+            texture_data = LoadTextureData(paths[i], srgb);
+        },
+        [&](uint32_t, CtTextureData& texture_data){
+            texture_ids.push_back(AddTexture(texture_data));
+            total_size += textures.back().size;
+        });
+
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("Loaded %u Textures (%.2f MB) on %u threads in %.2f ms.\n", count, total_size / (1024.0 * 1024.0), thread_count, milliseconds);
+
+    return texture_ids;
+}
+
+uint32_t CtTextureStore::GetMipCount(uint32_t width, uint32_t height){
+    return static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+}
+
+bool CtTextureStore::GetFormatBlock(VkFormat format, CtFormatBlock& block){
+    switch(format){
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+            block = {1, 1, 4, CT_TEXTURE_COMPRESSION_NONE};
+            return true;
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+        case VK_FORMAT_BC4_SNORM_BLOCK:
+            block = {4, 4, 8, CT_TEXTURE_COMPRESSION_BC};
+            return true;
+        case VK_FORMAT_BC2_UNORM_BLOCK:
+        case VK_FORMAT_BC2_SRGB_BLOCK:
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+        case VK_FORMAT_BC5_SNORM_BLOCK:
+        case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+        case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            block = {4, 4, 16, CT_TEXTURE_COMPRESSION_BC};
+            return true;
+        case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+        case VK_FORMAT_EAC_R11_UNORM_BLOCK:
+        case VK_FORMAT_EAC_R11_SNORM_BLOCK:
+            block = {4, 4, 8, CT_TEXTURE_COMPRESSION_ETC2};
+            return true;
+        case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+        case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+        case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:
+        case VK_FORMAT_EAC_R11G11_SNORM_BLOCK:
+            block = {4, 4, 16, CT_TEXTURE_COMPRESSION_ETC2};
+            return true;
+        case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+            block = {4, 4, 16, CT_TEXTURE_COMPRESSION_ASTC_LDR};
+            return true;
+        case VK_FORMAT_ASTC_5x4_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_5x4_SRGB_BLOCK:
+            block = {5, 4, 16, CT_TEXTURE_COMPRESSION_ASTC_LDR};
+            return true;
+        case VK_FORMAT_ASTC_5x5_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_5x5_SRGB_BLOCK:
+            block = {5, 5, 16, CT_TEXTURE_COMPRESSION_ASTC_LDR};
+            return true;
+        case VK_FORMAT_ASTC_6x5_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_6x5_SRGB_BLOCK:
+            block = {6, 5, 16, CT_TEXTURE_COMPRESSION_ASTC_LDR};
+            return true;
+        case VK_FORMAT_ASTC_6x6_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_6x6_SRGB_BLOCK:
+            block = {6, 6, 16, CT_TEXTURE_COMPRESSION_ASTC_LDR};
+            return true;
+        case VK_FORMAT_ASTC_8x5_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_8x5_SRGB_BLOCK:
+            block = {8, 5, 16, CT_TEXTURE_COMPRESSION_ASTC_LDR};
+            return true;
+        case VK_FORMAT_ASTC_8x6_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_8x6_SRGB_BLOCK:
+            block = {8, 6, 16, CT_TEXTURE_COMPRESSION_ASTC_LDR};
+            return true;
+        case VK_FORMAT_ASTC_8x8_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_8x8_SRGB_BLOCK:
+            block = {8, 8, 16, CT_TEXTURE_COMPRESSION_ASTC_LDR};
+            return true;
+        case VK_FORMAT_ASTC_10x5_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_10x5_SRGB_BLOCK:
+            block = {10, 5, 16, CT_TEXTURE_COMPRESSION_ASTC_LDR};
+            return true;
+        case VK_FORMAT_ASTC_10x6_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_10x6_SRGB_BLOCK:
+            block = {10, 6, 16, CT_TEXTURE_COMPRESSION_ASTC_LDR};
+            return true;
+        case VK_FORMAT_ASTC_10x8_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_10x8_SRGB_BLOCK:
+            block = {10, 8, 16, CT_TEXTURE_COMPRESSION_ASTC_LDR};
+            return true;
+        case VK_FORMAT_ASTC_10x10_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_10x10_SRGB_BLOCK:
+            block = {10, 10, 16, CT_TEXTURE_COMPRESSION_ASTC_LDR};
+            return true;
+        case VK_FORMAT_ASTC_12x10_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_12x10_SRGB_BLOCK:
+            block = {12, 10, 16, CT_TEXTURE_COMPRESSION_ASTC_LDR};
+            return true;
+        case VK_FORMAT_ASTC_12x12_UNORM_BLOCK:
+        case VK_FORMAT_ASTC_12x12_SRGB_BLOCK:
+            block = {12, 12, 16, CT_TEXTURE_COMPRESSION_ASTC_LDR};
+            return true;
+        default:
+            return false;
+    }
+}
+
+VkDeviceSize CtTextureStore::GetLevelSize(const CtFormatBlock& block, uint32_t width, uint32_t height, uint32_t level){
+    VkDeviceSize level_width = std::max(width >> level, 1u);
+    VkDeviceSize level_height = std::max(height >> level, 1u);
+
+    return ((level_width + block.width - 1) / block.width) * ((level_height + block.height - 1) / block.height) * block.size;
+}
+
+void CtTextureStore::CheckTexture(const CtTextureData& texture_data){
+    CtFormatBlock block {};
+    if(!GetFormatBlock(texture_data.format, block)){
+        throw std::runtime_error("A texture is in a format the texture store doesn't know.");
+    }
+    if(texture_data.width == 0 || texture_data.height == 0 || texture_data.levels.empty() || texture_data.levels.size() > texture_data.mip_levels ||
+        texture_data.mip_levels > GetMipCount(texture_data.width, texture_data.height)){
+        throw std::runtime_error("A texture's size doesn't match its mip levels.");
+    }
+    for(uint32_t level = 0; level < texture_data.levels.size(); level++){
+        if(texture_data.levels[level].size() != GetLevelSize(block, texture_data.width, texture_data.height, level)){
+            throw std::runtime_error("A texture's mip level doesn't match its size.");
+        }
+    }
+    if(texture_data.width > max_dimension || texture_data.height > max_dimension){
+        throw std::runtime_error("A texture is bigger than the device can hold. Scale it down.");
+    }
+    if(!CanSample(texture_data.format, block)){
+        throw std::runtime_error("The device can't sample a texture's format. Convert it to one it has.");
+    }
+}
+
+bool CtTextureStore::CanGenerateMips(VkFormat format){
+    VkFormatProperties format_properties;
+    vkGetPhysicalDeviceFormatProperties(*(device->GetPhysicalDevice()), format, &format_properties);
+
+    VkFormatFeatureFlags needed = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (format_properties.optimalTilingFeatures & needed) == needed;
+}
+
+//Block formats are off limits without their feature turned on, whatever the format properties say
+bool CtTextureStore::CanSample(VkFormat format, const CtFormatBlock& block){
+    const CtDeviceOptionalFeatures& features = device->GetOptionalFeatures();
+    switch(block.compression){
+        case CT_TEXTURE_COMPRESSION_BC:
+            if(!features.texture_compression_bc){
+                return false;
+            }
+            break;
+        case CT_TEXTURE_COMPRESSION_ETC2:
+            if(!features.texture_compression_etc2){
+                return false;
+            }
+            break;
+        case CT_TEXTURE_COMPRESSION_ASTC_LDR:
+            if(!features.texture_compression_astc_ldr){
+                return false;
+            }
+            break;
+        default:
+            break;
+    }
+
+    VkFormatProperties format_properties;
+    vkGetPhysicalDeviceFormatProperties(*(device->GetPhysicalDevice()), format, &format_properties);
+
+    VkFormatFeatureFlags needed = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (format_properties.optimalTilingFeatures & needed) == needed;
+}
+
+/**************************************************************UPLOADS*****************************************************************/
+
+//Staging buffer with every level given back to back, one submit, wait. Textures get added at load time so there's nothing to overlap with yet
+void CtTextureStore::Upload(const CtTexture& texture, const std::vector<std::vector<uint8_t>>& levels){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    VkBuffer staging_buffer;
+    VkDeviceMemory staging_buffer_memory;
+    std::vector<VkBufferImageCopy> copy_regions;
+    StageLevels(texture, levels, 0, staging_buffer, staging_buffer_memory, copy_regions);
+
+    VkCommandBufferAllocateInfo allocate_info {};
+    allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocate_info.commandPool = upload_pool;
+    allocate_info.commandBufferCount = 1;
+
+    VkCommandBuffer command_buffer;
+    vkAllocateCommandBuffers(interface_device, &allocate_info, &command_buffer);
+
+    VkCommandBufferBeginInfo begin_info {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(command_buffer, &begin_info);
+
+    RecordUpload(command_buffer, texture, staging_buffer, copy_regions);
+
+    vkEndCommandBuffer(command_buffer);
+
+    VkSubmitInfo submit_info {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &command_buffer;
+
+    vkQueueSubmit(device->queue_family->graphics_queue, 1, &submit_info, VK_NULL_HANDLE);
+    vkQueueWaitIdle(device->queue_family->graphics_queue);
+
+    vkFreeCommandBuffers(interface_device, upload_pool, 1, &command_buffer);
+    vkDestroyBuffer(interface_device, staging_buffer, nullptr);
+    vkFreeMemory(interface_device, staging_buffer_memory, nullptr);
+}
+
+void CtTextureStore::StageLevels(const CtTexture& texture, const std::vector<std::vector<uint8_t>>& levels, uint32_t first_level,
+    VkBuffer& staging_buffer, VkDeviceMemory& staging_buffer_memory, std::vector<VkBufferImageCopy>& copy_regions){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    uint32_t level_count = std::min(static_cast<uint32_t>(levels.size()) - first_level, texture.mip_levels);
+
+    VkDeviceSize size = 0;
+    for(uint32_t mip = 0; mip < level_count; mip++){
+        size = (size + CT_TEXTURE_STORE_LEVEL_ALIGNMENT - 1) / CT_TEXTURE_STORE_LEVEL_ALIGNMENT * CT_TEXTURE_STORE_LEVEL_ALIGNMENT + levels[first_level + mip].size();
+    }
+
+    CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        staging_buffer, staging_buffer_memory);
+
+    void* mapped;
+    if(vkMapMemory(interface_device, staging_buffer_memory, 0, size, 0, &mapped) != VK_SUCCESS){
+        vkDestroyBuffer(interface_device, staging_buffer, nullptr);
+        vkFreeMemory(interface_device, staging_buffer_memory, nullptr);
+        throw std::runtime_error("Failed to map texture store staging memory.");
+    }
+
+    //Extents are in texels even for block formats. A level smaller than a block still takes a whole one, the copy only has to reach the edge
+    copy_regions.clear();
+    VkDeviceSize offset = 0;
+    for(uint32_t mip = 0; mip < level_count; mip++){
+        const std::vector<uint8_t>& level = levels[first_level + mip];
+        offset = (offset + CT_TEXTURE_STORE_LEVEL_ALIGNMENT - 1) / CT_TEXTURE_STORE_LEVEL_ALIGNMENT * CT_TEXTURE_STORE_LEVEL_ALIGNMENT;
+        memcpy(static_cast<uint8_t*>(mapped) + offset, level.data(), level.size());
+
+        VkBufferImageCopy copy_region {};
+        copy_region.bufferOffset = offset;
+        copy_region.bufferRowLength = 0;
+        copy_region.bufferImageHeight = 0;
+        copy_region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        copy_region.imageSubresource.mipLevel = mip;
+        copy_region.imageSubresource.baseArrayLayer = 0;
+        copy_region.imageSubresource.layerCount = 1;
+        copy_region.imageExtent = {std::max(texture.width >> mip, 1u), std::max(texture.height >> mip, 1u), 1};
+        copy_regions.push_back(copy_region);
+
+        offset += level.size();
+    }
+    vkUnmapMemory(interface_device, staging_buffer_memory);
+}
+
+void CtTextureStore::RecordUpload(VkCommandBuffer command_buffer, const CtTexture& texture, VkBuffer staging_buffer,
+    const std::vector<VkBufferImageCopy>& copy_regions){
+    VkImageSubresourceRange all_levels {};
+    all_levels.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    all_levels.baseMipLevel = 0;
+    all_levels.levelCount = texture.mip_levels;
+    all_levels.baseArrayLayer = 0;
+    all_levels.layerCount = 1;
+
+    CtBarrierBatch barriers(device);
+    barriers.AddImageBarrier(texture.image, all_levels,
+        VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    barriers.Flush(command_buffer);
+
+    vkCmdCopyBufferToImage(command_buffer, staging_buffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        static_cast<uint32_t>(copy_regions.size()), copy_regions.data());
+
+    uint32_t given = static_cast<uint32_t>(copy_regions.size());
+    bool blitted = given < texture.mip_levels;
+    if(blitted){
+        RecordMipBlits(command_buffer, texture, given);
+    }
+
+    //Everything ends up sampled. The levels blits read from are in TRANSFER_SRC now and the rest are still where the copy left them
+    uint32_t first_source = blitted ? given - 1 : texture.mip_levels;
+    uint32_t last_source = blitted ? texture.mip_levels - 1 : texture.mip_levels;
+    VkPipelineStageFlags2 sampling_stages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+
+    VkImageSubresourceRange levels_range = all_levels;
+    if(first_source > 0){
+        levels_range.baseMipLevel = 0;
+        levels_range.levelCount = first_source;
+        barriers.AddImageBarrier(texture.image, levels_range,
+            VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            sampling_stages, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+    if(last_source > first_source){
+        levels_range.baseMipLevel = first_source;
+        levels_range.levelCount = last_source - first_source;
+        barriers.AddImageBarrier(texture.image, levels_range,
+            VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            sampling_stages, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+    if(last_source < texture.mip_levels){
+        levels_range.baseMipLevel = last_source;
+        levels_range.levelCount = texture.mip_levels - last_source;
+        barriers.AddImageBarrier(texture.image, levels_range,
+            VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            sampling_stages, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+    barriers.Flush(command_buffer);
+}
+
+//Each level is a linear filtered blit of the one above it at half the size. The one above has to be finished being written and moved
+//to TRANSFER_SRC before it can be read, so it's one barrier per level
+void CtTextureStore::RecordMipBlits(VkCommandBuffer command_buffer, const CtTexture& texture, uint32_t first_level){
+    CtBarrierBatch barriers(device);
+
+    for(uint32_t mip = first_level; mip < texture.mip_levels; mip++){
+        VkImageSubresourceRange source_range {};
+        source_range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        source_range.baseMipLevel = mip - 1;
+        source_range.levelCount = 1;
+        source_range.baseArrayLayer = 0;
+        source_range.layerCount = 1;
+
+        barriers.AddImageBarrier(texture.image, source_range,
+            VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        barriers.Flush(command_buffer);
+
+        int32_t source_width = static_cast<int32_t>(std::max(texture.width >> (mip - 1), 1u));
+        int32_t source_height = static_cast<int32_t>(std::max(texture.height >> (mip - 1), 1u));
+        int32_t destination_width = static_cast<int32_t>(std::max(texture.width >> mip, 1u));
+        int32_t destination_height = static_cast<int32_t>(std::max(texture.height >> mip, 1u));
+
+        VkImageBlit blit {};
+        blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.srcSubresource.mipLevel = mip - 1;
+        blit.srcSubresource.baseArrayLayer = 0;
+        blit.srcSubresource.layerCount = 1;
+        blit.srcOffsets[0] = {0, 0, 0};
+        blit.srcOffsets[1] = {source_width, source_height, 1};
+        blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.dstSubresource.mipLevel = mip;
+        blit.dstSubresource.baseArrayLayer = 0;
+        blit.dstSubresource.layerCount = 1;
+        blit.dstOffsets[0] = {0, 0, 0};
+        blit.dstOffsets[1] = {destination_width, destination_height, 1};
+
+        vkCmdBlitImage(command_buffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1, &blit, VK_FILTER_LINEAR);
+    }
+}
+
+/***************************************************************IMAGES*****************************************************************/
+
+void CtTextureStore::CreateImage(CtTexture& texture){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    VkImageCreateInfo image_info {};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.format = texture.format;
+    image_info.extent.width = texture.width;
+    image_info.extent.height = texture.height;
+    image_info.extent.depth = 1;
+    image_info.mipLevels = texture.mip_levels;
+    image_info.arrayLayers = 1;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if(vkCreateImage(interface_device, &image_info, nullptr, &texture.image) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create a texture image.");
+    }
+
+    VkMemoryRequirements memory_requirements;
+    vkGetImageMemoryRequirements(interface_device, texture.image, &memory_requirements);
+
+    VkMemoryAllocateInfo allocate_info {};
+    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocate_info.allocationSize = memory_requirements.size;
+    allocate_info.memoryTypeIndex = device->FindMemoryType(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    if(vkAllocateMemory(interface_device, &allocate_info, nullptr, &texture.memory) != VK_SUCCESS){
+        vkDestroyImage(interface_device, texture.image, nullptr);
+        throw std::runtime_error("Failed to allocate texture memory.");
+    }
+
+    vkBindImageMemory(interface_device, texture.image, texture.memory, 0);
+    texture.size = memory_requirements.size;
+}
+
+void CtTextureStore::CreateImageView(CtTexture& texture){
+    VkImageViewCreateInfo view_info {};
+    view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    view_info.image = texture.image;
+    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view_info.format = texture.format;
+    view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    view_info.subresourceRange.baseMipLevel = 0;
+    view_info.subresourceRange.levelCount = texture.mip_levels;
+    view_info.subresourceRange.baseArrayLayer = 0;
+    view_info.subresourceRange.layerCount = 1;
+
+    if(vkCreateImageView(*(device->GetInterfaceDevice()), &view_info, nullptr, &texture.view) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create a texture image view.");
+    }
+}
+
+void CtTextureStore::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& buffer_memory){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    VkBufferCreateInfo buffer_info {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = size;
+    buffer_info.usage = usage;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if(vkCreateBuffer(interface_device, &buffer_info, nullptr, &buffer) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create a texture store buffer.");
+    }
+
+    VkMemoryRequirements memory_requirements;
+    vkGetBufferMemoryRequirements(interface_device, buffer, &memory_requirements);
+
+    VkMemoryAllocateInfo allocate_info {};
+    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocate_info.allocationSize = memory_requirements.size;
+    allocate_info.memoryTypeIndex = device->FindMemoryType(memory_requirements.memoryTypeBits, properties);
+
+    if(vkAllocateMemory(interface_device, &allocate_info, nullptr, &buffer_memory) != VK_SUCCESS){
+        throw std::runtime_error("Failed to allocate texture store memory.");
+    }
+
+    vkBindBufferMemory(interface_device, buffer, buffer_memory, 0);
+}
+
+//Blits need a graphics queue, so uploads go there rather than to a transfer only one
+void CtTextureStore::CreateUploadPool(){
+    VkCommandPoolCreateInfo pool_info {};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pool_info.queueFamilyIndex = device->queue_family->graphics_family.value();
+
+    if(vkCreateCommandPool(*(device->GetInterfaceDevice()), &pool_info, nullptr, &upload_pool) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create the texture store's upload pool.");
+    }
+}
+
+//Anything still drawing with these has to be done first
+void CtTextureStore::Cleanup(){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    for(const auto& texture : textures){
+        if(bindless_table != nullptr){
+            bindless_table->ReleaseTexture(texture.bindless_index);
+        }
+        vkDestroyImageView(interface_device, texture.view, nullptr);
+        vkDestroyImage(interface_device, texture.image, nullptr);
+        vkFreeMemory(interface_device, texture.memory, nullptr);
+    }
+    textures.clear();
+
+    vkDestroyCommandPool(interface_device, upload_pool, nullptr);
+}
@@ -0,0 +1,149 @@
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+class CtDevice;
+class CtBindlessTable;
+struct CtImageData;
+
+//Decoding threads LoadTextures uses at most when it picks for itself
+const uint32_t CT_TEXTURE_STORE_MAX_THREADS = 16;
+
+//How many decoded images can be waiting on their upload per decoding thread
+const uint32_t CT_TEXTURE_STORE_PENDING_PER_THREAD = 2;
+
+//Which device feature a format needs before anything can use it
+enum CtTextureCompression{
+    CT_TEXTURE_COMPRESSION_NONE = 0,
+    CT_TEXTURE_COMPRESSION_BC = 1,
+    CT_TEXTURE_COMPRESSION_ETC2 = 2,
+    CT_TEXTURE_COMPRESSION_ASTC_LDR = 3
+};
+
+//How a format is laid out in memory. Uncompressed formats are 1x1 blocks of one texel
+struct CtFormatBlock{
+    uint32_t width;
+    uint32_t height;
+    uint32_t size; //Bytes
+    CtTextureCompression compression;
+};
+
+//A texture on the CPU, already in the format it's going to be sampled as
+struct CtTextureData{
+    VkFormat format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mip_levels; //How many the image gets. Any past the ones in levels get blitted down on the GPU
+
+    //Level 0 first. Each is rows of blocks from the top, tightly packed
+    std::vector<std::vector<uint8_t>> levels;
+};
+
+//A sampled image with its whole mip chain, ready to read in SHADER_READ_ONLY_OPTIMAL
+struct CtTexture{
+    VkImage image;
+    VkDeviceMemory memory;
+    VkImageView view; //Every mip
+    VkFormat format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mip_levels;
+    VkDeviceSize size; //What the image actually takes on the GPU
+    uint32_t bindless_index; //CT_BINDLESS_INVALID_INDEX without a bindless table
+};
+
+//Owns every texture. Images are decoded on worker threads, copied in through staging and get their mips made on the GPU by blitting
+//each level down from the one before it. Without mips a far away texture reads texels spread all over memory for every pixel and shimmers,
+//with them it reads a level about the size it covers on screen.
+//With compression on and a device that has BC, images are encoded to BC1 (opaque) or BC3 (with alpha) on the decoding threads instead,
+//a quarter to an eighth of the memory and bandwidth. Those get their mips made on the CPU, blocks can't be blitted. KTX2 files say
+//their own format and bring their own mips, which go up as they are when the device can sample that format
+class CtTextureStore{
+
+    public:
+        static CtTextureStore* CreateTextureStore(CtDevice* device, CtBindlessTable* bindless_table, bool use_compression);
+
+        //Uploads every level it has and makes the rest, then waits for it to land. Meant for load time, not the middle of a frame
+        uint32_t AddTexture(const CtTextureData& texture_data);
+
+        //Prepares and adds it. srgb is for color, anything that holds data like normals or roughness should be linear
+        uint32_t AddTexture(const CtImageData& image, bool srgb);
+
+        //Picks the format the image will be sampled as and does all the CPU work for it, compression and CPU made mips included.
+        //Safe to call from any thread
+        CtTextureData PrepareTexture(CtImageData image, bool srgb);
+
+        //Reads a KTX2 file as is, or decodes and prepares a PNG, TGA or BMP. srgb only matters for the latter, KTX2 says its own.
+        //A KTX2 file in a format the device can't sample gets decoded from its base level and prepared like a PNG.
+        //Safe to call from any thread
+        CtTextureData LoadTextureData(const std::string& path, bool srgb);
+
+        //Loads and adds one file, printing how long it took
+        uint32_t LoadTexture(const std::string& path, bool srgb);
+
+        //Loads on thread_count threads (0 picks for us) while the caller uploads them one at a time in order. Returns the ids in
+        //the same order as the paths
+        std::vector<uint32_t> LoadTextures(const std::vector<std::string>& paths, bool srgb, uint32_t thread_count = 0);
+
+        //A streamed texture gets a new image, view and bindless index whenever its mips change, so don't hold on to these past the frame
+        const CtTexture& GetTexture(uint32_t texture_id){
+            return textures[texture_id];
+        }
+        uint32_t GetTextureCount(){
+            return static_cast<uint32_t>(textures.size());
+        }
+
+        //Levels for an image this size, down to 1x1
+        static uint32_t GetMipCount(uint32_t width, uint32_t height);
+
+        //False for formats the store doesn't know how to lay out
+        static bool GetFormatBlock(VkFormat format, CtFormatBlock& block);
+
+        //Bytes in one mip level of an image this size, partial blocks at the edges counted whole
+        static VkDeviceSize GetLevelSize(const CtFormatBlock& block, uint32_t width, uint32_t height, uint32_t level);
+
+        void Cleanup();
+
+    private:
+
+        CtDevice* device;
+        CtBindlessTable* bindless_table; //Can be null
+
+        uint32_t max_dimension;
+
+        //Images get encoded to BC on the way in
+        bool compress;
+
+        std::vector<CtTexture> textures;
+
+        //Uploads
+        VkCommandPool upload_pool;
+
+        //Throws unless every level it has is the right size for its format and the device can sample it
+        void CheckTexture(const CtTextureData& texture_data);
+
+        //Blitting down a level needs the format to be blittable both ways and linearly filterable. RGBA8 always is in practice,
+        //but the spec doesn't promise it for sRGB
+        bool CanGenerateMips(VkFormat format);
+
+        //Its compression feature is on and it can be sampled with linear filtering
+        bool CanSample(VkFormat format, const CtFormatBlock& block);
+
+        void CreateImage(CtTexture& texture);
+        void CreateImageView(CtTexture& texture);
+        void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& buffer_memory);
+        void CreateUploadPool();
+
+        //Copies levels in as mips 0 on up. Any mips past the ones given get blitted down from the last one given
+        void Upload(const CtTexture& texture, const std::vector<std::vector<uint8_t>>& levels);
+
+        //The two halves of Upload, for anyone who'd rather submit it themselves and not wait. levels[first_level] goes to the image's mip 0,
+        //and copy_regions comes back with one copy per level that fit
+        void StageLevels(const CtTexture& texture, const std::vector<std::vector<uint8_t>>& levels, uint32_t first_level,
+            VkBuffer& staging_buffer, VkDeviceMemory& staging_buffer_memory, std::vector<VkBufferImageCopy>& copy_regions);
+        void RecordUpload(VkCommandBuffer command_buffer, const CtTexture& texture, VkBuffer staging_buffer, const std::vector<VkBufferImageCopy>& copy_regions);
+        void RecordMipBlits(VkCommandBuffer command_buffer, const CtTexture& texture, uint32_t first_level);
+
+    friend class CtTextureStreamer;
+};
@@ -0,0 +1,642 @@
+#include "CtTextureStreamer.h"
+#include "CtTextureStore.h"
+#include "CtDevice.h"
+#include "CtQueueFamily.h"
+#include "CtBindlessTable.h"
+#include "CtImageDecode.h"
+#include "CtOrderedWork.h"
+#include "CtBarrierBatch.h"
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <thread>
+
+//A texture the streamer has every level of
+struct CtStreamedTexture{
+    uint32_t texture_id; //The store's
+    CtTextureData texture_data;
+
+    uint32_t baseline_mip; //It never has fewer levels than from here down
+    uint32_t resident_mip; //The finest level its image has
+    uint32_t wanted_mip;
+    uint32_t requested_mip; //The finest asked for since the last update, UINT32_MAX if nothing was
+    uint64_t last_requested; //Frame
+
+    bool uploading;
+    uint32_t upload_mip; //What it has coming while it's uploading
+};
+
+//A new image for a streamed texture on its way in
+struct CtStreamingUpload{
+    uint32_t stream_id;
+    uint32_t first_mip;
+    CtTexture texture;
+
+    VkBuffer staging_buffer; //Null when every level comes from the old image
+    VkDeviceMemory staging_buffer_memory;
+    VkCommandBuffer command_buffer;
+    VkFence fence;
+};
+
+//An image that got swapped out, waiting on the frames that might still be reading it
+struct CtRetiredTexture{
+    CtTexture texture;
+    uint64_t free_frame;
+};
+
+CtTextureStreamer* CtTextureStreamer::CreateTextureStreamer(CtDevice* device, CtTextureStore* texture_store, CtBindlessTable* bindless_table,
+    uint32_t budget_megabytes, uint32_t max_frames_in_flight){
+    CtTextureStreamer* ct_texture_streamer = new CtTextureStreamer();
+
+    ct_texture_streamer->device = device;
+    ct_texture_streamer->texture_store = texture_store;
+    ct_texture_streamer->bindless_table = bindless_table;
+    ct_texture_streamer->budget_limit = static_cast<VkDeviceSize>(budget_megabytes) * 1024 * 1024;
+    ct_texture_streamer->budget = ct_texture_streamer->budget_limit;
+    ct_texture_streamer->resident_size = 0;
+    ct_texture_streamer->frame = 0;
+    ct_texture_streamer->max_frames_in_flight = max_frames_in_flight;
+
+    ct_texture_streamer->CreateUploadPool();
+
+    printf("Created Texture Streamer (%u MB budget, driver budget %s).\n", budget_megabytes, device->GetOptionalFeatures().memory_budget ? "on" : "off");
+
+    return ct_texture_streamer;
+}
+
+/*************************************************************TEXTURES*****************************************************************/
+
+uint32_t CtTextureStreamer::AddTexture(CtTextureData texture_data){
+    CompleteMipChain(texture_data);
+    if(texture_data.levels.size() < texture_data.mip_levels){
+        return texture_store->AddTexture(texture_data);
+    }
+
+    texture_store->CheckTexture(texture_data);
+
+    uint32_t baseline_mip = 0;
+    while(baseline_mip + 1 < texture_data.mip_levels && (std::max(texture_data.width, texture_data.height) >> baseline_mip) > CT_TEXTURE_STREAMING_BASELINE_SIZE){
+        baseline_mip++;
+    }
+
+    //The levels at the bottom of the chain are tiny, so copying them out for the store is nothing next to the ones we keep
+    CtTextureData baseline {};
+    baseline.format = texture_data.format;
+    baseline.width = std::max(texture_data.width >> baseline_mip, 1u);
+    baseline.height = std::max(texture_data.height >> baseline_mip, 1u);
+    baseline.mip_levels = texture_data.mip_levels - baseline_mip;
+    baseline.levels.assign(texture_data.levels.begin() + baseline_mip, texture_data.levels.end());
+
+    uint32_t texture_id = texture_store->AddTexture(baseline);
+
+    CtStreamedTexture streamed_texture {};
+    streamed_texture.texture_id = texture_id;
+    streamed_texture.texture_data = std::move(texture_data);
+    streamed_texture.baseline_mip = baseline_mip;
+    streamed_texture.resident_mip = baseline_mip;
+    streamed_texture.wanted_mip = baseline_mip;
+    streamed_texture.requested_mip = UINT32_MAX;
+    streamed_texture.last_requested = frame;
+    streamed_texture.uploading = false;
+    streamed_textures.push_back(std::move(streamed_texture));
+
+    if(stream_ids.size() <= texture_id){
+        stream_ids.resize(texture_id + 1, CT_TEXTURE_STREAMING_NOT_STREAMED);
+    }
+    stream_ids[texture_id] = static_cast<uint32_t>(streamed_textures.size() - 1);
+
+    resident_size += texture_store->GetTexture(texture_id).size;
+
+    return texture_id;
+}
+
+//Decoding and the CPU mips are most of the work and run on every thread, adding stays on this one like it does in the store
+std::vector<uint32_t> CtTextureStreamer::LoadTextures(const std::vector<std::string>& paths, bool srgb, uint32_t thread_count){
+    auto start = std::chrono::steady_clock::now();
+
+    uint32_t count = static_cast<uint32_t>(paths.size());
+    if(thread_count == 0){
+        thread_count = std::min(std::max(std::thread::hardware_concurrency(), 1u), CT_TEXTURE_STORE_MAX_THREADS);
+    }
+    thread_count = std::max(std::min(thread_count, count), 1u);
+
+    std::vector<uint32_t> texture_ids;
+    texture_ids.reserve(count);
+    VkDeviceSize full_size = 0;
+
+    CtRunOrdered<CtTextureData>(count, thread_count, thread_count * CT_TEXTURE_STORE_PENDING_PER_THREAD,
+        [&](uint32_t i, CtTextureData& texture_data){
+            texture_data = texture_store->LoadTextureData(paths[i], srgb);
+            CompleteMipChain(texture_data);
+        },
+        [&](uint32_t, CtTextureData& texture_data){
+            for(const auto& level : texture_data.levels){
+                full_size += level.size();
+            }
+            texture_ids.push_back(AddTexture(std::move(texture_data)));
+        });
+
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("Loaded %u Streamed Textures (%.2f MB resident of %.2f MB) on %u threads in %.2f ms.\n", count, resident_size / (1024.0 * 1024.0),
+        full_size / (1024.0 * 1024.0), thread_count, milliseconds);
+
+    return texture_ids;
+}
+
+void CtTextureStreamer::RequestMip(uint32_t texture_id, uint32_t mip){
+    if(texture_id >= stream_ids.size() || stream_ids[texture_id] == CT_TEXTURE_STREAMING_NOT_STREAMED){
+        return;
+    }
+
+    CtStreamedTexture& streamed_texture = streamed_textures[stream_ids[texture_id]];
+    streamed_texture.requested_mip = std::min(streamed_texture.requested_mip, std::min(mip, streamed_texture.baseline_mip));
+}
+
+void CtTextureStreamer::RequestScreenSize(uint32_t texture_id, float pixels){
+    if(texture_id >= stream_ids.size() || stream_ids[texture_id] == CT_TEXTURE_STREAMING_NOT_STREAMED){
+        return;
+    }
+
+    const CtTextureData& texture_data = streamed_textures[stream_ids[texture_id]].texture_data;
+    float size = static_cast<float>(std::max(texture_data.width, texture_data.height));
+
+    uint32_t mip = 0;
+    if(pixels < size){
+        mip = static_cast<uint32_t>(std::floor(std::log2(size / std::max(pixels, 1.0f))));
+    }
+
+    RequestMip(texture_id, mip);
+}
+
+//RGBA8 and BGRA8 downsample the same way, alpha is the last byte in both
+void CtTextureStreamer::CompleteMipChain(CtTextureData& texture_data){
+    bool srgb;
+    switch(texture_data.format){
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+            srgb = false;
+            break;
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+            srgb = true;
+            break;
+        default:
+            return;
+    }
+    if(texture_data.levels.empty() || texture_data.levels.size() >= texture_data.mip_levels){
+        return;
+    }
+
+    uint32_t last = static_cast<uint32_t>(texture_data.levels.size() - 1);
+    CtImageData image {};
+    image.width = std::max(texture_data.width >> last, 1u);
+    image.height = std::max(texture_data.height >> last, 1u);
+    image.pixels = texture_data.levels[last];
+    if(image.pixels.size() != static_cast<size_t>(image.width) * image.height * 4){
+        return;
+    }
+
+    while(texture_data.levels.size() < texture_data.mip_levels){
+        image = CtImageDecode::Downsample(image, srgb);
+        texture_data.levels.push_back(image.pixels);
+    }
+}
+
+/***************************************************************UPDATE*****************************************************************/
+
+void CtTextureStreamer::Update(){
+    frame++;
+
+    FinishUploads(false);
+    FreeRetiredTextures(false);
+    UpdateWantedMips();
+    UpdateBudget();
+    PlanResidency();
+}
+
+//Swapping in is just pointing the store's texture at the new image. Frames already recorded still use the old one's bindless index,
+//so it gets retired the same way the table retires that index
+void CtTextureStreamer::FinishUploads(bool wait){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    size_t kept = 0;
+    for(size_t i = 0; i < uploads.size(); i++){
+        CtStreamingUpload& upload = uploads[i];
+
+        VkResult status = wait ? vkWaitForFences(interface_device, 1, &upload.fence, VK_TRUE, UINT64_MAX) : vkGetFenceStatus(interface_device, upload.fence);
+        if(status == VK_NOT_READY){
+            uploads[kept++] = upload;
+            continue;
+        }
+        if(status != VK_SUCCESS){
+            throw std::runtime_error("A texture streaming upload failed.");
+        }
+
+        CtStreamedTexture& streamed_texture = streamed_textures[upload.stream_id];
+        CtTexture& texture = texture_store->textures[streamed_texture.texture_id];
+
+        if(bindless_table != nullptr){
+            upload.texture.bindless_index = bindless_table->RegisterTexture(upload.texture.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            bindless_table->ReleaseTexture(texture.bindless_index);
+        }
+
+        resident_size = resident_size - texture.size + upload.texture.size;
+        retired_textures.push_back({texture, frame + max_frames_in_flight});
+        texture = upload.texture;
+
+        streamed_texture.resident_mip = upload.first_mip;
+        streamed_texture.uploading = false;
+
+        vkFreeCommandBuffers(interface_device, upload_pool, 1, &upload.command_buffer);
+        vkDestroyFence(interface_device, upload.fence, nullptr);
+        vkDestroyBuffer(interface_device, upload.staging_buffer, nullptr);
+        vkFreeMemory(interface_device, upload.staging_buffer_memory, nullptr);
+    }
+
+    uploads.resize(kept);
+}
+
+void CtTextureStreamer::FreeRetiredTextures(bool all){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    size_t kept = 0;
+    for(size_t i = 0; i < retired_textures.size(); i++){
+        if(!all && retired_textures[i].free_frame > frame){
+            retired_textures[kept++] = retired_textures[i];
+            continue;
+        }
+
+        const CtTexture& texture = retired_textures[i].texture;
+        vkDestroyImageView(interface_device, texture.view, nullptr);
+        vkDestroyImage(interface_device, texture.image, nullptr);
+        vkFreeMemory(interface_device, texture.memory, nullptr);
+    }
+
+    retired_textures.resize(kept);
+}
+
+//What was asked for sticks until it goes unasked for long enough, so something seen every few frames doesn't keep streaming out and back in
+void CtTextureStreamer::UpdateWantedMips(){
+    for(auto& streamed_texture : streamed_textures){
+        if(streamed_texture.requested_mip != UINT32_MAX){
+            streamed_texture.wanted_mip = streamed_texture.requested_mip;
+            streamed_texture.last_requested = frame;
+            streamed_texture.requested_mip = UINT32_MAX;
+        }
+        else if(frame - streamed_texture.last_requested > CT_TEXTURE_STREAMING_IDLE_FRAMES){
+            streamed_texture.wanted_mip = streamed_texture.baseline_mip;
+        }
+    }
+}
+
+//The driver's usage is the whole process, us included. Whatever isn't ours belongs to everything else, and we take a share of what's left past that
+void CtTextureStreamer::UpdateBudget(){
+    VkDeviceSize device_budget;
+    VkDeviceSize device_usage;
+    device->GetDeviceLocalBudget(device_budget, device_usage);
+
+    VkDeviceSize allocated = resident_size;
+    for(const auto& upload : uploads){
+        allocated += upload.texture.size;
+    }
+    for(const auto& retired_texture : retired_textures){
+        allocated += retired_texture.texture.size;
+    }
+
+    VkDeviceSize others = device_usage > allocated ? device_usage - allocated : 0;
+    VkDeviceSize available = device_budget > others ? static_cast<VkDeviceSize>((device_budget - others) * CT_TEXTURE_STREAMING_BUDGET_SHARE) : 0;
+
+    budget = std::min(budget_limit, available);
+}
+
+//Everything is counted at what it's headed for, so uploads that haven't landed are already spent. Over budget, textures holding finer mips
+//than they want give them back first, least recently asked for first, and then the least recently asked for lose a level at a time. Under it,
+//the textures furthest from what they want go first and get the finest level that fits, taking back mips nobody wants to make room.
+//While an upload is going both images exist, so we can briefly go over by the new one. That's what the share leaves room for
+void CtTextureStreamer::PlanResidency(){
+    VkDeviceSize committed = 0;
+    std::vector<uint32_t> shrinking;
+    std::vector<uint32_t> growing;
+    for(uint32_t i = 0; i < streamed_textures.size(); i++){
+        const CtStreamedTexture& streamed_texture = streamed_textures[i];
+        committed += GetCommittedSize(i);
+
+        if(streamed_texture.uploading){
+            continue;
+        }
+        if(streamed_texture.resident_mip < streamed_texture.baseline_mip){
+            shrinking.push_back(i);
+        }
+        if(streamed_texture.wanted_mip < streamed_texture.resident_mip){
+            growing.push_back(i);
+        }
+    }
+
+    //Mips nobody wants first, then by how long ago it was asked for
+    std::sort(shrinking.begin(), shrinking.end(), [&](uint32_t a, uint32_t b){
+        const CtStreamedTexture& first = streamed_textures[a];
+        const CtStreamedTexture& second = streamed_textures[b];
+        bool first_extra = first.resident_mip < first.wanted_mip;
+        bool second_extra = second.resident_mip < second.wanted_mip;
+        if(first_extra != second_extra){
+            return first_extra;
+        }
+        return first.last_requested < second.last_requested;
+    });
+
+    //Most levels short first, then the most recently asked for
+    std::sort(growing.begin(), growing.end(), [&](uint32_t a, uint32_t b){
+        const CtStreamedTexture& first = streamed_textures[a];
+        const CtStreamedTexture& second = streamed_textures[b];
+        uint32_t first_missing = first.resident_mip - first.wanted_mip;
+        uint32_t second_missing = second.resident_mip - second.wanted_mip;
+        if(first_missing != second_missing){
+            return first_missing > second_missing;
+        }
+        return first.last_requested > second.last_requested;
+    });
+
+    //Only what comes from the CPU counts against the limits. Levels the old image already has are a copy on the GPU, so a shrink
+    //always gets to start
+    uint32_t staging = 0;
+    for(const auto& upload : uploads){
+        staging += upload.staging_buffer != VK_NULL_HANDLE ? 1 : 0;
+    }
+
+    VkDeviceSize started = 0;
+    auto can_start = [&](uint32_t stream_id, uint32_t first_mip){
+        VkDeviceSize size = GetUploadSize(stream_id, first_mip);
+        return size == 0 || (staging < CT_TEXTURE_STREAMING_MAX_UPLOADS && (started == 0 || started + size <= CT_TEXTURE_STREAMING_UPLOAD_BYTES_PER_FRAME));
+    };
+    auto start = [&](uint32_t stream_id, uint32_t first_mip){
+        VkDeviceSize size = GetUploadSize(stream_id, first_mip);
+        committed = committed - GetCommittedSize(stream_id) + GetStreamedSize(stream_id, first_mip);
+        started += size;
+        staging += size > 0 ? 1 : 0;
+        StartUpload(stream_id, first_mip);
+    };
+
+    //Taking back mips nobody wants only ever frees memory, so these go as far as the texture wants at once
+    size_t next_shrink = 0;
+    auto shrink_extra = [&](){
+        while(next_shrink < shrinking.size()){
+            const CtStreamedTexture& streamed_texture = streamed_textures[shrinking[next_shrink]];
+            if(streamed_texture.uploading){
+                next_shrink++;
+                continue;
+            }
+            if(streamed_texture.resident_mip >= streamed_texture.wanted_mip){
+                return false;
+            }
+
+            uint32_t stream_id = shrinking[next_shrink++];
+            if(!can_start(stream_id, streamed_texture.wanted_mip)){
+                return false;
+            }
+            start(stream_id, streamed_texture.wanted_mip);
+            return true;
+        }
+        return false;
+    };
+
+    bool shrinking_extra = true;
+    while(committed > budget && shrinking_extra){
+        shrinking_extra = shrink_extra();
+    }
+
+    //Still over means the budget shrank under what's actually wanted, so everything starts giving up its finest level
+    for(size_t i = next_shrink; i < shrinking.size() && committed > budget; i++){
+        const CtStreamedTexture& streamed_texture = streamed_textures[shrinking[i]];
+        if(streamed_texture.uploading){
+            continue;
+        }
+        if(!can_start(shrinking[i], streamed_texture.resident_mip + 1)){
+            break;
+        }
+        start(shrinking[i], streamed_texture.resident_mip + 1);
+    }
+
+    for(uint32_t stream_id : growing){
+        const CtStreamedTexture& streamed_texture = streamed_textures[stream_id];
+        if(streamed_texture.uploading){
+            continue;
+        }
+
+        //The finest level that fits, making room from mips nobody wants when it doesn't
+        uint32_t first_mip = streamed_texture.resident_mip;
+        for(uint32_t mip = streamed_texture.wanted_mip; mip < streamed_texture.resident_mip; mip++){
+            VkDeviceSize size = GetStreamedSize(stream_id, mip);
+            bool fits = committed - GetCommittedSize(stream_id) + size <= budget;
+            while(!fits && shrink_extra()){
+                fits = committed - GetCommittedSize(stream_id) + size <= budget;
+            }
+            if(fits){
+                first_mip = mip;
+                break;
+            }
+        }
+
+        if(first_mip == streamed_texture.resident_mip || !can_start(stream_id, first_mip)){
+            continue;
+        }
+        start(stream_id, first_mip);
+    }
+}
+
+VkDeviceSize CtTextureStreamer::GetStreamedSize(uint32_t stream_id, uint32_t first_mip){
+    const CtTextureData& texture_data = streamed_textures[stream_id].texture_data;
+
+    CtFormatBlock block {};
+    CtTextureStore::GetFormatBlock(texture_data.format, block);
+
+    VkDeviceSize size = 0;
+    for(uint32_t mip = first_mip; mip < texture_data.mip_levels; mip++){
+        size += CtTextureStore::GetLevelSize(block, texture_data.width, texture_data.height, mip);
+    }
+
+    return size;
+}
+
+//Just the levels finer than what's resident, everything else gets copied over from the old image
+VkDeviceSize CtTextureStreamer::GetUploadSize(uint32_t stream_id, uint32_t first_mip){
+    const CtStreamedTexture& streamed_texture = streamed_textures[stream_id];
+    const CtTextureData& texture_data = streamed_texture.texture_data;
+
+    CtFormatBlock block {};
+    CtTextureStore::GetFormatBlock(texture_data.format, block);
+
+    VkDeviceSize size = 0;
+    for(uint32_t mip = first_mip; mip < streamed_texture.resident_mip; mip++){
+        size += CtTextureStore::GetLevelSize(block, texture_data.width, texture_data.height, mip);
+    }
+
+    return size;
+}
+
+//What it takes now, or what it's going to once its upload lands
+VkDeviceSize CtTextureStreamer::GetCommittedSize(uint32_t stream_id){
+    const CtStreamedTexture& streamed_texture = streamed_textures[stream_id];
+    if(streamed_texture.uploading){
+        return GetStreamedSize(stream_id, streamed_texture.upload_mip);
+    }
+
+    return texture_store->GetTexture(streamed_texture.texture_id).size;
+}
+
+/**************************************************************UPLOADS*****************************************************************/
+
+//Levels the resident image already has get copied across on the GPU and only the finer ones are staged, the same way the store stages.
+//It goes out with a fence and we check on it next frame instead of waiting
+void CtTextureStreamer::StartUpload(uint32_t stream_id, uint32_t first_mip){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+    CtStreamedTexture& streamed_texture = streamed_textures[stream_id];
+    const CtTextureData& texture_data = streamed_texture.texture_data;
+    const CtTexture& resident = texture_store->GetTexture(streamed_texture.texture_id);
+
+    CtStreamingUpload upload {};
+    upload.stream_id = stream_id;
+    upload.first_mip = first_mip;
+    upload.texture.format = texture_data.format;
+    upload.texture.width = std::max(texture_data.width >> first_mip, 1u);
+    upload.texture.height = std::max(texture_data.height >> first_mip, 1u);
+    upload.texture.mip_levels = texture_data.mip_levels - first_mip;
+    upload.texture.bindless_index = CT_BINDLESS_INVALID_INDEX;
+
+    texture_store->CreateImage(upload.texture);
+    texture_store->CreateImageView(upload.texture);
+
+    std::vector<VkBufferImageCopy> copy_regions;
+    upload.staging_buffer = VK_NULL_HANDLE;
+    upload.staging_buffer_memory = VK_NULL_HANDLE;
+    if(first_mip < streamed_texture.resident_mip){
+        CtTexture staged = upload.texture;
+        staged.mip_levels = streamed_texture.resident_mip - first_mip;
+        texture_store->StageLevels(staged, texture_data.levels, first_mip, upload.staging_buffer, upload.staging_buffer_memory, copy_regions);
+    }
+
+    VkCommandBufferAllocateInfo allocate_info {};
+    allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocate_info.commandPool = upload_pool;
+    allocate_info.commandBufferCount = 1;
+
+    if(vkAllocateCommandBuffers(interface_device, &allocate_info, &upload.command_buffer) != VK_SUCCESS){
+        throw std::runtime_error("Failed to allocate a texture streaming command buffer.");
+    }
+
+    VkCommandBufferBeginInfo begin_info {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(upload.command_buffer, &begin_info);
+
+    RecordUpload(upload.command_buffer, upload, resident, streamed_texture.resident_mip, copy_regions);
+
+    vkEndCommandBuffer(upload.command_buffer);
+
+    VkFenceCreateInfo fence_info {};
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    if(vkCreateFence(interface_device, &fence_info, nullptr, &upload.fence) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create a texture streaming fence.");
+    }
+
+    VkSubmitInfo submit_info {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &upload.command_buffer;
+
+    if(vkQueueSubmit(device->queue_family->graphics_queue, 1, &submit_info, upload.fence) != VK_SUCCESS){
+        throw std::runtime_error("Failed to submit a texture streaming upload.");
+    }
+
+    streamed_texture.uploading = true;
+    streamed_texture.upload_mip = first_mip;
+    uploads.push_back(upload);
+}
+
+//The resident image is still being sampled by frames in flight. Those are all on this queue, so it can leave SHADER_READ_ONLY for the
+//copy as long as it waits on them first and frames after it wait for it to come back
+void CtTextureStreamer::RecordUpload(VkCommandBuffer command_buffer, const CtStreamingUpload& upload, const CtTexture& resident, uint32_t resident_mip,
+    const std::vector<VkBufferImageCopy>& copy_regions){
+    const CtTexture& texture = upload.texture;
+    VkPipelineStageFlags2 sampling_stages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+
+    //Where the two chains line up. Everything from max(first_mip, resident_mip) on down is in both
+    uint32_t shared_mip = std::max(upload.first_mip, resident_mip);
+    uint32_t shared_levels = texture.mip_levels - (shared_mip - upload.first_mip);
+
+    VkImageSubresourceRange all_levels {};
+    all_levels.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    all_levels.baseMipLevel = 0;
+    all_levels.levelCount = texture.mip_levels;
+    all_levels.baseArrayLayer = 0;
+    all_levels.layerCount = 1;
+
+    VkImageSubresourceRange resident_levels = all_levels;
+    resident_levels.baseMipLevel = shared_mip - resident_mip;
+    resident_levels.levelCount = shared_levels;
+
+    CtBarrierBatch barriers(device);
+    barriers.AddImageBarrier(texture.image, all_levels,
+        VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    barriers.AddImageBarrier(resident.image, resident_levels,
+        sampling_stages, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    barriers.Flush(command_buffer);
+
+    std::vector<VkImageCopy> image_copies;
+    for(uint32_t level = 0; level < shared_levels; level++){
+        uint32_t mip = shared_mip + level;
+
+        VkImageCopy image_copy {};
+        image_copy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        image_copy.srcSubresource.mipLevel = mip - resident_mip;
+        image_copy.srcSubresource.baseArrayLayer = 0;
+        image_copy.srcSubresource.layerCount = 1;
+        image_copy.dstSubresource = image_copy.srcSubresource;
+        image_copy.dstSubresource.mipLevel = mip - upload.first_mip;
+        image_copy.extent = {std::max(texture.width >> (mip - upload.first_mip), 1u), std::max(texture.height >> (mip - upload.first_mip), 1u), 1};
+        image_copies.push_back(image_copy);
+    }
+
+    vkCmdCopyImage(command_buffer, resident.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        static_cast<uint32_t>(image_copies.size()), image_copies.data());
+
+    if(!copy_regions.empty()){
+        vkCmdCopyBufferToImage(command_buffer, upload.staging_buffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            static_cast<uint32_t>(copy_regions.size()), copy_regions.data());
+    }
+
+    barriers.AddImageBarrier(resident.image, resident_levels,
+        VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        sampling_stages, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    barriers.AddImageBarrier(texture.image, all_levels,
+        VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        sampling_stages, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    barriers.Flush(command_buffer);
+}
+
+//Same family as the frame's work, the store's RecordUpload barriers are written for the stages the graphics queue has
+void CtTextureStreamer::CreateUploadPool(){
+    VkCommandPoolCreateInfo pool_info {};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pool_info.queueFamilyIndex = device->queue_family->graphics_family.value();
+
+    if(vkCreateCommandPool(*(device->GetInterfaceDevice()), &pool_info, nullptr, &upload_pool) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create the texture streamer's upload pool.");
+    }
+}
+
+void CtTextureStreamer::Cleanup(){
+    FinishUploads(true);
+    FreeRetiredTextures(true);
+
+    streamed_textures.clear();
+    stream_ids.clear();
+    resident_size = 0;
+
+    vkDestroyCommandPool(*(device->GetInterfaceDevice()), upload_pool, nullptr);
+}
@@ -0,0 +1,118 @@
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+class CtDevice;
+class CtTextureStore;
+class CtBindlessTable;
+struct CtTextureData;
+struct CtTexture;
+struct CtStreamedTexture;
+struct CtStreamingUpload;
+struct CtRetiredTexture;
+
+//A streamed texture always keeps every level from the first one this big or smaller (on its longest side) on down
+const uint32_t CT_TEXTURE_STREAMING_BASELINE_SIZE = 128;
+
+//Uploads staging from the CPU that can be in flight at once, and the most bytes of them that can be started in one frame. One always gets
+//to start, however big it is, or a big enough top level would never come in
+const uint32_t CT_TEXTURE_STREAMING_MAX_UPLOADS = 4;
+const VkDeviceSize CT_TEXTURE_STREAMING_UPLOAD_BYTES_PER_FRAME = 32 * 1024 * 1024;
+
+//Frames a texture can go without being asked for before the mips it wanted stop counting for anything
+const uint64_t CT_TEXTURE_STREAMING_IDLE_FRAMES = 120;
+
+//How much of what the driver says is left we let ourselves have. Render targets and whatever else gets allocated later need the rest
+const float CT_TEXTURE_STREAMING_BUDGET_SHARE = 0.8f;
+
+//What stream_ids holds for store textures that aren't streamed
+const uint32_t CT_TEXTURE_STREAMING_NOT_STREAMED = UINT32_MAX;
+
+//Keeps every texture's low mips on the GPU and streams the rest in and out under a memory budget. Whatever draws with a texture asks
+//for the mip it needs, from its size on screen or from the GPU saying what it sampled, and once a frame the textures furthest from
+//what they were asked for get the closest they can fit. The budget is the setting, or less when VK_EXT_memory_budget says the device
+//is running out.
+//A texture's mips can't be added to or taken off its image, so every change is a new image with just the levels it's getting. Levels
+//the old image has are copied over on the GPU and only finer ones come from the full chain kept on the CPU. Uploads go out with a fence and are swapped in once they land, so nothing ever waits on them,
+//and the old image sticks around until no frame in flight can still be reading it
+class CtTextureStreamer{
+
+    public:
+        static CtTextureStreamer* CreateTextureStreamer(CtDevice* device, CtTextureStore* texture_store, CtBindlessTable* bindless_table,
+            uint32_t budget_megabytes, uint32_t max_frames_in_flight);
+
+        //Adds it to the store with only its baseline and keeps every level here to stream from. Block compressed textures that
+        //don't bring all their levels can't have the rest made on the CPU, so they go in whole and never stream
+        uint32_t AddTexture(CtTextureData texture_data);
+
+        //The store's LoadTextures, but with every level made on the decoding threads and each texture added at its baseline
+        std::vector<uint32_t> LoadTextures(const std::vector<std::string>& paths, bool srgb, uint32_t thread_count = 0);
+
+        //Asks for texture_id to have mip (0 is full size) on the GPU. The finest one asked for between two updates is what it wants.
+        //Textures that aren't streamed are ignored
+        void RequestMip(uint32_t texture_id, uint32_t mip);
+
+        //Asks for the mip that's about a texel per pixel when the whole texture is this many pixels across on screen
+        void RequestScreenSize(uint32_t texture_id, float pixels);
+
+        //Once a frame after waiting on its fence. Swaps in uploads that landed, frees images no frame can still be reading, then works
+        //out the budget and starts the uploads that get closest to what everything asked for
+        void Update();
+
+        //Every streamed texture's image, baselines included, against what they're allowed
+        VkDeviceSize GetResidentSize(){
+            return resident_size;
+        }
+        VkDeviceSize GetBudget(){
+            return budget;
+        }
+
+        //Waits on uploads still going and swaps them in, so the store's Cleanup frees everything. Anything drawing with these has to be done first
+        void Cleanup();
+
+    private:
+
+        CtDevice* device;
+        CtTextureStore* texture_store;
+        CtBindlessTable* bindless_table; //Can be null
+
+        VkDeviceSize budget_limit; //The setting
+        VkDeviceSize budget; //This frame's, the setting or whatever the driver leaves us if that's less
+        VkDeviceSize resident_size;
+
+        std::vector<CtStreamedTexture> streamed_textures;
+        std::vector<uint32_t> stream_ids; //Per store texture, which streamed texture it is
+
+        std::vector<CtStreamingUpload> uploads;
+        std::vector<CtRetiredTexture> retired_textures;
+
+        VkCommandPool upload_pool;
+
+        uint64_t frame;
+        uint32_t max_frames_in_flight;
+
+        void CreateUploadPool();
+
+        void FinishUploads(bool wait);
+        void FreeRetiredTextures(bool all);
+        void UpdateWantedMips();
+        void UpdateBudget();
+        void PlanResidency();
+
+        //Makes the image for mips first_mip on down and starts filling it
+        void StartUpload(uint32_t stream_id, uint32_t first_mip);
+        void RecordUpload(VkCommandBuffer command_buffer, const CtStreamingUpload& upload, const CtTexture& resident, uint32_t resident_mip,
+            const std::vector<VkBufferImageCopy>& copy_regions);
+
+        //What the image for first_mip on down should come out to, near enough. The real one only gets known once it exists
+        VkDeviceSize GetStreamedSize(uint32_t stream_id, uint32_t first_mip);
+        VkDeviceSize GetCommittedSize(uint32_t stream_id);
+
+        //The part of that which has to be staged
+        VkDeviceSize GetUploadSize(uint32_t stream_id, uint32_t first_mip);
+
+        //Downsamples the last level it has until it has every one. Only works on formats with one texel per 4 bytes, anything
+        //else is left alone
+        static void CompleteMipChain(CtTextureData& texture_data);
+};
@@ -0,0 +1,58 @@
+#include <atomic>
+#include <array>
+#include <cstdint>
+
+//A lock-free triple buffer for handing whole objects from one producer thread to one consumer thread.
+//The producer always has a slot to write into, the consumer always has a slot to read from, and the third slot
+//sits in the middle holding the newest published object. Neither side ever waits on the other, the worst case is the
+//consumer reading the same object twice or the producer overwriting something that was never read.
+template<typename T>
+class CtTripleBuffer{
+
+    public:
+
+        //Producer side: the slot we are allowed to fill in
+        T& BeginWrite(){
+            return buffers[write_index].value;
+        }
+
+        //Producer side: hand the slot we just filled to the middle and take whatever was there back
+        void Publish(){
+            uint32_t previous = middle_state.exchange(write_index | FRESH_BIT, std::memory_order_acq_rel);
+            write_index = previous & INDEX_MASK;
+        }
+
+        //Consumer side: grab the newest object if one was published since we last looked. Returns true if Read() changed
+        bool Consume(){
+            if((middle_state.load(std::memory_order_relaxed) & FRESH_BIT) == 0){
+                return false;
+            }
+
+            uint32_t previous = middle_state.exchange(read_index, std::memory_order_acq_rel);
+            read_index = previous & INDEX_MASK;
+            return true;
+        }
+
+        //Consumer side: the object we currently own. Stays valid until the next Consume()
+        const T& Read() const{
+            return buffers[read_index].value;
+        }
+
+    private:
+        static constexpr uint32_t INDEX_MASK = 0x3;
+        static constexpr uint32_t FRESH_BIT = 0x4;
+
+        //Each slot gets its own cache line so the two threads don't fight over them
+        struct alignas(64) Slot{
+            T value;
+        };
+
+        std::array<Slot, 3> buffers;
+
+        //Only ever touched by the producer
+        alignas(64) uint32_t write_index = 0;
+        //Only ever touched by the consumer
+        alignas(64) uint32_t read_index = 1;
+        //The index of the middle slot plus whether it holds something the consumer hasn't seen
+        alignas(64) std::atomic<uint32_t> middle_state {2};
+};
@@ -0,0 +1,95 @@
+#include "CtUniformRing.h"
+#include "CtDevice.h"
+#include <stdexcept>
+#include <cstring>
+
+CtUniformRing* CtUniformRing::CreateUniformRing(CtDevice* device, VkDeviceSize frame_size, uint32_t max_frames_in_flight){
+    CtUniformRing* ct_uniform_ring = new CtUniformRing();
+
+    ct_uniform_ring->device = device;
+
+    VkPhysicalDeviceProperties properties {};
+    vkGetPhysicalDeviceProperties(*(device->GetPhysicalDevice()), &properties);
+    ct_uniform_ring->alignment = properties.limits.minUniformBufferOffsetAlignment;
+
+    //Each region has to start aligned too, otherwise the first push of every other frame would be off
+    VkDeviceSize alignment = ct_uniform_ring->alignment;
+    ct_uniform_ring->frame_size = (frame_size + alignment - 1) & ~(alignment - 1);
+    ct_uniform_ring->frame_start = 0;
+    ct_uniform_ring->head = 0;
+
+    ct_uniform_ring->CreateBuffer(ct_uniform_ring->frame_size * max_frames_in_flight);
+
+    printf("Created Uniform Ring.\n");
+
+    return ct_uniform_ring;
+}
+
+//We write this from the CPU every frame and the GPU reads it once per draw, so it should just stay mapped.
+//If the GPU lets us map device local memory we take that, otherwise plain host memory is fine for uniforms
+void CtUniformRing::CreateBuffer(VkDeviceSize size){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    VkBufferCreateInfo buffer_info {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = size;
+    buffer_info.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if(vkCreateBuffer(interface_device, &buffer_info, nullptr, &buffer) != VK_SUCCESS){
+        throw std::runtime_error("Failed to create the uniform ring buffer.");
+    }
+
+    VkMemoryRequirements memory_requirements;
+    vkGetBufferMemoryRequirements(interface_device, buffer, &memory_requirements);
+
+    VkMemoryAllocateInfo allocate_info {};
+    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocate_info.allocationSize = memory_requirements.size;
+
+    try{
+        allocate_info.memoryTypeIndex = device->FindMemoryType(memory_requirements.memoryTypeBits,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    } catch(const std::runtime_error&){
+        allocate_info.memoryTypeIndex = device->FindMemoryType(memory_requirements.memoryTypeBits,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    }
+
+    if(vkAllocateMemory(interface_device, &allocate_info, nullptr, &buffer_memory) != VK_SUCCESS){
+        throw std::runtime_error("Failed to allocate the uniform ring memory.");
+    }
+
+    vkBindBufferMemory(interface_device, buffer, buffer_memory, 0);
+
+    void* data;
+    if(vkMapMemory(interface_device, buffer_memory, 0, size, 0, &data) != VK_SUCCESS){
+        throw std::runtime_error("Failed to map the uniform ring memory.");
+    }
+    mapped = static_cast<uint8_t*>(data);
+}
+
+void CtUniformRing::BeginFrame(uint32_t frame){
+    frame_start = frame_size * frame;
+    head = frame_start;
+}
+
+uint32_t CtUniformRing::Push(const void* data, VkDeviceSize size){
+    if(head + size > frame_start + frame_size){
+        throw std::runtime_error("Uniform ring is out of space for this frame. Give it a bigger frame size.");
+    }
+
+    memcpy(mapped + head, data, static_cast<size_t>(size));
+
+    uint32_t offset = static_cast<uint32_t>(head);
+    head = (head + size + alignment - 1) & ~(alignment - 1);
+
+    return offset;
+}
+
+void CtUniformRing::Cleanup(){
+    VkDevice interface_device = *(device->GetInterfaceDevice());
+
+    vkUnmapMemory(interface_device, buffer_memory);
+    vkDestroyBuffer(interface_device, buffer, nullptr);
+    vkFreeMemory(interface_device, buffer_memory, nullptr);
+}
@@ -0,0 +1,48 @@
+#include <vulkan/vulkan.h>
+#include <cstdint>
+
+class CtDevice;
+
+//One big uniform buffer that stays mapped for the whole run, split into a region per frame in flight. Each draw copies its
+//constants to the front of the current region and gets back the dynamic offset to bind with, so a thousand objects
+//are a thousand offsets into one buffer instead of a thousand buffers and sets.
+//The buffer is meant to be bound through a VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC descriptor that covers one block
+class CtUniformRing{
+
+    public:
+        static CtUniformRing* CreateUniformRing(CtDevice* device, VkDeviceSize frame_size, uint32_t max_frames_in_flight);
+
+        //Call once the frame's fence has signaled, that region is free to be written over again
+        void BeginFrame(uint32_t frame);
+
+        //Copies the data in and returns the offset to hand to vkCmdBindDescriptorSets
+        uint32_t Push(const void* data, VkDeviceSize size);
+
+        template<typename T>
+        uint32_t Push(const T& data){
+            return Push(&data, sizeof(T));
+        }
+
+        VkBuffer GetBuffer(){
+            return buffer;
+        }
+
+        void Cleanup();
+
+    private:
+
+        CtDevice* device;
+
+        VkBuffer buffer;
+        VkDeviceMemory buffer_memory;
+        uint8_t* mapped;
+
+        //Every push starts on a multiple of this, the GPU won't take dynamic offsets that aren't
+        VkDeviceSize alignment;
+
+        VkDeviceSize frame_size;
+        VkDeviceSize frame_start;
+        VkDeviceSize head;
+
+        void CreateBuffer(VkDeviceSize size);
+};
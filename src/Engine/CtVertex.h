@@ -3,56 +3,305 @@
 #include <vulkan/vulkan.h>
 #include <vector>
 #include <array>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <functional>
 
 
+//A vertex at full precision. This is what meshes get built and loaded as, a CtVertexLayout decides what it turns into on the GPU
 struct CtVertex {
     glm::vec2 position;
     glm::vec3 color;
     glm::vec2 texCoord;
+    glm::vec3 normal;
 
-    static VkVertexInputBindingDescription GetBindingDescription(){
+    bool operator==(const CtVertex& other) const{
+        return position == other.position && color == other.color && texCoord == other.texCoord && normal == other.normal;
+    }
+};
+
+//Mixes the bits of every component. -0 and 0 compare equal, so they have to hash the same too
+inline uint64_t CtHashVertex(const CtVertex& vertex){
+    const float values[10] = {
+        vertex.position.x, vertex.position.y,
+        vertex.color.x, vertex.color.y, vertex.color.z,
+        vertex.texCoord.x, vertex.texCoord.y,
+        vertex.normal.x, vertex.normal.y, vertex.normal.z
+    };
+
+    uint64_t hash = 0x9E3779B97F4A7C15ull;
+    for(float value : values){
+        uint32_t bits = 0;
+        if(value != 0.0f){
+            memcpy(&bits, &value, sizeof(bits));
+        }
+
+        hash = (hash ^ bits) * 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 32;
+    }
+
+    //Finish it off so the low and the high bits are both usable
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ull;
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+namespace std{
+    template<>
+    struct hash<CtVertex>{
+        size_t operator()(const CtVertex& vertex) const{
+            return static_cast<size_t>(CtHashVertex(vertex));
+        }
+    };
+}
+
+//What an attribute holds. Each one always goes to the same shader location no matter the layout, so a shader doesn't
+//have to change when a mesh gets quantized differently, and the instance data can start right after the last one
+enum CtVertexSemantic{
+    CT_VERTEX_POSITION = 0,
+    CT_VERTEX_COLOR = 1,
+    CT_VERTEX_TEXCOORD = 2,
+    CT_VERTEX_NORMAL = 3,
+
+    CT_VERTEX_SEMANTIC_COUNT = 4
+};
+
+inline glm::vec4 CtReadVertexSemantic(const CtVertex& vertex, CtVertexSemantic semantic){
+    switch(semantic){
+        case CT_VERTEX_POSITION:
+            return glm::vec4(vertex.position.x, vertex.position.y, 0.0f, 1.0f);
+        case CT_VERTEX_COLOR:
+            return glm::vec4(vertex.color, 1.0f);
+        case CT_VERTEX_TEXCOORD:
+            return glm::vec4(vertex.texCoord.x, vertex.texCoord.y, 0.0f, 0.0f);
+        case CT_VERTEX_NORMAL:
+            return glm::vec4(vertex.normal, 0.0f);
+        default:
+            return glm::vec4(0.0f);
+    }
+}
+
+//Round to nearest even, same as the GPU would. Too big turns into infinity and too small into a subnormal or zero
+inline uint16_t CtFloatToHalf(float value){
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t float_exponent = (bits >> 23) & 0xFF;
+    int32_t exponent = static_cast<int32_t>(float_exponent) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if(float_exponent == 0xFF){
+        return static_cast<uint16_t>(sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0));
+    }
+    if(exponent >= 31){
+        return static_cast<uint16_t>(sign | 0x7C00);
+    }
+
+    if(exponent <= 0){
+        if(exponent < -10){
+            return static_cast<uint16_t>(sign);
+        }
+
+        mantissa |= 0x800000;
+        uint32_t shift = static_cast<uint32_t>(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if(rest > halfway || (rest == halfway && (half & 1))){
+            half++;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    //Rounding up can carry into the exponent, which is still the right answer
+    uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1FFF;
+    if(rest > 0x1000 || (rest == 0x1000 && (half & 1))){
+        half++;
+    }
+    return static_cast<uint16_t>(sign | half);
+}
+
+/**************************************************************ENCODINGS*****************************************************************/
+
+//How one attribute gets stored. Every encoding is a multiple of 4 bytes so the attributes after it stay aligned
+
+struct CtFloat2{
+    static constexpr uint32_t size = 8;
+    static constexpr VkFormat format = VK_FORMAT_R32G32_SFLOAT;
+
+    static void Encode(const glm::vec4& value, uint8_t* out){
+        float packed[2] = {value.x, value.y};
+        memcpy(out, packed, size);
+    }
+};
+
+struct CtFloat3{
+    static constexpr uint32_t size = 12;
+    static constexpr VkFormat format = VK_FORMAT_R32G32B32_SFLOAT;
+
+    static void Encode(const glm::vec4& value, uint8_t* out){
+        float packed[3] = {value.x, value.y, value.z};
+        memcpy(out, packed, size);
+    }
+};
+
+//Around three significant digits, and nothing past 65504. Fine for positions in a small mesh space
+struct CtHalf2{
+    static constexpr uint32_t size = 4;
+    static constexpr VkFormat format = VK_FORMAT_R16G16_SFLOAT;
+
+    static void Encode(const glm::vec4& value, uint8_t* out){
+        uint16_t packed[2] = {CtFloatToHalf(value.x), CtFloatToHalf(value.y)};
+        memcpy(out, packed, size);
+    }
+};
+
+//Three component halves are barely supported as vertex formats, so a 3D position carries w along with it
+struct CtHalf4{
+    static constexpr uint32_t size = 8;
+    static constexpr VkFormat format = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+    static void Encode(const glm::vec4& value, uint8_t* out){
+        uint16_t packed[4] = {CtFloatToHalf(value.x), CtFloatToHalf(value.y), CtFloatToHalf(value.z), CtFloatToHalf(value.w)};
+        memcpy(out, packed, size);
+    }
+};
+
+//Colors in 0 to 1. The shader still reads floats
+struct CtUnorm8x4{
+    static constexpr uint32_t size = 4;
+    static constexpr VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+
+    static void Encode(const glm::vec4& value, uint8_t* out){
+        for(uint32_t c = 0; c < 4; c++){
+            float clamped = value[c] < 0.0f ? 0.0f : (value[c] > 1.0f ? 1.0f : value[c]);
+            out[c] = static_cast<uint8_t>(std::lround(clamped * 255.0f));
+        }
+    }
+};
+
+//Texture coordinates that stay inside 0 to 1. Anything that tiles past that should use CtHalf2 instead, this clamps
+struct CtUnorm16x2{
+    static constexpr uint32_t size = 4;
+    static constexpr VkFormat format = VK_FORMAT_R16G16_UNORM;
+
+    static void Encode(const glm::vec4& value, uint8_t* out){
+        uint16_t packed[2];
+        for(uint32_t c = 0; c < 2; c++){
+            float clamped = value[c] < 0.0f ? 0.0f : (value[c] > 1.0f ? 1.0f : value[c]);
+            packed[c] = static_cast<uint16_t>(std::lround(clamped * 65535.0f));
+        }
+        memcpy(out, packed, size);
+    }
+};
+
+//A unit vector folded onto an octahedron and flattened into two snorms. To get it back in the shader:
+//  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y)); if(n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * sign(n.xy); n = normalize(n);
+//where sign has to treat 0 as positive
+struct CtOctahedral16{
+    static constexpr uint32_t size = 4;
+    static constexpr VkFormat format = VK_FORMAT_R16G16_SNORM;
+
+    static void Encode(const glm::vec4& value, uint8_t* out){
+        float length = std::fabs(value.x) + std::fabs(value.y) + std::fabs(value.z);
+        float x = length > 0.0f ? value.x / length : 0.0f;
+        float y = length > 0.0f ? value.y / length : 0.0f;
+
+        //The bottom half gets folded over the top one
+        if(value.z < 0.0f){
+            float folded_x = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            float folded_y = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = folded_x;
+            y = folded_y;
+        }
+
+        int16_t packed[2] = {static_cast<int16_t>(std::lround(x * 32767.0f)), static_cast<int16_t>(std::lround(y * 32767.0f))};
+        memcpy(out, packed, size);
+    }
+};
+
+/**************************************************************LAYOUTS*****************************************************************/
+
+template<CtVertexSemantic Semantic, typename Encoding>
+struct CtVertexAttribute{
+    static constexpr CtVertexSemantic semantic = Semantic;
+    using encoding = Encoding;
+};
+
+//A GPU vertex format put together out of CtVertexAttributes, packed back to back in the order given. The stride and the
+//binding and attribute descriptions all come out at compile time, and Encode turns full precision CtVertexes into it.
+//Semantics that a layout leaves out just don't get an attribute, so shaders shouldn't read ones the layout doesn't have
+template<typename... Attributes>
+struct CtVertexLayout{
+    static constexpr uint32_t stride = (Attributes::encoding::size + ...);
+    static constexpr uint32_t attribute_count = sizeof...(Attributes);
+
+    static_assert(stride % 4 == 0, "Vertex layouts have to stay 4 byte aligned.");
+
+    static constexpr VkVertexInputBindingDescription GetBindingDescription(){
         VkVertexInputBindingDescription binding_description{};
 
         binding_description.binding = 0;
-        binding_description.stride = sizeof(CtVertex);
+        binding_description.stride = stride;
         binding_description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
         return binding_description;
     }
 
-    static std::array<VkVertexInputAttributeDescription, 3> GetAttributeDescriptions(){
-        std::array<VkVertexInputAttributeDescription, 3> attribute_descriptions{};
+    static constexpr std::array<VkVertexInputAttributeDescription, sizeof...(Attributes)> GetAttributeDescriptions(){
+        std::array<VkVertexInputAttributeDescription, sizeof...(Attributes)> attribute_descriptions{};
 
-        attribute_descriptions[0].binding = 0;
-        attribute_descriptions[0].location = 0;
-        attribute_descriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
-        attribute_descriptions[0].offset = offsetof(CtVertex, position);
-
-        attribute_descriptions[1].binding = 0;
-        attribute_descriptions[1].location = 1;
-        attribute_descriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-        attribute_descriptions[1].offset = offsetof(CtVertex, color);
-
-        attribute_descriptions[2].binding = 0;
-        attribute_descriptions[2].location = 2;
-        attribute_descriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-        attribute_descriptions[2].offset = offsetof(CtVertex, texCoord);
+        uint32_t attribute = 0;
+        uint32_t offset = 0;
+        ((attribute_descriptions[attribute].binding = 0,
+          attribute_descriptions[attribute].location = static_cast<uint32_t>(Attributes::semantic),
+          attribute_descriptions[attribute].format = Attributes::encoding::format,
+          attribute_descriptions[attribute].offset = offset,
+          offset += Attributes::encoding::size,
+          attribute++), ...);
 
         return attribute_descriptions;
     }
 
-    bool operator==(const CtVertex& other) const{
-        return position == other.position && color == other.color && texCoord == other.texCoord;
+    static void Encode(const std::vector<CtVertex>& vertices, std::vector<uint8_t>& packed){
+        packed.resize(vertices.size() * stride);
+
+        for(size_t v = 0; v < vertices.size(); v++){
+            uint8_t* out = packed.data() + v * stride;
+            ((Attributes::encoding::Encode(CtReadVertexSemantic(vertices[v], Attributes::semantic), out), out += Attributes::encoding::size), ...);
+        }
     }
 };
 
+//Everything as plain floats, 40 bytes a vertex
+using CtFullVertexLayout = CtVertexLayout<
+    CtVertexAttribute<CT_VERTEX_POSITION, CtFloat2>,
+    CtVertexAttribute<CT_VERTEX_COLOR, CtFloat3>,
+    CtVertexAttribute<CT_VERTEX_TEXCOORD, CtFloat2>,
+    CtVertexAttribute<CT_VERTEX_NORMAL, CtFloat3>>;
+
+//Half positions, 8 bit colors, 16 bit coordinates and octahedral normals, 16 bytes a vertex
+using CtCompactVertexLayout = CtVertexLayout<
+    CtVertexAttribute<CT_VERTEX_POSITION, CtHalf2>,
+    CtVertexAttribute<CT_VERTEX_COLOR, CtUnorm8x4>,
+    CtVertexAttribute<CT_VERTEX_TEXCOORD, CtUnorm16x2>,
+    CtVertexAttribute<CT_VERTEX_NORMAL, CtOctahedral16>>;
+
+//What the main pipeline reads, and what meshes get stored as unless they ask for something else
+using CtMeshVertexLayout = CtCompactVertexLayout;
+
 const std::vector<CtVertex> test_vertices = {
-    {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}},
-    {{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}},
-    {{0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}},
-    {{-0.5f, 0.5f}, {1.0f, 1.0f, 0.0f}, {0.0f, 0.0f}}
+    {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+    {{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+    {{0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+    {{-0.5f, 0.5f}, {1.0f, 1.0f, 0.0f}, {0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}}
 };
 
 const std::vector<uint16_t> test_indices = {
     0, 1, 2, 2, 3, 0
-};
\ No newline at end of file
+};
@@ -8,6 +8,8 @@
 #include "CtSwapchain.h"
 #include "CtGraphicsPipeline.h"
 #include "CtRenderer.h"
+#include "CtSimulation.h"
+#include "CtBindlessTable.h"
 
 #define CT_DEBUG
 
@@ -25,12 +27,23 @@ void Engine::CreateObjects(EngineSettings settings){
     CreateSurface(settings);
     CreateDevices(settings);
     CreateSwapchain(settings);
+    CreateBindlessTable(settings);
     CreateGraphicsPipeline(settings);
+    CreateSimulation(settings);
     CreateRenderer(settings);
 }
 
 void Engine::CreateGraphicsPipeline(EngineSettings settings){
-    graphics_pipeline = CtGraphicsPipeline::CreateGraphicsPipeline(settings, devices, swapchain);
+    graphics_pipeline = CtGraphicsPipeline::CreateGraphicsPipeline(settings, devices, swapchain, bindless_table);
+}
+
+void Engine::CreateBindlessTable(EngineSettings settings){
+    bindless_table = nullptr;
+
+    if(devices->GetOptionalFeatures().descriptor_indexing){
+        bindless_table = CtBindlessTable::CreateBindlessTable(devices, settings.graphics_settings.max_bindless_textures,
+            settings.graphics_settings.max_bindless_storage_buffers, settings.graphics_settings.max_frames_in_flight);
+    }
 }
 
 void Engine::CreateSwapchain(EngineSettings settings){
@@ -50,16 +63,35 @@ void Engine::CreateWindow(EngineSettings settings){
     window = CtWindow::CreateWindow(settings.windows_settings.window_width, settings.windows_settings.window_height, engine_name);
 }
 
+void Engine::CreateSimulation(EngineSettings settings){
+    simulation = CtSimulation::CreateSimulation(settings);
+}
+
+//The main thread only polls events and renders, GLFW wants its events on the main thread anyways.
+//All of the update logic happens on the simulation thread and reaches us through snapshots
 void Engine::EngineLoop(){
 
-    while(!window->ShouldWindowClose()){
-        window->PollEvents();
-        renderer->DrawFrame();
+    simulation->Start();
+
+    //A thread that's still joinable when it gets destroyed takes the whole program down, so it has to be stopped whichever way we leave
+    try{
+        while(!window->ShouldWindowClose()){
+            window->PollEvents();
+            renderer->DrawFrame();
+        }
+    } catch(...){
+        simulation->Stop();
+        throw;
     }
 
+    simulation->Stop();
+
 }
 
 void Engine::Cleanup(){
+    simulation->Stop();
+    delete simulation;
+
     window->Cleanup();
     free(window);
 }
@@ -75,7 +107,7 @@ void Engine::CreateInstance(EngineSettings settings){
         VK_MAKE_VERSION(1, 0, 0), 
         "Calico Engine",
         VK_MAKE_VERSION(1, 0, 0),
-        VK_API_VERSION_1_0);
+        CtInstance::GetSupportedApiVersion(VK_API_VERSION_1_3)); //Newer versions let the device turn on things like dynamic rendering
 
 
     CtInstanceCreateInfo ct_create_info {}; 
@@ -97,5 +129,5 @@ void Engine::CreateInstance(EngineSettings settings){
 }
 
 void Engine::CreateRenderer(EngineSettings settings){
-    renderer = CtRenderer::CreateRenderer(settings, devices, swapchain, graphics_pipeline);
+    renderer = CtRenderer::CreateRenderer(settings, devices, swapchain, graphics_pipeline, bindless_table, simulation->GetSnapshots());
 }
\ No newline at end of file
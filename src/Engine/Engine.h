@@ -1,6 +1,7 @@
 #include <cstdint>
 #include <string>
 #include <vector>
+#include <functional>
 
 class CtWindow;
 class CtInstance;
@@ -8,6 +9,9 @@ class CtDevice;
 class CtSwapchain;
 class CtGraphicsPipeline;
 class CtRenderer;
+class CtSimulation;
+class CtBindlessTable;
+struct CtRenderSnapshot;
 
 struct WindowSettings{
     uint32_t window_width;
@@ -18,12 +22,86 @@ struct GraphicsSettings{
     std::vector<std::string> shader_files; 
     std::vector<uint32_t> shader_stages;
     uint32_t max_frames_in_flight;
+
+    //Bytes of per draw uniform data each frame in flight can use
+    uint32_t uniform_ring_size;
+
+    //How many instances each frame in flight can draw in total
+    uint32_t max_instances;
+
+    //Use vkCmdBeginRendering when the device has it instead of render pass and framebuffer objects
+    bool use_dynamic_rendering;
+
+    //Record barriers with vkCmdPipelineBarrier2 when the device has it
+    bool use_synchronization2;
+
+    //One global descriptor set of texture, sampler and storage buffer arrays that draws index into. Sizes get clamped to what the GPU allows
+    bool use_bindless;
+    uint32_t max_bindless_textures;
+    uint32_t max_bindless_storage_buffers;
+
+    //Draw each pipeline's whole bucket with one indirect call when the device can. Otherwise the batcher falls back to a direct draw per mesh
+    bool use_multi_draw_indirect;
+
+    //What the mesh store's shared buffers can hold across every mesh (indices counted as 32 bit ones), and how many indirect draws a frame can have
+    uint32_t max_mesh_vertices;
+    uint32_t max_mesh_indices;
+    uint32_t max_indirect_draws;
+
+    //How many meshlets the mesh store keeps bounds and cones for across every clustered mesh
+    uint32_t max_mesh_clusters;
+
+    //Meshes with a LOD chain draw the coarsest level that's off by at most this many pixels on screen
+    float lod_pixel_error;
+
+    //.ctmesh files (see Tools/mesh_converter.cpp) loaded at startup. A render object's mesh_id picks one of these, counting from 1,
+    //and 0 is the built in test mesh
+    std::vector<std::string> mesh_files;
+
+    //glTF 2.0 scenes (.gltf or .glb) loaded at startup and drawn every frame wherever their nodes put them
+    std::vector<std::string> scene_files;
+
+    //Color textures (PNG, TGA, BMP or KTX2) loaded at startup with full mip chains, and the most anisotropic filtering any sampler gets
+    std::vector<std::string> texture_files;
+    float max_sampler_anisotropy;
+
+    //Encode PNG, TGA and BMP textures to BC1 or BC3 while loading when the device has BC. KTX2 files keep the format they're in
+    //when the device has it, otherwise they get decoded and go through the same path
+    bool use_texture_compression;
+
+    //Load texture_files with only their low mips on the GPU and stream the rest in as they're asked for, keeping every streamed
+    //texture under this many megabytes. Less if the device has VK_EXT_memory_budget and it says there isn't that much to spare
+    bool use_texture_streaming;
+    uint32_t texture_streaming_budget;
+
+    //Frustum and Hi-Z occlusion cull every instance in compute and compact what's left into the indirect draws. Needs multi draw indirect
+    bool use_gpu_culling;
+    std::string cull_shader_file;
+    std::string hiz_shader_file;
+
+    //Frustum and backface cone cull clustered meshes one meshlet at a time and draw only the meshlets that are left.
+    //Needs multi draw indirect and draw indirect count
+    bool use_cluster_culling;
+    std::string cluster_cull_shader_file;
+
+    //Run render graph passes tagged for it on their own compute queue so they overlap with graphics work. Only happens if the
+    //device has a compute only queue family and timeline semaphores, otherwise those passes just stay on the graphics queue
+    bool use_async_compute;
+};
+
+struct SimulationSettings{
+    //How many times a second the update function runs
+    uint32_t tick_rate;
+
+    //Called once per tick on the simulation thread with the fixed tick length in seconds
+    std::function<void(CtRenderSnapshot&, double)> update;
 };
 
 struct EngineSettings{
 
     WindowSettings windows_settings;
     GraphicsSettings graphics_settings;
+    SimulationSettings simulation_settings;
 
 };
 
@@ -49,9 +127,15 @@ class Engine{
         //Pipeline
         CtGraphicsPipeline* graphics_pipeline;
 
+        //Every texture and storage buffer we can index into. Null if the device doesn't have descriptor indexing
+        CtBindlessTable* bindless_table;
+
         //The actual Renderer
         CtRenderer* renderer;
 
+        //Runs the update logic on its own thread
+        CtSimulation* simulation;
+
         //Functions
         void EngineLoop();
         void Cleanup();
@@ -63,6 +147,8 @@ class Engine{
         void CreateSurface(EngineSettings settings);
         void CreateSwapchain(EngineSettings settings);
         void CreateGraphicsPipeline(EngineSettings settings);
+        void CreateBindlessTable(EngineSettings settings);
+        void CreateSimulation(EngineSettings settings);
 
     friend class CtDevice;
     friend class CtSwapchain;